@@ -2,6 +2,7 @@
 
 #include <pybind11/complex.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
@@ -239,6 +240,86 @@ template <> struct type_caster<std::unique_ptr<DecisionTreeNode>> {
 
 namespace py = pybind11;
 
+// Symbolic value codes, converted from any integer array such as NumPy's default int64
+using SymbolicCodes = py::array_t<int, py::array::c_style | py::array::forcecast>;
+
+// Checks that a batch of NumPy arrays has one column per feature, and returns its number of rows
+template <typename T>
+size_t batchRows(size_t numFeatures,
+                 const py::array_t<T, py::array::c_style> &numericValues,
+                 const optional<SymbolicCodes> &symbolicCodes)
+{
+    if (numericValues.ndim() != 2 || static_cast<size_t>(numericValues.shape(1)) != numFeatures) {
+        throw std::invalid_argument("Expected a rows x " + std::to_string(numFeatures) + " array of numeric values");
+    }
+
+    const size_t numRows = static_cast<size_t>(numericValues.shape(0));
+    if (symbolicCodes && (symbolicCodes->ndim() != 2 || static_cast<size_t>(symbolicCodes->shape(0)) != numRows ||
+                          static_cast<size_t>(symbolicCodes->shape(1)) != numFeatures)) {
+        throw std::invalid_argument("The array of symbolic codes must have the shape of the array of numeric values");
+    }
+    return numRows;
+}
+
+// Batch prediction on NumPy arrays, read in place through the buffer protocol, for a CompiledDecisionTree, a
+// DecisionForest, a QuickScorer or a NativeDecisionTree
+template <typename Model, typename T>
+py::array_t<double> predictProbaNumpy(const Model &compiled,
+                                      py::array_t<T, py::array::c_style> numericValues,
+                                      optional<SymbolicCodes> symbolicCodes)
+{
+    const size_t numRows = batchRows(compiled.getNumFeatures(), numericValues, symbolicCodes);
+
+    py::array_t<double> probabilities({numRows, compiled.getNumClasses()});
+    const T* numericPtr    = numericValues.data();
+    const int* symbolicPtr = symbolicCodes ? symbolicCodes->data() : nullptr;
+    double* probabilityPtr = probabilities.mutable_data();
+
+    {
+        py::gil_scoped_release release;
+        compiled.predictProba(numericPtr, symbolicPtr, numRows, probabilityPtr);
+    }
+
+    return probabilities;
+}
+
+// The compiled copy of a tree used by DecisionTree.predict_proba, kept on the Python object and compiled again only
+// when nodes have been added to or removed from the tree since
+std::shared_ptr<CompiledDecisionTree> cachedCompiledTree(py::object self)
+{
+    auto dt = self.cast<std::shared_ptr<DecisionTree>>();
+    if (py::hasattr(self, "_compiledTree") &&
+        self.attr("_compiledTreeRevision").cast<uint64_t>() == dt->getTreeRevision()) {
+        return self.attr("_compiledTree").cast<std::shared_ptr<CompiledDecisionTree>>();
+    }
+
+    auto compiled                      = std::make_shared<CompiledDecisionTree>(dt);
+    self.attr("_compiledTree")         = py::cast(compiled);
+    self.attr("_compiledTreeRevision") = py::cast(dt->getTreeRevision());
+    return compiled;
+}
+
+// Trains a decision tree on a worker of the module's ThreadPoolExecutor without holding the GIL. The returned
+// concurrent.futures.Future resolves to the tree, or raises the exception thrown by fit(). The executor joins its
+// workers when the interpreter exits, so a fit still running then is waited for rather than cut off.
+py::object fitAsync(std::shared_ptr<DecisionTree> dt)
+{
+    py::module_ module = py::module_::import("DecisionTreePP");
+    if (!py::hasattr(module, "_fitExecutor")) {
+        module.attr("_fitExecutor") = py::module_::import("concurrent.futures")
+                                          .attr("ThreadPoolExecutor")(py::arg("thread_name_prefix") = "fit_async");
+    }
+
+    py::cpp_function job([dt]() {
+        {
+            py::gil_scoped_release release;
+            dt->fit();
+        }
+        return dt;
+    });
+    return module.attr("_fitExecutor").attr("submit")(job);
+}
+
 // Define the doughnut function for demonstration
 
 // Define the DecisionTreeNode module
@@ -247,6 +328,13 @@ PYBIND11_MODULE(DecisionTreePP, m)
 
     m.doc() = "Decision Tree Plus Plus Module"; // Optional module documentation
 
+    // Whether the module was compiled with -march=native (the DTPP_NATIVE_ARCH CMake option)
+#ifdef DTPP_NATIVE_ARCH
+    m.attr("NATIVE_ARCH") = true;
+#else
+    m.attr("NATIVE_ARCH") = false;
+#endif
+
     // ========= DecisionTreeNode Class =========
     py::class_<DecisionTreeNode, std::shared_ptr<DecisionTreeNode>>(m, "DecisionTreeNode")
 
@@ -285,7 +373,10 @@ PYBIND11_MODULE(DecisionTreePP, m)
         .def("GetBranchFeaturesAndValuesOrThresholds",
              &DecisionTreeNode::GetBranchFeaturesAndValuesOrThresholds,
              "Returns the features and their corresponding values or thresholds used for branching")
-        .def("GetChildren", &DecisionTreeNode::GetChildren, "Returns a list of child nodes")
+        .def("GetChildren",
+             &DecisionTreeNode::GetChildren,
+             py::return_value_policy::reference_internal,
+             "Returns a list of child nodes")
         .def("GetSerialNum", &DecisionTreeNode::GetSerialNum, "Returns this node's serial number")
 
         // Setters
@@ -315,15 +406,31 @@ PYBIND11_MODULE(DecisionTreePP, m)
              "Displays the entire decision tree starting from this node");
 
     // =========== DecisionTree Class ===========
-    py::class_<DecisionTree, std::shared_ptr<DecisionTree>>(m, "DecisionTree")
+    py::enum_<FeatureType>(m, "FeatureType")
+        .value("NUMERIC", FeatureType::NUMERIC)
+        .value("SYMBOLIC", FeatureType::SYMBOLIC);
+
+    py::class_<DecisionTree, std::shared_ptr<DecisionTree>>(m, "DecisionTree", py::dynamic_attr())
         //--------------- Constructors and Destructors ----------------//
         .def(py::init<std::map<std::string, std::string>>(), "Constructor with kwargs")
 
         //--------------- Class Functions ----------------//
-        .def("getTrainingData", &DecisionTree::getTrainingData, "Retrieve training data")
+        .def("getTrainingData",
+             &DecisionTree::getTrainingData,
+             py::call_guard<py::gil_scoped_release>(),
+             "Retrieve training data")
         .def("calculateFirstOrderProbabilities",
              &DecisionTree::calculateFirstOrderProbabilities,
+             py::call_guard<py::gil_scoped_release>(),
              "Calculate first order probabilities")
+        .def("fit",
+             &DecisionTree::fit,
+             py::return_value_policy::reference_internal,
+             py::call_guard<py::gil_scoped_release>(),
+             "Read the training data if needed, calculate the probabilities and construct the decision tree")
+        .def("fit_async",
+             &fitAsync,
+             "Run fit() on a background thread and return a concurrent.futures.Future that resolves to the tree")
         .def("showTrainingData", &DecisionTree::showTrainingData, "Show training data")
 
         //--------------- Classify ----------------//
@@ -331,7 +438,24 @@ PYBIND11_MODULE(DecisionTreePP, m)
              &DecisionTree::classify,
              py::arg("root_node"),
              py::arg("features_and_values"),
-             "Classify based on features and values")
+             py::call_guard<py::gil_scoped_release>(),
+             "Classify based on features and values; safe to call from several threads")
+        .def(
+            "predict_proba",
+            [](py::object self, py::array_t<double, py::array::c_style> X, optional<SymbolicCodes> symbolic) {
+                return predictProbaNumpy(*cachedCompiledTree(self), X, symbolic);
+            },
+            py::arg("X"),
+            py::arg("symbolic") = py::none(),
+            "Class probabilities (rows x classes) for a float64 array with one column per feature")
+        .def(
+            "predict_proba",
+            [](py::object self, py::array_t<float, py::array::c_style> X, optional<SymbolicCodes> symbolic) {
+                return predictProbaNumpy(*cachedCompiledTree(self), X, symbolic);
+            },
+            py::arg("X"),
+            py::arg("symbolic") = py::none(),
+            "Class probabilities (rows x classes) for a float32 array with one column per feature")
 
         .def("recursiveDescentForClassification",
              &DecisionTree::recursiveDescentForClassification,
@@ -354,6 +478,8 @@ PYBIND11_MODULE(DecisionTreePP, m)
         // -------------- Construct Tree ----------------//
         .def("constructDecisionTreeClassifier",
              &DecisionTree::constructDecisionTreeClassifier,
+             py::return_value_policy::reference_internal,
+             py::call_guard<py::gil_scoped_release>(),
              "Construct decision tree classifier")
         .def("recursiveDescent", &DecisionTree::recursiveDescent, py::arg("node"), "Recursive descent")
         .def("bestFeatureCalculator",
@@ -362,6 +488,51 @@ PYBIND11_MODULE(DecisionTreePP, m)
              py::arg("existingNodeEntropy"),
              "Calculate the best feature for the decision tree")
 
+        // -------------- Routing Index ----------------//
+        .def("buildRoutingIndex",
+             &DecisionTree::buildRoutingIndex,
+             py::call_guard<py::gil_scoped_release>(),
+             "Build the sample-to-leaf routing index")
+        .def("hasRoutingIndex", &DecisionTree::hasRoutingIndex, "Check whether the routing index has been built")
+        .def("getRoutingIndex",
+             &DecisionTree::getRoutingIndex,
+             py::return_value_policy::reference_internal,
+             "Get the sample-to-leaf routing index")
+
+        // -------------- Truncation ----------------//
+        .def("truncate",
+             &DecisionTree::truncate,
+             py::arg("entropy_threshold"),
+             py::arg("max_depth_desired"),
+             "Cut the tree in place to the tree a higher entropy threshold or smaller depth would have grown")
+        .def("countNodesAfterTruncation",
+             &DecisionTree::countNodesAfterTruncation,
+             py::arg("entropy_threshold"),
+             py::arg("max_depth_desired"),
+             "Count the nodes the tree would keep if truncated")
+
+        // -------------- Instrumentation ----------------//
+        .def("getStats", &DecisionTree::getStats, "Get the training timers, counters and cache sizes")
+        .def("resetStats", &DecisionTree::resetStats, "Reset the training timers and counters")
+        .def("setTracing",
+             &DecisionTree::setTracing,
+             py::arg("enabled"),
+             "Turn the recording of a construction trace on or off")
+        .def("writeChromeTrace",
+             &DecisionTree::writeChromeTrace,
+             py::arg("filename"),
+             "Write the construction trace as Chrome trace-event JSON, for Perfetto or chrome://tracing")
+        .def(
+            "getChromeTrace",
+            [](const DecisionTree &dt) { return dt.getTrace().toChromeTraceJson(); },
+            "Get the construction trace as Chrome trace-event JSON")
+
+        // -------------- Memory Accounting ----------------//
+        .def("getMemoryUsage",
+             &DecisionTree::getMemoryUsage,
+             "Get the estimated memory held by the data, caches and nodes")
+        .def("clearCaches", &DecisionTree::clearCaches, "Empty the probability and entropy caches")
+
         // --------- Entropy Calculators ------------//
 
         .def("classEntropyOnPriors", &DecisionTree::classEntropyOnPriors, "Calculate class entropy on priors")
@@ -398,7 +569,10 @@ PYBIND11_MODULE(DecisionTreePP, m)
              &DecisionTree::priorProbabilityForClass,
              py::arg("className"),
              "Calculate prior probability for a class")
-        .def("calculateClassPriors", &DecisionTree::calculateClassPriors, "Calculate class priors")
+        .def("calculateClassPriors",
+             &DecisionTree::calculateClassPriors,
+             py::call_guard<py::gil_scoped_release>(),
+             "Calculate class priors")
         .def("probabilityOfFeatureValue",
              (double(DecisionTree::*)(const std::string &, const std::string &)) &
                  DecisionTree::probabilityOfFeatureValue,
@@ -468,6 +642,19 @@ PYBIND11_MODULE(DecisionTreePP, m)
         .def("getDebug1", &DecisionTree::getDebug1, "Get the debug1 flag")
         .def("getDebug2", &DecisionTree::getDebug2, "Get the debug2 flag")
         .def("getDebug3", &DecisionTree::getDebug3, "Get the debug3 flag")
+        .def("getMemoryBudgetBytes", &DecisionTree::getMemoryBudgetBytes, "Get the memory budget in bytes")
+        .def("getContingencyCubeMaxCells",
+             &DecisionTree::getContingencyCubeMaxCells,
+             "Get the largest number of cells of a contingency cube")
+        .def("hasContingencyCube",
+             &DecisionTree::hasContingencyCube,
+             "Whether the training data is counted from a contingency cube")
+        .def("getFeaturesPerNode",
+             &DecisionTree::getFeaturesPerNode,
+             "Get the number of features drawn at random at each node (0 for all)")
+        .def("getSeed", &DecisionTree::getSeed, "Get the seed of the randomized steps, if one was given")
+        .def("getFeatureTypes", &DecisionTree::getFeatureTypes, "Get the type of every feature of the training data")
+        .def("isNumericFeature", &DecisionTree::isNumericFeature, py::arg("feature"), "Whether a feature is numeric")
         .def("getHowManyTotalTrainingSamples",
              &DecisionTree::getHowManyTotalTrainingSamples,
              "Get the total number of training samples")
@@ -485,7 +672,10 @@ PYBIND11_MODULE(DecisionTreePP, m)
              &DecisionTree::getNumericFeaturesValueRangeDict,
              "Get the numeric features value range dictionary")
         .def("getTrainingDataDict", &DecisionTree::getTrainingDataDict, "Get the training data dictionary")
-        .def("getRootNode", &DecisionTree::getRootNode, "Get the root node")
+        .def("getRootNode",
+             &DecisionTree::getRootNode,
+             py::return_value_policy::reference_internal,
+             "Get the root node")
 
         // --------------- Setters ----------------//
         .def("setTrainingDatafile",
@@ -523,6 +713,23 @@ PYBIND11_MODULE(DecisionTreePP, m)
         .def("setDebug1", &DecisionTree::setDebug1, py::arg("debug1"), "Set the debug1 flag")
         .def("setDebug2", &DecisionTree::setDebug2, py::arg("debug2"), "Set the debug2 flag")
         .def("setDebug3", &DecisionTree::setDebug3, py::arg("debug3"), "Set the debug3 flag")
+        .def("setMemoryBudgetBytes",
+             &DecisionTree::setMemoryBudgetBytes,
+             py::arg("memoryBudgetBytes"),
+             "Set the memory budget in bytes (0 for none)")
+        .def("setContingencyCubeMaxCells",
+             &DecisionTree::setContingencyCubeMaxCells,
+             py::arg("contingencyCubeMaxCells"),
+             "Set the largest number of cells of a contingency cube (0 for none), used when the data is next read")
+        .def("setFeaturesPerNode",
+             &DecisionTree::setFeaturesPerNode,
+             py::arg("featuresPerNode"),
+             "Set the number of features drawn at random at each node (0 for all)")
+        .def("setSeed", &DecisionTree::setSeed, py::arg("seed"), "Set the seed of the randomized steps")
+        .def("setFeatureTypes",
+             &DecisionTree::setFeatureTypes,
+             py::arg("featureTypes"),
+             "Declare the types of features, which are then not inferred when the training data is read")
         .def("setHowManyTotalTrainingSamples",
              &DecisionTree::setHowManyTotalTrainingSamples,
              py::arg("howManyTotalTrainingSamples"),
@@ -538,6 +745,7 @@ PYBIND11_MODULE(DecisionTreePP, m)
              "Read the parameter file for numeric data")
         .def("GenerateTrainingDataNumeric",
              &TrainingDataGeneratorNumeric::GenerateTrainingDataNumeric,
+             py::call_guard<py::gil_scoped_release>(),
              "Generate the training data for numeric data")
         .def("GenerateMultivariateSamples",
              &TrainingDataGeneratorNumeric::GenerateMultivariateSamples,
@@ -551,6 +759,8 @@ PYBIND11_MODULE(DecisionTreePP, m)
              &TrainingDataGeneratorNumeric::getNumberOfSamplesPerClass,
              "Get number of samples per class")
         .def("getDebug", &TrainingDataGeneratorNumeric::getDebug, "Get debug flag")
+        .def("getSeed", &TrainingDataGeneratorNumeric::getSeed, "Get seed")
+        .def("getNumberOfThreads", &TrainingDataGeneratorNumeric::getNumberOfThreads, "Get number of threads")
         .def("getClassNames", &TrainingDataGeneratorNumeric::getClassNames, "Get class names")
         .def("getFeaturesOrdered", &TrainingDataGeneratorNumeric::getFeaturesOrdered, "Get ordered features")
         .def("getClassNamesAndPriors",
@@ -571,9 +781,11 @@ PYBIND11_MODULE(DecisionTreePP, m)
              "Read the parameter file for symbolic data")
         .def("GenerateTrainingDataSymbolic",
              &TrainingDataGeneratorSymbolic::GenerateTrainingDataSymbolic,
+             py::call_guard<py::gil_scoped_release>(),
              "Generate the training data for symbolic data")
         .def("WriteTrainingDataToFile",
              &TrainingDataGeneratorSymbolic::WriteTrainingDataToFile,
+             py::call_guard<py::gil_scoped_release>(),
              "Write training data to file")
         .def("getClassPriors", &TrainingDataGeneratorSymbolic::getClassPriors, "Get class priors")
         .def("getClassNames", &TrainingDataGeneratorSymbolic::getClassNames, "Get class names")
@@ -589,22 +801,97 @@ PYBIND11_MODULE(DecisionTreePP, m)
         .def("getWriteToFile", &TrainingDataGeneratorSymbolic::getWriteToFile, "Get write to file flag")
         .def("getDebug1", &TrainingDataGeneratorSymbolic::getDebug1, "Get debug1 flag")
         .def("getDebug2", &TrainingDataGeneratorSymbolic::getDebug2, "Get debug2 flag")
+        .def("getSeed", &TrainingDataGeneratorSymbolic::getSeed, "Get seed")
+        .def("getNumberOfThreads", &TrainingDataGeneratorSymbolic::getNumberOfThreads, "Get number of threads")
+        .def("getSampleCodes",
+             &TrainingDataGeneratorSymbolic::getSampleCodes,
+             "Get the dictionary-coded samples: the class index followed by the value index of each feature")
         .def("getTrainingSampleRecords",
              &TrainingDataGeneratorSymbolic::getTrainingSampleRecords,
              "Get training sample records");
 
+    //========= BenchmarkDataGenerator Class =========//
+    py::class_<BenchmarkDataGenerator>(m, "BenchmarkDataGenerator")
+        .def(py::init<std::map<std::string, std::string>>(), "Constructor with parameters")
+        .def("GenerateBenchmarkData",
+             &BenchmarkDataGenerator::GenerateBenchmarkData,
+             py::call_guard<py::gil_scoped_release>(),
+             "Generate the data and write it to the output file")
+        .def("getOutputDatafile", &BenchmarkDataGenerator::getOutputDatafile, "Get output data file")
+        .def("getNumberOfSamples", &BenchmarkDataGenerator::getNumberOfSamples, "Get number of samples")
+        .def("getNumberOfNumericFeatures",
+             &BenchmarkDataGenerator::getNumberOfNumericFeatures,
+             "Get number of numeric features")
+        .def("getNumberOfSymbolicFeatures",
+             &BenchmarkDataGenerator::getNumberOfSymbolicFeatures,
+             "Get number of symbolic features")
+        .def("getNumberOfClasses", &BenchmarkDataGenerator::getNumberOfClasses, "Get number of classes")
+        .def("getNumberOfSymbolicValues",
+             &BenchmarkDataGenerator::getNumberOfSymbolicValues,
+             "Get number of values of each symbolic feature")
+        .def("getSeed", &BenchmarkDataGenerator::getSeed, "Get seed")
+        .def("getNumberOfThreads", &BenchmarkDataGenerator::getNumberOfThreads, "Get number of threads")
+        .def("getBlockSize", &BenchmarkDataGenerator::getBlockSize, "Get block size")
+        .def("getFeatureNames", &BenchmarkDataGenerator::getFeatureNames, "Get feature names")
+        .def(
+            "getCsvColumnsForFeatures",
+            [](const BenchmarkDataGenerator &self) { return py::bytes(self.getCsvColumnsForFeatures()); },
+            "Get the feature columns in the form taken by csv_columns_for_features");
+
     //========= EvalTrainingData Class =========//
     py::class_<EvalTrainingData, DecisionTree, std::shared_ptr<EvalTrainingData>>(m, "EvalTrainingData")
         .def(py::init<std::map<std::string, std::string>>(), "Constructor with parameters")
-        .def("evaluateTrainingData", &EvalTrainingData::evaluateTrainingData, "Evaluate the training data")
+        .def("evaluateTrainingData",
+             &EvalTrainingData::evaluateTrainingData,
+             py::call_guard<py::gil_scoped_release>(),
+             "Evaluate the training data")
+        .def("sweepHyperparameters",
+             &EvalTrainingData::sweepHyperparameters,
+             py::arg("entropy_thresholds"),
+             py::arg("max_depths_desired"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Cross-validate every combination of the parameters, growing one tree per fold")
         .def_readwrite("_dataQualityIndex", &EvalTrainingData::_dataQualityIndex)
         .def_readwrite("_csvClassColumnIndex", &EvalTrainingData::_csvClassColumnIndex);
 
+    // ========= Tree Pruning =========
+    py::class_<TreePruner, std::shared_ptr<TreePruner>>(m, "TreePruner")
+        .def(py::init<std::shared_ptr<DecisionTree>>(), py::arg("dt"))
+        .def("setHeldOutSamples",
+             &TreePruner::setHeldOutSamples,
+             py::arg("features_and_values"),
+             py::arg("class_names"),
+             "Set the samples that score the pruned trees, as \"feature=value\" strings with their classes")
+        .def("computePruningPath",
+             &TreePruner::computePruningPath,
+             py::return_value_policy::copy,
+             py::call_guard<py::gil_scoped_release>(),
+             "Compute the cost-complexity pruning path, from the full tree down to its root")
+        .def("selectStep", &TreePruner::selectStep, "Get the step of the path with the best held-out accuracy")
+        .def("pruneToStep",
+             &TreePruner::pruneToStep,
+             py::arg("step"),
+             py::return_value_policy::reference_internal,
+             "Prune the tree in place to a step of the path")
+        .def("prune",
+             &TreePruner::prune,
+             py::return_value_policy::reference_internal,
+             py::call_guard<py::gil_scoped_release>(),
+             "Prune the tree in place to the step of the path with the best held-out accuracy")
+        .def("getPruningPath", &TreePruner::getPruningPath, "Get the pruning path");
+
     // ========= DecisionTree Introspection =========
     py::class_<DTIntrospection, std::shared_ptr<DTIntrospection>>(m, "DTIntrospection")
         //--------------- Constructors and Destructors ----------------//
         .def(py::init<std::shared_ptr<DecisionTree>>(), py::arg("dt"))
-        .def("initialize", &DTIntrospection::initialize, "Initialize the introspection")
+        .def("initialize",
+             &DTIntrospection::initialize,
+             py::call_guard<py::gil_scoped_release>(),
+             "Initialize the introspection")
+        .def("initializeLazy",
+             &DTIntrospection::initializeLazy,
+             py::call_guard<py::gil_scoped_release>(),
+             "Initialize the introspection without materializing per-node or per-sample information")
         //--------------- Recursive Descent ----------------//
 
         .def("recursiveDescent", &DTIntrospection::recursiveDescent, py::arg("node"), "Perform recursive descent")
@@ -636,6 +923,20 @@ PYBIND11_MODULE(DecisionTreePP, m)
              py::arg("nodeID"),
              "Explain classification at specific node")
 
+        //--------------- Lazy Queries ----------------//
+        .def("getSamplesAtNode",
+             &DTIntrospection::getSamplesAtNode,
+             py::arg("nodeSerialNum"),
+             "Get the samples at a node, computed on first use and memoized")
+        .def("getBranchFeaturesAtNode",
+             &DTIntrospection::getBranchFeaturesAtNode,
+             py::arg("nodeSerialNum"),
+             "Get the feature tests on the branch leading to a node")
+        .def("getNodePathForSample",
+             &DTIntrospection::getNodePathForSample,
+             py::arg("sample"),
+             "Get the nodes containing a sample, computed on first use and memoized")
+
         //--------------- Class Utility ----------------//
         .def("getSamplesForFeatureValueCombo",
              &DTIntrospection::getSamplesForFeatureValueCombo,
@@ -656,6 +957,159 @@ PYBIND11_MODULE(DecisionTreePP, m)
              "Get mapping of serial numbers to nodes");
 
 
+    // ========= Compiled DecisionTree =========
+    py::enum_<NodeLayout>(m, "NodeLayout")
+        .value("DEPTH_FIRST", NodeLayout::DEPTH_FIRST)
+        .value("BREADTH_FIRST", NodeLayout::BREADTH_FIRST)
+        .value("VAN_EMDE_BOAS", NodeLayout::VAN_EMDE_BOAS)
+        .value("HOT_PATH", NodeLayout::HOT_PATH);
+
+    py::class_<CompiledDecisionTree, std::shared_ptr<CompiledDecisionTree>>(m, "CompiledDecisionTree")
+        .def(py::init<std::shared_ptr<DecisionTree>, NodeLayout>(),
+             py::arg("dt"),
+             py::arg("layout") = NodeLayout::DEPTH_FIRST,
+             "Compile a constructed decision tree, with its nodes in the given order")
+        .def(
+            "countTraffic",
+            [](const CompiledDecisionTree &compiled,
+               py::array_t<double, py::array::c_style> X,
+               optional<SymbolicCodes> symbolic) {
+                const size_t numRows = batchRows(compiled.getNumFeatures(), X, symbolic);
+                py::gil_scoped_release release;
+                return compiled.countTraffic(X.data(), symbolic ? symbolic->data() : nullptr, numRows);
+            },
+            py::arg("X"),
+            py::arg("symbolic") = py::none(),
+            "Count the samples passing through every node, by node serial number")
+        .def("relayout",
+             &CompiledDecisionTree::relayout,
+             py::arg("layout"),
+             py::arg("traffic") = std::map<int, size_t>{},
+             "Reorder the nodes for the cache; HOT_PATH takes the traffic from countTraffic")
+        .def("getLayout", &CompiledDecisionTree::getLayout, "Get the order of the nodes")
+        .def("predict_proba",
+             &predictProbaNumpy<CompiledDecisionTree, double>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities (rows x classes) for a float64 array with one column per feature")
+        .def("predict_proba",
+             &predictProbaNumpy<CompiledDecisionTree, float>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities (rows x classes) for a float32 array with one column per feature")
+        .def("encodeSymbolicValue",
+             &CompiledDecisionTree::encodeSymbolicValue,
+             py::arg("feature"),
+             py::arg("value"),
+             "Get the integer code of a symbolic value")
+        .def("getFeatureNames", &CompiledDecisionTree::getFeatureNames, "Get the feature names, in column order")
+        .def("getClassNames", &CompiledDecisionTree::getClassNames, "Get the class names, in column order")
+        .def("getSymbolicValues",
+             &CompiledDecisionTree::getSymbolicValues,
+             "Get the symbolic values of every symbolic feature, in code order")
+        .def("getNumNodes", &CompiledDecisionTree::getNumNodes, "Get the number of nodes");
+
+
+    // ========= DecisionForest =========
+    py::class_<DecisionForest, std::shared_ptr<DecisionForest>>(m, "DecisionForest")
+        .def(py::init<map<string, string>>(), py::arg("kwargs"), "Create a forest; takes the DecisionTree keywords too")
+        .def("fit",
+             &DecisionForest::fit,
+             py::call_guard<py::gil_scoped_release>(),
+             "Read the training data once and train the trees in parallel")
+        .def("predict_proba",
+             &predictProbaNumpy<DecisionForest, double>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities averaged over the trees for a float64 array with one column per feature")
+        .def("predict_proba",
+             &predictProbaNumpy<DecisionForest, float>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities averaged over the trees for a float32 array with one column per feature")
+        .def("classify",
+             &DecisionForest::classify,
+             py::arg("features_and_values"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Class probabilities averaged over the trees for a sample of \"feature=value\" strings")
+        .def("encodeSymbolicValue",
+             &DecisionForest::encodeSymbolicValue,
+             py::arg("feature"),
+             py::arg("value"),
+             "Get the integer code of a symbolic value")
+        .def("getTrees", &DecisionForest::getTrees, "Get the trees of the forest")
+        .def("getNumTrees", &DecisionForest::getNumTrees, "Get the number of trained trees")
+        .def("getNumberOfThreads", &DecisionForest::getNumberOfThreads, "Get the number of training threads")
+        .def("getFeaturesPerNode",
+             &DecisionForest::getFeaturesPerNode,
+             "Get the features drawn at each node (0 for the square root of the number of features)")
+        .def("getSeed", &DecisionForest::getSeed, "Get the seed of the bootstrap samples and feature draws")
+        .def("getFeatureNames", &DecisionForest::getFeatureNames, "Get the feature names, in column order")
+        .def("getClassNames", &DecisionForest::getClassNames, "Get the class names, in column order");
+
+
+    // ========= QuickScorer =========
+    py::class_<QuickScorer, std::shared_ptr<QuickScorer>>(m, "QuickScorer")
+        .def(py::init<const DecisionForest &>(), py::arg("forest"), "Build the bitvectors of a fitted forest")
+        .def("predict_proba",
+             &predictProbaNumpy<QuickScorer, double>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities averaged over the trees for a float64 array with one column per feature")
+        .def("predict_proba",
+             &predictProbaNumpy<QuickScorer, float>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities averaged over the trees for a float32 array with one column per feature")
+        .def("encodeSymbolicValue",
+             &QuickScorer::encodeSymbolicValue,
+             py::arg("feature"),
+             py::arg("value"),
+             "Get the integer code of a symbolic value")
+        .def("getNumTrees", &QuickScorer::getNumTrees, "Get the number of trees")
+        .def("getNumTests", &QuickScorer::getNumTests, "Get the number of branch tests over all the trees")
+        .def("getFeatureNames", &QuickScorer::getFeatureNames, "Get the feature names, in column order")
+        .def("getClassNames", &QuickScorer::getClassNames, "Get the class names, in column order");
+
+    // ========= Code Generation =========
+    py::class_<TreeCodeGenerator, std::shared_ptr<TreeCodeGenerator>>(m, "TreeCodeGenerator")
+        .def(py::init<std::shared_ptr<DecisionTree>, const std::string &>(),
+             py::arg("dt"),
+             py::arg("name") = "decision_tree",
+             "Compile a constructed tree for code generation")
+        .def("generateHeader", &TreeCodeGenerator::generateHeader, "Get the tree as a C++ header")
+        .def("generatePluginSource",
+             &TreeCodeGenerator::generatePluginSource,
+             "Get the tree as the C++ source of a shared library with extern \"C\" entry points")
+        .def("writeHeader", &TreeCodeGenerator::writeHeader, py::arg("filename"), "Write the C++ header to a file")
+        .def("compileAndLoad",
+             &TreeCodeGenerator::compileAndLoad,
+             py::arg("compiler") = "",
+             py::arg("flags")    = "-O2",
+             py::call_guard<py::gil_scoped_release>(),
+             "Compile the generated code with the system compiler and load it")
+        .def("getName", &TreeCodeGenerator::getName, "Get the namespace and entry point prefix of the generated code");
+
+    py::class_<NativeDecisionTree, std::shared_ptr<NativeDecisionTree>>(m, "NativeDecisionTree")
+        .def("predict_proba",
+             &predictProbaNumpy<NativeDecisionTree, double>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities for a float64 array with one column per feature")
+        .def("predict_proba",
+             &predictProbaNumpy<NativeDecisionTree, float>,
+             py::arg("X"),
+             py::arg("symbolic") = py::none(),
+             "Class probabilities for a float32 array with one column per feature")
+        .def("encodeSymbolicValue",
+             &NativeDecisionTree::encodeSymbolicValue,
+             py::arg("feature"),
+             py::arg("value"),
+             "Get the integer code of a symbolic value")
+        .def("getFeatureNames", &NativeDecisionTree::getFeatureNames, "Get the feature names, in column order")
+        .def("getClassNames", &NativeDecisionTree::getClassNames, "Get the class names, in column order");
+
+
     //======== Structs
     py::class_<BestFeatureResult>(m, "BestFeatureResult")
         .def(py::init<>()) // Default constructor
@@ -667,12 +1121,64 @@ PYBIND11_MODULE(DecisionTreePP, m)
         .def(py::init<>()) // Default constructor
         .def_readwrite("classProbabilities", &ClassificationAnswer::classProbabilities)
         .def_readwrite("solutionPath", &ClassificationAnswer::solutionPath);
+    py::class_<RoutingIndex>(m, "RoutingIndex")
+        .def(py::init<>()) // Default constructor
+        .def_readonly("permutedSamples", &RoutingIndex::permutedSamples)
+        .def_readonly("nodeRowRanges", &RoutingIndex::nodeRowRanges)
+        .def_readonly("parentNodes", &RoutingIndex::parentNodes)
+        .def_readonly("firstSample", &RoutingIndex::firstSample)
+        .def_readonly("sampleToLeaf", &RoutingIndex::sampleToLeaf);
+    py::class_<TrainingStats>(m, "TrainingStats")
+        .def(py::init<>()) // Default constructor
+        .def_readonly("loadSeconds", &TrainingStats::loadSeconds)
+        .def_readonly("firstOrderProbabilitiesSeconds", &TrainingStats::firstOrderProbabilitiesSeconds)
+        .def_readonly("constructSeconds", &TrainingStats::constructSeconds)
+        .def_readonly("splitSearchSeconds", &TrainingStats::splitSearchSeconds)
+        .def_readonly("splitSearchSecondsPerNode", &TrainingStats::splitSearchSecondsPerNode)
+        .def_readonly("splitSearches", &TrainingStats::splitSearches)
+        .def_readonly("featuresEvaluated", &TrainingStats::featuresEvaluated)
+        .def_readonly("thresholdsEvaluated", &TrainingStats::thresholdsEvaluated)
+        .def_readonly("probabilityCacheHits", &TrainingStats::probabilityCacheHits)
+        .def_readonly("probabilityCacheMisses", &TrainingStats::probabilityCacheMisses)
+        .def_readonly("entropyCacheHits", &TrainingStats::entropyCacheHits)
+        .def_readonly("entropyCacheMisses", &TrainingStats::entropyCacheMisses)
+        .def_readonly("nodesCreated", &TrainingStats::nodesCreated)
+        .def_readonly("probabilityCacheEntries", &TrainingStats::probabilityCacheEntries)
+        .def_readonly("entropyCacheEntries", &TrainingStats::entropyCacheEntries)
+        .def_readonly("bytesAllocated", &TrainingStats::bytesAllocated)
+        .def("probabilityCacheHitRate", &TrainingStats::probabilityCacheHitRate)
+        .def("entropyCacheHitRate", &TrainingStats::entropyCacheHitRate);
+    py::class_<SweepResult>(m, "SweepResult")
+        .def(py::init<>()) // Default constructor
+        .def_readonly("entropyThreshold", &SweepResult::entropyThreshold)
+        .def_readonly("maxDepthDesired", &SweepResult::maxDepthDesired)
+        .def_readonly("dataQualityIndex", &SweepResult::dataQualityIndex)
+        .def_readonly("meanNumNodes", &SweepResult::meanNumNodes);
+    py::class_<PruningStep>(m, "PruningStep")
+        .def(py::init<>()) // Default constructor
+        .def_readonly("alpha", &PruningStep::alpha)
+        .def_readonly("numNodes", &PruningStep::numNodes)
+        .def_readonly("numLeaves", &PruningStep::numLeaves)
+        .def_readonly("trainingAccuracy", &PruningStep::trainingAccuracy)
+        .def_readonly("heldOutAccuracy", &PruningStep::heldOutAccuracy)
+        .def_readonly("prunedNodes", &PruningStep::prunedNodes);
+    py::class_<MemoryUsage>(m, "MemoryUsage")
+        .def(py::init<>()) // Default constructor
+        .def_readonly("trainingDataBytes", &MemoryUsage::trainingDataBytes)
+        .def_readonly("probabilityCacheBytes", &MemoryUsage::probabilityCacheBytes)
+        .def_readonly("entropyCacheBytes", &MemoryUsage::entropyCacheBytes)
+        .def_readonly("nodeBytes", &MemoryUsage::nodeBytes)
+        .def_readonly("budgetBytes", &MemoryUsage::budgetBytes)
+        .def_readonly("cacheEvictions", &MemoryUsage::cacheEvictions)
+        .def_readonly("peakResidentBytes", &MemoryUsage::peakResidentBytes)
+        .def("totalBytes", &MemoryUsage::totalBytes);
 
     //==== demo functions
     m.def("constructDemo", &constructDemo, "Construct a demo decision tree");
     m.def("interactiveIntrospectionDemo", &interactiveIntrospection, "Interactive introspection");
     m.def("interactiveClassificationDemo", &interactiveClassification, "Interactive classification");
     m.def("evalTrainingDataDemo", &evalTraningDataDemo, "Evaluate training data");
+    m.def("defaultSeed", &defaultSeed, "Get the seed used when none is given (DTPP_SEED, if set)");
 
     m.def("BenchmarkConstructSmall", &BenchmarkConstructSmall, "Benchmark the construction of a small decision tree");
     m.def("BenchmarkConstructLarge", &BenchmarkConstructLarge, "Benchmark the construction of a large decision tree");
@@ -1,54 +1,64 @@
 # setup.py
 import os
-from setuptools import setup, Extension
-from pybind11.setup_helpers import build_ext
-import pybind11
+import sys
 import shutil
 import subprocess
+from setuptools import setup, Extension
+from setuptools.command.build_ext import build_ext
 # python setup.py build_ext --inplace
+#
+# The module is built by CMake as the DecisionTreePP target, linked against the same DecisionTreeLibrary as the C++
+# tests. Build options are passed through the environment, e.g.
+#   DTPP_ENABLE_LTO=ON DTPP_ENABLE_OPENMP=ON python setup.py build_ext --inplace
 
-def find_eigen_include_dir():
-    try:
-        # Run pkg-config to get the include directory
-        result = subprocess.run(
-            ["pkg-config", "--cflags", "eigen3"],
-            stdout=subprocess.PIPE,
-            stderr=subprocess.PIPE,
-            check=True,
-            text=True
-        )
-        return result.stdout.strip().split()[0][2:]  # Remove the leading '-I'
-    except subprocess.CalledProcessError:
-        print("Eigen not found. Make sure it's installed and pkg-config is configured.")
-        return None
+CMAKE_OPTIONS = ["DTPP_ENABLE_LTO", "DTPP_NATIVE_ARCH", "DTPP_ENABLE_OPENMP", "DTPP_ENABLE_MULTIVERSIONING"]
 
-#change the directory to the file location
-os.chdir(os.path.dirname(os.path.abspath(__file__)))
 
-eigen_include_dir = find_eigen_include_dir()
+class CMakeExtension(Extension):
+    def __init__(self, name, source_dir):
+        super().__init__(name, sources=[])
+        self.source_dir = os.path.abspath(source_dir)
 
-#copy the src and includes dir locally
-if os.path.exists('src'):
-    shutil.rmtree('src')
-shutil.copytree('../src', 'src')
 
+class CMakeBuild(build_ext):
+    def build_extension(self, ext):
+        build_dir = os.path.abspath(self.build_temp)
+        os.makedirs(build_dir, exist_ok=True)
 
+        configure_args = [
+            "-DDTPP_BUILD_PYTHON=ON",
+            # Only the module is built, so do not require GoogleTest or Google Benchmark
+            "-DDTPP_BUILD_TESTS=OFF",
+            "-DDTPP_BUILD_BENCHMARKS=OFF",
+            "-DPYTHON_EXECUTABLE=" + sys.executable,
+            "-DPython_EXECUTABLE=" + sys.executable,
+        ]
+        try:
+            # Use the pybind11 installed in this Python if the extern/pybind11 submodule is not checked out
+            import pybind11
+            configure_args.append("-Dpybind11_DIR=" + pybind11.get_cmake_dir())
+        except ImportError:
+            # Otherwise let CMake download it, unless the submodule is there
+            configure_args.append("-DDTPP_FETCH_PYBIND11=ON")
+        for option in CMAKE_OPTIONS:
+            if option in os.environ:
+                configure_args.append("-D" + option + "=" + os.environ[option])
 
-#get name in src dir
-src_files = os.listdir('../src')
-src_files = ['src/' + file for file in src_files]
-src_files.append("bindings.cpp")
+        subprocess.run(["cmake", "-S", ext.source_dir, "-B", build_dir] + configure_args, check=True)
+        subprocess.run(["cmake", "--build", build_dir, "--target", "DecisionTreePP", "-j", str(os.cpu_count() or 1)],
+                       check=True)
 
-ext_modules = [
-    Extension(
-        name = 'DecisionTreePP',  # Name of the resulting Python module
-        sources=src_files,  # Source file
-        include_dirs=[pybind11.get_include(), "../include", eigen_include_dir],  # Include `pybind11` headers
-        language='c++',  # This is a C++ extension
-        extra_compile_args=['-O3', '-Wall', '-shared', '-fPIC'],  # Optimization flags
+        # Copy the module to where setuptools expects it
+        built = [f for f in os.listdir(build_dir) if f.startswith(ext.name) and f.endswith((".so", ".pyd"))]
+        if not built:
+            raise RuntimeError("CMake did not produce the DecisionTreePP module. Is pybind11 available?")
+        destination = self.get_ext_fullpath(ext.name)
+        os.makedirs(os.path.dirname(destination), exist_ok=True)
+        shutil.copyfile(os.path.join(build_dir, built[0]), destination)
 
-    ),
-]
+
+#change the directory to the file location
+os.chdir(os.path.dirname(os.path.abspath(__file__)))
 
 setup(
     name='DecisionTreePP',
@@ -57,9 +67,6 @@ setup(
     author_email='N/A',
     description='Decision Tree C++ implementation',
     long_description='',
-    ext_modules=ext_modules,
-    cmdclass={'build_ext': build_ext},  # Use `build_ext` imported from `pybind11.setup_helpers`
+    ext_modules=[CMakeExtension('DecisionTreePP', '..')],
+    cmdclass={'build_ext': CMakeBuild},
 )
-
-#remove the src dir
-shutil.rmtree('src')
\ No newline at end of file
@@ -0,0 +1,550 @@
+#include "DecisionTree++.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <sstream>
+
+#ifndef DTPP_RESOURCE_DIR
+#define DTPP_RESOURCE_DIR "../test/resources"
+#endif
+
+/*
+ * Benchmarks for the stages of the decision tree pipeline. Every stage runs on the shipped datasets and on generated
+ * datasets of several sizes, and is registered as "<stage>/<dataset>". For results that can be compared from commit to
+ * commit, run
+ *
+ *     ./DecisionTreeBenchmarks --benchmark_out=benchmark_results.json --benchmark_out_format=json
+ *
+ * or build the run_benchmarks target, which writes the JSON to benchmark_results.json in the build directory.
+ */
+
+//--------------- Datasets ----------------//
+
+struct Dataset {
+    string name;
+    map<string, string> kwargs;
+    bool crossValidate; // EvalTrainingData needs integer class labels, and builds ten trees per iteration
+};
+
+// Sizes of the generated datasets
+const vector<int> GENERATED_SYMBOLIC_SAMPLES         = {1000, 10000};
+const vector<int> GENERATED_NUMERIC_SAMPLES_PER_CLASS = {250, 1000};
+const vector<int> GENERATED_MIXED_SAMPLES            = {2000};
+
+// Layouts of the compiled trees, with the suffix of their benchmark names
+const vector<pair<NodeLayout, string>> NODE_LAYOUTS = {
+    {  NodeLayout::DEPTH_FIRST,               ""},
+    {NodeLayout::BREADTH_FIRST, "/breadth_first"},
+    {NodeLayout::VAN_EMDE_BOAS, "/van_emde_boas"},
+    {     NodeLayout::HOT_PATH,      "/hot_path"}
+};
+
+// The synthetic tree for the layouts: a complete binary tree of this depth, the number of samples run through it, and
+// the power of a uniform draw that skews the samples towards the largest values
+const int SYNTHETIC_TREE_DEPTH   = 18;
+const int SYNTHETIC_TREE_SAMPLES = 100000;
+const double SYNTHETIC_TREE_SKEW = 12.0;
+
+// Numbers of trees of the scored forests, with the suffix of their benchmark names
+const vector<pair<int, string>> FOREST_SIZES = {
+    { 10,           ""},
+    {200, "/200_trees"}
+};
+
+vector<Dataset> makeDatasets()
+{
+    const string resources = DTPP_RESOURCE_DIR;
+    vector<Dataset> datasets;
+
+    datasets.push_back({"stage3cancer",
+                        {{"training_datafile", resources + "/stage3cancer.csv"},
+                         {"csv_class_column_index", "2"},
+                         {"csv_columns_for_features", {3, 4, 5, 6, 7, 8}},
+                         {"max_depth_desired", "8"},
+                         {"entropy_threshold", "0.01"}},
+                        true});
+    datasets.push_back({"training_symbolic_large1",
+                        {{"training_datafile", resources + "/training_symbolic_large1.csv"},
+                         {"csv_class_column_index", "1"},
+                         {"csv_columns_for_features", {2, 3, 4, 5}},
+                         {"max_depth_desired", "5"},
+                         {"entropy_threshold", "0.1"}},
+                        false});
+
+    // Generate the larger datasets from the shipped parameter files
+    std::filesystem::path outputDir = std::filesystem::temp_directory_path() / "dtpp-benchmarks";
+    std::filesystem::create_directories(outputDir);
+
+    for (int numSamples : GENERATED_SYMBOLIC_SAMPLES) {
+        string outputFile = (outputDir / ("symbolic_" + std::to_string(numSamples) + ".csv")).string();
+        TrainingDataGeneratorSymbolic generator({
+            {           "output_datafile",                       outputFile},
+            {            "parameter_file", resources + "/param_symbolic.txt"},
+            {"number_of_training_samples",         std::to_string(numSamples)},
+            {             "write_to_file",                               "1"}
+        });
+        generator.ReadParameterFileSymbolic();
+        generator.GenerateTrainingDataSymbolic();
+        generator.WriteTrainingDataToFile();
+
+        datasets.push_back({"symbolic_" + std::to_string(numSamples),
+                            {{"training_datafile", outputFile},
+                             {"csv_class_column_index", "1"},
+                             {"csv_columns_for_features", {2, 3, 4, 5}},
+                             {"max_depth_desired", "5"},
+                             {"entropy_threshold", "0.1"}},
+                            false});
+    }
+
+    for (int numSamplesPerClass : GENERATED_NUMERIC_SAMPLES_PER_CLASS) {
+        string outputFile = (outputDir / ("numeric_" + std::to_string(numSamplesPerClass) + ".csv")).string();
+        TrainingDataGeneratorNumeric generator({
+            {            "output_csv_file",                        outputFile},
+            {             "parameter_file", resources + "/param_numeric.txt"},
+            {"number_of_samples_per_class", std::to_string(numSamplesPerClass)}
+        });
+        generator.ReadParameterFileNumeric();
+        generator.GenerateTrainingDataNumeric();
+
+        datasets.push_back({"numeric_" + std::to_string(2 * numSamplesPerClass),
+                            {{"training_datafile", outputFile},
+                             {"csv_class_column_index", "1"},
+                             {"csv_columns_for_features", {2, 3}},
+                             {"max_depth_desired", "5"},
+                             {"entropy_threshold", "0.01"}},
+                            false});
+    }
+
+    for (int numSamples : GENERATED_MIXED_SAMPLES) {
+        string outputFile = (outputDir / ("mixed_" + std::to_string(numSamples) + ".csv")).string();
+        BenchmarkDataGenerator generator({
+            {            "output_datafile",                 outputFile},
+            {          "number_of_samples", std::to_string(numSamples)},
+            { "number_of_numeric_features",                        "4"},
+            {"number_of_symbolic_features",                        "4"},
+            {                       "seed",                        "0"}
+        });
+        generator.GenerateBenchmarkData();
+
+        datasets.push_back({"mixed_" + std::to_string(numSamples),
+                            {{"training_datafile", outputFile},
+                             {"csv_class_column_index", "1"},
+                             {"csv_columns_for_features", generator.getCsvColumnsForFeatures()},
+                             {"max_depth_desired", "5"},
+                             {"entropy_threshold", "0.01"}},
+                            false});
+    }
+
+    return datasets;
+}
+
+
+//--------------- Helpers ----------------//
+
+// Discards what the library prints to cout while in scope, without touching the benchmark reporters
+struct SilenceCout {
+    std::ostringstream sink;
+    std::streambuf* original;
+
+    SilenceCout() : original(std::cout.rdbuf(sink.rdbuf())) {}
+    ~SilenceCout() { std::cout.rdbuf(original); }
+};
+
+shared_ptr<DecisionTree> loadTree(const Dataset &dataset)
+{
+    auto dt = make_shared<DecisionTree>(dataset.kwargs);
+    dt->getTrainingData();
+    dt->calculateFirstOrderProbabilities();
+    dt->calculateClassPriors();
+    return dt;
+}
+
+// Trees are constructed once per dataset and shared by the benchmarks that only read them
+shared_ptr<DecisionTree> constructedTree(const Dataset &dataset)
+{
+    static map<string, shared_ptr<DecisionTree>> trees;
+
+    auto it = trees.find(dataset.name);
+    if (it == trees.end()) {
+        SilenceCout silence;
+        auto dt = loadTree(dataset);
+        dt->constructDecisionTreeClassifier();
+        it = trees.emplace(dataset.name, dt).first;
+    }
+
+    return it->second;
+}
+
+// Forests are trained once per dataset and size and shared by the ensemble scoring benchmarks
+shared_ptr<DecisionForest> fittedForest(const Dataset &dataset, int numTrees)
+{
+    static map<pair<string, int>, shared_ptr<DecisionForest>> forests;
+
+    auto it = forests.find({dataset.name, numTrees});
+    if (it == forests.end()) {
+        SilenceCout silence;
+        map<string, string> kwargs = dataset.kwargs;
+        kwargs["number_of_trees"]  = std::to_string(numTrees);
+        kwargs["seed"]             = "1";
+        auto forest                = make_shared<DecisionForest>(kwargs);
+        forest->fit();
+        it = forests.emplace(std::make_pair(dataset.name, numTrees), forest).first;
+    }
+
+    return it->second;
+}
+
+// Splits the values [begin, end) of the feature x of the synthetic tree in half below a node, down to the leaves
+void growSyntheticSubtree(const shared_ptr<DecisionTree> &dt, DecisionTreeNode* node, int begin, int end, int depth)
+{
+    if (depth == SYNTHETIC_TREE_DEPTH) {
+        return;
+    }
+
+    const int middle = begin + (end - begin) / 2;
+
+    const vector<tuple<string, int, int>> children = {
+        {"x<" + std::to_string(middle - 1), begin, middle},
+        {"x>" + std::to_string(middle - 1), middle, end}
+    };
+    node->SetFeature("x");
+    for (const auto &[test, childBegin, childEnd] : children) {
+        vector<string> branch = node->GetBranchFeaturesAndValuesOrThresholds();
+        branch.push_back(test);
+        const double share = (childBegin + childEnd) / 2.0 / (1 << SYNTHETIC_TREE_DEPTH);
+        auto child         = make_unique<DecisionTreeNode>(
+            "", 0.0, vector<double>{share, 1.0 - share}, branch, dt, false);
+        growSyntheticSubtree(dt, child.get(), childBegin, childEnd, depth + 1);
+        node->AddChildLink(std::move(child));
+    }
+}
+
+/*
+ * A complete binary tree on one numeric feature, far larger than the trees grown from the datasets, with training
+ * samples that mostly take the '>' branches. DEPTH_FIRST lays out the subtree of the '>' child of a node after the
+ * whole subtree of its '<' child, so the hot paths jump across the node array, while HOT_PATH keeps them together.
+ */
+shared_ptr<DecisionTree> syntheticDeepTree()
+{
+    static shared_ptr<DecisionTree> dt;
+    if (dt) {
+        return dt;
+    }
+
+    dt = make_shared<DecisionTree>(map<string, string>{
+        {"training_datafile", "synthetic.csv"}
+    });
+    dt->_featureNames                             = {"x"};
+    dt->_classNames                               = {"low", "high"};
+    dt->_probDistributionNumericFeaturesDict["x"] = {};
+
+    const int numValues = 1 << SYNTHETIC_TREE_DEPTH;
+    auto root           = make_unique<DecisionTreeNode>("", 0.0, vector<double>{0.5, 0.5}, vector<string>{}, dt, true);
+    growSyntheticSubtree(dt, root.get(), 0, numValues, 0);
+    dt->setRootNode(std::move(root));
+
+    Philox4x32 rng(0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (int sample = 0; sample < SYNTHETIC_TREE_SAMPLES; sample++) {
+        const double u                = uniform(rng);
+        const int value               = numValues - 1 - static_cast<int>(numValues * std::pow(u, SYNTHETIC_TREE_SKEW));
+        dt->_trainingDataDict[sample] = {std::to_string(value)};
+    }
+    return dt;
+}
+
+// The training samples of a forest's data as the arrays taken by predictProba(), with NA as NaN
+void encodedTrainingData(const DecisionForest &forest, vector<double> &numericValues, vector<int> &symbolicCodes)
+{
+    for (const auto &[sample, values] : forest.getData()->_trainingDataDict) {
+        forest.getCompiledTrees().front().encodeRow(values, numericValues, symbolicCodes);
+    }
+}
+
+// The training samples of a dataset in the "feature=value" form taken by classify(), without missing values
+vector<vector<string>> classifiableSamples(const shared_ptr<DecisionTree> &dt)
+{
+    vector<vector<string>> samples;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        if (std::find(values.begin(), values.end(), "NA") != values.end()) {
+            continue;
+        }
+
+        vector<string> featuresAndValues;
+        for (size_t i = 0; i < values.size(); i++) {
+            featuresAndValues.push_back(dt->_featureNames[i] + "=" + values[i]);
+        }
+        samples.push_back(featuresAndValues);
+    }
+    return samples;
+}
+
+
+//--------------- Benchmarks ----------------//
+
+void BM_GetTrainingData(benchmark::State &state, const Dataset &dataset)
+{
+    for (auto _ : state) {
+        SilenceCout silence;
+        auto dt = make_shared<DecisionTree>(dataset.kwargs);
+        dt->getTrainingData();
+        benchmark::DoNotOptimize(dt->_trainingDataDict.size());
+    }
+}
+
+void BM_CalculateFirstOrderProbabilities(benchmark::State &state, const Dataset &dataset)
+{
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto dt = make_shared<DecisionTree>(dataset.kwargs);
+        dt->getTrainingData();
+        state.ResumeTiming();
+
+        SilenceCout silence;
+        dt->calculateFirstOrderProbabilities();
+    }
+}
+
+void BM_ConstructDecisionTreeClassifier(benchmark::State &state, const Dataset &dataset)
+{
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto dt = loadTree(dataset);
+        state.ResumeTiming();
+
+        SilenceCout silence;
+        benchmark::DoNotOptimize(dt->constructDecisionTreeClassifier());
+    }
+}
+
+void BM_ClassifySingle(benchmark::State &state, const Dataset &dataset)
+{
+    auto dt                        = constructedTree(dataset);
+    vector<vector<string>> samples = classifiableSamples(dt);
+    size_t next                    = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dt->classify(dt->getRootNode(), samples[next]));
+        next = (next + 1) % samples.size();
+    }
+}
+
+void BM_ClassifyBatch(benchmark::State &state, const Dataset &dataset)
+{
+    auto dt                        = constructedTree(dataset);
+    vector<vector<string>> samples = classifiableSamples(dt);
+
+    for (auto _ : state) {
+        for (const auto &sample : samples) {
+            benchmark::DoNotOptimize(dt->classify(dt->getRootNode(), sample));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+
+void BM_PredictProbaBatch(benchmark::State &state, const Dataset &dataset, NodeLayout layout)
+{
+    auto dt = constructedTree(dataset);
+    CompiledDecisionTree compiled(dt, layout);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        compiled.encodeRow(values, numericValues, symbolicCodes);
+    }
+
+    const size_t numRows = dt->_trainingDataDict.size();
+    vector<double> probabilities(numRows * compiled.getNumClasses());
+
+    for (auto _ : state) {
+        compiled.predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+        benchmark::DoNotOptimize(probabilities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numRows);
+}
+
+void BM_PredictProbaSyntheticDeepTree(benchmark::State &state, NodeLayout layout)
+{
+    auto dt = syntheticDeepTree();
+    CompiledDecisionTree compiled(dt, layout);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        compiled.encodeRow(values, numericValues, symbolicCodes);
+    }
+
+    const size_t numRows = dt->_trainingDataDict.size();
+    vector<double> probabilities(numRows * compiled.getNumClasses());
+
+    for (auto _ : state) {
+        compiled.predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+        benchmark::DoNotOptimize(probabilities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numRows);
+}
+
+// The compiled tree emitted as C++ and built by the system compiler; the build is not timed
+void BM_NativePredictProbaBatch(benchmark::State &state, const Dataset &dataset)
+{
+    auto dt = constructedTree(dataset);
+    TreeCodeGenerator generator(dt);
+    shared_ptr<NativeDecisionTree> native;
+    try {
+        native = generator.compileAndLoad();
+    }
+    catch (const std::runtime_error &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    const CompiledDecisionTree &compiled = generator.getCompiledTree();
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        compiled.encodeRow(values, numericValues, symbolicCodes);
+    }
+
+    const size_t numRows = dt->_trainingDataDict.size();
+    vector<double> probabilities(numRows * native->getNumClasses());
+
+    for (auto _ : state) {
+        native->predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+        benchmark::DoNotOptimize(probabilities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numRows);
+}
+
+void BM_ForestPredictProbaBatch(benchmark::State &state, const Dataset &dataset, int numTrees)
+{
+    auto forest = fittedForest(dataset, numTrees);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    encodedTrainingData(*forest, numericValues, symbolicCodes);
+    const size_t numRows = numericValues.size() / forest->getNumFeatures();
+    vector<double> probabilities(numRows * forest->getNumClasses());
+
+    for (auto _ : state) {
+        forest->predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+        benchmark::DoNotOptimize(probabilities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numRows);
+}
+
+void BM_QuickScorerPredictProbaBatch(benchmark::State &state, const Dataset &dataset, int numTrees)
+{
+    auto forest = fittedForest(dataset, numTrees);
+    QuickScorer scorer(*forest);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    encodedTrainingData(*forest, numericValues, symbolicCodes);
+    const size_t numRows = numericValues.size() / forest->getNumFeatures();
+    vector<double> probabilities(numRows * scorer.getNumClasses());
+
+    for (auto _ : state) {
+        scorer.predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+        benchmark::DoNotOptimize(probabilities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * numRows);
+}
+
+void BM_EvaluateTrainingData(benchmark::State &state, const Dataset &dataset)
+{
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto evalData = make_shared<EvalTrainingData>(dataset.kwargs);
+        {
+            SilenceCout silence;
+            evalData->getTrainingData();
+        }
+        state.ResumeTiming();
+
+        SilenceCout silence;
+        benchmark::DoNotOptimize(evalData->evaluateTrainingData());
+    }
+}
+
+void BM_IntrospectionInitialize(benchmark::State &state, const Dataset &dataset)
+{
+    auto dt = constructedTree(dataset);
+
+    for (auto _ : state) {
+        auto dtI = make_shared<DTIntrospection>(dt);
+        dtI->initialize();
+        benchmark::DoNotOptimize(dtI->getSamplesAtNodesDict().size());
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    // The datasets must outlive the benchmarks that refer to them
+    static const vector<Dataset> datasets = [] {
+        SilenceCout silence;
+        return makeDatasets();
+    }();
+
+    for (const auto &dataset : datasets) {
+        benchmark::RegisterBenchmark(("GetTrainingData/" + dataset.name).c_str(), BM_GetTrainingData, dataset)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("CalculateFirstOrderProbabilities/" + dataset.name).c_str(),
+                                     BM_CalculateFirstOrderProbabilities,
+                                     dataset)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(
+            ("ConstructDecisionTreeClassifier/" + dataset.name).c_str(), BM_ConstructDecisionTreeClassifier, dataset)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("ClassifySingle/" + dataset.name).c_str(), BM_ClassifySingle, dataset)
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("ClassifyBatch/" + dataset.name).c_str(), BM_ClassifyBatch, dataset)
+            ->Unit(benchmark::kMillisecond);
+        for (const auto &[layout, suffix] : NODE_LAYOUTS) {
+            benchmark::RegisterBenchmark(
+                ("PredictProbaBatch/" + dataset.name + suffix).c_str(), BM_PredictProbaBatch, dataset, layout)
+                ->Unit(benchmark::kMicrosecond);
+        }
+        benchmark::RegisterBenchmark(
+            ("NativePredictProbaBatch/" + dataset.name).c_str(), BM_NativePredictProbaBatch, dataset)
+            ->Unit(benchmark::kMicrosecond);
+        for (const auto &[numTrees, suffix] : FOREST_SIZES) {
+            benchmark::RegisterBenchmark(("ForestPredictProbaBatch/" + dataset.name + suffix).c_str(),
+                                         BM_ForestPredictProbaBatch,
+                                         dataset,
+                                         numTrees)
+                ->Unit(benchmark::kMicrosecond);
+            benchmark::RegisterBenchmark(("QuickScorerPredictProbaBatch/" + dataset.name + suffix).c_str(),
+                                         BM_QuickScorerPredictProbaBatch,
+                                         dataset,
+                                         numTrees)
+                ->Unit(benchmark::kMicrosecond);
+        }
+        benchmark::RegisterBenchmark(
+            ("IntrospectionInitialize/" + dataset.name).c_str(), BM_IntrospectionInitialize, dataset)
+            ->Unit(benchmark::kMillisecond);
+
+        if (dataset.crossValidate) {
+            benchmark::RegisterBenchmark(
+                ("EvaluateTrainingData/" + dataset.name).c_str(), BM_EvaluateTrainingData, dataset)
+                ->Unit(benchmark::kMillisecond);
+        }
+    }
+
+    for (const auto &[layout, suffix] : NODE_LAYOUTS) {
+        benchmark::RegisterBenchmark(
+            ("PredictProbaBatch/synthetic_deep" + suffix).c_str(), BM_PredictProbaSyntheticDeepTree, layout)
+            ->Unit(benchmark::kMicrosecond);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
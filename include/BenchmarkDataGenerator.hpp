@@ -0,0 +1,68 @@
+#ifndef BENCHMARK_DATA_GENERATOR_HPP
+#define BENCHMARK_DATA_GENERATOR_HPP
+
+// Include
+#include "Common.hpp"
+
+#include <cstdint>
+#include <random>
+
+/**
+ * @class BenchmarkDataGenerator
+ * @brief A class to generate large training data sets with mixed numeric and symbolic features.
+ *
+ * Unlike TrainingDataGeneratorNumeric and TrainingDataGeneratorSymbolic, which model the small data sets described by
+ * a parameter file, this generator is meant for stress-testing training at scale. The class-conditional distributions
+ * are drawn from the seed: each numeric feature is normal with a class-dependent mean and unit variance, and each
+ * symbolic feature has a class-dependent distribution over its values.
+ *
+ * Rows are generated in blocks, each with its own random stream derived from the seed and the block number, and the
+ * blocks are formatted on several threads and written in order. Memory use depends on the block size and the number
+ * of threads but not on the number of samples, and the output depends only on the seed.
+ *
+ * The output is a CSV file in the layout read by DecisionTree::getTrainingData(): a sample ID column, the class
+ * column (class labels are integers, as EvalTrainingData requires), the numeric features and then the symbolic
+ * features.
+ */
+class BenchmarkDataGenerator {
+  private:
+    // Attributes
+    string _outputDatafile;
+    long long _numberOfSamples;
+    int _numberOfNumericFeatures;
+    int _numberOfSymbolicFeatures;
+    int _numberOfClasses;
+    int _numberOfSymbolicValues;
+    uint64_t _seed;
+    int _numberOfThreads;
+    int _blockSize;
+    int _debug;
+
+    // Class-conditional distributions, initialized in the constructor
+    vector<string> _featureNames;
+    vector<vector<double>> _numericMeans;                                               // [class][numeric feature]
+    vector<vector<std::discrete_distribution<int>::param_type>> _symbolicDistributions; // [class][symbolic feature]
+
+    void formatBlock(size_t block, string &text) const;
+
+  public:
+    BenchmarkDataGenerator(map<string, string> kwargs);
+    ~BenchmarkDataGenerator();
+
+    void GenerateBenchmarkData(); // Generate the data and write it to the output file
+
+    // Getters
+    string getOutputDatafile() const { return _outputDatafile; }
+    long long getNumberOfSamples() const { return _numberOfSamples; }
+    int getNumberOfNumericFeatures() const { return _numberOfNumericFeatures; }
+    int getNumberOfSymbolicFeatures() const { return _numberOfSymbolicFeatures; }
+    int getNumberOfClasses() const { return _numberOfClasses; }
+    int getNumberOfSymbolicValues() const { return _numberOfSymbolicValues; }
+    uint64_t getSeed() const { return _seed; }
+    int getNumberOfThreads() const { return _numberOfThreads; }
+    int getBlockSize() const { return _blockSize; }
+    const vector<string> &getFeatureNames() const { return _featureNames; }
+    string getCsvColumnsForFeatures() const;
+};
+
+#endif // BENCHMARK_DATA_GENERATOR_HPP
@@ -0,0 +1,124 @@
+#ifndef COMPILED_DECISION_TREE_HPP
+#define COMPILED_DECISION_TREE_HPP
+
+// Include
+#include "Common.hpp"
+#include "DecisionTree.hpp"
+#include "Kernels.hpp"
+#include "Utility.hpp"
+
+#include <cstddef>
+
+/**
+ * @struct CompiledNode
+ * @brief A node of a CompiledDecisionTree.
+ *
+ * The children of a node are stored next to each other in the node array of the compiled tree. The feature test on
+ * the branch leading to a node is stored with the node itself, so that choosing a child is a scan over the children of
+ * the current node.
+ */
+struct CompiledNode {
+    int serialNum;    // Serial number of the node in the DecisionTree
+    int featureIndex; // Index of the feature tested at the node, -1 at a leaf
+    int firstChild;   // Index of the first child in the node array
+    int numChildren;  // Number of children
+    char op;          // Test on the branch leading to the node: '<', '>' or '=', and 0 at the root
+    int code;         // Symbolic value code for '=' tests, -1 if the value is not in the training data
+    double value;     // Threshold for '<' and '>' tests, numeric value for '=' tests (NaN if not numeric)
+};
+
+
+/**
+ * @enum NodeLayout
+ * @brief The order of the nodes in the node array of a CompiledDecisionTree.
+ *
+ * The children of a node always form one block in their original order, so the layouts order the blocks:
+ * - DEPTH_FIRST: the block of a node's children right after the blocks of its elder siblings' subtrees.
+ * - BREADTH_FIRST: level by level, so the top levels that every sample visits are packed together.
+ * - VAN_EMDE_BOAS: the top half of the levels first, then each subtree below them, recursively, so that a descent stays
+ *   within few cache lines at every scale without knowing the cache sizes.
+ * - HOT_PATH: depth first, taking the children by decreasing traffic, so that the blocks along the most travelled paths
+ *   follow each other in memory.
+ */
+enum class NodeLayout { DEPTH_FIRST, BREADTH_FIRST, VAN_EMDE_BOAS, HOT_PATH };
+
+
+/**
+ * @class CompiledDecisionTree
+ * @brief A flattened, read-only copy of a constructed DecisionTree for fast batch classification.
+ *
+ * DecisionTree::classify() takes one sample at a time as "feature=value" strings and parses every feature test on the
+ * way down the tree. A CompiledDecisionTree parses the feature tests once, stores the nodes contiguously and classifies
+ * rows of raw values: a row-major array of numeric values and, optionally, a row-major array of integer codes for the
+ * symbolic values. Column j of both arrays is the feature getFeatureNames()[j]. The code of a symbolic value is its
+ * index in getSymbolicValues()[feature], which lists the values seen in the training data in sorted order.
+ *
+ * The descent follows DecisionTree::classify(): a numeric value takes the '<' branch if it is less than or equal to the
+ * threshold and the '>' branch otherwise, and a sample whose value is missing (NaN or a negative code), or matches no
+ * child, gets the class probabilities of the node it has reached. A symbolic feature with a negative code falls back
+ * on the numeric array, so numeric-looking symbolic values such as grades can be given as numbers.
+ *
+ * The nodes can be reordered for the cache with relayout(), which changes neither the predictions nor the serial
+ * numbers returned by predictLeaf(). For HOT_PATH, the traffic through every node is counted by countTraffic() on
+ * sample rows, or on the training data when the tree is compiled with that layout.
+ *
+ * The compiled tree does not refer back to the DecisionTree, and all of its member functions but relayout() are const,
+ * so it can be used concurrently from several threads.
+ */
+class CompiledDecisionTree {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    CompiledDecisionTree(shared_ptr<DecisionTree> dt, NodeLayout layout = NodeLayout::DEPTH_FIRST);
+    ~CompiledDecisionTree();
+
+    //--------------- Layout ----------------//
+    template <typename T>
+    map<int, size_t> countTraffic(const T* numericValues, const int* symbolicCodes, size_t numRows) const;
+    void relayout(NodeLayout layout, const map<int, size_t> &traffic = {});
+
+    //--------------- Classify ----------------//
+    template <typename T>
+    void predictProba(const T* numericValues, const int* symbolicCodes, size_t numRows, double* probabilities) const;
+    vector<double> predictProba(const vector<double> &numericValues, const vector<int> &symbolicCodes) const;
+    int predictLeaf(const double* numericValues, const int* symbolicCodes) const;
+    int encodeSymbolicValue(const string &feature, const string &value) const;
+    void encodeRow(const vector<string> &values, vector<double> &numericValues, vector<int> &symbolicCodes) const;
+
+    //--------------- Getters ----------------//
+    const vector<string> &getFeatureNames() const { return _featureNames; }
+    const vector<string> &getClassNames() const { return _classNames; }
+    const map<string, vector<string>> &getSymbolicValues() const { return _symbolicValues; }
+    const vector<CompiledNode> &getNodes() const { return _nodes; }
+    const vector<double> &getClassProbabilities() const { return _classProbabilities; }
+    bool isNumericFeature(size_t featureIndex) const { return _featureIsNumeric[featureIndex]; }
+    size_t getNumFeatures() const { return _featureNames.size(); }
+    size_t getNumClasses() const { return _classNames.size(); }
+    size_t getNumNodes() const { return _nodes.size(); }
+    NodeLayout getLayout() const { return _layout; }
+
+  private:
+    static constexpr size_t PREDICT_BLOCK_SIZE = 1024;
+
+    void compileNode(DecisionTreeNode* node, int index);
+    template <typename T>
+    void predictProbaRows(
+        const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const;
+    template <typename T> int descend(const T* numericRow, const int* symbolicRow) const;
+    pair<int, int> blockRange(int parent) const;
+    size_t addSubtreeTraffic(int index, vector<size_t> &traffic) const;
+    void orderBlocksDepthFirst(int parent, const vector<size_t> &traffic, vector<int> &order) const;
+    void orderBlocksBreadthFirst(vector<int> &order) const;
+    void orderBlocksVanEmdeBoas(int parent, int height, vector<int> &order) const;
+    void blocksAtDepth(int parent, int depth, vector<int> &blocks) const;
+    int blockHeight(int parent) const;
+
+    vector<string> _featureNames;
+    vector<string> _classNames;
+    vector<bool> _featureIsNumeric;
+    map<string, vector<string>> _symbolicValues;
+    vector<CompiledNode> _nodes;
+    vector<double> _classProbabilities; // Row-major, one row of getNumClasses() probabilities per node
+    NodeLayout _layout;
+};
+
+#endif // COMPILED_DECISION_TREE_HPP
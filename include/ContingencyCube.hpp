@@ -0,0 +1,73 @@
+#ifndef CONTINGENCY_CUBE_HPP
+#define CONTINGENCY_CUBE_HPP
+
+// Include
+#include "Common.hpp"
+
+#include <cstdint>
+
+/**
+ * @class ContingencyCube
+ * @brief Dense counts of the training samples over every combination of the values of symbolic features and class.
+ *
+ * Axis i of the cube holds the codes of the values of feature i, which are their positions in the sorted list of its
+ * values, and the last axis holds the class, with one extra slot for samples without a class label. The cube is filled
+ * in one pass over the samples. A branch of the tree fixes the values of some of the features; the first time a
+ * branch is queried, one pass over its cells sums them into its marginals, the count of each value of every feature
+ * per class slot, which are kept. The counts of the branch, and of the branch with one more feature fixed, are then
+ * lookups.
+ *
+ * Queries take ANY for a feature or class that is not fixed. ANY as a class also counts the samples without a label.
+ */
+class ContingencyCube {
+  public:
+    static constexpr int ANY = -1;
+
+    /**
+     * @struct Marginals
+     * @brief The counts of the samples on a branch, per class slot, in total and for each value of every feature.
+     */
+    struct Marginals {
+        vector<vector<uint64_t>> valueCounts; // Per feature, the count of each value code in each class slot
+        vector<uint64_t> classTotals;         // The count of each class slot
+    };
+
+    ContingencyCube() = default;
+    ContingencyCube(vector<vector<string>> featureValues, size_t numClasses);
+
+    static size_t numCells(const vector<vector<string>> &featureValues, size_t numClasses);
+
+    //--------------- Filling ----------------//
+    void add(const vector<int> &valueCodes, int classIndex, uint32_t weight);
+
+    //--------------- Queries ----------------//
+    int valueCode(size_t feature, const string &value) const;
+    const Marginals &marginals(const vector<int> &valueCodes);
+    uint64_t count(const vector<int> &valueCodes, int classIndex);
+    uint64_t featureValueCount(size_t feature, int valueCode, int classIndex);
+    uint64_t classCount(int classIndex);
+
+    bool empty() const { return _counts.empty(); }
+    size_t getNumFeatures() const { return _featureValues.size(); }
+    size_t getNumClasses() const { return _numClasses; }
+    const vector<string> &getFeatureValues(size_t feature) const { return _featureValues[feature]; }
+
+    //--------------- Memory ----------------//
+    size_t bytes() const;
+    size_t branchMarginalsBytes() const { return _branchMarginalsBytes; }
+    void clearBranchMarginals();
+
+  private:
+    size_t classSlot(int classIndex) const { return classIndex < 0 ? _numClasses : static_cast<size_t>(classIndex); }
+    uint64_t slotCount(const uint64_t* slotCounts, int classIndex) const;
+    Marginals sumBranch(const vector<int> &valueCodes) const;
+
+    vector<vector<string>> _featureValues; // The sorted values of each feature; a value's code is its position
+    size_t _numClasses = 0;
+    vector<size_t> _strides;               // Stride of each feature axis; the class axis has stride 1
+    vector<uint32_t> _counts;              // The cube, with the class as the innermost axis
+    map<vector<int>, Marginals> _branchMarginals; // Per branch queried, as the code of every feature or ANY
+    size_t _branchMarginalsBytes = 0;             // Estimated bytes held by _branchMarginals
+};
+
+#endif // CONTINGENCY_CUBE_HPP
@@ -46,6 +46,24 @@ struct FeatureOpValue {
  * @method initialize
  * @brief Initializes the DTIntrospection object.
  *
+ * @method initializeLazy
+ * @brief Initializes the DTIntrospection object without materializing any per-node or per-sample information.
+ *
+ * @method getSamplesAtNode
+ * @brief Lazily computes and memoizes the samples at a node.
+ * @param nodeSerialNum The serial number of the node.
+ * @return A const reference to the sorted sample IDs at the node.
+ *
+ * @method getBranchFeaturesAtNode
+ * @brief Lazily memoizes the branch features and values or thresholds leading to a node.
+ * @param nodeSerialNum The serial number of the node.
+ * @return A const reference to the branch feature strings.
+ *
+ * @method getNodePathForSample
+ * @brief Lazily computes and memoizes the nodes a sample falls into.
+ * @param sample The sample ID.
+ * @return A const reference to the node serial numbers in the order of descent.
+ *
  * @method recursiveDescent
  * @brief Recursively descends through the decision tree starting from a given node.
  * @param node A pointer to the starting DecisionTreeNode.
@@ -118,6 +136,12 @@ struct FeatureOpValue {
  * @var _nodeSerialNumToNodeDict
  * @brief A dictionary mapping node serial numbers to nodes.
  *
+ * @var _lazySamplesAtNodesDict
+ * @brief Memoized samples at the nodes queried through getSamplesAtNode().
+ *
+ * @var _lazyNodePathsForSamplesDict
+ * @brief Memoized node paths for the samples queried through getNodePathForSample().
+ *
  * @var _awarenessRaisingMessageShown
  * @brief An integer indicating if an awareness-raising message has been shown.
  *
@@ -132,11 +156,14 @@ class DTIntrospection : public std::enable_shared_from_this<DTIntrospection> {
     DTIntrospection(shared_ptr<DecisionTree> dt);
     ~DTIntrospection();
     void initialize();
+    void initializeLazy();
 
     //--------------- Recursive Descent ----------------//
     void recursiveDescent(DecisionTreeNode* node);
     void recursiveDescentForShowingSamplesAtANode(DecisionTreeNode* node);
-    void recursiveDescentForSampleToNodeInfluence(int nodeSerialNum, vector<int> nodesAlreadyAccountedFor, int offset);
+    void recursiveDescentForSampleToNodeInfluence(int nodeSerialNum,
+                                                  const vector<int> &nodesAlreadyAccountedFor,
+                                                  int offset);
 
     //--------------- Display ----------------//
     void displayTrainingSamplesAtAllNodesDirectInfluenceOnly();
@@ -146,23 +173,35 @@ class DTIntrospection : public std::enable_shared_from_this<DTIntrospection> {
     void explainClassificationsAtMultipleNodesInteractively();
     void explainClassificationAtOneNode(int nodeID);
 
+    //--------------- Lazy Queries ----------------//
+    const vector<int> &getSamplesAtNode(int nodeSerialNum);
+    const vector<string> &getBranchFeaturesAtNode(int nodeSerialNum);
+    const vector<int> &getNodePathForSample(int sample);
+
     //--------------- Class Utility ----------------//
     vector<int> getSamplesForFeatureValueCombo(string featureValueCombo);
     FeatureOpValue extractFeatureOpValue(string featureValueCombo);
+    bool sampleSatisfiesFeatureValueCombo(const vector<string> &featureValues, const FeatureOpValue &featureOpValue);
 
     //--------------- Getters ----------------//
-    map<int, vector<string>> getSamplesAtNodesDict() const { return _samplesAtNodesDict; }
-    map<int, vector<string>> getBranchFeaturesToNodesDict() const { return _branchFeaturesToNodesDict; }
-    map<string, vector<int>> getSampleToNodeMappingDirectDict() const { return _sampleToNodeMappingDirectDict; }
-    map<int, DecisionTreeNode*> getNodeSerialNumToNodeDict() const { return _nodeSerialNumToNodeDict; }
+    const map<int, vector<string>> &getSamplesAtNodesDict() const { return _samplesAtNodesDict; }
+    const map<int, vector<string>> &getBranchFeaturesToNodesDict() const { return _branchFeaturesToNodesDict; }
+    const map<string, vector<int>> &getSampleToNodeMappingDirectDict() const { return _sampleToNodeMappingDirectDict; }
+    const map<int, DecisionTreeNode*> &getNodeSerialNumToNodeDict() const { return _nodeSerialNumToNodeDict; }
 
   private:
+    DecisionTreeNode* findNode(int nodeSerialNum);
+    vector<int> samplesFromRoutingIndex(int nodeSerialNum) const;
+    void indexNodes(DecisionTreeNode* node);
+
     shared_ptr<DecisionTree> _dt;
     DecisionTreeNode* _rootNode;
     map<int, vector<string>> _samplesAtNodesDict;
     map<int, vector<string>> _branchFeaturesToNodesDict;
     map<string, vector<int>> _sampleToNodeMappingDirectDict;
     map<int, DecisionTreeNode*> _nodeSerialNumToNodeDict;
+    map<int, vector<int>> _lazySamplesAtNodesDict;
+    map<int, vector<int>> _lazyNodePathsForSamplesDict;
     int _awarenessRaisingMessageShown;
     int _debug;
 };
@@ -0,0 +1,77 @@
+#ifndef DECISION_FOREST_HPP
+#define DECISION_FOREST_HPP
+
+// Include
+#include "Common.hpp"
+#include "CompiledDecisionTree.hpp"
+#include "DecisionTree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class DecisionForest
+ * @brief A bagged random forest of decision trees that share one copy of the training data.
+ *
+ * The training data is read, typed and compacted into weighted rows once, by a DecisionTree that holds it. Each tree
+ * of the forest is then trained on a bootstrap sample of that data, given as a weight per weighted row (the number of
+ * times its samples were drawn) rather than as a copy of the rows, and draws features_per_node features at random to
+ * compete at every node. The trees are trained concurrently, and each is compiled into a CompiledDecisionTree.
+ *
+ * The bootstrap sample and the feature draws of tree t come from stream t of the forest's seed, so the forest depends
+ * only on the seed and not on the number of threads.
+ *
+ * Batch prediction takes the same arrays as CompiledDecisionTree::predictProba() and averages the class probabilities
+ * of the trees. Rows are scored in blocks, every tree in turn, so that a block stays in cache while it passes through
+ * the whole forest.
+ */
+class DecisionForest {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    DecisionForest(map<string, string> kwargs);
+    ~DecisionForest();
+
+    //--------------- Training ----------------//
+    void fit();
+
+    //--------------- Classify ----------------//
+    template <typename T>
+    void predictProba(const T* numericValues, const int* symbolicCodes, size_t numRows, double* probabilities) const;
+    vector<double> predictProba(const vector<double> &numericValues, const vector<int> &symbolicCodes) const;
+    map<string, double> classify(const vector<string> &featuresAndValues) const;
+    int encodeSymbolicValue(const string &feature, const string &value) const;
+
+    //--------------- Getters ----------------//
+    shared_ptr<DecisionTree> getData() const { return _data; }
+    const vector<shared_ptr<DecisionTree>> &getTrees() const { return _trees; }
+    const vector<CompiledDecisionTree> &getCompiledTrees() const { return _compiledTrees; }
+    size_t getNumTrees() const { return _trees.size(); }
+    int getNumberOfTrees() const { return _numberOfTrees; }
+    int getNumberOfThreads() const { return _numberOfThreads; }
+    int getFeaturesPerNode() const { return _featuresPerNode; }
+    uint64_t getSeed() const { return _seed; }
+    const vector<string> &getFeatureNames() const { return _data->_featureNames; }
+    const vector<string> &getClassNames() const { return _data->_classNames; }
+    size_t getNumFeatures() const { return _data->_featureNames.size(); }
+    size_t getNumClasses() const { return _data->_classNames.size(); }
+
+  private:
+    static constexpr size_t PREDICT_BLOCK_SIZE = 1024;
+
+    vector<int> bootstrapRowWeights(Philox4x32 &rng, const vector<size_t> &cumulativeWeights) const;
+    template <typename T>
+    void predictProbaRows(
+        const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const;
+
+    map<string, string> _treeKwargs; // The keywords passed on to every tree
+    int _numberOfTrees;
+    int _numberOfThreads;
+    int _featuresPerNode; // 0 draws the ceiling of the square root of the number of features
+    uint64_t _seed;
+
+    shared_ptr<DecisionTree> _data; // Holds the training data that every tree's weighted rows point into
+    vector<shared_ptr<DecisionTree>> _trees;
+    vector<CompiledDecisionTree> _compiledTrees;
+};
+
+#endif // DECISION_FOREST_HPP
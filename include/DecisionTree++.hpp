@@ -1,10 +1,19 @@
 #pragma once
 
+#include "BenchmarkDataGenerator.hpp"
 #include "Common.hpp"
+#include "CompiledDecisionTree.hpp"
 #include "DTIntrospection.hpp"
+#include "DecisionForest.hpp"
 #include "DecisionTree.hpp"
 #include "DecisionTreeNode.hpp"
 #include "EvalTrainingData.hpp"
+#include "Instrumentation.hpp"
+#include "Logger.hpp"
+#include "QuickScorer.hpp"
+#include "Random.hpp"
 #include "TrainingDataGeneratorNumeric.hpp"
 #include "TrainingDataGeneratorSymbolic.hpp"
+#include "TreeCodeGenerator.hpp"
+#include "TreePruner.hpp"
 #include "Utility.hpp"
\ No newline at end of file
@@ -3,9 +3,14 @@
 
 // Include
 #include "Common.hpp"
+#include "ContingencyCube.hpp"
 #include "DecisionTreeNode.hpp"
+#include "Instrumentation.hpp"
+#include "Logger.hpp"
+#include "Random.hpp"
 #include "Utility.hpp"
 
+#include <functional>
 #include <iostream>
 #include <memory>
 
@@ -39,6 +44,49 @@ struct BestFeatureResult {
 };
 
 
+/**
+ * @struct RoutingIndex
+ * @brief Records where every training sample ends up in a constructed decision tree.
+ *
+ * The samples are stored in a single permuted array in which the samples of every node occupy a contiguous range,
+ * with the ranges of the children nested inside that of their parent. A sample that satisfies none of the feature
+ * tests of the children of a node stays in the tail of that node's range, and that node is then its leaf.
+ *
+ * The nodes are looked up by serial number and the samples by ID in vectors indexed by them. Serial numbers that are
+ * not in the tree, such as those of pruned nodes, have the range {-1, -1} and the parent -1, as the root has, and IDs
+ * between those of the training samples have the leaf -1.
+ */
+struct RoutingIndex {
+    vector<int> permutedSamples;          // Sample IDs grouped by node
+    vector<pair<int, int>> nodeRowRanges; // Node serial number -> [begin, end) in permutedSamples
+    vector<int> parentNodes;              // Node serial number -> serial number of its parent
+    int firstSample = 0;                  // The smallest sample ID
+    vector<int> sampleToLeaf;             // Sample ID - firstSample -> serial number of the deepest node containing it
+};
+
+
+/**
+ * @struct WeightedRow
+ * @brief A distinct combination of feature values and class in the training data, with the number of samples that
+ * have it.
+ */
+struct WeightedRow {
+    int sample;                   // ID of the first sample with these values and class, which stands for the others
+    int classIndex;               // Index of the class in _classNames, or -1 for a sample without a class label
+    int weight;                   // Number of samples with these values and class
+    const vector<string>* values; // The feature values, owned by the training data the row was compacted from
+    const double* numericValues;  // The feature values parsed as numbers, NaN where not a number, owned likewise
+};
+
+
+/**
+ * @enum FeatureType
+ * @brief How a feature is modeled. A NUMERIC feature is split at thresholds, using a histogram estimate of its
+ * distribution; a SYMBOLIC feature branches on each of its values, even if they are numbers.
+ */
+enum class FeatureType { NUMERIC, SYMBOLIC };
+
+
 class DecisionTreeNode;
 
 
@@ -66,13 +114,33 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     //--------------- Class Functions ----------------//
     void getTrainingData();
     void calculateFirstOrderProbabilities();
+    DecisionTreeNode* fit();
     void showTrainingData() const;
 
+    //--------------- Schema ----------------//
+    void inferFeatureTypes();
+    bool isNumericFeature(const string &feature) const;
+    const map<string, FeatureType> &getFeatureTypes() const { return _featureTypes; }
+    void setFeatureTypes(const map<string, FeatureType> &featureTypes) { _declaredFeatureTypes = featureTypes; }
+
+    //--------------- Row Compaction ----------------//
+    void compactTrainingData();
+    const vector<WeightedRow> &getWeightedRows();
+    void bindTrainingData(const DecisionTree &source, const vector<int> &rowWeights);
+    pair<map<string, size_t>, size_t> countFeatureValues(const string &feature, const optional<string> &className);
+    pair<vector<size_t>, size_t> countClassSamples();
+    vector<double> gatherNumericValues(const string &feature);
+
+    //--------------- Contingency Cube ----------------//
+    void buildContingencyCube();
+    bool hasContingencyCube() const { return !_contingencyCube.empty(); }
+    const ContingencyCube &getContingencyCube() const { return _contingencyCube; }
+
     //--------------- Classify ----------------//
-    map<string, string> classify(DecisionTreeNode* rootNode, const vector<string> &featuresAndValues);
-    void recursiveDescentForClassification(DecisionTreeNode* node,
+    map<string, string> classify(DecisionTreeNode* rootNode, const vector<string> &featuresAndValues) const;
+    void recursiveDescentForClassification(const DecisionTreeNode* node,
                                            const vector<string> &featureAndValues,
-                                           ClassificationAnswer &answer);
+                                           ClassificationAnswer &answer) const;
     ClassificationAnswer classifyByAskingQuestions(DecisionTreeNode* rootNode);
     void interactiveRecursiveDescentForClassification(DecisionTreeNode* node,
                                                       ClassificationAnswer &answer,
@@ -84,6 +152,44 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     BestFeatureResult bestFeatureCalculator(const vector<string> &featuresAndValuesOrThresholdsOnBranch,
                                             double existingNodeEntropy);
 
+    //--------------- Routing Index ----------------//
+    void buildRoutingIndex();
+    void partitionSamplesAtNode(DecisionTreeNode* node, int begin, int end);
+    std::function<bool(const vector<string> &)> featureTestPredicate(const string &featureTest) const;
+    tuple<size_t, char, string> parseFeatureTest(const string &featureTest) const;
+    int countSamplesOnBranch(const vector<string> &featuresAndValuesOrThresholds);
+    bool hasRoutingIndex() const { return !_routingIndex.nodeRowRanges.empty(); }
+    const RoutingIndex &getRoutingIndex() const { return _routingIndex; }
+
+    //--------------- Truncation ----------------//
+    bool survivesTruncation(const DecisionTreeNode* parent,
+                            const DecisionTreeNode* child,
+                            double entropyThreshold,
+                            int maxDepthDesired) const;
+    int countNodesAfterTruncation(double entropyThreshold, int maxDepthDesired) const;
+    void truncate(double entropyThreshold, int maxDepthDesired);
+
+    //--------------- Instrumentation ----------------//
+    TrainingStats getStats() const;
+    void resetStats() { _stats = TrainingStats(); }
+    optional<double> cachedProbability(const string &key);
+    optional<double> cachedEntropy(const string &key);
+    void setTracing(bool enabled) { _trace.setEnabled(enabled); }
+    const TraceRecorder &getTrace() const { return _trace; }
+    void writeChromeTrace(const string &filename) const { _trace.writeChromeTrace(filename); }
+    void setLogger(shared_ptr<Logger> logger) { _logger = std::move(logger); }
+    shared_ptr<Logger> getLogger() const { return _logger; }
+    Logger &debugLogger();
+
+    //--------------- Memory Accounting ----------------//
+    MemoryUsage getMemoryUsage() const;
+    void storeProbability(const string &key, double value);
+    void storeEntropy(const string &key, double value);
+    void clearCaches();
+    void recordNode(const DecisionTreeNode &node);
+    void forgetSubtree(const DecisionTreeNode &node);
+    void enforceMemoryBudget();
+
     //--------------- Entropy Calculators ----------------//
     double classEntropyOnPriors();
     void entropyScannerForANumericFeature(const string &feature);
@@ -101,6 +207,8 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
 
     double classEntropyForAGivenSequenceOfFeaturesAndValuesOrThresholds(
         const vector<string> &arrayOfFeaturesAndValuesOrThresholds);
+    template <typename ProbabilityOfClass>
+    double entropyOfClassDistribution(const ProbabilityOfClass &probabilityOfClass) const;
 
     //--------------- Probability Calculators ----------------//
     double priorProbabilityForClass(const string &className);
@@ -121,7 +229,7 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
 
     //--------------- Class Based Utilities ----------------//
     void determineDataCondition();
-    bool checkNamesUsed(const vector<string> &featuresAndValues);
+    bool checkNamesUsed(const vector<string> &featuresAndValues) const;
     DecisionTree &operator=(const DecisionTree &dt);
     vector<vector<string>> findBoundedIntervalsForNumericFeatures(const vector<string> &trueNumericTypes);
     void printStats();
@@ -140,6 +248,10 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     int getDebug1() const;
     int getDebug2() const;
     int getDebug3() const;
+    size_t getMemoryBudgetBytes() const;
+    size_t getContingencyCubeMaxCells() const;
+    int getFeaturesPerNode() const;
+    optional<uint64_t> getSeed() const;
     int getHowManyTotalTrainingSamples() const;
     vector<string> getFeatureNames() const;
     map<string, vector<string>> getFeaturesAndValuesDict() const;
@@ -148,6 +260,7 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     map<string, vector<double>> getNumericFeaturesValueRangeDict() const;
     map<int, vector<string>> getTrainingDataDict() const;
     DecisionTreeNode* getRootNode() const;
+    uint64_t getTreeRevision() const { return _treeRevision; }
 
     //---------------- Setters ----------------//
     void setTrainingDatafile(const string &trainingDatafile);
@@ -161,6 +274,10 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     void setDebug1(int debug1);
     void setDebug2(int debug2);
     void setDebug3(int debug3);
+    void setMemoryBudgetBytes(size_t memoryBudgetBytes);
+    void setContingencyCubeMaxCells(size_t contingencyCubeMaxCells);
+    void setFeaturesPerNode(int featuresPerNode);
+    void setSeed(uint64_t seed);
     void setHowManyTotalTrainingSamples(int howManyTotalTrainingSamples);
     void setRootNode(unique_ptr<DecisionTreeNode> rootNode);
     void setClassNames(const vector<string> &classNames);
@@ -175,6 +292,12 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     int _csvCleanupNeeded;
     int _debug1, _debug2, _debug3;
     int _howManyTotalTrainingSamples;
+    int _buildRoutingIndex;
+    size_t _memoryBudgetBytes;
+    size_t _contingencyCubeMaxCells; // Largest contingency cube built for all-symbolic data; 0 never builds one
+    int _featuresPerNode; // Features drawn at random to compete at each node; 0 considers them all
+    optional<uint64_t> _seed; // Seed of the randomized steps (fold assignment); none keeps them deterministic by ID
+    Philox4x32 _featureSampler; // Draws the features of each node when features_per_node is set
 
     unique_ptr<DecisionTreeNode> _rootNode;
     vector<int> _csvColumnsForFeatures;
@@ -192,6 +315,17 @@ class DecisionTree : public std::enable_shared_from_this<DecisionTree> {
     map<string, map<double, double>> _probDistributionNumericFeaturesDict;
     map<string, double> _histogramDeltaDict;
     map<string, int> _numOfHistogramBinsDict;
+    map<string, FeatureType> _declaredFeatureTypes; // Types given by the user, checked against the data when it is read
+    map<string, FeatureType> _featureTypes;         // The type of every feature of the training data
+    vector<WeightedRow> _weightedRows; // The training samples collapsed into distinct rows, built on first use
+    vector<double> _rowNumericValues;  // The numericValues of the weighted rows, one row of features after another
+    ContingencyCube _contingencyCube;  // Counts over every combination of values and class, for all-symbolic data
+    RoutingIndex _routingIndex;
+    TrainingStats _stats;
+    TraceRecorder _trace;
+    shared_ptr<Logger> _logger; // Receives the construction output of debug3, on the console unless one is given
+    MemoryUsage _memoryUsage;
+    uint64_t _treeRevision = 0; // Changes whenever nodes are added to or removed from the tree
 };
 
 
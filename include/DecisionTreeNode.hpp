@@ -45,23 +45,28 @@ class DecisionTreeNode {
     // Getters
     vector<string> GetClassNames() const;
     int GetNextSerialNum() const;
-    string GetFeature() const;
+    const string &GetFeature() const;
     double GetNodeEntropy() const;
-    vector<double> GetClassProbabilities() const;
-    vector<string> GetBranchFeaturesAndValuesOrThresholds() const;
+    double GetSplitEntropy() const { return _splitEntropy; }
+    const vector<double> &GetClassProbabilities() const;
+    const vector<string> &GetBranchFeaturesAndValuesOrThresholds() const;
     const vector<DecisionTreeNode*> GetChildren() const;
+    size_t GetNumChildren() const { return _linkedTo.size(); }
+    DecisionTreeNode* GetChild(size_t index) const { return _linkedTo[index].get(); }
     int GetSerialNum() const;
 
     // Setters
     void SetClassNames(const vector<string> classNames);
     void SetFeature(const string &feature) { _feature = feature; };
     void SetNodeCreationEntropy(const double entropy);
+    void SetSplitEntropy(double entropy) { _splitEntropy = entropy; }
     void AddChildLink(unique_ptr<DecisionTreeNode> newNode);
 
     void DeleteAllLinks();
+    void DeleteChildLink(size_t index);
 
     // Displays
-    void DisplayNode(const string &offset) const;
+    void DisplayNode(const string &offset, std::ostream &out = cout) const;
     void DisplayDecisionTree(const string &offset) const;
 
   private:
@@ -70,6 +75,7 @@ class DecisionTreeNode {
     int _serialNumber;
     string _feature;
     double _nodeCreationEntropy;
+    double _splitEntropy = 0.0; // Class entropy after the split on _feature, for truncating the tree later
     vector<double> _classProbabilities;
     vector<string> _branchFeaturesAndValuesOrThresholds;
     vector<unique_ptr<DecisionTreeNode>> _linkedTo; // maybe change to weak if cyclic referencing
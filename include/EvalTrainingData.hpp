@@ -8,6 +8,18 @@
 #include <map>
 #include <string>
 
+/**
+ * @struct SweepResult
+ * @brief The cross-validated quality of the trees grown with one combination of entropy threshold and maximum depth.
+ */
+struct SweepResult {
+    double entropyThreshold;
+    int maxDepthDesired;
+    double dataQualityIndex; // Percentage of the samples classified correctly, as returned by evaluateTrainingData()
+    double meanNumNodes;     // Nodes of the tree of a fold, averaged over the folds
+};
+
+
 /**
  * @class EvalTrainingData
  * @brief A class that evaluates training data for a decision tree.
@@ -21,6 +33,8 @@ class EvalTrainingData : public DecisionTree {
     ~EvalTrainingData();                                         // Destructor
 
     double evaluateTrainingData(); // Evaluate the training data
+    vector<SweepResult> sweepHyperparameters(const vector<double> &entropyThresholds,
+                                             const vector<int> &maxDepthsDesired);
     double _dataQualityIndex;
     int _csvClassColumnIndex;
 
@@ -34,7 +48,14 @@ class EvalTrainingData : public DecisionTree {
     void printDataQualityEvaluation(double data_quality_index);
 
   private:
-    // Private members
+    vector<string> crossValidationOrder() const;
+    shared_ptr<DecisionTree> trainFoldTree(const vector<string> &trainingSamples,
+                                           double entropyThreshold,
+                                           int maxDepthDesired,
+                                           bool debug);
+    vector<string> testSampleFeaturesAndValues(const string &testSampleName) const;
+    map<int, map<string, int>> emptyConfusionMatrix() const;
+    static string mostLikelyClassLabel(map<string, string> classification);
 };
 ;
 
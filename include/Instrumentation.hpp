@@ -0,0 +1,204 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+// Include
+#include "Common.hpp"
+
+#include <chrono>
+#include <utility>
+
+/**
+ * @struct TrainingStats
+ * @brief Timers and counters collected while a DecisionTree is trained.
+ *
+ * The timers and counters are only updated when the library is built with DTPP_ENABLE_STATS (the DTPP_ENABLE_STATS
+ * CMake option); otherwise the instrumentation is compiled out and they stay at zero. The cache sizes and the memory
+ * estimate are filled in by DecisionTree::getStats() either way.
+ */
+struct TrainingStats {
+    // Time spent in each phase, in seconds
+    double loadSeconds                    = 0.0; // getTrainingData()
+    double firstOrderProbabilitiesSeconds = 0.0; // calculateFirstOrderProbabilities()
+    double constructSeconds               = 0.0; // constructDecisionTreeClassifier()
+    double splitSearchSeconds             = 0.0; // bestFeatureCalculator(), summed over all nodes
+    map<int, double> splitSearchSecondsPerNode;  // Node serial number -> time spent finding its best feature
+
+    // Counters
+    long long splitSearches          = 0; // Calls to bestFeatureCalculator()
+    long long featuresEvaluated      = 0; // Features considered by bestFeatureCalculator()
+    long long thresholdsEvaluated    = 0; // Thresholds and symbolic values tried by bestFeatureCalculator()
+    long long probabilityCacheHits   = 0;
+    long long probabilityCacheMisses = 0;
+    long long entropyCacheHits       = 0;
+    long long entropyCacheMisses     = 0;
+    long long nodesCreated           = 0;
+
+    // Sizes, computed by DecisionTree::getStats()
+    size_t probabilityCacheEntries = 0;
+    size_t entropyCacheEntries     = 0;
+    size_t bytesAllocated          = 0; // Estimate of the memory held by the training data, the caches and the nodes
+
+    double probabilityCacheHitRate() const { return hitRate(probabilityCacheHits, probabilityCacheMisses); }
+    double entropyCacheHitRate() const { return hitRate(entropyCacheHits, entropyCacheMisses); }
+    long long cacheHits() const { return probabilityCacheHits + entropyCacheHits; }
+
+  private:
+    static double hitRate(long long hits, long long misses)
+    {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    }
+};
+
+
+/**
+ * @struct MemoryUsage
+ * @brief Estimated bytes held by a DecisionTree, by owner, and its memory budget.
+ *
+ * The estimates count the heap blocks of the strings and containers and the bookkeeping of the map nodes, but not
+ * allocator overhead, so the memory used by the process is somewhat larger.
+ */
+struct MemoryUsage {
+    size_t trainingDataBytes     = 0; // Training samples, the copies of their values kept per feature and weighted rows
+    size_t probabilityCacheBytes = 0;
+    size_t entropyCacheBytes     = 0;
+    size_t nodeBytes             = 0;
+    size_t budgetBytes           = 0; // 0 when there is no budget
+    long long cacheEvictions     = 0; // Times the caches were dropped to stay within the budget
+    size_t peakResidentBytes     = 0; // Peak resident set size of the whole process, 0 where unavailable
+
+    size_t totalBytes() const { return trainingDataBytes + probabilityCacheBytes + entropyCacheBytes + nodeBytes; }
+};
+
+size_t peakResidentSetBytes();
+
+
+/**
+ * @class ScopedTimer
+ * @brief Adds the time between its construction and destruction to a running total in seconds.
+ */
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(double &seconds) : _seconds(seconds), _start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { _seconds += elapsed(); }
+
+    ScopedTimer(const ScopedTimer &)            = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+  private:
+    double &_seconds;
+    std::chrono::steady_clock::time_point _start;
+};
+
+
+/**
+ * @struct TraceEvent
+ * @brief A span of time recorded by a TraceRecorder, with numeric arguments shown alongside it in the trace viewer.
+ */
+struct TraceEvent {
+    string name;
+    string category;
+    double startMicros    = 0.0; // Since the tracing was enabled
+    double durationMicros = 0.0;
+    vector<pair<string, double>> args;
+};
+
+
+/**
+ * @class TraceRecorder
+ * @brief Collects the spans of a DecisionTree being trained and exports them in the Chrome trace-event format.
+ *
+ * The exported JSON can be loaded into Perfetto (ui.perfetto.dev) or chrome://tracing. Recording is off until
+ * setEnabled(true) is called, and a disabled recorder ignores spans.
+ */
+class TraceRecorder {
+  public:
+    TraceRecorder() : _origin(std::chrono::steady_clock::now()) {}
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return _enabled; }
+    void clear() { _events.clear(); }
+
+    double nowMicros() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - _origin).count();
+    }
+    void addEvent(TraceEvent event) { _events.push_back(std::move(event)); }
+    const vector<TraceEvent> &getEvents() const { return _events; }
+
+    string toChromeTraceJson() const;
+    void writeChromeTrace(const string &filename) const;
+
+  private:
+    bool _enabled = false;
+    std::chrono::steady_clock::time_point _origin;
+    vector<TraceEvent> _events;
+};
+
+
+/**
+ * @class TraceSpan
+ * @brief Records a span from its construction to its destruction in a TraceRecorder, if the recorder is enabled.
+ *
+ * Spans of a single thread nest, so a span opened inside another one shows up below it in the trace viewer.
+ */
+class TraceSpan {
+  public:
+    TraceSpan(TraceRecorder &recorder, const string &name, const string &category) : _recorder(recorder)
+    {
+        if (_recorder.isEnabled()) {
+            _event.name        = name;
+            _event.category    = category;
+            _event.startMicros = _recorder.nowMicros();
+        }
+    }
+    ~TraceSpan()
+    {
+        if (_recorder.isEnabled()) {
+            _event.durationMicros = _recorder.nowMicros() - _event.startMicros;
+            _recorder.addEvent(std::move(_event));
+        }
+    }
+
+    TraceSpan(const TraceSpan &)            = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    bool isActive() const { return _recorder.isEnabled(); }
+    void setArg(const string &key, double value)
+    {
+        if (_recorder.isEnabled()) {
+            _event.args.emplace_back(key, value);
+        }
+    }
+
+  private:
+    TraceRecorder &_recorder;
+    TraceEvent _event;
+};
+
+
+/**
+ * @def DTPP_STATS_TIMER(name, seconds)
+ * @brief Declares a ScopedTimer called name that adds the time to the end of the enclosing scope to seconds.
+ *
+ * @def DTPP_STATS_COUNT(counter, n)
+ * @brief Adds n to counter.
+ *
+ * @def DTPP_STATS_ONLY(...)
+ * @brief Keeps a statement only when the instrumentation is compiled in.
+ */
+#ifdef DTPP_ENABLE_STATS
+#define DTPP_STATS_TIMER(name, seconds) ScopedTimer name(seconds)
+#define DTPP_STATS_COUNT(counter, n) ((counter) += (n))
+#define DTPP_STATS_ONLY(...) __VA_ARGS__
+#else
+#define DTPP_STATS_TIMER(name, seconds) ((void)0)
+#define DTPP_STATS_COUNT(counter, n) ((void)0)
+#define DTPP_STATS_ONLY(...) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_HPP
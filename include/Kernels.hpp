@@ -0,0 +1,38 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+// Include
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @def DTPP_MULTIVERSION
+ * @brief Builds SSE4.2, AVX2 and AVX-512 clones of a function next to the baseline version.
+ *
+ * The dynamic loader picks the best clone for the CPU the library runs on, so a single build of the library (and of
+ * the Python module) gets the wide vector units of the machine without -march=native. Multiversioning is turned on by
+ * the DTPP_ENABLE_MULTIVERSIONING CMake option and needs GCC or Clang on x86-64 Linux, where it relies on ifuncs.
+ */
+#if defined(DTPP_ENABLE_MULTIVERSIONING) && defined(__x86_64__) && defined(__linux__) &&                             \
+    (defined(__GNUC__) || defined(__clang__))
+#define DTPP_MULTIVERSION __attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+#else
+#define DTPP_MULTIVERSION
+#endif
+
+//--------------- Split Finding ----------------//
+size_t closestSamplingPointIndex(const double* samplingPoints, size_t numSamplingPoints, double value);
+double entropyOfProbabilities(const double* probabilities, size_t numClasses);
+
+//--------------- Histograms ----------------//
+void binIndices(const double* values, size_t numValues, double origin, double binWidth, int32_t* bins);
+void countValuesNearGridPointsByClass(const double* gridPoints,
+                                      size_t numGridPoints,
+                                      const double* values,
+                                      const int32_t* classes,
+                                      size_t numValues,
+                                      size_t numClasses,
+                                      double histogramDelta,
+                                      size_t* counts);
+
+#endif // KERNELS_HPP
@@ -0,0 +1,100 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+// Include
+#include "Common.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <thread>
+
+/**
+ * @enum LogLevel
+ * @brief The severity of a log message, from the least to the most severe.
+ */
+enum class LogLevel { DEBUG, INFO, WARNING, ERROR, CRITICAL };
+
+/**
+ * @def DTPP_MIN_LOG_LEVEL
+ * @brief The least severe level that is compiled in, as an integer (0 for DEBUG to 4 for CRITICAL).
+ *
+ * Messages below it passed to the DTPP_LOG macros are removed at compile time, along with the code that builds them.
+ */
+#ifndef DTPP_MIN_LOG_LEVEL
+#define DTPP_MIN_LOG_LEVEL 0
+#endif
+
+/**
+ * @class Logger
+ * @brief An asynchronous logger that can be used from several threads at once.
+ *
+ * log() only moves the message into a bounded lock-free multi-producer single-consumer ring buffer, so it never waits
+ * for I/O or for a lock. A background writer thread takes the messages out in order, adds the timestamp and level, and
+ * writes them to the log file and, optionally, to the console. When the ring buffer is full the message is dropped
+ * and counted rather than blocking the caller.
+ */
+class Logger {
+  public:
+    static constexpr LogLevel MIN_LEVEL = static_cast<LogLevel>(DTPP_MIN_LOG_LEVEL);
+
+    Logger(const string &filename, bool echoToConsole = true, size_t capacity = 8192);
+    ~Logger();
+
+    Logger(const Logger &)            = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    bool log(LogLevel level, string message);
+    void flush();
+
+    size_t getCapacity() const { return _capacity; }
+    size_t getDroppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+    static string levelToString(LogLevel level);
+
+  private:
+    // A slot of the ring buffer. The sequence number tells producers and the writer whose turn it is to use the slot.
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        std::chrono::system_clock::time_point time;
+        string message;
+    };
+
+    // The writer flushes at least once every FLUSH_INTERVAL messages, even when the ring buffer never runs empty
+    static constexpr size_t FLUSH_INTERVAL = 256;
+
+    bool tryPop(Slot* &slot);
+    void writerLoop();
+    void write(const Slot &slot);
+    void flushStreams();
+
+    unique_ptr<Slot[]> _slots;
+    size_t _capacity;
+    size_t _mask;
+    bool _echoToConsole;
+    std::ofstream _logFile;
+
+    alignas(64) std::atomic<size_t> _enqueuePosition{0}; // Next position claimed by a producer
+    alignas(64) std::atomic<size_t> _flushedPosition{0}; // Messages before it are written and flushed
+    alignas(64) std::atomic<size_t> _flushRequested{0};  // flush() waits for the messages before it
+    alignas(64) std::atomic<size_t> _dropped{0};
+    size_t _dequeuePosition = 0; // Next position taken by the writer, only touched by the writer thread
+
+    std::atomic<bool> _stop{false};
+    std::thread _writer;
+};
+
+/**
+ * @def DTPP_LOG(logger, level, message)
+ * @brief Logs message at level (one of DEBUG, INFO, WARNING, ERROR, CRITICAL) unless the level is compiled out, in
+ * which case message is not evaluated.
+ */
+#define DTPP_LOG(logger, level, message)                                                                                \
+    do {                                                                                                               \
+        if constexpr (LogLevel::level >= Logger::MIN_LEVEL) {                                                          \
+            (logger).log(LogLevel::level, (message));                                                                  \
+        }                                                                                                              \
+    } while (0)
+
+#endif // LOGGER_HPP
@@ -0,0 +1,127 @@
+#ifndef QUICK_SCORER_HPP
+#define QUICK_SCORER_HPP
+
+// Include
+#include "Common.hpp"
+#include "CompiledDecisionTree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+class DecisionForest;
+
+/**
+ * @struct QuickScorerTest
+ * @brief The feature test on a branch of a tree in a QuickScorer, with the exits it rules out when it is false.
+ */
+struct QuickScorerTest {
+    double value;       // Threshold of a '<' or '>' test, numeric value of an '=' test (NaN if not numeric)
+    int code;           // Symbolic value code of an '=' test, -1 otherwise
+    uint32_t exitBegin; // First exit of the subtree behind the branch, as a bit of the concatenated bitvectors
+    uint32_t exitEnd;   // One past the last exit of the subtree
+};
+
+
+/**
+ * @class QuickScorer
+ * @brief Scores an ensemble of compiled trees with bitvectors, feature by feature, instead of descending each tree.
+ *
+ * This is the QuickScorer algorithm (Lucchese et al., "QuickScorer: a fast algorithm to rank documents with additive
+ * ensembles of regression trees", SIGIR 2015), extended to the multiway, possibly incomplete trees built here. Every
+ * node of a tree is an exit: the leaves, and the internal nodes at which a sample stops when it has a missing value or
+ * matches none of the children. The exits are numbered in postorder (the subtrees of the children in order, then the
+ * node), so the exits of any subtree are a contiguous range of bits of the tree's bitvector.
+ *
+ * A sample starts with every bit set. Every branch test that is false for the sample clears the bits of the subtree
+ * behind it, and the exit of the sample is then the lowest set bit: the subtrees of the children before the one taken
+ * at each node of the path have been cleared, and nothing clears the path itself. The tests are grouped by feature
+ * and kept sorted by threshold, so the false '<' and '>' tests of a feature are a prefix of its lists, found without
+ * visiting any node, and the work per sample is bit operations on a small array instead of dependent loads and
+ * mispredicted branches down every tree. The bits cleared by a symbolic value, and by a missing value, do not depend
+ * on the sample, so they are precomputed as a mask per value and feature, and applied with one lookup. So are the
+ * bits cleared by every checkpointInterval-th prefix of the '<' and '>' lists, which leaves fewer than
+ * checkpointInterval tests of each list to clear one at a time; the interval is chosen to keep the masks within
+ * MASK_BUDGET_BYTES.
+ *
+ * The results are those of CompiledDecisionTree::predictProba(), averaged over the trees, as for
+ * DecisionForest::predictProba().
+ */
+class QuickScorer {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    QuickScorer(const vector<CompiledDecisionTree> &trees);
+    QuickScorer(const DecisionForest &forest);
+    ~QuickScorer();
+
+    //--------------- Classify ----------------//
+    template <typename T>
+    void predictProba(const T* numericValues, const int* symbolicCodes, size_t numRows, double* probabilities) const;
+    vector<double> predictProba(const vector<double> &numericValues, const vector<int> &symbolicCodes) const;
+    int encodeSymbolicValue(const string &feature, const string &value) const;
+
+    //--------------- Getters ----------------//
+    const vector<string> &getFeatureNames() const { return _featureNames; }
+    const vector<string> &getClassNames() const { return _classNames; }
+    size_t getNumFeatures() const { return _featureNames.size(); }
+    size_t getNumClasses() const { return _classNames.size(); }
+    size_t getNumTrees() const { return _treeWordOffsets.size() - 1; }
+    size_t getNumTests() const { return _tests.size(); }
+    size_t getNumWords() const { return _initialBitvectors.size(); }
+    size_t getCheckpointInterval() const { return _checkpointInterval; }
+
+  private:
+    static constexpr size_t PREDICT_BLOCK_SIZE = 1024;
+    static constexpr size_t MASK_BUDGET_BYTES  = size_t{16} << 20;
+
+    // The tests on a feature, in _tests: '<' tests by increasing threshold, '>' tests by decreasing threshold, then
+    // '=' tests. The masks of a feature, as indices in _maskOffsets: its missing value, then one per symbolic code,
+    // then one per checkpoint of the '<' tests and one per checkpoint of the '>' tests
+    struct FeatureTests {
+        size_t lessBegin;
+        size_t greaterBegin;
+        size_t equalBegin;
+        size_t end;
+        size_t missingMask;
+        int numCodes;
+        size_t lessMasks;    // Mask of the first checkpointInterval '<' tests; the next checkpoints follow
+        size_t greaterMasks; // Mask of the first checkpointInterval '>' tests
+    };
+
+    // The bits of a word of the bitvectors left set by a mask; the words a mask does not list are left alone
+    struct WordMask {
+        uint32_t word;
+        uint64_t mask;
+    };
+
+    uint32_t addExits(const CompiledDecisionTree &tree,
+                      int nodeIndex,
+                      uint32_t firstBit,
+                      uint32_t &nextExit,
+                      size_t exitOffset,
+                      vector<vector<QuickScorerTest>> &lessTests,
+                      vector<vector<QuickScorerTest>> &greaterTests,
+                      vector<vector<QuickScorerTest>> &equalTests);
+    void clearTests(vector<uint64_t> &words, size_t testsBegin, size_t testsEnd, int keptCode) const;
+    void addMask(const vector<uint64_t> &words);
+    void clearPrefix(uint64_t* words, size_t testsBegin, size_t numFalse, size_t firstMask) const;
+    template <typename T>
+    void predictProbaRows(
+        const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const;
+
+    vector<string> _featureNames;
+    vector<string> _classNames;
+    vector<bool> _featureIsNumeric;
+    map<string, vector<string>> _symbolicValues;
+
+    vector<QuickScorerTest> _tests;        // Grouped by feature, as described by _featureTests
+    vector<FeatureTests> _featureTests;    // Where the tests on each feature are in _tests
+    vector<WordMask> _wordMasks;           // Every mask, in the order given by _featureTests
+    vector<size_t> _maskOffsets;           // Where each mask starts in _wordMasks, and the total number of words last
+    size_t _checkpointInterval;            // Number of '<' or '>' tests between two checkpoint masks
+    vector<size_t> _treeWordOffsets;       // First word of each tree's bitvector, and the total number of words last
+    vector<uint64_t> _initialBitvectors;   // Every exit set, for all the trees one after the other
+    vector<size_t> _treeExitOffsets;       // Index of each tree's first exit in _exitProbabilities
+    vector<double> _exitProbabilities;     // Row-major, one row of getNumClasses() probabilities per exit
+};
+
+#endif // QUICK_SCORER_HPP
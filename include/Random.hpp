@@ -0,0 +1,104 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+// Include
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @class Philox4x32
+ * @brief The Philox4x32-10 counter-based random number generator, usable with the <random> distributions.
+ *
+ * Each output block is a keyed bijection of a 128-bit counter, so the generator has no state besides its key and
+ * counter. The key is the seed, and the high half of the counter selects one of 2^64 independent streams, each
+ * 2^64 blocks of two 64-bit numbers long. Any stream, or any position in it, is reached in constant time, so work
+ * split into tasks (blocks of rows, folds, trees) gives every task its own stream and gets the same numbers whichever
+ * thread runs it and however many threads there are.
+ *
+ * See Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011.
+ */
+class Philox4x32 {
+  public:
+    using result_type = uint64_t;
+    using Block       = std::array<uint32_t, 4>;
+    using Key         = std::array<uint32_t, 2>;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0) : _seed(seed), _stream(stream) {}
+
+    result_type operator()()
+    {
+        if (_index == 2) {
+            _output = philox({static_cast<uint32_t>(_position),
+                              static_cast<uint32_t>(_position >> 32),
+                              static_cast<uint32_t>(_stream),
+                              static_cast<uint32_t>(_stream >> 32)},
+                             {static_cast<uint32_t>(_seed), static_cast<uint32_t>(_seed >> 32)});
+            ++_position;
+            _index = 0;
+        }
+        const result_type result = (static_cast<uint64_t>(_output[2 * _index + 1]) << 32) | _output[2 * _index];
+        ++_index;
+        return result;
+    }
+
+    // Skips n outputs
+    void discard(unsigned long long n)
+    {
+        while (n > 0 && _index < 2) {
+            ++_index;
+            --n;
+        }
+        _position += n / 2;
+        if (n % 2) {
+            (*this)();
+        }
+    }
+
+    /**
+     * @brief Returns the generator of a substream, independent of this one and of the other substreams.
+     *
+     * The stream number of the substream is a hash of this stream's number and the index, so nested splits (trees of
+     * a forest, then folds of a tree) do not collide.
+     */
+    Philox4x32 split(uint64_t index) const
+    {
+        uint64_t stream = _stream + 0x9E3779B97F4A7C15ull * (index + 1);
+        stream          = (stream ^ (stream >> 30)) * 0xBF58476D1CE4E5B9ull;
+        stream          = (stream ^ (stream >> 27)) * 0x94D049BB133111EBull;
+        return Philox4x32(_seed, stream ^ (stream >> 31));
+    }
+
+    uint64_t getSeed() const { return _seed; }
+    uint64_t getStream() const { return _stream; }
+
+    // The Philox4x32-10 bijection of a counter under a key
+    static Block philox(Block counter, Key key)
+    {
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+            const uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+            counter                 = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                                       static_cast<uint32_t>(product1),
+                                       static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                                       static_cast<uint32_t>(product0)};
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        return counter;
+    }
+
+  private:
+    uint64_t _seed;
+    uint64_t _stream;
+    uint64_t _position = 0; // Next block of the stream
+    Block _output{};
+    int _index = 2; // Next 64-bit half of _output to return; 2 when a new block is needed
+};
+
+uint64_t defaultSeed();
+
+#endif // RANDOM_HPP
@@ -5,7 +5,7 @@
 #include "Common.hpp"
 
 #include <Eigen/Dense> // For multivariate normal generation
-#include <ctime>       // For seeding random shuffle
+#include <cstdint>
 #include <fstream>
 #include <random>
 #include <regex>
@@ -16,6 +16,11 @@ using Eigen::VectorXd;
 /**
  * @class TrainingDataGeneratorNumeric
  * @brief A class to generate training data for numeric data.
+ *
+ * The samples are generated and written in blocks of rows. The order of the rows is a pseudorandom permutation of
+ * the samples of all classes, computed row by row, so no block needs the others and the blocks are generated on
+ * several threads, each from its own random stream derived from the seed and the block number. Memory use does not
+ * depend on the number of samples, and with a given seed the output does not depend on the number of threads.
  */
 class TrainingDataGeneratorNumeric {
   private:
@@ -24,6 +29,9 @@ class TrainingDataGeneratorNumeric {
     string _parameterFile;
     int _numberOfSamplesPerClass;
     int _debug;
+    uint64_t _seed;
+    int _numberOfThreads;
+    uint64_t _multivariateDraws = 0; // Calls to GenerateMultivariateSamples(), each with its own random substream
 
     // Other attributes initialized in the constructor
     vector<string> _classNames;
@@ -32,6 +40,18 @@ class TrainingDataGeneratorNumeric {
     map<string, pair<double, double>> _featuresWithValueRange;
     map<string, map<string, vector<double>>> _classesAndTheirParamValues;
 
+    static constexpr size_t BLOCK_SIZE = 4096; // Rows generated at a time by a thread
+
+    // Means and Cholesky factors of the covariances of the classes, in the order of _classesAndTheirParamValues
+    struct ClassDistribution {
+        string className;
+        VectorXd mean;
+        MatrixXd choleskyFactor;
+    };
+
+    vector<ClassDistribution> classDistributions() const;
+    void formatBlock(const vector<ClassDistribution> &distributions, size_t block, string &text) const;
+
   public:
     TrainingDataGeneratorNumeric(map<string, string> kwargs);
     ~TrainingDataGeneratorNumeric();
@@ -48,6 +68,8 @@ class TrainingDataGeneratorNumeric {
     string getParameterFile() const;
     int getNumberOfSamplesPerClass() const;
     int getDebug() const;
+    uint64_t getSeed() const;
+    int getNumberOfThreads() const;
     vector<string> getClassNames() const;
     vector<string> getFeaturesOrdered() const;
     map<string, double> getClassNamesAndPriors() const;
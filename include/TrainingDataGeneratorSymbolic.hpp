@@ -4,14 +4,48 @@
 // Include
 #include "Common.hpp"
 
+#include <cstdint>
 #include <fstream>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
 
+/**
+ * @class AliasTable
+ * @brief Walker's alias method for drawing from a discrete distribution in constant time.
+ *
+ * Building the table takes time linear in the number of outcomes. Each draw then takes one uniform random number
+ * and one table lookup, however many outcomes there are.
+ */
+class AliasTable {
+  public:
+    AliasTable() = default;
+    AliasTable(const vector<double> &weights);
+
+    template <typename RNG> int operator()(RNG &rng) const
+    {
+        const double x = std::uniform_real_distribution<double>(0.0, 1.0)(rng) * _probabilities.size();
+        const int i    = std::min(static_cast<int>(x), static_cast<int>(_probabilities.size()) - 1);
+        return x - i < _probabilities[i] ? i : _aliases[i];
+    }
+
+    size_t size() const { return _probabilities.size(); }
+
+  private:
+    vector<double> _probabilities; // Probability of keeping outcome i when column i is drawn
+    vector<int> _aliases;          // Outcome drawn from column i otherwise
+};
+
+
 /**
  * @class TrainingDataGeneratorSymbolic
  * @brief A class to generate training data for symbolic data.
+ *
+ * The class labels and feature values are drawn from alias tables. The samples are generated in blocks, on several
+ * threads, each block from its own random stream derived from the seed and the block number, so that the data depends
+ * on the seed but not on the number of threads. The records are kept dictionary coded, as indices into the class
+ * names and the feature values.
  */
 class TrainingDataGeneratorSymbolic {
   private:
@@ -21,12 +55,23 @@ class TrainingDataGeneratorSymbolic {
     int _writeToFile;
     int _debug1;
     int _debug2;
-    map<int, vector<string>> _trainingSampleRecords;
+    uint64_t _seed;
+    int _numberOfThreads;
     map<string, vector<string>> _featuresAndValuesDict;
     map<string, map<string, vector<string>>> _biasDict;
     vector<string> _classNames;
     vector<double> _classPriors;
 
+    // Row i holds the index of the class of sample i in _classNames, followed by the index of each of its feature
+    // values in _featuresAndValuesDict, in the order of the features
+    vector<uint16_t> _sampleCodes;
+
+    static constexpr size_t BLOCK_SIZE = 4096; // Samples generated or written at a time by a thread
+
+    size_t rowWidth() const { return 1 + _featuresAndValuesDict.size(); }
+    size_t numberOfGeneratedSamples() const { return _sampleCodes.size() / rowWidth(); }
+    void formatRecords(size_t first, size_t last, string &text) const;
+
     // vecToString for string and double
     template <typename T> string vecToString(const vector<T> &vec)
     {
@@ -57,12 +102,14 @@ class TrainingDataGeneratorSymbolic {
     map<string, map<string, vector<string>>> getBiasDict() { return _biasDict; }
     string getOutputDatafile() { return _outputDatafile; }
     string getParameterFile() { return _parameterFile; }
-    double randomDouble(double upper, double lower);
     int getNumberOfTrainingSamples() { return _numberOfTrainingSamples; }
     int getWriteToFile() { return _writeToFile; }
     int getDebug1() { return _debug1; }
     int getDebug2() { return _debug2; }
-    map<int, vector<string>> getTrainingSampleRecords() { return _trainingSampleRecords; }
+    uint64_t getSeed() { return _seed; }
+    int getNumberOfThreads() { return _numberOfThreads; }
+    const vector<uint16_t> &getSampleCodes() { return _sampleCodes; }
+    map<int, vector<string>> getTrainingSampleRecords();
 };
 
 #endif // TRAINING_DATA_GENERATOR_SYMBOLIC_HPP
\ No newline at end of file
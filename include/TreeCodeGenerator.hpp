@@ -0,0 +1,99 @@
+#ifndef TREE_CODE_GENERATOR_HPP
+#define TREE_CODE_GENERATOR_HPP
+
+// Include
+#include "Common.hpp"
+#include "CompiledDecisionTree.hpp"
+
+#include <cstddef>
+#include <ostream>
+
+class NativeDecisionTree;
+
+/**
+ * @class TreeCodeGenerator
+ * @brief Emits a constructed decision tree as straight-line C++ source code.
+ *
+ * Every node of the tree becomes a block of nested branches on the raw feature arrays, and the class probabilities of
+ * the nodes become a constexpr table, so classifying a sample is a few compares and jumps with no node array to walk.
+ * The generated code takes the arrays of CompiledDecisionTree::predictProba(), with the same column order and symbolic
+ * value codes, and gives the same class probabilities.
+ *
+ * The code can be written to a header and compiled into a program, where everything is in a namespace named after the
+ * generator; or it can be compiled at run time by the system compiler into a shared library, which is loaded as a
+ * NativeDecisionTree through extern "C" entry points prefixed with the same name.
+ *
+ * Missing values are NaN and rely on comparisons with NaN being false, so the code must not be compiled with
+ * -ffast-math.
+ */
+class TreeCodeGenerator {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    TreeCodeGenerator(shared_ptr<DecisionTree> dt, const string &name = "decision_tree");
+    TreeCodeGenerator(const CompiledDecisionTree &tree, const string &name = "decision_tree");
+    ~TreeCodeGenerator();
+
+    //--------------- Code Generation ----------------//
+    string generateHeader() const;
+    string generatePluginSource() const;
+    void writeHeader(const string &filename) const;
+    shared_ptr<NativeDecisionTree> compileAndLoad(const string &compiler = "", const string &flags = "-O2") const;
+
+    //--------------- Getters ----------------//
+    const string &getName() const { return _name; }
+    const CompiledDecisionTree &getCompiledTree() const { return _tree; }
+
+  private:
+    void emitNode(std::ostream &out, int index, int depth) const;
+    static string doubleLiteral(double value);
+    static string condition(char op, const string &variable, double value);
+
+    CompiledDecisionTree _tree;
+    string _name; // A C identifier: the namespace of the header and the prefix of the plugin's entry points
+};
+
+
+/**
+ * @class NativeDecisionTree
+ * @brief A decision tree compiled to machine code by TreeCodeGenerator::compileAndLoad() and loaded as a plugin.
+ *
+ * It classifies the same arrays as the CompiledDecisionTree it was generated from. The shared library stays loaded
+ * until the object is destroyed. All of its member functions are const and the generated code has no state, so it can
+ * be used concurrently from several threads.
+ */
+class NativeDecisionTree {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    ~NativeDecisionTree();
+    NativeDecisionTree(const NativeDecisionTree &)            = delete;
+    NativeDecisionTree &operator=(const NativeDecisionTree &) = delete;
+
+    //--------------- Classify ----------------//
+    template <typename T>
+    void predictProba(const T* numericValues, const int* symbolicCodes, size_t numRows, double* probabilities) const;
+    vector<double> predictProba(const vector<double> &numericValues, const vector<int> &symbolicCodes) const;
+    int encodeSymbolicValue(const string &feature, const string &value) const;
+
+    //--------------- Getters ----------------//
+    const vector<string> &getFeatureNames() const { return _featureNames; }
+    const vector<string> &getClassNames() const { return _classNames; }
+    size_t getNumFeatures() const { return _featureNames.size(); }
+    size_t getNumClasses() const { return _classNames.size(); }
+
+  private:
+    friend class TreeCodeGenerator;
+
+    using PredictProbaDouble = void (*)(const double*, const int*, size_t, double*);
+    using PredictProbaFloat  = void (*)(const float*, const int*, size_t, double*);
+
+    NativeDecisionTree(void* handle, const string &name, const CompiledDecisionTree &tree);
+
+    void* _handle; // From dlopen()
+    PredictProbaDouble _predictProbaDouble;
+    PredictProbaFloat _predictProbaFloat;
+    vector<string> _featureNames;
+    vector<string> _classNames;
+    map<string, vector<string>> _symbolicValues;
+};
+
+#endif // TREE_CODE_GENERATOR_HPP
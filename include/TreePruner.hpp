@@ -0,0 +1,89 @@
+#ifndef TREE_PRUNER_HPP
+#define TREE_PRUNER_HPP
+
+// Include
+#include "Common.hpp"
+#include "DecisionTree.hpp"
+
+#include <cstddef>
+
+/**
+ * @struct PruningStep
+ * @brief One subtree of the cost-complexity pruning path of a decision tree, with its size and accuracy.
+ */
+struct PruningStep {
+    double alpha;            // Complexity cost per node from which this subtree is the optimal one
+    int numNodes;            // Nodes left in the tree
+    int numLeaves;           // Leaves left in the tree
+    double trainingAccuracy; // Fraction of the training samples classified as their class
+    double heldOutAccuracy;  // Fraction of the held-out samples classified as their class, NaN without any
+    vector<int> prunedNodes; // Serial numbers of the nodes that become leaves at this step
+};
+
+
+/**
+ * @class TreePruner
+ * @brief Shrinks a constructed decision tree by minimal cost-complexity pruning (Breiman et al., "Classification and
+ * Regression Trees", 1984).
+ *
+ * A sample is classified as the most probable class of the node at which its descent stops. The cost of a subtree is
+ * the fraction of the training samples it misclassifies plus alpha times its number of nodes; nodes rather than leaves
+ * are counted since a multiway node with a single child still costs a node on every descent. As alpha grows, the
+ * internal nodes whose subtrees buy the least accuracy per node are turned into leaves one after the other, which
+ * gives a nested sequence of subtrees from the full tree down to its root alone. Each of them is scored on the
+ * held-out samples, if any were given, and the tree can be pruned to any of them in place.
+ */
+class TreePruner {
+  public:
+    //--------------- Constructors and Destructors ----------------//
+    TreePruner(shared_ptr<DecisionTree> dt);
+    ~TreePruner();
+
+    //--------------- Pruning ----------------//
+    void setHeldOutSamples(const vector<vector<string>> &featuresAndValues, const vector<string> &classNames);
+    const vector<PruningStep> &computePruningPath();
+    size_t selectStep() const;
+    DecisionTreeNode* pruneToStep(size_t step);
+    DecisionTreeNode* prune();
+
+    //--------------- Getters ----------------//
+    const vector<PruningStep> &getPruningPath() const { return _pruningPath; }
+
+  private:
+    // A node of the tree, with the samples that reach it counted as errors of the node's class
+    struct NodeErrors {
+        DecisionTreeNode* node;
+        vector<size_t> children;   // Indices in _nodes
+        int predictedClass;        // Most probable class of the node
+        double trainingIfLeaf;     // Training samples through the node not of its class
+        double trainingStopped;    // Training samples stopping at the node not of its class
+        double heldOutIfLeaf;      // The same for the held-out samples
+        double heldOutStopped;
+        size_t subtreeEnd;         // One past the index of the node's last descendant
+        bool collapsed;            // Turned into a leaf by the pruning path so far
+    };
+
+    // The errors and size of the subtree of a node in the tree pruned so far
+    struct SubtreeCost {
+        double trainingErrors;
+        double heldOutErrors;
+        int numNodes;
+        int numLeaves;
+    };
+
+    size_t indexNodes(DecisionTreeNode* node);
+    void countErrors(const vector<string> &featuresAndValues, int classIndex, double weight, bool heldOut);
+    SubtreeCost subtreeCost(size_t index, vector<SubtreeCost> &costs, vector<size_t> &internalNodes) const;
+    PruningStep makeStep(double alpha, const SubtreeCost &cost) const;
+
+    shared_ptr<DecisionTree> _dt;
+    vector<vector<string>> _heldOutFeaturesAndValues;
+    vector<int> _heldOutClasses;
+    vector<NodeErrors> _nodes;       // In preorder, the root first
+    map<int, size_t> _nodeIndices;   // Node serial number -> index in _nodes
+    double _trainingWeight;
+    double _heldOutWeight;
+    vector<PruningStep> _pruningPath;
+};
+
+#endif // TREE_PRUNER_HPP
@@ -3,10 +3,15 @@
 
 // Include
 #include "Common.hpp"
+#include "Kernels.hpp"
 
 #include <cmath>
+#include <cstdint>
+#include <functional>
 #include <numeric>
+#include <random>
 #include <regex>
+#include <string_view>
 #include <utility>
 
 int sampleIndex(string sample_name);
@@ -34,6 +39,7 @@ template <typename T> pair<T, size_t> minimum(const vector<T> &vec)
     return std::make_pair(min, index);
 }
 
+bool parseDouble(std::string_view str, double &value);
 double convert(const string &str);
 
 inline double ClosestSamplingPoint(const vector<double> &vec, const double &val)
@@ -43,19 +49,8 @@ inline double ClosestSamplingPoint(const vector<double> &vec, const double &val)
         return val;
     }
 
-    // find the closest sampling point
-    double min_diff = std::abs(val - vec[0]);
-    size_t index    = 0;
-    for (size_t i = 1; i < vec.size(); ++i) {
-        double diff = std::abs(val - vec[i]);
-        if (diff < min_diff) {
-            min_diff = diff;
-            index    = i;
-        }
-    }
-
-    // return the closest sampling point
-    return vec[index];
+    // find and return the closest sampling point
+    return vec[closestSamplingPointIndex(vec.data(), vec.size(), val)];
 };
 
 string CleanupCsvString(const string &str);
@@ -63,6 +58,14 @@ string CleanupCsvString(const string &str);
 string removeTrailingZeros(const string &str);
 string formatDouble(double value);
 
+// Helpers for the training data generators
+void parallelFor(size_t numTasks, int numThreads, const std::function<void(size_t task)> &task);
+void appendNumber(string &out, double value);
+void writeBlocksInParallel(std::ostream &out,
+                           size_t numBlocks,
+                           int numThreads,
+                           const std::function<void(size_t block, string &text)> &formatBlock);
+
 /**
  * @brief Overloaded stream insertion operator for printing vectors.
  *
@@ -0,0 +1,224 @@
+#include "BenchmarkDataGenerator.hpp"
+
+#include "Random.hpp"
+#include "Utility.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief Constructs a new BenchmarkDataGenerator object with the given keyword arguments.
+ *
+ * The class-conditional distributions are drawn from the seed here, so two generators with the same arguments write
+ * the same data.
+ *
+ * @param kwargs A map containing the keyword arguments for initialization. The allowed keys are:
+ * - "output_datafile": The name of the output CSV file.
+ * - "number_of_samples": The number of samples to generate.
+ * - "number_of_numeric_features": The number of numeric features (default 10).
+ * - "number_of_symbolic_features": The number of symbolic features (default 10).
+ * - "number_of_classes": The number of classes (default 2).
+ * - "number_of_symbolic_values": The number of values of each symbolic feature (default 5).
+ * - "seed": The seed of the random number generator (default 0).
+ * - "number_of_threads": The number of threads (default: the number of hardware threads).
+ * - "block_size": The number of rows generated at a time by a thread (default 4096).
+ * - "debug": Debug flag (integer value).
+ *
+ * @throws std::invalid_argument if the kwargs map is empty, contains invalid keys, or describes an empty data set.
+ */
+BenchmarkDataGenerator::BenchmarkDataGenerator(map<string, string> kwargs)
+{
+    vector<string> allowedKeys = {"output_datafile",
+                                  "number_of_samples",
+                                  "number_of_numeric_features",
+                                  "number_of_symbolic_features",
+                                  "number_of_classes",
+                                  "number_of_symbolic_values",
+                                  "seed",
+                                  "number_of_threads",
+                                  "block_size",
+                                  "debug"};
+
+    if (kwargs.empty()) {
+        throw std::invalid_argument("Missing parameters.");
+    }
+
+    // Checking passed keyword arguments
+    for (const auto &kv : kwargs) {
+        // see if the key is in the allowed keys
+        if (std::find(allowedKeys.begin(), allowedKeys.end(), kv.first) == allowedKeys.end()) {
+            throw std::invalid_argument(kv.first + ": Wrong keyword used --- check spelling");
+        }
+    }
+
+    // Set default values
+    _numberOfSamples          = 0;
+    _numberOfNumericFeatures  = 10;
+    _numberOfSymbolicFeatures = 10;
+    _numberOfClasses          = 2;
+    _numberOfSymbolicValues   = 5;
+    _seed                     = 0;
+    _numberOfThreads          = std::max(1u, std::thread::hardware_concurrency());
+    _blockSize                = 4096;
+    _debug                    = 0;
+
+    // go through the passed keyword arguments
+    for (const auto &kv : kwargs) {
+        const string &key   = kv.first;
+        const string &value = kv.second;
+
+        if (key == "output_datafile") {
+            _outputDatafile = value;
+        }
+        else if (key == "number_of_samples") {
+            _numberOfSamples = std::stoll(value);
+        }
+        else if (key == "number_of_numeric_features") {
+            _numberOfNumericFeatures = std::stoi(value);
+        }
+        else if (key == "number_of_symbolic_features") {
+            _numberOfSymbolicFeatures = std::stoi(value);
+        }
+        else if (key == "number_of_classes") {
+            _numberOfClasses = std::stoi(value);
+        }
+        else if (key == "number_of_symbolic_values") {
+            _numberOfSymbolicValues = std::stoi(value);
+        }
+        else if (key == "seed") {
+            _seed = std::stoull(value);
+        }
+        else if (key == "number_of_threads") {
+            _numberOfThreads = std::stoi(value);
+        }
+        else if (key == "block_size") {
+            _blockSize = std::stoi(value);
+        }
+        else if (key == "debug") {
+            _debug = std::stoi(value);
+        }
+    }
+
+    if (_numberOfSamples <= 0 || _numberOfClasses < 1 || _numberOfNumericFeatures < 0 ||
+        _numberOfSymbolicFeatures < 0 || _numberOfNumericFeatures + _numberOfSymbolicFeatures == 0 ||
+        (_numberOfSymbolicFeatures > 0 && _numberOfSymbolicValues < 1) || _numberOfThreads < 1 || _blockSize < 1) {
+        throw std::invalid_argument("Invalid benchmark data set parameters.");
+    }
+
+    // DecisionTree takes the feature columns as the characters of a string
+    if (_numberOfNumericFeatures + _numberOfSymbolicFeatures > 253) {
+        throw std::invalid_argument("At most 253 features are supported.");
+    }
+
+    for (int i = 1; i <= _numberOfNumericFeatures; ++i) {
+        _featureNames.push_back("numeric_" + std::to_string(i));
+    }
+    for (int i = 1; i <= _numberOfSymbolicFeatures; ++i) {
+        _featureNames.push_back("symbolic_" + std::to_string(i));
+    }
+
+    // Draw the class-conditional distributions. The class means of a numeric feature are spread over a few standard
+    // deviations, and the value weights of a symbolic feature are uniform in [0, 1), so that every feature carries
+    // some information about the class.
+    Philox4x32 rng = Philox4x32(_seed).split(0); // Away from the streams of the blocks
+    std::uniform_real_distribution<double> meanDist(-2.0, 2.0);
+    std::uniform_real_distribution<double> weightDist(0.0, 1.0);
+
+    _numericMeans.assign(_numberOfClasses, vector<double>(_numberOfNumericFeatures));
+    _symbolicDistributions.resize(_numberOfClasses);
+    for (int c = 0; c < _numberOfClasses; ++c) {
+        for (int f = 0; f < _numberOfNumericFeatures; ++f) {
+            _numericMeans[c][f] = meanDist(rng);
+        }
+        for (int f = 0; f < _numberOfSymbolicFeatures; ++f) {
+            vector<double> weights(_numberOfSymbolicValues);
+            for (double &weight : weights) {
+                weight = weightDist(rng) + 1e-3;
+            }
+            _symbolicDistributions[c].emplace_back(weights.begin(), weights.end());
+        }
+    }
+}
+
+BenchmarkDataGenerator::~BenchmarkDataGenerator() {}
+
+/**
+ * @brief Generates the data set and writes it to the output file.
+ *
+ * @throws std::runtime_error if the output file cannot be opened.
+ */
+void BenchmarkDataGenerator::GenerateBenchmarkData()
+{
+    std::ofstream file(_outputDatafile, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open output file: " + _outputDatafile);
+    }
+
+    // Write header
+    file << "\"\",class";
+    for (const auto &feature : _featureNames) {
+        file << ',' << feature;
+    }
+    file << '\n';
+
+    const size_t numBlocks = (_numberOfSamples + _blockSize - 1) / _blockSize;
+    writeBlocksInParallel(
+        file, numBlocks, _numberOfThreads, [this](size_t block, string &text) { formatBlock(block, text); });
+
+    if (_debug) {
+        cout << "Wrote " << _numberOfSamples << " samples to " << _outputDatafile << endl;
+    }
+}
+
+/**
+ * @brief Generates and formats one block of rows.
+ *
+ * Each block has its own random stream, seeded from the seed and the block number, so a block is the same whichever
+ * thread generates it.
+ *
+ * @param block The block number.
+ * @param text The string to append the CSV rows to.
+ */
+void BenchmarkDataGenerator::formatBlock(size_t block, string &text) const
+{
+    Philox4x32 rng(_seed, block);
+    std::uniform_int_distribution<int> classDist(0, _numberOfClasses - 1);
+    std::normal_distribution<double> noiseDist(0.0, 1.0);
+    std::discrete_distribution<int> valueDist; // Draws with the weights of _symbolicDistributions, which stay shared
+
+    const long long first = static_cast<long long>(block) * _blockSize;
+    const long long last  = std::min(first + _blockSize, _numberOfSamples);
+
+    for (long long row = first; row < last; ++row) {
+        const int c = classDist(rng);
+
+        // Sample IDs start at 1, like the other generators
+        text += std::to_string(row + 1);
+        text += ',';
+        text += std::to_string(c);
+
+        for (int f = 0; f < _numberOfNumericFeatures; ++f) {
+            text += ',';
+            appendNumber(text, _numericMeans[c][f] + noiseDist(rng));
+        }
+        for (int f = 0; f < _numberOfSymbolicFeatures; ++f) {
+            text += ",v";
+            text += std::to_string(valueDist(rng, _symbolicDistributions[c][f]));
+        }
+        text += '\n';
+    }
+}
+
+/**
+ * @brief Returns the feature columns of the output file in the form taken by the csv_columns_for_features option of
+ * DecisionTree, one character per column.
+ */
+string BenchmarkDataGenerator::getCsvColumnsForFeatures() const
+{
+    string columns;
+    for (size_t i = 0; i < _featureNames.size(); ++i) {
+        columns.push_back(static_cast<char>(i + 2));
+    }
+    return columns;
+}
@@ -0,0 +1,545 @@
+// Include
+#include "CompiledDecisionTree.hpp"
+
+#include <stdexcept>
+
+
+//--------------- Constructors and Destructors ----------------//
+
+/**
+ * @brief Compiles a constructed decision tree into a flat node array.
+ *
+ * The feature names, class names and the sorted symbolic values of every feature are copied from the decision tree,
+ * and the feature test on every branch is parsed once into its operator and value.
+ *
+ * The nodes are compiled depth first and then laid out as asked. For HOT_PATH, the traffic is that of the training
+ * samples of the decision tree.
+ *
+ * @param dt A shared pointer to a DecisionTree whose classifier has been constructed.
+ * @param layout The order of the nodes in the node array.
+ * @throws std::runtime_error If the decision tree has not been constructed.
+ */
+CompiledDecisionTree::CompiledDecisionTree(shared_ptr<DecisionTree> dt, NodeLayout layout)
+{
+    DecisionTreeNode* rootNode = dt->getRootNode();
+    if (rootNode == nullptr) {
+        throw std::runtime_error("You must first construct the decision tree before compiling it.");
+    }
+
+    _featureNames = dt->_featureNames;
+    _classNames   = dt->_classNames;
+
+    for (const auto &feature : _featureNames) {
+        bool isNumeric = dt->_probDistributionNumericFeaturesDict.find(feature) !=
+                         dt->_probDistributionNumericFeaturesDict.end();
+        _featureIsNumeric.push_back(isNumeric);
+
+        if (!isNumeric) {
+            const auto &uniqueValues = dt->_featuresAndUniqueValuesDict[feature];
+            _symbolicValues[feature] = vector<string>(uniqueValues.begin(), uniqueValues.end());
+        }
+    }
+
+    _nodes.resize(1);
+    _nodes[0].op    = 0;
+    _nodes[0].code  = -1;
+    _nodes[0].value = std::nan("");
+    _classProbabilities.resize(_classNames.size());
+    _layout = NodeLayout::DEPTH_FIRST;
+    compileNode(rootNode, 0);
+
+    if (layout == NodeLayout::HOT_PATH) {
+        vector<double> numericValues;
+        vector<int> symbolicCodes;
+        for (const auto &[sample, values] : dt->_trainingDataDict) {
+            encodeRow(values, numericValues, symbolicCodes);
+        }
+        relayout(layout, countTraffic(numericValues.data(), symbolicCodes.data(), dt->_trainingDataDict.size()));
+    }
+    else if (layout != NodeLayout::DEPTH_FIRST) {
+        relayout(layout);
+    }
+}
+
+CompiledDecisionTree::~CompiledDecisionTree() {}
+
+
+//--------------- Layout ----------------//
+
+/**
+ * @brief Counts the samples of a batch that pass through every node, for the HOT_PATH layout.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues A row-major numRows x getNumFeatures() array of numeric values, or nullptr.
+ * @param symbolicCodes A row-major numRows x getNumFeatures() array of symbolic value codes, or nullptr.
+ * @param numRows The number of samples.
+ * @return The number of samples whose descent goes through each node, by the serial number of the node.
+ */
+template <typename T>
+map<int, size_t>
+CompiledDecisionTree::countTraffic(const T* numericValues, const int* symbolicCodes, size_t numRows) const
+{
+    const size_t numFeatures = _featureNames.size();
+
+    // Every node on the path of a sample is passed through, so the traffic of a node is that of the exits below it
+    vector<size_t> traffic(_nodes.size(), 0);
+    for (size_t row = 0; row < numRows; row++) {
+        const T* numericRow    = numericValues ? numericValues + row * numFeatures : nullptr;
+        const int* symbolicRow = symbolicCodes ? symbolicCodes + row * numFeatures : nullptr;
+        traffic[descend(numericRow, symbolicRow)]++;
+    }
+    addSubtreeTraffic(0, traffic);
+
+    map<int, size_t> nodeTraffic;
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        nodeTraffic[_nodes[i].serialNum] = traffic[i];
+    }
+    return nodeTraffic;
+}
+
+/**
+ * @brief Reorders the node array for the cache.
+ *
+ * The children of every node stay adjacent and in their order, which the descent depends on, and only the order of
+ * these blocks changes, so the predictions do not.
+ *
+ * @param layout The new order of the nodes.
+ * @param traffic For HOT_PATH, the number of samples through each node by serial number, as from countTraffic().
+ * Nodes that are not in it count as never visited.
+ * @throws std::invalid_argument If the layout is HOT_PATH and there is no traffic.
+ */
+void CompiledDecisionTree::relayout(NodeLayout layout, const map<int, size_t> &traffic)
+{
+    if (layout == NodeLayout::HOT_PATH && traffic.empty()) {
+        throw std::invalid_argument("The HOT_PATH layout needs the traffic through the nodes; see countTraffic().");
+    }
+
+    vector<size_t> nodeTraffic(_nodes.size(), 0);
+    if (layout == NodeLayout::HOT_PATH) {
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            auto it        = traffic.find(_nodes[i].serialNum);
+            nodeTraffic[i] = it != traffic.end() ? it->second : 0;
+        }
+    }
+
+    // The blocks in their new order, each given by the index of the node whose children it holds, -1 for the root
+    vector<int> order;
+    switch (layout) {
+    case NodeLayout::DEPTH_FIRST:
+    case NodeLayout::HOT_PATH:
+        orderBlocksDepthFirst(-1, nodeTraffic, order);
+        break;
+    case NodeLayout::BREADTH_FIRST:
+        orderBlocksBreadthFirst(order);
+        break;
+    case NodeLayout::VAN_EMDE_BOAS:
+        orderBlocksVanEmdeBoas(-1, blockHeight(-1), order);
+        break;
+    }
+
+    vector<int> newIndex(_nodes.size());
+    int next = 0;
+    for (int parent : order) {
+        const auto [first, count] = blockRange(parent);
+        for (int i = first; i < first + count; i++) {
+            newIndex[i] = next++;
+        }
+    }
+
+    const size_t numClasses = _classNames.size();
+    vector<CompiledNode> nodes(_nodes.size());
+    vector<double> classProbabilities(_classProbabilities.size());
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        CompiledNode &node = nodes[newIndex[i]];
+        node               = _nodes[i];
+        node.firstChild    = node.numChildren > 0 ? newIndex[node.firstChild] : static_cast<int>(_nodes.size());
+        std::copy(_classProbabilities.begin() + i * numClasses,
+                  _classProbabilities.begin() + (i + 1) * numClasses,
+                  classProbabilities.begin() + newIndex[i] * numClasses);
+    }
+
+    _nodes              = std::move(nodes);
+    _classProbabilities = std::move(classProbabilities);
+    _layout             = layout;
+}
+
+
+//--------------- Classify ----------------//
+
+/**
+ * @brief Computes the class probabilities for a batch of samples.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues A row-major numRows x getNumFeatures() array of numeric values, or nullptr if all the features
+ * are given as symbolic codes. NaN marks a missing value.
+ * @param symbolicCodes A row-major numRows x getNumFeatures() array of symbolic value codes, or nullptr if all the
+ * features are given as numeric values. A negative code marks a value to be read from the numeric array instead.
+ * @param numRows The number of samples.
+ * @param probabilities A row-major numRows x getNumClasses() array into which the class probabilities are written.
+ */
+template <typename T>
+void CompiledDecisionTree::predictProba(const T* numericValues,
+                                        const int* symbolicCodes,
+                                        size_t numRows,
+                                        double* probabilities) const
+{
+    // Rows are scored in blocks, which are spread over the threads when the library is built with OpenMP
+    const long long numBlocks = static_cast<long long>((numRows + PREDICT_BLOCK_SIZE - 1) / PREDICT_BLOCK_SIZE);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (numBlocks > 1)
+#endif
+    for (long long block = 0; block < numBlocks; block++) {
+        const size_t begin = static_cast<size_t>(block) * PREDICT_BLOCK_SIZE;
+        const size_t end   = std::min(numRows, begin + PREDICT_BLOCK_SIZE);
+        predictProbaRows(numericValues, symbolicCodes, begin, end, probabilities);
+    }
+}
+
+/**
+ * @brief Computes the class probabilities for a single sample.
+ *
+ * @param numericValues The numeric values of the sample, one per feature, or an empty vector.
+ * @param symbolicCodes The symbolic value codes of the sample, one per feature, or an empty vector.
+ * @return The class probabilities, in the order of getClassNames().
+ * @throws std::invalid_argument If a non-empty vector does not have one entry per feature.
+ */
+vector<double> CompiledDecisionTree::predictProba(const vector<double> &numericValues,
+                                                  const vector<int> &symbolicCodes) const
+{
+    if ((!numericValues.empty() && numericValues.size() != _featureNames.size()) ||
+        (!symbolicCodes.empty() && symbolicCodes.size() != _featureNames.size())) {
+        throw std::invalid_argument("Expected one value per feature: " + std::to_string(_featureNames.size()));
+    }
+
+    vector<double> probabilities(_classNames.size());
+    predictProba(numericValues.empty() ? nullptr : numericValues.data(),
+                 symbolicCodes.empty() ? nullptr : symbolicCodes.data(),
+                 1,
+                 probabilities.data());
+
+    return probabilities;
+}
+
+/**
+ * @brief Finds the node at which the descent of a single sample ends.
+ *
+ * @param numericValues The numeric values of the sample, or nullptr.
+ * @param symbolicCodes The symbolic value codes of the sample, or nullptr.
+ * @return The serial number of the node in the original DecisionTree.
+ */
+int CompiledDecisionTree::predictLeaf(const double* numericValues, const int* symbolicCodes) const
+{
+    return _nodes[descend(numericValues, symbolicCodes)].serialNum;
+}
+
+/**
+ * @brief Returns the code of a symbolic value of a feature.
+ *
+ * @param feature The name of the feature.
+ * @param value The symbolic value.
+ * @return The index of the value in getSymbolicValues()[feature], or -1 if the value was not seen in the training data
+ * or the feature is numeric.
+ */
+int CompiledDecisionTree::encodeSymbolicValue(const string &feature, const string &value) const
+{
+    auto it = _symbolicValues.find(feature);
+    if (it == _symbolicValues.end()) {
+        return -1;
+    }
+
+    auto valueIt = std::lower_bound(it->second.begin(), it->second.end(), value);
+    if (valueIt == it->second.end() || *valueIt != value) {
+        return -1;
+    }
+
+    return static_cast<int>(valueIt - it->second.begin());
+}
+
+/**
+ * @brief Appends the values of a sample to the arrays taken by predictProba().
+ *
+ * Every value is appended to the numeric array as a number, NaN if it is not one (such as NA), and to the symbolic
+ * array as its code, -1 if it has none.
+ *
+ * @param values The values of the sample, in the order of getFeatureNames(), as in the training data.
+ * @param numericValues The row-major numeric values, to which the row is appended.
+ * @param symbolicCodes The row-major symbolic codes, to which the row is appended.
+ */
+void CompiledDecisionTree::encodeRow(const vector<string> &values,
+                                     vector<double> &numericValues,
+                                     vector<int> &symbolicCodes) const
+{
+    for (size_t i = 0; i < values.size(); i++) {
+        numericValues.push_back(convert(values[i]));
+        symbolicCodes.push_back(encodeSymbolicValue(_featureNames[i], values[i]));
+    }
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Computes the class probabilities for the rows [begin, end) of a batch.
+ *
+ * This is the inner loop of predictProba(), and is multiversioned for the vector extensions of the CPU.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues The numeric values of the whole batch, or nullptr.
+ * @param symbolicCodes The symbolic value codes of the whole batch, or nullptr.
+ * @param begin The first row to score.
+ * @param end One past the last row to score.
+ * @param probabilities The class probabilities of the whole batch.
+ */
+template <typename T>
+DTPP_MULTIVERSION void CompiledDecisionTree::predictProbaRows(
+    const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const
+{
+    const size_t numFeatures = _featureNames.size();
+    const size_t numClasses  = _classNames.size();
+
+    for (size_t row = begin; row < end; row++) {
+        const T* numericRow    = numericValues ? numericValues + row * numFeatures : nullptr;
+        const int* symbolicRow = symbolicCodes ? symbolicCodes + row * numFeatures : nullptr;
+        int nodeIndex          = descend(numericRow, symbolicRow);
+
+        std::copy(_classProbabilities.begin() + nodeIndex * numClasses,
+                  _classProbabilities.begin() + (nodeIndex + 1) * numClasses,
+                  probabilities + row * numClasses);
+    }
+}
+
+/**
+ * @brief Copies a node into the node array and recursively compiles its children.
+ *
+ * The children of the node are given consecutive slots at the end of the node array before any of them is compiled,
+ * which keeps them adjacent.
+ *
+ * @param node A pointer to the node to compile.
+ * @param index The slot of the node in the node array.
+ */
+void CompiledDecisionTree::compileNode(DecisionTreeNode* node, int index)
+{
+    const size_t numClasses           = _classNames.size();
+    vector<double> classProbabilities = node->GetClassProbabilities();
+    std::copy(classProbabilities.begin(), classProbabilities.end(), _classProbabilities.begin() + index * numClasses);
+
+    vector<DecisionTreeNode*> children = node->GetChildren();
+    const string feature               = node->GetFeature();
+    auto featureIt                     = std::find(_featureNames.begin(), _featureNames.end(), feature);
+
+    _nodes[index].serialNum    = node->GetSerialNum();
+    _nodes[index].featureIndex = -1;
+    _nodes[index].firstChild   = static_cast<int>(_nodes.size());
+    _nodes[index].numChildren  = 0;
+
+    if (children.empty() || featureIt == _featureNames.end()) {
+        return;
+    }
+
+    const int featureIndex     = static_cast<int>(featureIt - _featureNames.begin());
+    _nodes[index].featureIndex = featureIndex;
+    _nodes[index].numChildren  = static_cast<int>(children.size());
+
+    const int firstChild = static_cast<int>(_nodes.size());
+    _nodes.resize(_nodes.size() + children.size());
+    _classProbabilities.resize(_nodes.size() * numClasses);
+
+    for (size_t i = 0; i < children.size(); i++) {
+        // The last test on the branch of a child is on the feature tested at its parent
+        const string featureTest = children[i]->GetBranchFeaturesAndValuesOrThresholds().back();
+        const string value       = featureTest.substr(feature.size() + 1);
+
+        CompiledNode &child = _nodes[firstChild + i];
+        child.op            = featureTest[feature.size()];
+        child.value         = convert(value);
+        child.code          = child.op == '=' ? encodeSymbolicValue(feature, value) : -1;
+
+        compileNode(children[i], firstChild + static_cast<int>(i));
+    }
+}
+
+/**
+ * @brief Descends the compiled tree for a single sample.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericRow The numeric values of the sample, or nullptr.
+ * @param symbolicRow The symbolic value codes of the sample, or nullptr.
+ * @return The index in the node array of the node at which the descent ends.
+ */
+template <typename T> int CompiledDecisionTree::descend(const T* numericRow, const int* symbolicRow) const
+{
+    int nodeIndex = 0;
+
+    while (true) {
+        const CompiledNode &node = _nodes[nodeIndex];
+        if (node.numChildren == 0) {
+            return nodeIndex;
+        }
+
+        const int featureIndex = node.featureIndex;
+        const int code         = symbolicRow ? symbolicRow[featureIndex] : -1;
+        const double value     = numericRow ? static_cast<double>(numericRow[featureIndex]) : std::nan("");
+        int nextIndex          = -1;
+
+        if (_featureIsNumeric[featureIndex] || code < 0) {
+            if (std::isnan(value)) {
+                return nodeIndex;
+            }
+
+            for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+                const CompiledNode &child = _nodes[i];
+                if ((child.op == '<' && value <= child.value) || (child.op == '>' && value > child.value) ||
+                    (child.op == '=' && value == child.value)) {
+                    nextIndex = i;
+                    break;
+                }
+            }
+        }
+        else {
+            for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+                if (_nodes[i].code == code) {
+                    nextIndex = i;
+                    break;
+                }
+            }
+        }
+
+        if (nextIndex < 0) {
+            return nodeIndex;
+        }
+        nodeIndex = nextIndex;
+    }
+}
+
+
+/**
+ * @brief The nodes of a block: the children of a node, or the root alone.
+ *
+ * @param parent The index of the node whose children the block holds, or -1 for the root.
+ * @return The index of the first node of the block and the number of nodes in it.
+ */
+pair<int, int> CompiledDecisionTree::blockRange(int parent) const
+{
+    if (parent < 0) {
+        return {0, 1};
+    }
+    return {_nodes[parent].firstChild, _nodes[parent].numChildren};
+}
+
+/**
+ * @brief Turns the number of samples ending at every node of a subtree into the number passing through it.
+ *
+ * @return The traffic through the root of the subtree.
+ */
+size_t CompiledDecisionTree::addSubtreeTraffic(int index, vector<size_t> &traffic) const
+{
+    const CompiledNode &node = _nodes[index];
+    for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+        traffic[index] += addSubtreeTraffic(i, traffic);
+    }
+    return traffic[index];
+}
+
+/**
+ * @brief Appends a block and the blocks below it in depth-first order, visiting the nodes of every block by decreasing
+ * traffic and in their order on ties.
+ */
+void CompiledDecisionTree::orderBlocksDepthFirst(int parent, const vector<size_t> &traffic, vector<int> &order) const
+{
+    order.push_back(parent);
+
+    const auto [first, count] = blockRange(parent);
+    vector<int> members;
+    for (int i = first; i < first + count; i++) {
+        members.push_back(i);
+    }
+    std::stable_sort(members.begin(), members.end(), [&](int a, int b) { return traffic[a] > traffic[b]; });
+
+    for (int member : members) {
+        if (_nodes[member].numChildren > 0) {
+            orderBlocksDepthFirst(member, traffic, order);
+        }
+    }
+}
+
+/**
+ * @brief Lists all the blocks level by level.
+ */
+void CompiledDecisionTree::orderBlocksBreadthFirst(vector<int> &order) const
+{
+    order.push_back(-1);
+    for (size_t k = 0; k < order.size(); k++) {
+        const auto [first, count] = blockRange(order[k]);
+        for (int i = first; i < first + count; i++) {
+            if (_nodes[i].numChildren > 0) {
+                order.push_back(i);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Appends the blocks of the first levels below a block in van Emde Boas order: the top half of the levels, then
+ * each subtree hanging from them, both laid out the same way.
+ *
+ * @param parent The block at the top.
+ * @param height The number of levels of blocks to lay out, counting the top one.
+ * @param order The order of the blocks, appended to.
+ */
+void CompiledDecisionTree::orderBlocksVanEmdeBoas(int parent, int height, vector<int> &order) const
+{
+    if (height <= 1) {
+        order.push_back(parent);
+        return;
+    }
+
+    const int topHeight = height / 2;
+    orderBlocksVanEmdeBoas(parent, topHeight, order);
+
+    vector<int> bottoms;
+    blocksAtDepth(parent, topHeight, bottoms);
+    for (int bottom : bottoms) {
+        orderBlocksVanEmdeBoas(bottom, height - topHeight, order);
+    }
+}
+
+/**
+ * @brief Appends the blocks a given number of levels below a block, from left to right.
+ */
+void CompiledDecisionTree::blocksAtDepth(int parent, int depth, vector<int> &blocks) const
+{
+    if (depth == 0) {
+        blocks.push_back(parent);
+        return;
+    }
+
+    const auto [first, count] = blockRange(parent);
+    for (int i = first; i < first + count; i++) {
+        if (_nodes[i].numChildren > 0) {
+            blocksAtDepth(i, depth - 1, blocks);
+        }
+    }
+}
+
+/**
+ * @brief The number of levels of blocks from a block down to the deepest block below it.
+ */
+int CompiledDecisionTree::blockHeight(int parent) const
+{
+    int height                = 1;
+    const auto [first, count] = blockRange(parent);
+    for (int i = first; i < first + count; i++) {
+        if (_nodes[i].numChildren > 0) {
+            height = std::max(height, 1 + blockHeight(i));
+        }
+    }
+    return height;
+}
+
+
+//--------------- Explicit Instantiations ----------------//
+template void CompiledDecisionTree::predictProba<double>(const double*, const int*, size_t, double*) const;
+template void CompiledDecisionTree::predictProba<float>(const float*, const int*, size_t, double*) const;
+template map<int, size_t> CompiledDecisionTree::countTraffic<double>(const double*, const int*, size_t) const;
+template map<int, size_t> CompiledDecisionTree::countTraffic<float>(const float*, const int*, size_t) const;
@@ -0,0 +1,271 @@
+#include "ContingencyCube.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+/**
+ * @brief Constructs an empty cube for features with the given values.
+ *
+ * @param featureValues The values of each feature, sorted, with no duplicates.
+ * @param numClasses The number of classes.
+ */
+ContingencyCube::ContingencyCube(vector<vector<string>> featureValues, size_t numClasses)
+    : _featureValues(std::move(featureValues)), _numClasses(numClasses)
+{
+    _strides.assign(_featureValues.size(), 0);
+    size_t stride = _numClasses + 1;
+    for (size_t i = _featureValues.size(); i-- > 0;) {
+        _strides[i] = stride;
+        stride *= std::max<size_t>(_featureValues[i].size(), 1);
+    }
+    _counts.assign(stride, 0);
+}
+
+/**
+ * @brief Returns the number of cells of a cube for features with the given values, or SIZE_MAX if it overflows.
+ */
+size_t ContingencyCube::numCells(const vector<vector<string>> &featureValues, size_t numClasses)
+{
+    size_t cells = numClasses + 1;
+    for (const auto &values : featureValues) {
+        const size_t cardinality = std::max<size_t>(values.size(), 1);
+        if (cells > std::numeric_limits<size_t>::max() / cardinality) {
+            return std::numeric_limits<size_t>::max();
+        }
+        cells *= cardinality;
+    }
+    return cells;
+}
+
+//--------------- Filling ----------------//
+
+/**
+ * @brief Adds samples with the given value codes and class to the cube, dropping the marginals summed so far.
+ *
+ * @param valueCodes The code of the value of every feature.
+ * @param classIndex The index of the class, or ANY for samples without a class label.
+ * @param weight The number of samples.
+ *
+ * @throws std::invalid_argument If a code is out of range.
+ */
+void ContingencyCube::add(const vector<int> &valueCodes, int classIndex, uint32_t weight)
+{
+    if (valueCodes.size() != _featureValues.size() || classIndex >= static_cast<int>(_numClasses)) {
+        throw std::invalid_argument("ContingencyCube: the sample does not fit the cube");
+    }
+
+    size_t cell = classSlot(classIndex);
+    for (size_t i = 0; i < valueCodes.size(); ++i) {
+        if (valueCodes[i] < 0 || static_cast<size_t>(valueCodes[i]) >= _featureValues[i].size()) {
+            throw std::invalid_argument("ContingencyCube: the value code " + std::to_string(valueCodes[i]) +
+                                        " of feature " + std::to_string(i) + " is out of range");
+        }
+        cell += valueCodes[i] * _strides[i];
+    }
+    _counts[cell] += weight;
+
+    if (!_branchMarginals.empty()) {
+        clearBranchMarginals();
+    }
+}
+
+//--------------- Queries ----------------//
+
+/**
+ * @brief Returns the code of a value of a feature, or ANY if the feature does not have the value.
+ */
+int ContingencyCube::valueCode(size_t feature, const string &value) const
+{
+    const vector<string> &values = _featureValues[feature];
+    auto it                      = std::lower_bound(values.begin(), values.end(), value);
+    return it != values.end() && *it == value ? static_cast<int>(it - values.begin()) : ANY;
+}
+
+/**
+ * @brief Returns the marginals of a branch, summing them over its cells the first time the branch is queried.
+ *
+ * @param valueCodes The code of the value of every feature, or ANY for a feature that is not on the branch.
+ */
+const ContingencyCube::Marginals &ContingencyCube::marginals(const vector<int> &valueCodes)
+{
+    auto cached = _branchMarginals.find(valueCodes);
+    if (cached != _branchMarginals.end()) {
+        return cached->second;
+    }
+
+    Marginals branch = sumBranch(valueCodes);
+    size_t bytes     = sizeof(pair<const vector<int>, Marginals>) + 4 * sizeof(void*) +
+                   valueCodes.size() * sizeof(int) + branch.classTotals.size() * sizeof(uint64_t);
+    for (const auto &counts : branch.valueCounts) {
+        bytes += sizeof(counts) + counts.size() * sizeof(uint64_t);
+    }
+    _branchMarginalsBytes += bytes;
+    return _branchMarginals.emplace(valueCodes, std::move(branch)).first->second;
+}
+
+/**
+ * @brief Counts the samples with the given values of some of the features, in a class.
+ *
+ * A branch whose marginals have been summed is counted from them. Otherwise the branch is one feature longer than the
+ * branch without its last fixed feature, and is counted from the marginals of that one, so that the children of a node
+ * are counted from the marginals of the node without a pass of their own.
+ *
+ * @param valueCodes The code of the value of every feature, or ANY for a feature that may have any value.
+ * @param classIndex The index of the class, or ANY for every sample.
+ * @return The number of samples.
+ */
+uint64_t ContingencyCube::count(const vector<int> &valueCodes, int classIndex)
+{
+    if (_counts.empty()) {
+        return 0;
+    }
+
+    auto cached = _branchMarginals.find(valueCodes);
+    if (cached != _branchMarginals.end()) {
+        return slotCount(cached->second.classTotals.data(), classIndex);
+    }
+
+    for (size_t i = valueCodes.size(); i-- > 0;) {
+        if (valueCodes[i] != ANY) {
+            vector<int> parentCodes = valueCodes;
+            parentCodes[i]          = ANY;
+            return slotCount(marginals(parentCodes).valueCounts[i].data() + valueCodes[i] * (_numClasses + 1),
+                             classIndex);
+        }
+    }
+    return slotCount(marginals(valueCodes).classTotals.data(), classIndex);
+}
+
+/**
+ * @brief Returns the number of samples with a value of a feature in a class, from the marginals of the whole cube.
+ *
+ * @param feature The index of the feature.
+ * @param valueCode The code of the value.
+ * @param classIndex The index of the class, or ANY for every sample.
+ */
+uint64_t ContingencyCube::featureValueCount(size_t feature, int valueCode, int classIndex)
+{
+    const vector<uint64_t> &counts = marginals(vector<int>(_featureValues.size(), ANY)).valueCounts[feature];
+    return slotCount(counts.data() + valueCode * (_numClasses + 1), classIndex);
+}
+
+/**
+ * @brief Returns the number of samples in a class, or of every sample for ANY.
+ */
+uint64_t ContingencyCube::classCount(int classIndex)
+{
+    return slotCount(marginals(vector<int>(_featureValues.size(), ANY)).classTotals.data(), classIndex);
+}
+
+/**
+ * @brief Returns the count of a class slot among the counts of every slot, or the sum of every slot for ANY.
+ */
+uint64_t ContingencyCube::slotCount(const uint64_t* slotCounts, int classIndex) const
+{
+    if (classIndex != ANY) {
+        return slotCounts[classSlot(classIndex)];
+    }
+
+    uint64_t total = 0;
+    for (size_t slot = 0; slot <= _numClasses; ++slot) {
+        total += slotCounts[slot];
+    }
+    return total;
+}
+
+/**
+ * @brief Sums the marginals of a branch in one pass over its cells.
+ *
+ * The cells are walked like an odometer over the axes of the features that are not fixed, with the innermost axis
+ * last. The value counts of a fixed feature are those of its fixed value, which are the class totals of the branch.
+ */
+ContingencyCube::Marginals ContingencyCube::sumBranch(const vector<int> &valueCodes) const
+{
+    const size_t numSlots = _numClasses + 1;
+    Marginals branch;
+    branch.classTotals.assign(numSlots, 0);
+    branch.valueCounts.resize(_featureValues.size());
+    for (size_t i = 0; i < _featureValues.size(); ++i) {
+        branch.valueCounts[i].assign(_featureValues[i].size() * numSlots, 0);
+    }
+    if (_counts.empty()) {
+        return branch;
+    }
+
+    size_t base = 0;
+    vector<size_t> freeAxes;
+    for (size_t i = 0; i < _featureValues.size(); ++i) {
+        if (i < valueCodes.size() && valueCodes[i] != ANY) {
+            base += valueCodes[i] * _strides[i];
+        }
+        else if (!_featureValues[i].empty()) {
+            freeAxes.push_back(i);
+        }
+    }
+
+    vector<size_t> position(freeAxes.size(), 0);
+    size_t cell = base;
+    while (true) {
+        for (size_t slot = 0; slot < numSlots; ++slot) {
+            const uint32_t count = _counts[cell + slot];
+            if (count == 0) {
+                continue;
+            }
+            branch.classTotals[slot] += count;
+            for (size_t axis = 0; axis < freeAxes.size(); ++axis) {
+                branch.valueCounts[freeAxes[axis]][position[axis] * numSlots + slot] += count;
+            }
+        }
+
+        bool advanced = false;
+        for (size_t axis = freeAxes.size(); axis-- > 0;) {
+            const size_t feature = freeAxes[axis];
+            cell += _strides[feature];
+            if (++position[axis] < _featureValues[feature].size()) {
+                advanced = true;
+                break;
+            }
+            cell -= position[axis] * _strides[feature];
+            position[axis] = 0;
+        }
+        if (!advanced) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < _featureValues.size(); ++i) {
+        if (i < valueCodes.size() && valueCodes[i] != ANY) {
+            std::copy(branch.classTotals.begin(),
+                      branch.classTotals.end(),
+                      branch.valueCounts[i].begin() + valueCodes[i] * numSlots);
+        }
+    }
+    return branch;
+}
+
+//--------------- Memory ----------------//
+
+/**
+ * @brief Returns the estimated bytes held by the cube, without the marginals of the branches.
+ */
+size_t ContingencyCube::bytes() const
+{
+    size_t bytes =
+        sizeof(ContingencyCube) + _counts.capacity() * sizeof(uint32_t) + _strides.capacity() * sizeof(size_t);
+    for (const auto &values : _featureValues) {
+        bytes += sizeof(values);
+        for (const auto &value : values) {
+            bytes += sizeof(string) + (value.capacity() > 15 ? value.capacity() + 1 : 0);
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Drops the marginals of every branch. They are summed again when the branches are next queried.
+ */
+void ContingencyCube::clearBranchMarginals()
+{
+    _branchMarginals.clear();
+    _branchMarginalsBytes = 0;
+}
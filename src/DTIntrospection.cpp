@@ -19,6 +19,8 @@ DTIntrospection::DTIntrospection(shared_ptr<DecisionTree> dt)
     _branchFeaturesToNodesDict     = {};
     _sampleToNodeMappingDirectDict = {};
     _nodeSerialNumToNodeDict       = {};
+    _lazySamplesAtNodesDict        = {};
+    _lazyNodePathsForSamplesDict   = {};
     _awarenessRaisingMessageShown  = 0;
     _debug                         = 0;
 }
@@ -34,6 +36,7 @@ DTIntrospection::DTIntrospection(shared_ptr<DecisionTree> dt)
  * - Clears the dictionary that maps branch features to nodes.
  * - Clears the dictionary that maps samples directly to nodes.
  * - Clears the dictionary that maps node serial numbers to nodes.
+ * - Clears the memoized results of the lazy queries.
  */
 DTIntrospection::~DTIntrospection()
 {
@@ -43,6 +46,8 @@ DTIntrospection::~DTIntrospection()
     _branchFeaturesToNodesDict.clear();
     _sampleToNodeMappingDirectDict.clear();
     _nodeSerialNumToNodeDict.clear();
+    _lazySamplesAtNodesDict.clear();
+    _lazyNodePathsForSamplesDict.clear();
 }
 
 /**
@@ -66,6 +71,32 @@ void DTIntrospection::initialize()
     recursiveDescent(_rootNode);
 }
 
+/**
+ * @brief Initializes the DTIntrospection object for on-demand queries only.
+ *
+ * Unlike initialize(), this function does not scan the training data and does not fill the samples-at-nodes or
+ * sample-to-node dictionaries. It only indexes the node pointers by serial number. The samples at a node and the node
+ * path of a sample are then computed the first time they are asked for through getSamplesAtNode() and
+ * getNodePathForSample(), and memoized for subsequent queries.
+ *
+ * @throws std::runtime_error If the root node is not set.
+ */
+void DTIntrospection::initializeLazy()
+{
+    _rootNode = _dt->getRootNode();
+
+    if (_rootNode == nullptr) {
+        throw std::runtime_error(
+            "Root node is not set. You must first construct the decision tree before using introspection.");
+    }
+
+    _nodeSerialNumToNodeDict.clear();
+    _branchFeaturesToNodesDict.clear();
+    _lazySamplesAtNodesDict.clear();
+    _lazyNodePathsForSamplesDict.clear();
+    indexNodes(_rootNode);
+}
+
 
 //--------------- Recursive Descent ----------------//
 
@@ -81,7 +112,8 @@ void DTIntrospection::initialize()
  * The function performs the following steps:
  * 1. Stores the node in a dictionary using its serial number.
  * 2. Retrieves and optionally prints the branch features and values or thresholds.
- * 3. Determines the samples at the node by intersecting samples for each feature-value combination.
+ * 3. Determines the samples at the node from the routing index of the decision tree if it has one, and otherwise by
+ *    intersecting samples for each feature-value combination.
  * 4. Sorts the samples at the node.
  * 5. Optionally prints the samples at the node.
  * 6. Converts the samples at the node to a vector of strings.
@@ -109,21 +141,26 @@ void DTIntrospection::recursiveDescent(DecisionTreeNode* node)
     // Determine Samples at the Node
     optional<vector<int>> samplesAtNode;
 
-    for (const auto &item : branchFeaturesAndValuesOrThresholds) {
-        vector<int> samplesForFeatureValueCombo = getSamplesForFeatureValueCombo(item);
-        if (!samplesAtNode.has_value()) {
-            samplesAtNode = samplesForFeatureValueCombo;
-        }
-        else {
-            // Intersect with existing samplesAtNode
-            vector<int> intersection;
-            std::set_intersection(samplesAtNode->begin(),
-                                  samplesAtNode->end(),
-                                  samplesForFeatureValueCombo.begin(),
-                                  samplesForFeatureValueCombo.end(),
-                                  std::back_inserter(intersection));
-
-            samplesAtNode = intersection;
+    if (_dt->hasRoutingIndex() && !branchFeaturesAndValuesOrThresholds.empty()) {
+        samplesAtNode = samplesFromRoutingIndex(nodeSerialNum);
+    }
+    else {
+        for (const auto &item : branchFeaturesAndValuesOrThresholds) {
+            vector<int> samplesForFeatureValueCombo = getSamplesForFeatureValueCombo(item);
+            if (!samplesAtNode.has_value()) {
+                samplesAtNode = samplesForFeatureValueCombo;
+            }
+            else {
+                // Intersect with existing samplesAtNode
+                vector<int> intersection;
+                std::set_intersection(samplesAtNode->begin(),
+                                      samplesAtNode->end(),
+                                      samplesForFeatureValueCombo.begin(),
+                                      samplesForFeatureValueCombo.end(),
+                                      std::back_inserter(intersection));
+
+                samplesAtNode = intersection;
+            }
         }
     }
 
@@ -224,11 +261,11 @@ void DTIntrospection::recursiveDescentForShowingSamplesAtANode(DecisionTreeNode*
  * @param offset The indentation offset used for displaying the hierarchical influence path.
  */
 void DTIntrospection::recursiveDescentForSampleToNodeInfluence(int nodeSerialNum,
-                                                               vector<int> nodesAlreadyAccountedFor,
+                                                               const vector<int> &nodesAlreadyAccountedFor,
                                                                int offset)
 {
     offset += 4;
-    DecisionTreeNode* node             = _nodeSerialNumToNodeDict[nodeSerialNum];
+    DecisionTreeNode* node             = findNode(nodeSerialNum);
     vector<DecisionTreeNode*> children = node->GetChildren();
     vector<int> childrenSerialNums;
 
@@ -294,24 +331,32 @@ void DTIntrospection::displayTrainingSamplesAtAllNodesDirectInfluenceOnly()
  * descends to display nodes affected through probabilistic generalization.
  *
  * The function performs the following steps:
- * 1. Retrieves the training data dictionary from the decision tree.
- * 2. Iterates through each sample in the training data dictionary.
- * 3. Converts the sample identifier to a string.
- * 4. Checks if the sample has a direct node mapping.
- * 5. If a direct mapping exists, prints the nodes directly affected by the sample.
- * 6. Recursively descends to display nodes affected through probabilistic generalization.
+ * 1. Iterates through each sample in the training data dictionary of the decision tree.
+ * 2. Finds the nodes containing the sample, on the path to its leaf in the routing index of the decision tree if it has
+ *    one, and otherwise in the direct sample-to-node mapping built by initialize().
+ * 3. If the sample is at any node, prints the nodes directly affected by the sample.
+ * 4. Recursively descends to display nodes affected through probabilistic generalization.
  *
  * @note The recursion depth for the probabilistic generalization is limited to 4.
  */
 void DTIntrospection::displayTrainingSamplesToNodesInfluencePropagation()
 {
-    auto trainingDataDict = _dt->getTrainingDataDict();
+    const bool fromRoutingIndex = _rootNode != nullptr && _dt->hasRoutingIndex();
 
-    for (const auto &samplePair : trainingDataDict) {
+    for (const auto &samplePair : _dt->_trainingDataDict) {
         const string sample = std::to_string(samplePair.first);
 
-        if (_sampleToNodeMappingDirectDict.find(sample) != _sampleToNodeMappingDirectDict.end()) {
-            vector<int> nodesDirectlyAffected = _sampleToNodeMappingDirectDict[sample];
+        // The nodes containing the sample are the path to its leaf, if there is a routing index to read it off
+        const vector<int>* nodesContainingSample = nullptr;
+        if (fromRoutingIndex) {
+            nodesContainingSample = &getNodePathForSample(samplePair.first);
+        }
+        else if (auto it = _sampleToNodeMappingDirectDict.find(sample); it != _sampleToNodeMappingDirectDict.end()) {
+            nodesContainingSample = &it->second;
+        }
+
+        if (nodesContainingSample != nullptr && !nodesContainingSample->empty()) {
+            const vector<int> &nodesDirectlyAffected = *nodesContainingSample;
             cout << "\n"
                  << sample << ":\n"
                  << "   nodes affected directly: ";
@@ -324,8 +369,7 @@ void DTIntrospection::displayTrainingSamplesToNodesInfluencePropagation()
             cout << "   nodes affected through probabilistic generalization:" << endl;
 
             for (const auto &nodeSerialNum : nodesDirectlyAffected) {
-                vector<int> nodesAlreadyAccountedFor = nodesDirectlyAffected;
-                recursiveDescentForSampleToNodeInfluence(nodeSerialNum, nodesAlreadyAccountedFor, 4);
+                recursiveDescentForSampleToNodeInfluence(nodeSerialNum, nodesDirectlyAffected, 4);
             }
         }
     }
@@ -570,6 +614,157 @@ void DTIntrospection::explainClassificationAtOneNode(int nodeId)
 }
 
 
+//--------------- Lazy Queries ----------------//
+
+/**
+ * @brief Returns the training samples that fall in the region of the feature space assigned to a node.
+ *
+ * The samples are computed on the first call for a given node, either from the routing index of the decision tree or,
+ * if it has none, with a single pass over the training data, testing every sample against all the feature tests on
+ * the branch leading to the node. The result is memoized, so later calls for the same node are a lookup. The root
+ * node has no feature tests on its branch and, as with initialize(), has no samples associated with it.
+ *
+ * @param nodeSerialNum The serial number of the node.
+ * @return A const reference to the sample IDs at the node, sorted in increasing order. The reference stays valid for
+ * the lifetime of this DTIntrospection object or until initializeLazy() is called again.
+ * @throws std::runtime_error If the introspection instance has not been initialized or the node does not exist.
+ */
+const vector<int> &DTIntrospection::getSamplesAtNode(int nodeSerialNum)
+{
+    auto it = _lazySamplesAtNodesDict.find(nodeSerialNum);
+    if (it != _lazySamplesAtNodesDict.end()) {
+        return it->second;
+    }
+
+    const vector<string> &branchFeatures = getBranchFeaturesAtNode(nodeSerialNum);
+    vector<int> samplesAtNode;
+
+    if (!branchFeatures.empty() && _dt->hasRoutingIndex()) {
+        samplesAtNode = samplesFromRoutingIndex(nodeSerialNum);
+    }
+    else if (!branchFeatures.empty()) {
+        vector<FeatureOpValue> featureOpValues;
+        for (const auto &item : branchFeatures) {
+            featureOpValues.push_back(extractFeatureOpValue(item));
+        }
+
+        for (const auto &samplePair : _dt->_trainingDataDict) {
+            bool satisfiesAll = true;
+            for (const auto &featureOpValue : featureOpValues) {
+                if (!sampleSatisfiesFeatureValueCombo(samplePair.second, featureOpValue)) {
+                    satisfiesAll = false;
+                    break;
+                }
+            }
+
+            if (satisfiesAll) {
+                samplesAtNode.push_back(samplePair.first);
+            }
+        }
+    }
+
+    if (_debug) {
+        cout << "Node: " << nodeSerialNum << " the samples are: " << samplesAtNode << endl;
+    }
+
+    return _lazySamplesAtNodesDict.emplace(nodeSerialNum, std::move(samplesAtNode)).first->second;
+}
+
+/**
+ * @brief Returns the feature tests on the branch leading to a node.
+ *
+ * The branch is copied out of the node only the first time it is asked for and is then kept in
+ * _branchFeaturesToNodesDict, which is the same dictionary that initialize() fills eagerly.
+ *
+ * @param nodeSerialNum The serial number of the node.
+ * @return A const reference to the branch features and values or thresholds of the node.
+ * @throws std::runtime_error If the introspection instance has not been initialized or the node does not exist.
+ */
+const vector<string> &DTIntrospection::getBranchFeaturesAtNode(int nodeSerialNum)
+{
+    auto it = _branchFeaturesToNodesDict.find(nodeSerialNum);
+    if (it != _branchFeaturesToNodesDict.end()) {
+        return it->second;
+    }
+
+    DecisionTreeNode* node = findNode(nodeSerialNum);
+    return _branchFeaturesToNodesDict.emplace(nodeSerialNum, node->GetBranchFeaturesAndValuesOrThresholds())
+        .first->second;
+}
+
+/**
+ * @brief Returns the nodes whose region of the feature space contains a given training sample.
+ *
+ * If the decision tree has a routing index, the path is read off the chain of parents of the leaf of the sample.
+ * Otherwise, since the branch of every child node extends the branch of its parent by one feature test, the nodes
+ * containing a sample form a subtree hanging from the root. This function descends only into the children whose last
+ * feature test the sample satisfies, so it never visits the rest of the tree and never rescans the training data. The
+ * nodes are returned in the same depth-first order as the entries of _sampleToNodeMappingDirectDict built by
+ * initialize().
+ *
+ * @param sample The ID of the training sample.
+ * @return A const reference to the serial numbers of the nodes containing the sample. The reference stays valid for
+ * the lifetime of this DTIntrospection object or until initializeLazy() is called again.
+ * @throws std::runtime_error If the introspection instance has not been initialized or the sample does not exist.
+ */
+const vector<int> &DTIntrospection::getNodePathForSample(int sample)
+{
+    auto it = _lazyNodePathsForSamplesDict.find(sample);
+    if (it != _lazyNodePathsForSamplesDict.end()) {
+        return it->second;
+    }
+
+    if (_rootNode == nullptr) {
+        throw std::runtime_error("You must first call initialize() or initializeLazy() before using introspection.");
+    }
+
+    auto sampleIt = _dt->_trainingDataDict.find(sample);
+    if (sampleIt == _dt->_trainingDataDict.end()) {
+        throw std::runtime_error("Sample " + std::to_string(sample) + " is not in the training data");
+    }
+    const vector<string> &featureValues = sampleIt->second;
+
+    vector<int> nodePath;
+
+    // With a routing index, the path is the chain of parents of the leaf of the sample
+    if (_dt->hasRoutingIndex()) {
+        const RoutingIndex &routingIndex = _dt->getRoutingIndex();
+        int nodeSerialNum                = routingIndex.sampleToLeaf[sample - routingIndex.firstSample];
+
+        while (nodeSerialNum != _rootNode->GetSerialNum()) {
+            nodePath.push_back(nodeSerialNum);
+            nodeSerialNum = routingIndex.parentNodes[nodeSerialNum];
+        }
+        std::reverse(nodePath.begin(), nodePath.end());
+
+        return _lazyNodePathsForSamplesDict.emplace(sample, std::move(nodePath)).first->second;
+    }
+
+    vector<DecisionTreeNode*> nodesToVisit = {_rootNode};
+
+    while (!nodesToVisit.empty()) {
+        DecisionTreeNode* node = nodesToVisit.back();
+        nodesToVisit.pop_back();
+
+        if (node != _rootNode) {
+            nodePath.push_back(node->GetSerialNum());
+        }
+
+        // Push the matching children in reverse so that they are visited in order
+        vector<DecisionTreeNode*> children = node->GetChildren();
+        for (auto child = children.rbegin(); child != children.rend(); ++child) {
+            const vector<string> &branchFeatures = getBranchFeaturesAtNode((*child)->GetSerialNum());
+            if (!branchFeatures.empty() &&
+                sampleSatisfiesFeatureValueCombo(featureValues, extractFeatureOpValue(branchFeatures.back()))) {
+                nodesToVisit.push_back(*child);
+            }
+        }
+    }
+
+    return _lazyNodePathsForSamplesDict.emplace(sample, std::move(nodePath)).first->second;
+}
+
+
 //--------------- Class Utility ----------------//
 
 /**
@@ -705,4 +900,107 @@ FeatureOpValue DTIntrospection::extractFeatureOpValue(string featureValueCombo)
     FeatureOpValue featureOpValue = {feature, op, value};
 
     return featureOpValue;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Checks whether a training sample satisfies a single feature test.
+ *
+ * The tests follow the same semantics as getSamplesForFeatureValueCombo(): a symbolic test "feature=value" requires an
+ * exact string match, "feature<threshold" is satisfied by values less than or equal to the threshold, and
+ * "feature>threshold" by values strictly greater than it. Numeric tests are never satisfied by non-numeric values.
+ *
+ * @param featureValues The feature values of the sample, in the order of the feature names of the decision tree.
+ * @param featureOpValue The feature test, as returned by extractFeatureOpValue().
+ * @return True if the sample satisfies the feature test.
+ * @throws std::runtime_error If the operator of the feature test is not one of '=', '<' or '>'.
+ */
+bool DTIntrospection::sampleSatisfiesFeatureValueCombo(const vector<string> &featureValues,
+                                                        const FeatureOpValue &featureOpValue)
+{
+    const vector<string> &featureNames = _dt->_featureNames;
+    auto featureIt = std::find(featureNames.begin(), featureNames.end(), featureOpValue.feature);
+    if (featureIt == featureNames.end()) {
+        return false;
+    }
+
+    const string &value = featureValues[featureIt - featureNames.begin()];
+
+    if (featureOpValue.op == "=") {
+        return value == featureOpValue.value;
+    }
+
+    double valueAsDouble  = convert(featureOpValue.value);
+    double value2AsDouble = convert(value);
+    if (std::isnan(valueAsDouble) || std::isnan(value2AsDouble)) {
+        return false;
+    }
+
+    if (featureOpValue.op == "<") {
+        return value2AsDouble <= valueAsDouble;
+    }
+    else if (featureOpValue.op == ">") {
+        return value2AsDouble > valueAsDouble;
+    }
+
+    throw std::runtime_error("Something is wrong with the feature-value syntax");
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Reads the samples at a node off the routing index of the decision tree.
+ *
+ * @param nodeSerialNum The serial number of the node.
+ * @return The sample IDs at the node, sorted in increasing order.
+ */
+vector<int> DTIntrospection::samplesFromRoutingIndex(int nodeSerialNum) const
+{
+    const RoutingIndex &routingIndex = _dt->getRoutingIndex();
+    const pair<int, int> &range      = routingIndex.nodeRowRanges[nodeSerialNum];
+
+    vector<int> samples(routingIndex.permutedSamples.begin() + range.first,
+                        routingIndex.permutedSamples.begin() + range.second);
+    std::sort(samples.begin(), samples.end());
+
+    return samples;
+}
+
+/**
+ * @brief Looks up a node by its serial number, indexing the node pointers of the tree on first use.
+ *
+ * @param nodeSerialNum The serial number of the node.
+ * @return A pointer to the node.
+ * @throws std::runtime_error If the introspection instance has not been initialized or the node does not exist.
+ */
+DecisionTreeNode* DTIntrospection::findNode(int nodeSerialNum)
+{
+    if (_rootNode == nullptr) {
+        throw std::runtime_error("You must first call initialize() or initializeLazy() before using introspection.");
+    }
+
+    if (_nodeSerialNumToNodeDict.empty()) {
+        indexNodes(_rootNode);
+    }
+
+    auto it = _nodeSerialNumToNodeDict.find(nodeSerialNum);
+    if (it == _nodeSerialNumToNodeDict.end()) {
+        throw std::runtime_error("Node " + std::to_string(nodeSerialNum) + " is not a node in the tree");
+    }
+
+    return it->second;
+}
+
+/**
+ * @brief Records the pointers of a node and all of its descendants by serial number.
+ *
+ * @param node A pointer to the node at which to start.
+ */
+void DTIntrospection::indexNodes(DecisionTreeNode* node)
+{
+    _nodeSerialNumToNodeDict[node->GetSerialNum()] = node;
+
+    for (auto child : node->GetChildren()) {
+        indexNodes(child);
+    }
+}
@@ -0,0 +1,306 @@
+#include "DecisionForest.hpp"
+
+#include "Random.hpp"
+#include "Utility.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+
+//--------------- Constructors and Destructors ----------------//
+
+/**
+ * @brief Constructs a new DecisionForest object with the given keyword arguments.
+ *
+ * The training data is not read until fit() is called.
+ *
+ * @param kwargs A map containing the keyword arguments for initialization. The allowed keys are those of DecisionTree,
+ * which are passed on to every tree, and:
+ * - "number_of_trees": The number of trees (default 10).
+ * - "number_of_threads": The number of threads that train the trees (default: the number of hardware threads).
+ * - "features_per_node": The number of features drawn at random at each node (default: the ceiling of the square
+ *   root of the number of features).
+ * - "seed": The seed of the bootstrap samples and the feature draws (default: defaultSeed()).
+ *
+ * @throws std::invalid_argument if the forest parameters are invalid, or if DecisionTree rejects the other keywords.
+ */
+DecisionForest::DecisionForest(map<string, string> kwargs)
+{
+    // Set default values
+    _numberOfTrees   = 10;
+    _numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+    _featuresPerNode = 0;
+    _seed            = 0;
+    bool seedGiven   = false;
+
+    for (const auto &kv : kwargs) {
+        const string &key   = kv.first;
+        const string &value = kv.second;
+
+        if (key == "number_of_trees") {
+            _numberOfTrees = std::stoi(value);
+        }
+        else if (key == "number_of_threads") {
+            _numberOfThreads = std::stoi(value);
+        }
+        else if (key == "features_per_node") {
+            _featuresPerNode = std::stoi(value);
+        }
+        else if (key == "seed") {
+            _seed     = std::stoull(value);
+            seedGiven = true;
+        }
+        else {
+            _treeKwargs[key] = value;
+        }
+    }
+
+    if (_numberOfTrees < 1 || _numberOfThreads < 1 || _featuresPerNode < 0) {
+        throw std::invalid_argument("Invalid decision forest parameters.");
+    }
+    if (!seedGiven) {
+        _seed = defaultSeed();
+    }
+
+    // The tree holding the data also checks the tree keywords
+    _data = make_shared<DecisionTree>(_treeKwargs);
+}
+
+DecisionForest::~DecisionForest() {}
+
+
+//--------------- Training ----------------//
+
+/**
+ * @brief Reads the training data, unless it has been read already, and trains and compiles the trees.
+ *
+ * Each tree is bound to its bootstrap weights over the weighted rows of the data with
+ * DecisionTree::bindTrainingData(), so the trees share the feature values of the data, and the numbers parsed from
+ * them once, and add only their weights and caches to the memory held by the data.
+ *
+ * @throws std::runtime_error If there is no training data, or rethrows an error raised by a tree, leaving the trees of
+ * the last successful fit.
+ */
+void DecisionForest::fit()
+{
+    if (_data->_trainingDataDict.empty()) {
+        _data->getTrainingData();
+    }
+
+    // Compacting is done here, before the trees read the rows from several threads
+    const vector<WeightedRow> &rows = _data->getWeightedRows();
+    if (rows.empty()) {
+        throw std::runtime_error("The decision forest has no training data.");
+    }
+    vector<size_t> cumulativeWeights;
+    size_t totalWeight = 0;
+    for (const auto &row : rows) {
+        totalWeight += row.weight;
+        cumulativeWeights.push_back(totalWeight);
+    }
+
+    const int featuresPerNode =
+        _featuresPerNode > 0 ? _featuresPerNode : static_cast<int>(std::ceil(std::sqrt(getNumFeatures())));
+
+    // The trees are kept only once they have all been fitted, as parallelFor() rethrows the error of a tree
+    vector<shared_ptr<DecisionTree>> trees(_numberOfTrees);
+    parallelFor(_numberOfTrees, _numberOfThreads, [&](size_t treeIndex) {
+        Philox4x32 rng = Philox4x32(_seed).split(treeIndex);
+        auto tree      = make_shared<DecisionTree>(_treeKwargs);
+        tree->bindTrainingData(*_data, bootstrapRowWeights(rng, cumulativeWeights));
+        tree->setFeaturesPerNode(featuresPerNode);
+        tree->setSeed(rng());
+        tree->fit();
+        trees[treeIndex] = tree;
+    });
+    _trees = std::move(trees);
+
+    _compiledTrees.clear();
+    for (const auto &tree : _trees) {
+        _compiledTrees.emplace_back(tree);
+    }
+}
+
+
+//--------------- Classify ----------------//
+
+/**
+ * @brief Computes the class probabilities of a batch of samples, averaged over the trees.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues A row-major numRows x getNumFeatures() array of numeric values, or nullptr, as for
+ * CompiledDecisionTree::predictProba().
+ * @param symbolicCodes A row-major numRows x getNumFeatures() array of symbolic value codes, or nullptr.
+ * @param numRows The number of samples.
+ * @param probabilities A row-major numRows x getNumClasses() array into which the class probabilities are written.
+ *
+ * @throws std::runtime_error If the forest has not been fitted.
+ */
+template <typename T>
+void DecisionForest::predictProba(const T* numericValues,
+                                  const int* symbolicCodes,
+                                  size_t numRows,
+                                  double* probabilities) const
+{
+    if (_compiledTrees.empty()) {
+        throw std::runtime_error("You must first fit the decision forest before classifying with it.");
+    }
+
+    // Blocks of rows go through every tree in turn, and are spread over the threads when the library is built with
+    // OpenMP
+    const long long numBlocks = static_cast<long long>((numRows + PREDICT_BLOCK_SIZE - 1) / PREDICT_BLOCK_SIZE);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (numBlocks > 1)
+#endif
+    for (long long block = 0; block < numBlocks; block++) {
+        const size_t begin = static_cast<size_t>(block) * PREDICT_BLOCK_SIZE;
+        const size_t end   = std::min(numRows, begin + PREDICT_BLOCK_SIZE);
+        predictProbaRows(numericValues, symbolicCodes, begin, end, probabilities);
+    }
+}
+
+/**
+ * @brief Computes the class probabilities of a single sample, averaged over the trees.
+ *
+ * @param numericValues One numeric value per feature, or an empty vector.
+ * @param symbolicCodes One symbolic value code per feature, or an empty vector.
+ * @return The probability of each class, in the order of getClassNames().
+ *
+ * @throws std::runtime_error If the forest has not been fitted.
+ * @throws std::invalid_argument If a non-empty vector does not have one entry per feature.
+ */
+vector<double> DecisionForest::predictProba(const vector<double> &numericValues,
+                                            const vector<int> &symbolicCodes) const
+{
+    if (_compiledTrees.empty()) {
+        throw std::runtime_error("You must first fit the decision forest before classifying with it.");
+    }
+    if ((!numericValues.empty() && numericValues.size() != getNumFeatures()) ||
+        (!symbolicCodes.empty() && symbolicCodes.size() != getNumFeatures())) {
+        throw std::invalid_argument("Expected one value per feature: " + std::to_string(getNumFeatures()));
+    }
+
+    vector<double> probabilities(getNumClasses());
+    predictProba(numericValues.empty() ? nullptr : numericValues.data(),
+                 symbolicCodes.empty() ? nullptr : symbolicCodes.data(),
+                 1,
+                 probabilities.data());
+
+    return probabilities;
+}
+
+/**
+ * @brief Classifies a sample given as "feature=value" strings, averaging the class probabilities of the trees.
+ *
+ * @param featuresAndValues The features and their values, as for DecisionTree::classify().
+ * @return The probability of each class.
+ *
+ * @throws std::runtime_error If the forest has not been fitted, or if the sample uses unknown names.
+ */
+map<string, double> DecisionForest::classify(const vector<string> &featuresAndValues) const
+{
+    if (_trees.empty()) {
+        throw std::runtime_error("You must first fit the decision forest before classifying with it.");
+    }
+    if (!_data->checkNamesUsed(featuresAndValues)) {
+        throw std::runtime_error("\n\nError in the names you have used for features and/or values. "
+                                 "Try using the csv_cleanup_needed option in the constructor call.");
+    }
+
+    map<string, double> classProbabilities;
+    for (const auto &className : getClassNames()) {
+        classProbabilities[className] = 0.0;
+    }
+
+    for (const auto &tree : _trees) {
+        ClassificationAnswer answer;
+        for (const auto &className : getClassNames()) {
+            answer.classProbabilities[className] = 0.0;
+        }
+        tree->recursiveDescentForClassification(tree->getRootNode(), featuresAndValues, answer);
+        for (const auto &[className, probability] : answer.classProbabilities) {
+            classProbabilities[className] += probability / static_cast<double>(_trees.size());
+        }
+    }
+
+    return classProbabilities;
+}
+
+/**
+ * @brief Returns the code of a symbolic value, which is the same for every tree, or -1 if it is not known.
+ *
+ * @throws std::runtime_error If the forest has not been fitted.
+ */
+int DecisionForest::encodeSymbolicValue(const string &feature, const string &value) const
+{
+    if (_compiledTrees.empty()) {
+        throw std::runtime_error("You must first fit the decision forest before classifying with it.");
+    }
+    return _compiledTrees.front().encodeSymbolicValue(feature, value);
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Draws a bootstrap sample of the training samples, as the number of draws that fell in each weighted row.
+ *
+ * @param rng The random stream of the tree.
+ * @param cumulativeWeights The running sum of the weights of the weighted rows of the data.
+ * @return The weight of each weighted row in the bootstrap sample; the weights add up to the number of samples.
+ */
+vector<int> DecisionForest::bootstrapRowWeights(Philox4x32 &rng, const vector<size_t> &cumulativeWeights) const
+{
+    const size_t numSamples = cumulativeWeights.back();
+    vector<int> rowWeights(cumulativeWeights.size(), 0);
+    for (size_t draw = 0; draw < numSamples; ++draw) {
+        const size_t sample = rng() % numSamples;
+        auto row            = std::upper_bound(cumulativeWeights.begin(), cumulativeWeights.end(), sample);
+        rowWeights[row - cumulativeWeights.begin()]++;
+    }
+    return rowWeights;
+}
+
+/**
+ * @brief Averages the class probabilities of the trees for the rows [begin, end) of a batch.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues The numeric values of the whole batch, or nullptr.
+ * @param symbolicCodes The symbolic value codes of the whole batch, or nullptr.
+ * @param begin The first row to score.
+ * @param end One past the last row to score.
+ * @param probabilities The class probabilities of the whole batch.
+ */
+template <typename T>
+void DecisionForest::predictProbaRows(
+    const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const
+{
+    const size_t numFeatures   = getNumFeatures();
+    const size_t numClasses    = getNumClasses();
+    const size_t numRows       = end - begin;
+    const T* numericBlock      = numericValues ? numericValues + begin * numFeatures : nullptr;
+    const int* symbolicBlock   = symbolicCodes ? symbolicCodes + begin * numFeatures : nullptr;
+    double* blockProbabilities = probabilities + begin * numClasses;
+
+    std::fill(blockProbabilities, blockProbabilities + numRows * numClasses, 0.0);
+    vector<double> treeProbabilities(numRows * numClasses);
+    for (const auto &tree : _compiledTrees) {
+        tree.predictProba(numericBlock, symbolicBlock, numRows, treeProbabilities.data());
+        for (size_t i = 0; i < treeProbabilities.size(); i++) {
+            blockProbabilities[i] += treeProbabilities[i];
+        }
+    }
+
+    const double scale = 1.0 / static_cast<double>(_compiledTrees.size());
+    for (size_t i = 0; i < numRows * numClasses; i++) {
+        blockProbabilities[i] *= scale;
+    }
+}
+
+
+//--------------- Explicit Instantiations ----------------//
+template void DecisionForest::predictProba<double>(const double*, const int*, size_t, double*) const;
+template void DecisionForest::predictProba<float>(const float*, const int*, size_t, double*) const;
@@ -10,9 +10,79 @@
 #include <regex>
 #include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
 
 
+namespace {
+// Bookkeeping of a node of a std::map: three pointers and the color, rounded up
+constexpr size_t MAP_NODE_BYTES = 4 * sizeof(void*);
+
+// Bytes held by a string, including its heap block when it is too long for the small-string buffer
+size_t stringBytes(const string &str)
+{
+    return sizeof(string) + (str.capacity() > 15 ? str.capacity() + 1 : 0);
+}
+
+size_t containerBytes(const vector<string> &strings)
+{
+    size_t bytes = sizeof(vector<string>) + (strings.capacity() - strings.size()) * sizeof(string);
+    for (const auto &str : strings) {
+        bytes += stringBytes(str);
+    }
+    return bytes;
+}
+
+// Strips the spaces and tabs around a string, as trim() does, without copying it
+std::string_view trimView(std::string_view str)
+{
+    const size_t first = str.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+}
+
+// Splits "feature=value" at the first '=' into the trimmed feature and value; both are empty if there is no '='
+pair<std::string_view, std::string_view> splitFeatureAndValue(std::string_view featureAndValue)
+{
+    const size_t pos = featureAndValue.find('=');
+    if (pos == std::string_view::npos) {
+        return {};
+    }
+    return {trimView(featureAndValue.substr(0, pos)), trimView(featureAndValue.substr(pos + 1))};
+}
+
+// Writes an optional value of the debugging output, or None
+std::ostream &operator<<(std::ostream &os, const optional<double> &value)
+{
+    return value ? os << *value : os << "None";
+}
+
+std::ostream &operator<<(std::ostream &os, const optional<pair<double, double>> &values)
+{
+    return values ? os << values->first << " and " << values->second : os << "None";
+}
+
+} // namespace
+
+/**
+ * @def DTPP_DEBUG3(streamed)
+ * @brief Logs the construction debugging output of debug3 at DEBUG level, from what is streamed into it. Nothing is
+ * streamed unless debug3 is set and DEBUG is compiled in.
+ */
+#define DTPP_DEBUG3(streamed)                                                                                          \
+    do {                                                                                                               \
+        if (_debug3) {                                                                                                 \
+            DTPP_LOG(debugLogger(), DEBUG, ([&] {                                                                      \
+                         std::ostringstream debugMessage;                                                              \
+                         debugMessage << streamed;                                                                     \
+                         return debugMessage.str();                                                                    \
+                     }()));                                                                                            \
+        }                                                                                                              \
+    } while (0)
+
+
 //--------------- Constructors and Destructors ----------------//
 DecisionTree::DecisionTree()
 {
@@ -34,6 +104,12 @@ DecisionTree::DecisionTree(map<string, string> kwargs)
                                   "csv_columns_for_features",
                                   "number_of_histogram_bins",
                                   "csv_cleanup_needed",
+                                  "build_routing_index",
+                                  "memory_budget_mb",
+                                  "contingency_cube_max_cells",
+                                  "features_per_node",
+                                  "seed",
+                                  "feature_types",
                                   "debug1",
                                   "debug2",
                                   "debug3"};
@@ -42,6 +118,10 @@ DecisionTree::DecisionTree(map<string, string> kwargs)
     _entropyThreshold                      = 0.01;
     _symbolicToNumericCardinalityThreshold = 10;
     _csvCleanupNeeded                      = 0;
+    _buildRoutingIndex                     = 0;
+    _memoryBudgetBytes                     = 0;
+    _contingencyCubeMaxCells               = size_t{1} << 20;
+    _featuresPerNode                       = 0;
     _csvColumnsForFeatures                 = {};
     _debug1 = _debug2 = _debug3 = 0;
     _maxDepthDesired = _csvClassColumnIndex = _numberOfHistogramBins = -1;
@@ -81,8 +161,9 @@ DecisionTree::DecisionTree(map<string, string> kwargs)
             _csvClassColumnIndex = std::stoi(value);
         }
         else if (key == "csv_columns_for_features") {
+            // One column per character, read as unsigned so that columns up to 255 can be given
             for (const auto &count : value) {
-                _csvColumnsForFeatures.push_back(count);
+                _csvColumnsForFeatures.push_back(static_cast<unsigned char>(count));
             }
         }
         else if (key == "symbolic_to_numeric_cardinality_threshold") {
@@ -94,6 +175,42 @@ DecisionTree::DecisionTree(map<string, string> kwargs)
         else if (key == "csv_cleanup_needed") {
             _csvCleanupNeeded = std::stoi(value);
         }
+        else if (key == "build_routing_index") {
+            _buildRoutingIndex = std::stoi(value);
+        }
+        else if (key == "memory_budget_mb") {
+            double budgetMb = std::stod(value);
+            if (budgetMb < 0) {
+                throw std::invalid_argument("memory_budget_mb must not be negative");
+            }
+            _memoryBudgetBytes = static_cast<size_t>(budgetMb * 1024 * 1024);
+        }
+        else if (key == "contingency_cube_max_cells") {
+            _contingencyCubeMaxCells = std::stoull(value);
+        }
+        else if (key == "features_per_node") {
+            _featuresPerNode = std::stoi(value);
+            if (_featuresPerNode < 0) {
+                throw std::invalid_argument("features_per_node must not be negative");
+            }
+        }
+        else if (key == "seed") {
+            _seed = std::stoull(value);
+        }
+        else if (key == "feature_types") {
+            // Comma-separated "feature=numeric" or "feature=symbolic" entries
+            std::istringstream entries(value);
+            string entry;
+            while (std::getline(entries, entry, ',')) {
+                auto [feature, type] = splitFeatureAndValue(entry);
+                if (type != "numeric" && type != "symbolic") {
+                    throw std::invalid_argument("feature_types: expected feature=numeric or feature=symbolic, got " +
+                                                entry);
+                }
+                _declaredFeatureTypes[string(feature)] =
+                    type == "numeric" ? FeatureType::NUMERIC : FeatureType::SYMBOLIC;
+            }
+        }
         else if (key == "debug1") {
             _debug1 = std::stoi(value);
         }
@@ -133,6 +250,8 @@ DecisionTree::~DecisionTree() {}
  */
 void DecisionTree::getTrainingData()
 {
+    DTPP_STATS_TIMER(loadTimer, _stats.loadSeconds);
+
     // Check if training data file is a CSV file
     if (_trainingDatafile.find(".csv") == string::npos) { // string.find() returns string::npos if not found
         throw std::invalid_argument("Aborted. get_training_data_from_csv() is only for CSV files");
@@ -233,31 +352,109 @@ void DecisionTree::getTrainingData()
         _featureValuesHowManyUniquesDict[kv.first] = kv.second.size();
     }
 
-    // Get the _numericFeaturesValuerangeDict
+    // Decide once which features are numeric, instead of at every use
+    inferFeatureTypes();
+
+    // Collapse the duplicate samples that the counting need only visit once, and count them all at once if the
+    // features are symbolic with few enough values
+    compactTrainingData();
+    buildContingencyCube();
+
+    // Account for the samples, the copies of their values kept per feature, the weighted rows with their numbers and
+    // the cube
+    _memoryUsage.trainingDataBytes = sizeof(_weightedRows) + _weightedRows.capacity() * sizeof(WeightedRow) +
+                                     sizeof(_rowNumericValues) + _rowNumericValues.capacity() * sizeof(double) +
+                                     (hasContingencyCube() ? _contingencyCube.bytes() : 0);
+    for (const auto &[sample, values] : _trainingDataDict) {
+        _memoryUsage.trainingDataBytes += MAP_NODE_BYTES + sizeof(int) + containerBytes(values);
+    }
+    for (const auto &[feature, values] : _featuresAndValuesDict) {
+        _memoryUsage.trainingDataBytes += MAP_NODE_BYTES + stringBytes(feature) + containerBytes(values);
+    }
+    enforceMemoryBudget();
+}
+
+/**
+ * @brief Decides, once after the training data is read, whether each feature is numeric or symbolic.
+ *
+ * A feature with numeric values gets its value range, and is modeled as NUMERIC if it has more unique values than the
+ * symbolic-to-numeric cardinality threshold; every other feature is SYMBOLIC. The values are parsed with parseDouble,
+ * so no exception is thrown for the symbolic ones. Features whose types were given with the feature_types keyword or
+ * setFeatureTypes() are not inferred, but a feature declared NUMERIC must have only numbers (or NA) and at least three
+ * distinct values, which the histogram estimate of its distribution needs.
+ *
+ * @throws std::invalid_argument if a declared type names an unknown feature or does not fit the data.
+ */
+void DecisionTree::inferFeatureTypes()
+{
+    for (const auto &[feature, type] : _declaredFeatureTypes) {
+        if (std::find(_featureNames.begin(), _featureNames.end(), feature) == _featureNames.end()) {
+            throw std::invalid_argument("feature_types names an unknown feature: " + feature);
+        }
+    }
+
+    _featureTypes.clear();
     for (const auto &feature : _featureNames) {
-        // Get the min and max values of the feature and store them in a vector
-        vector<double> values;
-        double min = std::numeric_limits<double>::max();
-        double max = std::numeric_limits<double>::min();
-        for (const auto &value : _featuresAndUniqueValuesDict[feature]) {
+        const set<string> &uniqueValues = _featuresAndUniqueValuesDict[feature];
+
+        // Get the min and max values of the feature
+        double min              = std::numeric_limits<double>::max();
+        double max              = std::numeric_limits<double>::min();
+        size_t numNumericValues = 0;
+        optional<string> nonNumericValue;
+        for (const auto &value : uniqueValues) {
             double numericValue = convert(value);
             if (std::isnan(numericValue)) {
+                if (value != "NA") {
+                    nonNumericValue = value;
+                }
                 continue;
             }
-            if (numericValue < min) {
-                min = numericValue;
-            }
-            if (numericValue > max) {
-                max = numericValue;
-            }
+            ++numNumericValues;
+            min = std::min(min, numericValue);
+            max = std::max(max, numericValue);
+        }
+        if (numNumericValues > 0) {
+            _numericFeaturesValueRangeDict[feature] = {min, max};
         }
-        if (min == std::numeric_limits<double>::max() && max == std::numeric_limits<double>::min()) {
+
+        auto declared = _declaredFeatureTypes.find(feature);
+        if (declared == _declaredFeatureTypes.end()) {
+            const bool numeric = numNumericValues > 0 &&
+                                 static_cast<int>(uniqueValues.size()) > _symbolicToNumericCardinalityThreshold;
+            _featureTypes[feature] = numeric ? FeatureType::NUMERIC : FeatureType::SYMBOLIC;
             continue;
         }
-        values.push_back(min);
-        values.push_back(max);
-        _numericFeaturesValueRangeDict[feature] = values;
+
+        if (declared->second == FeatureType::NUMERIC && nonNumericValue) {
+            throw std::invalid_argument("Feature " + feature + " is declared numeric but has the value " +
+                                        *nonNumericValue);
+        }
+        if (declared->second == FeatureType::NUMERIC && numNumericValues < 3) {
+            throw std::invalid_argument("Feature " + feature +
+                                        " is declared numeric but has fewer than three distinct values");
+        }
+        _featureTypes[feature] = declared->second;
+    }
+}
+
+/**
+ * @brief Whether a feature is modeled as NUMERIC.
+ *
+ * Trees whose training data was not read by getTrainingData(), such as the ones EvalTrainingData builds for its
+ * folds, have no schema, and their features are classified by the rule inferFeatureTypes() applies.
+ */
+bool DecisionTree::isNumericFeature(const string &feature) const
+{
+    auto type = _featureTypes.find(feature);
+    if (type != _featureTypes.end()) {
+        return type->second == FeatureType::NUMERIC;
     }
+
+    auto uniques = _featureValuesHowManyUniquesDict.find(feature);
+    return _numericFeaturesValueRangeDict.find(feature) != _numericFeaturesValueRangeDict.end() &&
+           (uniques != _featureValuesHowManyUniquesDict.end() ? uniques->second : 0) >
+               _symbolicToNumericCardinalityThreshold;
 }
 
 // Calculate first order probabilities
@@ -283,9 +480,12 @@ void DecisionTree::getTrainingData()
  */
 void DecisionTree::calculateFirstOrderProbabilities()
 {
+    DTPP_STATS_TIMER(firstOrderProbabilitiesTimer, _stats.firstOrderProbabilitiesSeconds);
+
     for (const auto &feature : _featureNames) {
         // Calculate probability for the feature's value
         probabilityOfFeatureValue(feature, "");
+        enforceMemoryBudget();
 
         // Debug output if debug2 is enabled
         if (_debug2) {
@@ -317,6 +517,28 @@ void DecisionTree::calculateFirstOrderProbabilities()
     }
 }
 
+/**
+ * @brief Runs the whole training pipeline and constructs the decision tree.
+ *
+ * This is a convenience wrapper for the calls that the examples make one after the other: it reads the training data
+ * (unless it has already been read or bound with bindTrainingData()), calculates the first-order probabilities and the
+ * class priors, and constructs the decision tree classifier. Different DecisionTree instances share no state, so fit()
+ * may be called for several trees concurrently from different threads.
+ *
+ * @return A pointer to the root node of the constructed decision tree.
+ */
+DecisionTreeNode* DecisionTree::fit()
+{
+    if (_trainingDataDict.empty() && _weightedRows.empty()) {
+        getTrainingData();
+    }
+
+    calculateFirstOrderProbabilities();
+    calculateClassPriors();
+
+    return constructDecisionTreeClassifier();
+}
+
 // Show training data
 void DecisionTree::showTrainingData() const
 {
@@ -330,6 +552,263 @@ void DecisionTree::showTrainingData() const
 }
 
 
+//--------------- Row Compaction ----------------//
+
+/**
+ * @brief Collapses the training samples with identical feature values and class into weighted rows.
+ *
+ * The class priors and the probabilities of symbolic feature values are then counted over the distinct rows, adding
+ * their weights, instead of over every sample. The counts are the same, and so is the tree, but data with few
+ * distinct combinations of symbolic values is counted in a fraction of the time. Samples without a class label, such
+ * as the held-out samples in the trees EvalTrainingData builds for its folds, count towards the values of the
+ * features but not towards any class, so they form rows of their own.
+ *
+ * The feature values of each row are also parsed as numbers here, once, so that counting the numeric features, and
+ * every tree bound to these rows with bindTrainingData(), reads doubles rather than converting the strings again.
+ *
+ * This is called by getTrainingData(); trees whose training data is filled in directly are compacted on first use.
+ */
+void DecisionTree::compactTrainingData()
+{
+    using RowKey = pair<const vector<string>*, int>;
+    auto rowLess = [](const RowKey &a, const RowKey &b) {
+        return std::tie(a.second, *a.first) < std::tie(b.second, *b.first);
+    };
+    map<RowKey, size_t, decltype(rowLess)> rowIndices(rowLess);
+
+    _weightedRows.clear();
+    for (const auto &[sample, values] : _trainingDataDict) {
+        int classIndex = -1;
+        auto label     = _samplesClassLabelDict.find(sample);
+        if (label != _samplesClassLabelDict.end()) {
+            auto classIt = std::find(_classNames.begin(), _classNames.end(), label->second);
+            if (classIt != _classNames.end()) {
+                classIndex = static_cast<int>(classIt - _classNames.begin());
+            }
+        }
+
+        auto [rowIndex, inserted] = rowIndices.try_emplace(RowKey{&values, classIndex}, _weightedRows.size());
+        if (inserted) {
+            _weightedRows.push_back({sample, classIndex, 0, &values, nullptr});
+        }
+        _weightedRows[rowIndex->second].weight++;
+    }
+    _weightedRows.shrink_to_fit();
+
+    const size_t numFeatures = _featureNames.size();
+    _rowNumericValues = vector<double>(_weightedRows.size() * numFeatures, std::nan(""));
+    for (size_t i = 0; i < _weightedRows.size(); ++i) {
+        const vector<string> &values = *_weightedRows[i].values;
+        double* numericValues        = &_rowNumericValues[i * numFeatures];
+        for (size_t featureIndex = 0; featureIndex < std::min(numFeatures, values.size()); ++featureIndex) {
+            numericValues[featureIndex] = convert(values[featureIndex]);
+        }
+        _weightedRows[i].numericValues = numericValues;
+    }
+}
+
+/**
+ * @brief Returns the weighted rows of the training data, compacting it first if that has not been done.
+ */
+const vector<WeightedRow> &DecisionTree::getWeightedRows()
+{
+    if (_weightedRows.empty() && !_trainingDataDict.empty()) {
+        compactTrainingData();
+    }
+    return _weightedRows;
+}
+
+/**
+ * @brief Trains on a reweighting of the rows of another tree's training data, without copying their values.
+ *
+ * The schema of the source (feature and class names, feature types, value ranges and symbolic values) is copied, and
+ * every weighted row of the source with a non-zero weight becomes a row of this tree with that weight, pointing at the
+ * feature values held by the source. A bootstrap sample, for instance, is a weight per row that is the number of times
+ * the row was drawn. This tree has no training samples of its own, so the source must outlive it, and the routing
+ * index cannot be built, and it adds only its weighted rows to the memory held by the source.
+ *
+ * @param source A tree whose training data has been read.
+ * @param rowWeights The weight of each of the weighted rows of the source.
+ *
+ * @throws std::invalid_argument If there is not one weight per weighted row of the source.
+ */
+void DecisionTree::bindTrainingData(const DecisionTree &source, const vector<int> &rowWeights)
+{
+    if (rowWeights.size() != source._weightedRows.size()) {
+        throw std::invalid_argument("bindTrainingData: expected " + std::to_string(source._weightedRows.size()) +
+                                    " row weights, got " + std::to_string(rowWeights.size()));
+    }
+
+    _featureNames                    = source._featureNames;
+    _classNames                      = source._classNames;
+    _classLabel                      = source._classLabel;
+    _featureTypes                    = source._featureTypes;
+    _numericFeaturesValueRangeDict   = source._numericFeaturesValueRangeDict;
+    _featureValuesHowManyUniquesDict = source._featureValuesHowManyUniquesDict;
+    _featuresAndUniqueValuesDict.clear();
+    for (const auto &feature : _featureNames) {
+        if (!isNumericFeature(feature)) {
+            _featuresAndUniqueValuesDict[feature] = source._featuresAndUniqueValuesDict.at(feature);
+        }
+    }
+
+    _contingencyCube = ContingencyCube();
+    _weightedRows.clear();
+    _howManyTotalTrainingSamples = 0;
+    for (size_t i = 0; i < rowWeights.size(); ++i) {
+        if (rowWeights[i] > 0) {
+            const WeightedRow &row = source._weightedRows[i];
+            _weightedRows.push_back({row.sample, row.classIndex, rowWeights[i], row.values, row.numericValues});
+            _howManyTotalTrainingSamples += rowWeights[i];
+        }
+    }
+    _weightedRows.shrink_to_fit();
+
+    _memoryUsage.trainingDataBytes = sizeof(_weightedRows) + _weightedRows.capacity() * sizeof(WeightedRow);
+    enforceMemoryBudget();
+}
+
+/**
+ * @brief Counts the training samples with each value of a feature, over the weighted rows.
+ *
+ * @param feature The name of the feature.
+ * @param className If given, only the samples of this class are counted.
+ * @return The number of samples with each value of the feature, and the number of samples counted.
+ */
+pair<map<string, size_t>, size_t> DecisionTree::countFeatureValues(const string &feature,
+                                                                   const optional<string> &className)
+{
+    const size_t featureIndex = std::find(_featureNames.begin(), _featureNames.end(), feature) - _featureNames.begin();
+    int classIndex            = -1;
+    if (className) {
+        auto classIt = std::find(_classNames.begin(), _classNames.end(), *className);
+        if (classIt == _classNames.end()) {
+            return {};
+        }
+        classIndex = static_cast<int>(classIt - _classNames.begin());
+    }
+
+    // The cube has the counts of every value in every class at hand
+    map<string, size_t> counts;
+    if (hasContingencyCube() && featureIndex < _contingencyCube.getNumFeatures()) {
+        const vector<string> &values = _contingencyCube.getFeatureValues(featureIndex);
+        for (size_t code = 0; code < values.size(); ++code) {
+            if (uint64_t count = _contingencyCube.featureValueCount(featureIndex, code, classIndex)) {
+                counts[values[code]] = count;
+            }
+        }
+        return {counts, _contingencyCube.classCount(classIndex)};
+    }
+
+    size_t totalCount = 0;
+    for (const auto &row : getWeightedRows()) {
+        if (className && row.classIndex != classIndex) {
+            continue;
+        }
+        const vector<string> &values = *row.values;
+        if (featureIndex < values.size()) {
+            counts[values[featureIndex]] += row.weight;
+        }
+        totalCount += row.weight;
+    }
+    return {counts, totalCount};
+}
+
+/**
+ * @brief Counts the training samples of each class, from the contingency cube if there is one and otherwise over the
+ * weighted rows.
+ *
+ * @return The number of samples of each class, and the number of samples with a class label.
+ */
+pair<vector<size_t>, size_t> DecisionTree::countClassSamples()
+{
+    vector<size_t> numSamplesForClasses(_classNames.size(), 0);
+    size_t totalNumSamples = 0;
+    if (hasContingencyCube()) {
+        for (size_t i = 0; i < _classNames.size(); ++i) {
+            numSamplesForClasses[i] = _contingencyCube.classCount(static_cast<int>(i));
+            totalNumSamples += numSamplesForClasses[i];
+        }
+        return {numSamplesForClasses, totalNumSamples};
+    }
+
+    for (const auto &row : getWeightedRows()) {
+        if (row.classIndex >= 0) {
+            numSamplesForClasses[row.classIndex] += row.weight;
+            totalNumSamples += row.weight;
+        }
+    }
+    return {numSamplesForClasses, totalNumSamples};
+}
+
+/**
+ * @brief Gathers the numeric values of a feature over the weighted rows, repeating each by the weight of its row.
+ *
+ * @param feature The name of the feature.
+ * @return The values of the feature that are numbers, skipping NA.
+ */
+vector<double> DecisionTree::gatherNumericValues(const string &feature)
+{
+    const size_t featureIndex = std::find(_featureNames.begin(), _featureNames.end(), feature) - _featureNames.begin();
+    vector<double> numericValues;
+    for (const auto &row : getWeightedRows()) {
+        if (featureIndex >= row.values->size() || (*row.values)[featureIndex] == "NA") {
+            continue;
+        }
+        double valueAsDouble = row.numericValues[featureIndex];
+        if (!std::isnan(valueAsDouble)) {
+            numericValues.insert(numericValues.end(), row.weight, valueAsDouble);
+        }
+    }
+    return numericValues;
+}
+
+
+
+//--------------- Contingency Cube ----------------//
+
+/**
+ * @brief Counts the samples over every combination of feature values and class, when every feature is symbolic.
+ *
+ * The cube is only built if it has at most contingency_cube_max_cells cells, which is the product of the numbers of
+ * values of the features and of the number of classes plus one. It is filled in one pass over the weighted rows. The
+ * counts of the values of each feature per class, the class priors and the number of samples on a branch of symbolic
+ * tests are then looked up in the marginals of the cube, with no pass over the samples. Otherwise, or if a feature is
+ * numeric, the counts come from the weighted rows.
+ */
+void DecisionTree::buildContingencyCube()
+{
+    _contingencyCube = ContingencyCube();
+    if (_contingencyCubeMaxCells == 0 || _featureNames.empty()) {
+        return;
+    }
+
+    vector<vector<string>> featureValues;
+    for (const auto &feature : _featureNames) {
+        if (isNumericFeature(feature)) {
+            return;
+        }
+        const set<string> &values = _featuresAndUniqueValuesDict[feature];
+        featureValues.emplace_back(values.begin(), values.end());
+    }
+    if (ContingencyCube::numCells(featureValues, _classNames.size()) > _contingencyCubeMaxCells) {
+        return;
+    }
+
+    ContingencyCube cube(std::move(featureValues), _classNames.size());
+    vector<int> valueCodes(_featureNames.size());
+    for (const auto &row : getWeightedRows()) {
+        if (row.values->size() != valueCodes.size()) {
+            return;
+        }
+        for (size_t i = 0; i < valueCodes.size(); ++i) {
+            valueCodes[i] = cube.valueCode(i, (*row.values)[i]);
+        }
+        cube.add(valueCodes, row.classIndex, row.weight);
+    }
+    _contingencyCube = std::move(cube);
+}
+
 //--------------- Classify ----------------//
 
 /**
@@ -340,6 +819,9 @@ void DecisionTree::showTrainingData() const
  * be supplied in the format shown in the scripts in the `Examples` subdirectory.
  * See the scripts construct_dt_and_classify_one_sample_caseX.py in that subdirectory.
  *
+ * Classification does not change the tree or the training data, so a constructed tree can classify samples from
+ * several threads at once without locking.
+ *
  * @param rootNode Pointer to the root node of the decision tree.
  * @param featuresAndValues A vector of strings representing the features and their values
  *                          in the format "feature=value".
@@ -350,7 +832,7 @@ void DecisionTree::showTrainingData() const
  * @throws std::runtime_error if there is an error in the names used for features and/or values,
  *                            or if there is an error in the format of the feature and value pairs.
  */
-map<string, string> DecisionTree::classify(DecisionTreeNode* rootNode, const vector<string> &featuresAndValues)
+map<string, string> DecisionTree::classify(DecisionTreeNode* rootNode, const vector<string> &featuresAndValues) const
 {
     /*
     Classifies one test sample at a time using the decision tree constructed from
@@ -363,28 +845,12 @@ map<string, string> DecisionTree::classify(DecisionTreeNode* rootNode, const vec
                                  "Try using the csv_cleanup_needed option in the constructor call.");
     }
 
-    vector<string> newFeaturesAndValues;
-
-    for (const auto &fv : featuresAndValues) {
-        auto pos = fv.find('=');
-
-        if (pos == string::npos) {
-            throw std::runtime_error("\n\nError in the format of the feature and value pairs. "
-                                     "Use the format feature=value.");
-        }
-
-        string feature = trim(fv.substr(0, pos));
-        string value   = trim(fv.substr(pos + 1));
-
-        newFeaturesAndValues.push_back(feature + "=" + value);
-        _featuresAndValuesDict[feature].push_back(value);
-    }
-
     if (_debug3) {
         cout << "\nCL1 New features and values:\n";
 
-        for (const auto &item : newFeaturesAndValues) {
-            cout << item << " ";
+        for (const auto &item : featuresAndValues) {
+            auto [feature, value] = splitFeatureAndValue(item);
+            cout << feature << "=" << value << " ";
         }
     }
 
@@ -395,7 +861,7 @@ map<string, string> DecisionTree::classify(DecisionTreeNode* rootNode, const vec
     }
 
     // Perform classification
-    recursiveDescentForClassification(rootNode, newFeaturesAndValues, answer);
+    recursiveDescentForClassification(rootNode, featuresAndValues, answer);
 
     // Reverse the solution path (Top-down traversal instead of bottom up, more user readable)
     std::reverse(answer.solutionPath.begin(), answer.solutionPath.end());
@@ -441,60 +907,56 @@ map<string, string> DecisionTree::classify(DecisionTreeNode* rootNode, const vec
  * to classify an instance. It updates the classification answer with class probabilities
  * and the solution path.
  *
+ * The descent only reads the tree and the model, and parses the feature values and the feature tests in place, so it
+ * allocates nothing but the solution path and can run on one tree from several threads at once.
+ *
  * @param node Pointer to the current node in the decision tree.
  * @param featureAndValues Vector of strings representing the feature-value pairs of the instance.
- * @param answer Reference to the ClassificationAnswer object to store the classification result.
+ * @param answer Reference to the ClassificationAnswer object to store the classification result. Its class
+ * probabilities must already hold every class.
+ *
+ * @throws std::invalid_argument if the value of a numeric feature tested on the way is not a number.
  */
-void DecisionTree::recursiveDescentForClassification(DecisionTreeNode* node,
+void DecisionTree::recursiveDescentForClassification(const DecisionTreeNode* node,
                                                      const vector<string> &featureAndValues,
-                                                     ClassificationAnswer &answer)
+                                                     ClassificationAnswer &answer) const
 {
-    const auto &children = node->GetChildren();
-
-    // Leaf node: assign class probabilities
-    if (children.empty()) {
-        vector<double> leafNodeClassProbabilities = node->GetClassProbabilities();
+    // Assigns the class probabilities of the node where the descent stops
+    auto stopAtNode = [&]() {
+        const vector<double> &leafNodeClassProbabilities = node->GetClassProbabilities();
 
         for (size_t i = 0; i < _classNames.size(); ++i) {
             answer.classProbabilities[_classNames[i]] = leafNodeClassProbabilities[i];
         }
 
         answer.solutionPath.push_back(node->GetSerialNum());
+    };
+
+    // Leaf node: assign class probabilities
+    if (node->GetNumChildren() == 0) {
+        stopAtNode();
         return;
     }
 
-    string featureTestedAtNode = node->GetFeature();
+    const string &featureTestedAtNode = node->GetFeature();
 
     if (_debug3) {
         cout << "\nCLRD1 Feature tested at node for classification: " << featureTestedAtNode << endl;
     }
 
-    string valueForFeature;
-    bool pathFound = false;
-    std::regex pattern(R"((\S+)\s*=\s*(\S+))");
-    std::smatch match;
-
     // Find the value for the feature being tested
+    std::string_view valueForFeature;
     for (const auto &featureAndValue : featureAndValues) {
-        if (std::regex_search(featureAndValue, match, pattern)) {
-            string feature = match[1].str();
-            string value   = match[2].str();
-            if (feature == featureTestedAtNode) {
-                valueForFeature = value;
-                break;
-            }
+        auto [feature, value] = splitFeatureAndValue(featureAndValue);
+        if (feature == featureTestedAtNode) {
+            valueForFeature = value;
+            break;
         }
     }
 
     // Handle missing feature values
     if (valueForFeature.empty()) {
-        vector<double> leafNodeClassProbabilities = node->GetClassProbabilities();
-
-        for (size_t i = 0; i < _classNames.size(); ++i) {
-            answer.classProbabilities[_classNames[i]] = leafNodeClassProbabilities[i];
-        }
-
-        answer.solutionPath.push_back(node->GetSerialNum());
+        stopAtNode();
         return;
     }
 
@@ -504,52 +966,44 @@ void DecisionTree::recursiveDescentForClassification(DecisionTreeNode* node,
             cout << "\nCLRD2 In the truly numeric section" << endl;
         }
 
-        double numericValue = std::stod(valueForFeature);
-
-        for (const auto &child : children) {
-            vector<string> branchFeaturesAndValues = child->GetBranchFeaturesAndValuesOrThresholds();
-            string lastFeatureAndValueOnBranch     = branchFeaturesAndValues.back();
-            std::regex pattern1(R"((.+)<(.+))");
-            std::regex pattern2(R"((.+)>(.+))");
+        double numericValue;
+        if (!parseDouble(valueForFeature, numericValue)) {
+            throw std::invalid_argument("The value " + string(valueForFeature) + " of the numeric feature " +
+                                        featureTestedAtNode + " is not a number");
+        }
 
-            if (std::regex_match(lastFeatureAndValueOnBranch, match, pattern1)) {
-                string thresholdStr = match[2].str();
-                double threshold    = std::stod(thresholdStr);
+        for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+            const DecisionTreeNode* child = node->GetChild(i);
+            const string &lastFeatureAndValueOnBranch = child->GetBranchFeaturesAndValuesOrThresholds().back();
 
-                if (numericValue <= threshold) {
-                    pathFound = true;
-                    recursiveDescentForClassification(child, featureAndValues, answer);
-                    answer.solutionPath.push_back(node->GetSerialNum());
-                    break;
-                }
+            // A test is "feature<threshold" or "feature>threshold", split at the last operator
+            size_t opPos = lastFeatureAndValueOnBranch.rfind('<');
+            if (opPos == string::npos) {
+                opPos = lastFeatureAndValueOnBranch.rfind('>');
             }
-            else if (std::regex_match(lastFeatureAndValueOnBranch, match, pattern2)) {
-                string thresholdStr = match[2].str();
-                double threshold    = std::stod(thresholdStr);
-
-                if (numericValue > threshold) {
-                    pathFound = true;
-                    recursiveDescentForClassification(child, featureAndValues, answer);
-                    answer.solutionPath.push_back(node->GetSerialNum());
-                    break;
-                }
+            double threshold;
+            if (opPos == string::npos ||
+                !parseDouble(std::string_view(lastFeatureAndValueOnBranch).substr(opPos + 1), threshold)) {
+                continue;
             }
-        }
 
-        if (pathFound) {
-            return;
+            if (lastFeatureAndValueOnBranch[opPos] == '<' ? numericValue <= threshold : numericValue > threshold) {
+                recursiveDescentForClassification(child, featureAndValues, answer);
+                answer.solutionPath.push_back(node->GetSerialNum());
+                return;
+            }
         }
     }
     else {
-        // Symbolic feature case
-        string featureValueCombo = featureTestedAtNode + "=" + valueForFeature;
-
+        // Symbolic feature case: the test on the branch of the child to take is "feature=value"
         if (_debug3) {
-            cout << "\nCLRD3 In the symbolic section with feature_value_combo: " << featureValueCombo << endl;
+            cout << "\nCLRD3 In the symbolic section with feature_value_combo: " << featureTestedAtNode << "="
+                 << valueForFeature << endl;
         }
 
-        for (const auto &child : children) {
-            vector<string> branchFeaturesAndValues = child->GetBranchFeaturesAndValuesOrThresholds();
+        for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+            const DecisionTreeNode* child = node->GetChild(i);
+            const vector<string> &branchFeaturesAndValues = child->GetBranchFeaturesAndValuesOrThresholds();
 
             if (_debug3) {
                 cout << "\nCLRD4 branch features and values: ";
@@ -559,32 +1013,22 @@ void DecisionTree::recursiveDescentForClassification(DecisionTreeNode* node,
                 cout << endl;
             }
 
-            string lastFeatureAndValueOnBranch = branchFeaturesAndValues.back();
+            std::string_view lastFeatureAndValueOnBranch = branchFeaturesAndValues.back();
+            const size_t featureLength                   = featureTestedAtNode.size();
 
-            if (lastFeatureAndValueOnBranch == featureValueCombo) {
-                pathFound = true;
+            if (lastFeatureAndValueOnBranch.size() == featureLength + 1 + valueForFeature.size() &&
+                lastFeatureAndValueOnBranch.compare(0, featureLength, featureTestedAtNode) == 0 &&
+                lastFeatureAndValueOnBranch[featureLength] == '=' &&
+                lastFeatureAndValueOnBranch.substr(featureLength + 1) == valueForFeature) {
                 recursiveDescentForClassification(child, featureAndValues, answer);
                 answer.solutionPath.push_back(node->GetSerialNum());
-                break;
+                return;
             }
         }
-
-        if (pathFound) {
-            return;
-        }
     }
 
     // If no path found, assign class probabilities from the current node
-    if (!pathFound) {
-        vector<double> leafNodeClassProbabilities = node->GetClassProbabilities();
-
-        for (size_t i = 0; i < _classNames.size(); ++i) {
-            answer.classProbabilities[_classNames[i]] = leafNodeClassProbabilities[i];
-        }
-
-        answer.solutionPath.push_back(node->GetSerialNum());
-        return;
-    }
+    stopAtNode();
 }
 
 
@@ -825,7 +1269,7 @@ void DecisionTree::interactiveRecursiveDescentForClassification(DecisionTreeNode
  *
  * @return DecisionTreeNode* Pointer to the root node of the constructed decision tree.
  *
- * @throws std::runtime_error If the root node is null after creation.
+ * @throws std::runtime_error If the root node is null after creation, or if the memory budget is exceeded.
  */
 DecisionTreeNode* DecisionTree::constructDecisionTreeClassifier()
 {
@@ -833,12 +1277,13 @@ DecisionTreeNode* DecisionTree::constructDecisionTreeClassifier()
     Construct the root node object and set its entropy value as derived from the
     priors associated with the different classes.
     */
-    cout << "\nConstructing a decision tree" << endl;
+    DTPP_DEBUG3("Constructing a decision tree");
+    DTPP_STATS_TIMER(constructTimer, _stats.constructSeconds);
 
     if (_debug3) {
         determineDataCondition();
-        cout << endl << "Starting construction of the decision tree:" << endl;
     }
+    DTPP_DEBUG3("Starting construction of the decision tree:");
 
     // Calculate prior class probabilities
     vector<double> classProbabilities;
@@ -846,26 +1291,33 @@ DecisionTreeNode* DecisionTree::constructDecisionTreeClassifier()
         classProbabilities.push_back(priorProbabilityForClass(className));
     }
 
-    if (_debug3) {
-        cout << "\nPriot class probabilities: " << classProbabilities << endl;
-        cout << "\nClass names: " << _classNames << endl;
-    }
+    DTPP_DEBUG3("Prior class probabilities: " << classProbabilities);
+    DTPP_DEBUG3("Class names: " << _classNames);
 
     double entropy = classEntropyOnPriors();
-    if (_debug3) {
-        cout << endl << "Entropy on priors: " << entropy << endl;
-    }
+    DTPP_DEBUG3("Entropy on priors: " << entropy);
 
     // Create the root node
     auto rootNode = make_unique<DecisionTreeNode>(
         string(""), entropy, classProbabilities, vector<string>{}, shared_from_this(), true);
     rootNode->SetClassNames(_classNames); // MARK: This might be redundant
+    _memoryUsage.nodeBytes = 0;
+    recordNode(*rootNode);
     setRootNode(std::move(rootNode));
     // Start recursive descent
     if (!_rootNode) {
         throw std::runtime_error("Error: Root node is null");
     }
+    if (_featuresPerNode > 0) {
+        // The nodes are constructed in a fixed order, so the features drawn at each depend only on the seed
+        _featureSampler = Philox4x32(_seed ? *_seed : defaultSeed()).split(1);
+    }
     recursiveDescent(_rootNode.get());
+    enforceMemoryBudget();
+
+    if (_buildRoutingIndex) {
+        buildRoutingIndex();
+    }
 
     return _rootNode.get();
 }
@@ -913,12 +1365,10 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
     create the rest of the tree.
     */
 
-    if (_debug3) {
-        cout << "\n==================== ENTERING RECURSIVE DESCENT ==========================" << endl;
-    }
+    DTPP_DEBUG3("==================== ENTERING RECURSIVE DESCENT ==========================");
 
     if (!node) {
-        cout << "Error: Null node passed to recursiveDescent" << endl;
+        DTPP_LOG(debugLogger(), ERROR, "Null node passed to recursiveDescent");
         return;
     }
 
@@ -927,42 +1377,57 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
     vector<string> featuresAndValuesOrThresholdsOnBranch = node->GetBranchFeaturesAndValuesOrThresholds();
     double existingNodeEntropy                           = node->GetNodeEntropy();
 
-    if (_debug3) {
-        cout << "\nRD1 NODE SERIAL NUMBER: " << nodeSerialNumber << endl;
-        cout << "\nRD2 Existing Node Entropy: " << existingNodeEntropy << endl;
-        cout << "\nRD3 Features and values or thresholds on branch: " << endl;
-        cout << featuresAndValuesOrThresholdsOnBranch << endl;
-        auto classProbs = node->GetClassProbabilities();
-        cout << "\nRD4 Class probabilities: " << endl << classProbs << endl;
+    // The span of the node includes the construction of its subtree
+    TraceSpan nodeSpan(_trace, "node " + std::to_string(nodeSerialNumber), "recursiveDescent");
+    if (nodeSpan.isActive()) {
+        nodeSpan.setArg("node", nodeSerialNumber);
+        nodeSpan.setArg("depth", featuresAndValuesOrThresholdsOnBranch.size());
+        nodeSpan.setArg("samples", countSamplesOnBranch(featuresAndValuesOrThresholdsOnBranch));
     }
 
+    DTPP_DEBUG3("RD1 NODE SERIAL NUMBER: " << nodeSerialNumber);
+    DTPP_DEBUG3("RD2 Existing Node Entropy: " << existingNodeEntropy);
+    DTPP_DEBUG3("RD3 Features and values or thresholds on branch: " << featuresAndValuesOrThresholdsOnBranch);
+    DTPP_DEBUG3("RD4 Class probabilities: " << node->GetClassProbabilities());
+
     if (existingNodeEntropy < _entropyThreshold) {
-        if (_debug3) {
-            cout << "\nRD5 Returning because Existing Node Entropy is below threshold" << endl;
-        }
+        DTPP_DEBUG3("RD5 Returning because Existing Node Entropy is below threshold");
         return;
     }
 
+    enforceMemoryBudget();
+
     // Get the best feature info
-    vector<string> copyOfPathAttributes  = featuresAndValuesOrThresholdsOnBranch;
-    BestFeatureResult bestFeatureResults = bestFeatureCalculator(copyOfPathAttributes, existingNodeEntropy);
-    string bestFeature                   = bestFeatureResults.bestFeatureName;
-    double bestFeatureEntropy            = bestFeatureResults.bestFeatureEntropy;
+    vector<string> copyOfPathAttributes = featuresAndValuesOrThresholdsOnBranch;
+    BestFeatureResult bestFeatureResults;
+    {
+        DTPP_STATS_TIMER(splitSearchTimer, _stats.splitSearchSeconds);
+        DTPP_STATS_ONLY(const long long thresholdsBefore = _stats.thresholdsEvaluated);
+        DTPP_STATS_ONLY(const long long cacheHitsBefore = _stats.cacheHits());
+        bestFeatureResults = bestFeatureCalculator(copyOfPathAttributes, existingNodeEntropy);
+        DTPP_STATS_COUNT(_stats.splitSearches, 1);
+        DTPP_STATS_ONLY(_stats.splitSearchSecondsPerNode[nodeSerialNumber] = splitSearchTimer.elapsed());
+        DTPP_STATS_ONLY(nodeSpan.setArg("thresholdsTried", _stats.thresholdsEvaluated - thresholdsBefore));
+        DTPP_STATS_ONLY(nodeSpan.setArg("cacheHits", _stats.cacheHits() - cacheHitsBefore));
+    }
+    string bestFeature                                     = bestFeatureResults.bestFeatureName;
+    double bestFeatureEntropy                              = bestFeatureResults.bestFeatureEntropy;
     optional<pair<double, double>> bestFeatureValEntropies = bestFeatureResults.valBasedEntropies;
     optional<double> decisionVal                           = bestFeatureResults.decisionValue;
 
     // Set the best feature and its entropy
     node->SetFeature(bestFeature);
+    node->SetSplitEntropy(bestFeatureEntropy);
 
-    if (_debug3) {
-        node->DisplayNode("");
-    }
+    DTPP_DEBUG3("Node:\n" << [node] {
+        std::ostringstream display;
+        node->DisplayNode("", display);
+        return display.str();
+    }());
 
     // -1 represents "None"
     if (_maxDepthDesired != -1 && (featuresAndValuesOrThresholdsOnBranch.size() >= _maxDepthDesired)) {
-        if (_debug3) {
-            cout << "\nRD6 REACHED LEAF NODE AT MAX DEPTH ALLOWED" << endl;
-        }
+        DTPP_DEBUG3("RD6 REACHED LEAF NODE AT MAX DEPTH ALLOWED");
         return;
     }
 
@@ -971,35 +1436,17 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
         return;
     }
 
-    if (_debug3) {
-        cout << "\nRD7 Existing entropy at node: " << existingNodeEntropy << endl;
-        cout << "\nRD8 Calculated best feature is: " << bestFeature << " with value: ";
-        if (decisionVal.has_value()) {
-            cout << decisionVal.value() << endl;
-        }
-        else {
-            cout << "None" << endl;
-        }
-        cout << "\nRD9 Best feature entropy: " << bestFeatureEntropy << endl;
-        cout << "\nRD10 Calculated entropies for different values of best feature: ";
-        if (bestFeatureValEntropies.has_value()) {
-            cout << bestFeatureValEntropies.value().first << " and " << bestFeatureValEntropies.value().second << endl;
-        }
-        else {
-            cout << "None" << endl;
-        }
-    }
+    DTPP_DEBUG3("RD7 Existing entropy at node: " << existingNodeEntropy);
+    DTPP_DEBUG3("RD8 Calculated best feature is: " << bestFeature << " with value: " << decisionVal);
+    DTPP_DEBUG3("RD9 Best feature entropy: " << bestFeatureEntropy);
+    DTPP_DEBUG3("RD10 Calculated entropies for different values of best feature: " << bestFeatureValEntropies);
 
     // calc entropy gain
     double entropyGain = existingNodeEntropy - bestFeatureEntropy;
-
-    if (_debug3) {
-        cout << "\nRD11 Expected entropy gain: " << entropyGain << endl;
-    }
+    DTPP_DEBUG3("RD11 Expected entropy gain: " << entropyGain);
 
     if (entropyGain > _entropyThreshold) {
-        if (_numericFeaturesValueRangeDict.find(bestFeature) != _numericFeaturesValueRangeDict.end() &&
-            _featureValuesHowManyUniquesDict[bestFeature] > _symbolicToNumericCardinalityThreshold) {
+        if (isNumericFeature(bestFeature)) {
             double bestThreshold         = decisionVal.value();
             double bestEntropyForLess    = bestFeatureValEntropies.value().first;
             double bestEntropyForGreater = bestFeatureValEntropies.value().second;
@@ -1014,12 +1461,10 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
             extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild.push_back(
                 featureThresholdComboForGreaterThanChild);
 
-            if (_debug3) {
-                cout << "\nRD12 extendedBranchFeaturesAndValuesOrThresholdsOnBranchLessThanChild: "
-                     << extendedBranchFeaturesAndValuesOrThresholdsOnBranchLessThanChild << endl;
-                cout << "\nRD13 extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild: "
-                     << extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild << endl;
-            }
+            DTPP_DEBUG3("RD12 extendedBranchFeaturesAndValuesOrThresholdsOnBranchLessThanChild: "
+                        << extendedBranchFeaturesAndValuesOrThresholdsOnBranchLessThanChild);
+            DTPP_DEBUG3("RD13 extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild: "
+                        << extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild);
 
             // list(map(lambda x: self.probability_of_a_class_given_sequence_of_features_and_values_or_thresholds(x,
             // extended_branch_features_and_values_or_thresholds_for_lessthan_child), self._class_names))
@@ -1037,10 +1482,8 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                         className, extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild));
             }
 
-            if (_debug3) {
-                cout << "\nRD14 class entropy for going down lessthan child: " << bestEntropyForLess << endl;
-                cout << "\nRD15 class entropy for going down greaterthan child: " << bestEntropyForGreater << endl;
-            }
+            DTPP_DEBUG3("RD14 class entropy for going down lessthan child: " << bestEntropyForLess);
+            DTPP_DEBUG3("RD15 class entropy for going down greaterthan child: " << bestEntropyForGreater);
 
             if (bestEntropyForLess < existingNodeEntropy - _entropyThreshold) {
                 // create a new child node
@@ -1051,6 +1494,7 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                                                   extendedBranchFeaturesAndValuesOrThresholdsOnBranchLessThanChild,
                                                   shared_from_this(),
                                                   false);
+                recordNode(*leftChildNode);
                 // Get the raw pointer before moving the unique_ptr
                 DecisionTreeNode* leftChildNodePtr = leftChildNode.get();
 
@@ -1070,6 +1514,7 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                                                   extendedBranchFeaturesAndValuesOrThresholdsOnBranchGreaterThanChild,
                                                   shared_from_this(),
                                                   false);
+                recordNode(*rightChildNode);
                 // Get the raw pointer before moving the unique_ptr
                 DecisionTreeNode* rightChildNodePtr = rightChildNode.get();
 
@@ -1081,19 +1526,11 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
             }
         }
         else {
-            if (_debug3) {
-                cout << "\nRD16 RECURSIVE DESCENT: In section for Symbolic features for creating children" << endl;
-            }
+            DTPP_DEBUG3("RD16 RECURSIVE DESCENT: In section for Symbolic features for creating children");
 
             set<string> valuesForFeature = _featuresAndUniqueValuesDict[bestFeature];
-
-            if (_debug3) {
-                cout << "\nRD17 Values for feature " << bestFeature << " are: {";
-                for (const auto &value : valuesForFeature) {
-                    cout << value << ", ";
-                }
-                cout << "}" << endl;
-            }
+            DTPP_DEBUG3("RD17 Values for feature " << bestFeature << " are: "
+                                                   << vector<string>(valuesForFeature.begin(), valuesForFeature.end()));
             // map(lambda x
             //     : "".join([ best_feature, "=", x ]), map(str, map(convert, values_for_feature)))
 
@@ -1106,9 +1543,7 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
 
             // auto classEntropiesForChildresn = {};
             for (int featureValueIndex = 0; featureValueIndex < featureValueCombos.size(); featureValueIndex++) {
-                if (_debug3) {
-                    cout << "\nRD18 Creating a child node for: " << featureValueCombos[featureValueIndex] << endl;
-                }
+                DTPP_DEBUG3("RD18 Creating a child node for: " << featureValueCombos[featureValueIndex]);
                 vector<string> extendedBranchFeaturesAndValeusOrThresholds;
 
                 if (featuresAndValuesOrThresholdsOnBranch.empty()) {
@@ -1128,10 +1563,8 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                 double classEntropyForChild = classEntropyForAGivenSequenceOfFeaturesAndValuesOrThresholds(
                     extendedBranchFeaturesAndValeusOrThresholds);
 
-                if (_debug3) {
-                    cout << "\nRD19 branch attributes: " << extendedBranchFeaturesAndValeusOrThresholds << endl;
-                    cout << "\nRD20 class entropy for child: " << classEntropyForChild << endl;
-                }
+                DTPP_DEBUG3("RD19 branch attributes: " << extendedBranchFeaturesAndValeusOrThresholds);
+                DTPP_DEBUG3("RD20 class entropy for child: " << classEntropyForChild);
 
                 if (existingNodeEntropy - classEntropyForChild > _entropyThreshold) {
                     // create a new child node
@@ -1142,6 +1575,7 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                                                       extendedBranchFeaturesAndValeusOrThresholds,
                                                       shared_from_this(),
                                                       false);
+                    recordNode(*childNode);
                     // Get the raw pointer before moving the unique_ptr
                     DecisionTreeNode* childNodePtr = childNode.get();
 
@@ -1151,16 +1585,14 @@ void DecisionTree::recursiveDescent(DecisionTreeNode* node)
                     // Traverse the node using the raw pointer
                     recursiveDescent(childNodePtr);
                 }
-                else if (_debug3) {
-                    cout << "\nRD21 This child will NOT result in a node" << endl;
+                else {
+                    DTPP_DEBUG3("RD21 This child will NOT result in a node");
                 }
             }
         }
     }
     else {
-        if (_debug3) {
-            cout << "\nRD22 REACHED LEAF NODE NATURALLY for: " << featuresAndValuesOrThresholdsOnBranch << endl;
-        }
+        DTPP_DEBUG3("RD22 REACHED LEAF NODE NATURALLY for: " << featuresAndValuesOrThresholdsOnBranch);
     }
 }
 
@@ -1201,6 +1633,24 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
         }
     }
 
+    // With features_per_node, only that many features not already used on the branch are drawn at random to compete
+    set<string> featuresSkippedAtNode;
+    if (_featuresPerNode > 0) {
+        vector<string> candidateFeatures;
+        for (const auto &featureName : _featureNames) {
+            if (std::find(symbolicFeaturesAlreadyUsed.begin(), symbolicFeaturesAlreadyUsed.end(), featureName) ==
+                symbolicFeaturesAlreadyUsed.end()) {
+                candidateFeatures.push_back(featureName);
+            }
+        }
+        // Partial Fisher-Yates shuffle: the first _featuresPerNode candidates are drawn, the rest are skipped
+        const size_t numDrawn = std::min<size_t>(_featuresPerNode, candidateFeatures.size());
+        for (size_t i = 0; i < numDrawn; ++i) {
+            std::swap(candidateFeatures[i], candidateFeatures[i + _featureSampler() % (candidateFeatures.size() - i)]);
+        }
+        featuresSkippedAtNode.insert(candidateFeatures.begin() + numDrawn, candidateFeatures.end());
+    }
+
     vector<string> trueNumericTypes;
     vector<string> symbolicTypes;
     vector<string> trueNumericTypesFeatureNames;
@@ -1263,24 +1713,24 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
 
     // Loop through all features to calculate entropies
     for (const auto &featureName : _featureNames) {
-        if (_debug3) {
-            std::cout << "\n\nBFC1    FEATURE BEING CONSIDERED: " << featureName << std::endl;
-        }
+        DTPP_DEBUG3("BFC1    FEATURE BEING CONSIDERED: " << featureName);
+        enforceMemoryBudget();
 
-        // Skip symbolic features that are already used
+        // Skip symbolic features that are already used, and those not drawn for this node
         if (std::find(symbolicFeaturesAlreadyUsed.begin(), symbolicFeaturesAlreadyUsed.end(), featureName) !=
-            symbolicFeaturesAlreadyUsed.end()) {
+                symbolicFeaturesAlreadyUsed.end() ||
+            featuresSkippedAtNode.count(featureName)) {
             continue;
         }
 
         // Check if the feature is numeric and exceeds the symbolic-to-numeric cardinality threshold
-        else if (_numericFeaturesValueRangeDict.find(featureName) != _numericFeaturesValueRangeDict.end() &&
-                 _featureValuesHowManyUniquesDict[featureName] > _symbolicToNumericCardinalityThreshold) {
+        else if (isNumericFeature(featureName)) {
+            DTPP_STATS_COUNT(_stats.featuresEvaluated, 1);
+            TraceSpan featureSpan(_trace, featureName, "bestFeatureCalculator");
+            DTPP_STATS_ONLY(const long long cacheHitsBefore = _stats.cacheHits());
             // Get the sampling points for the numeric feature
             vector<double> values = _samplingPointsForNumericFeatureDict[featureName];
-            if (_debug3) {
-                cout << "\nBFC2 values for " << featureName << " are " << values;
-            }
+            DTPP_DEBUG3("BFC2 values for " << featureName << " are " << values);
 
             vector<double> newValues;
 
@@ -1334,6 +1784,7 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
             }
 
             vector<double> partitioningEntropies;
+            DTPP_STATS_COUNT(_stats.thresholdsEvaluated, newValues.size());
 
             for (const auto &value : newValues) {
                 string featureAndLessThanValueString    = featureName + "<" + formatDouble(value);
@@ -1362,6 +1813,8 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
                 partitioningEntropies.push_back(partitioningEntropy);
                 partitioningPointChildEntropiesDict[featureName][value] = {entropy1, entropy2};
             }
+            featureSpan.setArg("thresholdsTried", newValues.size());
+            DTPP_STATS_ONLY(featureSpan.setArg("cacheHits", _stats.cacheHits() - cacheHitsBefore));
 
             double minEntropy = *std::min_element(partitioningEntropies.begin(), partitioningEntropies.end());
             int bestPartitioningPointIndex =
@@ -1374,21 +1827,21 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
             }
         }
         else {
-            if (_debug3) {
-                std::cout << "\nBFC3 Best feature calculator: Entering section reserved for symbolic features";
-                cout << "\nBFC4 Feature name: " << featureName;
-            }
+            DTPP_STATS_COUNT(_stats.featuresEvaluated, 1);
+            TraceSpan featureSpan(_trace, featureName, "bestFeatureCalculator");
+            DTPP_STATS_ONLY(const long long cacheHitsBefore = _stats.cacheHits());
+            DTPP_DEBUG3("BFC3 Best feature calculator: Entering section reserved for symbolic features");
+            DTPP_DEBUG3("BFC4 Feature name: " << featureName);
 
             set<string> valuesSet = _featuresAndUniqueValuesDict[featureName];
             vector<string> values(valuesSet.begin(), valuesSet.end());
             // Sort the values
             std::sort(values.begin(), values.end());
 
-            if (_debug3) {
-                cout << "\nBFC5 Values for feature " << featureName << " are: " << values;
-            }
+            DTPP_DEBUG3("BFC5 Values for feature " << featureName << " are: " << values);
 
             double entropy = 0.0;
+            DTPP_STATS_COUNT(_stats.thresholdsEvaluated, values.size());
 
             for (const auto &value : values) {
                 string featureValueString;
@@ -1401,9 +1854,7 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
                     featureValueString = featureName + "=" + formatDouble(valueAsDouble);
                 }
 
-                if (_debug3) {
-                    cout << "\nBFC6 Feature value string: " << featureValueString;
-                }
+                DTPP_DEBUG3("BFC6 Feature value string: " << featureValueString);
 
                 vector<string> extendedAttributes = deepCopy(featuresAndValuesOrThresholdsOnBranch);
 
@@ -1416,99 +1867,595 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
                 double entrop = classEntropyForAGivenSequenceOfFeaturesAndValuesOrThresholds(extendedAttributes);
                 double probs  = probabilityOfASequenceOfFeaturesAndValuesOrThresholds(extendedAttributes);
 
-                entropy += entrop * probs;
+                entropy += entrop * probs;
+
+                DTPP_DEBUG3("BFC6.1 Extended Attributes: " << extendedAttributes);
+                DTPP_DEBUG3("BFC7 Entropy calculated for symbolic feature value choice (" << featureName << ", " << value
+                                                                                          << ") is " << entropy);
+                DTPP_DEBUG3("BFC7.1 Class Entropy: " << entrop);
+                DTPP_DEBUG3("BFC7.2 Probability: " << probs);
+
+                entropiesForDifferentValuesOfSymbolicFeature[featureName].push_back(entropy);
+            }
+            featureSpan.setArg("thresholdsTried", values.size());
+            DTPP_STATS_ONLY(featureSpan.setArg("cacheHits", _stats.cacheHits() - cacheHitsBefore));
+
+            if (entropy < existingNodeEntropy) {
+                entropyValuesForDifferentFeatures[featureName] = entropy;
+            }
+        }
+    }
+
+    double minEntropyForBestFeature = std::numeric_limits<double>::max();
+    string bestFeatureName;
+
+    for (const auto &featureNom : entropyValuesForDifferentFeatures) {
+        if (bestFeatureName == "" || featureNom.second < minEntropyForBestFeature) {
+            minEntropyForBestFeature = featureNom.second;
+            bestFeatureName          = featureNom.first;
+        }
+    }
+
+    optional<double> thresholdForBestFeature;
+    // If best feature name is in partioning point threshold, return the threshold
+    if (partitioningPointThreshold.find(bestFeatureName) != partitioningPointThreshold.end()) {
+        if (partitioningPointThreshold[bestFeatureName].has_value()) {
+            thresholdForBestFeature = partitioningPointThreshold[bestFeatureName].value();
+        }
+        else {
+            thresholdForBestFeature = nullopt;
+        }
+    }
+    else {
+        thresholdForBestFeature = nullopt;
+    }
+
+    double bestFeatureEntropy = minEntropyForBestFeature;
+    optional<pair<double, double>> valBasedEntropiesToBeReturned;
+    optional<double> decisionValToBeReturned;
+
+    if (isNumericFeature(bestFeatureName)) {
+        if (thresholdForBestFeature.has_value()) {
+            valBasedEntropiesToBeReturned =
+                partitioningPointChildEntropiesDict[bestFeatureName][thresholdForBestFeature.value()];
+            decisionValToBeReturned = thresholdForBestFeature;
+        }
+        else {
+            valBasedEntropiesToBeReturned = nullopt;
+        }
+
+        decisionValToBeReturned = thresholdForBestFeature;
+    }
+    else {
+        valBasedEntropiesToBeReturned = nullopt;
+    }
+
+    if (partitioningPointThreshold.find(bestFeatureName) != partitioningPointThreshold.end()) {
+        if (partitioningPointThreshold[bestFeatureName].has_value()) {
+            decisionValToBeReturned = partitioningPointThreshold[bestFeatureName].value();
+        }
+        else {
+            decisionValToBeReturned = nullopt;
+        }
+    }
+    else {
+        decisionValToBeReturned = nullopt;
+    }
+
+    DTPP_DEBUG3("BFC8 Val based entropies to be returned for feature " << bestFeatureName << " are "
+                                                                       << valBasedEntropiesToBeReturned);
+
+    return {bestFeatureName, bestFeatureEntropy, valBasedEntropiesToBeReturned, decisionValToBeReturned};
+}
+
+
+//--------------- Routing Index ----------------//
+
+/**
+ * @brief Builds the routing index of the training samples for the constructed decision tree.
+ *
+ * Starting with all training samples in increasing order of their IDs, the samples are stably partitioned at every
+ * node according to the feature test that leads to each of its children, in the same way recursiveDescent() lays out
+ * the children. The result is one pass of feature tests per tree level: afterwards the samples at any node, the leaf of
+ * any sample and the path from the root to that leaf are available without rescanning the training data.
+ *
+ * This is called at the end of constructDecisionTreeClassifier() when the "build_routing_index" keyword is set, and
+ * may also be called directly on an already constructed tree.
+ *
+ * @throws std::runtime_error If the decision tree has not been constructed.
+ */
+void DecisionTree::buildRoutingIndex()
+{
+    if (!_rootNode) {
+        throw std::runtime_error("You must first construct the decision tree before building its routing index.");
+    }
+
+    _routingIndex = RoutingIndex{};
+    _routingIndex.permutedSamples.reserve(_trainingDataDict.size());
+    for (const auto &samplePair : _trainingDataDict) {
+        _routingIndex.permutedSamples.push_back(samplePair.first);
+    }
+
+    // The serial numbers come from the node counter of the tree, and the sample IDs are the sorted keys of the data
+    _routingIndex.nodeRowRanges.assign(_nodesCreated + 1, {-1, -1});
+    _routingIndex.parentNodes.assign(_nodesCreated + 1, -1);
+    if (!_trainingDataDict.empty()) {
+        _routingIndex.firstSample = _trainingDataDict.begin()->first;
+        _routingIndex.sampleToLeaf.assign(_trainingDataDict.rbegin()->first - _routingIndex.firstSample + 1, -1);
+    }
+
+    partitionSamplesAtNode(_rootNode.get(), 0, static_cast<int>(_routingIndex.permutedSamples.size()));
+}
+
+/**
+ * @brief Records the sample range of a node and partitions it among the children of the node.
+ *
+ * The samples in [begin, end) of the permuted sample array are those at the node. Each child takes, in order, the
+ * samples of the remaining range that satisfy the last feature test on its branch. A symbolic test "feature=value"
+ * requires an exact match, "feature<threshold" is satisfied by values less than or equal to the threshold and
+ * "feature>threshold" by values greater than it, which is how classify() descends the tree.
+ *
+ * @param node A pointer to the node whose samples are in [begin, end).
+ * @param begin The start of the range of the node in the permuted sample array.
+ * @param end One past the end of the range of the node in the permuted sample array.
+ */
+void DecisionTree::partitionSamplesAtNode(DecisionTreeNode* node, int begin, int end)
+{
+    int nodeSerialNum            = node->GetSerialNum();
+    vector<int> &permutedSamples = _routingIndex.permutedSamples;
+    if (nodeSerialNum >= static_cast<int>(_routingIndex.nodeRowRanges.size())) {
+        _routingIndex.nodeRowRanges.resize(nodeSerialNum + 1, {-1, -1});
+        _routingIndex.parentNodes.resize(nodeSerialNum + 1, -1);
+    }
+    _routingIndex.nodeRowRanges[nodeSerialNum] = {begin, end};
+
+    int childBegin = begin;
+    for (auto child : node->GetChildren()) {
+
+        // The last feature test on the branch is the one that leads from this node to the child
+        auto satisfiesTest = featureTestPredicate(child->GetBranchFeaturesAndValuesOrThresholds().back());
+
+        auto childEnd = std::stable_partition(permutedSamples.begin() + childBegin,
+                                              permutedSamples.begin() + end,
+                                              [&](int sample) { return satisfiesTest(_trainingDataDict.at(sample)); });
+        int childEndIndex = static_cast<int>(childEnd - permutedSamples.begin());
+
+        partitionSamplesAtNode(child, childBegin, childEndIndex);
+        _routingIndex.parentNodes[child->GetSerialNum()] = nodeSerialNum;
+        childBegin                                       = childEndIndex;
+    }
+
+    // Samples that no child took end their descent at this node
+    for (int i = childBegin; i < end; i++) {
+        _routingIndex.sampleToLeaf[permutedSamples[i] - _routingIndex.firstSample] = nodeSerialNum;
+    }
+}
+
+/**
+ * @brief Returns a function that tells whether the feature values of a sample satisfy a feature test.
+ *
+ * A symbolic test "feature=value" requires an exact match, "feature<threshold" is satisfied by values less than or
+ * equal to the threshold and "feature>threshold" by values greater than it, which is how classify() descends the
+ * tree. A missing numeric value satisfies neither.
+ *
+ * @param featureTest A feature test in the form used on the branches of the tree.
+ * @return A function of the feature values of the sample.
+ *
+ * @throws std::runtime_error If the test does not start with the name of a feature followed by '=', '<' or '>'.
+ */
+std::function<bool(const vector<string> &)> DecisionTree::featureTestPredicate(const string &featureTest) const
+{
+    size_t featureIndex;
+    char op;
+    string value;
+    std::tie(featureIndex, op, value) = parseFeatureTest(featureTest);
+    const double thresh               = convert(value);
+
+    return [featureIndex, op, value, thresh](const vector<string> &sampleValues) -> bool {
+        const string &sampleValue = sampleValues[featureIndex];
+        if (op == '=') {
+            return sampleValue == value;
+        }
+
+        double sampleValueAsDouble = convert(sampleValue);
+        if (std::isnan(sampleValueAsDouble) || std::isnan(thresh)) {
+            return false;
+        }
+        return op == '<' ? sampleValueAsDouble <= thresh : sampleValueAsDouble > thresh;
+    };
+}
+
+/**
+ * @brief Splits a feature test into the index of its feature, its operator ('=', '<' or '>') and its value.
+ *
+ * @throws std::runtime_error If the test does not start with the name of a feature followed by '=', '<' or '>'.
+ */
+tuple<size_t, char, string> DecisionTree::parseFeatureTest(const string &featureTest) const
+{
+    size_t featureIndex = _featureNames.size();
+    size_t opPos        = 0;
+    for (size_t i = 0; i < _featureNames.size(); i++) {
+        const string &name = _featureNames[i];
+        // Prefer the longest feature name in case one feature name is a prefix of another
+        if (featureTest.size() > name.size() && name.size() >= opPos && featureTest.compare(0, name.size(), name) == 0 &&
+            string("=<>").find(featureTest[name.size()]) != string::npos) {
+            featureIndex = i;
+            opPos        = name.size();
+        }
+    }
+
+    if (featureIndex == _featureNames.size()) {
+        throw std::runtime_error("Unknown feature test: " + featureTest);
+    }
+
+    return {featureIndex, featureTest[opPos], featureTest.substr(opPos + 1)};
+}
+
+/**
+ * @brief Counts the training samples that satisfy every feature test of a branch.
+ *
+ * A branch of symbolic tests is looked up in the marginals of the contingency cube, if there is one. Otherwise every
+ * weighted row is tested, counting its weight if it satisfies them all.
+ *
+ * @param featuresAndValuesOrThresholds The feature tests on the branch.
+ * @return The number of training samples.
+ */
+int DecisionTree::countSamplesOnBranch(const vector<string> &featuresAndValuesOrThresholds)
+{
+    if (hasContingencyCube()) {
+        vector<int> valueCodes(_featureNames.size(), ContingencyCube::ANY);
+        bool allSymbolic = true;
+        for (const auto &featureTest : featuresAndValuesOrThresholds) {
+            auto [featureIndex, op, value] = parseFeatureTest(featureTest);
+            if (op != '=') {
+                allSymbolic = false;
+                break;
+            }
+
+            // A value the feature does not have, or a second value for the same feature, leaves no samples
+            const int code = _contingencyCube.valueCode(featureIndex, value);
+            if (code == ContingencyCube::ANY ||
+                (valueCodes[featureIndex] != ContingencyCube::ANY && valueCodes[featureIndex] != code)) {
+                return 0;
+            }
+            valueCodes[featureIndex] = code;
+        }
+        if (allSymbolic) {
+            return static_cast<int>(_contingencyCube.count(valueCodes, ContingencyCube::ANY));
+        }
+    }
+
+    vector<std::function<bool(const vector<string> &)>> tests;
+    for (const auto &featureTest : featuresAndValuesOrThresholds) {
+        tests.push_back(featureTestPredicate(featureTest));
+    }
+
+    int count = 0;
+    for (const auto &row : getWeightedRows()) {
+        if (std::all_of(tests.begin(), tests.end(), [&](const auto &test) { return test(*row.values); })) {
+            count += row.weight;
+        }
+    }
+    return count;
+}
+
+
+//--------------- Truncation ----------------//
+
+/**
+ * @brief Tells whether a child of a node would have been grown with a higher entropy threshold or a smaller maximum
+ * depth than those the tree was grown with.
+ *
+ * Both parameters only stop the recursive descent, so the tree grown with them is the tree grown with more permissive
+ * ones, less the nodes whose parent fails one of the tests of recursiveDescent(). The tests are replayed on the
+ * entropies stored in the nodes, in the same floating-point form, so the truncated tree is exactly the tree that
+ * constructDecisionTreeClassifier() would grow, unless features_per_node draws the features at random.
+ *
+ * @param parent A node of the tree.
+ * @param child A child of the node.
+ * @param entropyThreshold The entropy threshold, no lower than the one the tree was grown with.
+ * @param maxDepthDesired The maximum depth, no greater than the one the tree was grown with; -1 for none.
+ * @return Whether the child is in the truncated tree, given that its parent is.
+ */
+bool DecisionTree::survivesTruncation(const DecisionTreeNode* parent,
+                                      const DecisionTreeNode* child,
+                                      double entropyThreshold,
+                                      int maxDepthDesired) const
+{
+    const double parentEntropy = parent->GetNodeEntropy();
+    const size_t parentDepth   = parent->GetBranchFeaturesAndValuesOrThresholds().size();
+    if (parentEntropy < entropyThreshold) {
+        return false;
+    }
+    if (maxDepthDesired != -1 && parentDepth >= static_cast<size_t>(maxDepthDesired)) {
+        return false;
+    }
+    if (!(parentEntropy - parent->GetSplitEntropy() > entropyThreshold)) {
+        return false;
+    }
+
+    const double childEntropy = child->GetNodeEntropy();
+    if (isNumericFeature(parent->GetFeature())) {
+        return childEntropy < parentEntropy - entropyThreshold;
+    }
+    return parentEntropy - childEntropy > entropyThreshold;
+}
+
+/**
+ * @brief Counts the nodes the tree would have if it were truncated with truncate().
+ */
+int DecisionTree::countNodesAfterTruncation(double entropyThreshold, int maxDepthDesired) const
+{
+    std::function<int(const DecisionTreeNode*)> countNodes = [&](const DecisionTreeNode* node) {
+        int count = 1;
+        for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+            if (survivesTruncation(node, node->GetChild(i), entropyThreshold, maxDepthDesired)) {
+                count += countNodes(node->GetChild(i));
+            }
+        }
+        return count;
+    };
+    return _rootNode ? countNodes(_rootNode.get()) : 0;
+}
+
+/**
+ * @brief Truncates the tree in place to the tree that a higher entropy threshold or a smaller maximum depth would
+ * have grown, and makes them the parameters of the tree.
+ *
+ * Growing the most permissive tree once and truncating it gives every less permissive tree without growing it again.
+ * The routing index of the tree, if it has one, is rebuilt.
+ *
+ * @param entropyThreshold The entropy threshold, no lower than the current one.
+ * @param maxDepthDesired The maximum depth, no greater than the current one; -1 for none.
+ *
+ * @throws std::runtime_error If the tree has not been constructed.
+ * @throws std::invalid_argument If a parameter is more permissive than the one the tree was grown with.
+ */
+void DecisionTree::truncate(double entropyThreshold, int maxDepthDesired)
+{
+    if (!_rootNode) {
+        throw std::runtime_error("You must first construct the decision tree before truncating it.");
+    }
+    if (entropyThreshold < _entropyThreshold ||
+        (_maxDepthDesired != -1 && (maxDepthDesired == -1 || maxDepthDesired > _maxDepthDesired))) {
+        throw std::invalid_argument("A tree can only be truncated to a higher entropy threshold or a smaller depth.");
+    }
+
+    std::function<void(DecisionTreeNode*)> truncateNode = [&](DecisionTreeNode* node) {
+        for (size_t i = node->GetNumChildren(); i-- > 0;) {
+            DecisionTreeNode* child = node->GetChild(i);
+            if (survivesTruncation(node, child, entropyThreshold, maxDepthDesired)) {
+                truncateNode(child);
+            }
+            else {
+                forgetSubtree(*child);
+                node->DeleteChildLink(i);
+            }
+        }
+    };
+    truncateNode(_rootNode.get());
+
+    _entropyThreshold = entropyThreshold;
+    _maxDepthDesired  = maxDepthDesired;
+    if (hasRoutingIndex()) {
+        buildRoutingIndex();
+    }
+}
+
+
+//--------------- Instrumentation ----------------//
+
+/**
+ * @brief Returns the timers and counters collected so far, with the current cache sizes and memory estimate.
+ *
+ * The timers and counters accumulate over calls until resetStats() is called. They are only collected when the
+ * library is built with DTPP_ENABLE_STATS.
+ *
+ * @return A copy of the statistics.
+ */
+TrainingStats DecisionTree::getStats() const
+{
+    TrainingStats stats           = _stats;
+    stats.probabilityCacheEntries = _probabilityCache.size();
+    stats.entropyCacheEntries     = _entropyCache.size();
+    stats.bytesAllocated          = _memoryUsage.totalBytes() + _contingencyCube.branchMarginalsBytes();
+
+    return stats;
+}
+
+/**
+ * @brief Looks up a key in the probability cache, counting the hit or miss.
+ *
+ * @param key The cache key.
+ * @return The cached probability, or nullopt if it has not been computed.
+ */
+optional<double> DecisionTree::cachedProbability(const string &key)
+{
+    auto it = _probabilityCache.find(key);
+    if (it == _probabilityCache.end()) {
+        DTPP_STATS_COUNT(_stats.probabilityCacheMisses, 1);
+        return std::nullopt;
+    }
+    DTPP_STATS_COUNT(_stats.probabilityCacheHits, 1);
+    return it->second;
+}
+
+/**
+ * @brief Looks up a key in the entropy cache, counting the hit or miss.
+ *
+ * @param key The cache key.
+ * @return The cached entropy, or nullopt if it has not been computed.
+ */
+optional<double> DecisionTree::cachedEntropy(const string &key)
+{
+    auto it = _entropyCache.find(key);
+    if (it == _entropyCache.end()) {
+        DTPP_STATS_COUNT(_stats.entropyCacheMisses, 1);
+        return std::nullopt;
+    }
+    DTPP_STATS_COUNT(_stats.entropyCacheHits, 1);
+    return it->second;
+}
+
+/**
+ * @brief Returns the logger that receives the construction debugging output of debug3.
+ *
+ * Without a logger given by setLogger(), a logger that writes to the console only is created on first use.
+ */
+Logger &DecisionTree::debugLogger()
+{
+    if (!_logger) {
+        _logger = make_shared<Logger>("", true);
+    }
+    return *_logger;
+}
+
 
-                if (_debug3) {
-                    cout << "\nBFC6.1 Extended Attributes: " << extendedAttributes << endl;
-                    cout << "\nBFC7 Entropy calculated for symbolic feature value choice (" << featureName << ", "
-                         << value << ") is " << entropy;
-                    cout << "\nBFC7.1 Class Entropy: " << entrop;
-                    cout << "\nBFC7.2 Probability: " << probs;
-                }
+//--------------- Memory Accounting ----------------//
 
-                entropiesForDifferentValuesOfSymbolicFeature[featureName].push_back(entropy);
-            }
+/**
+ * @brief Returns the estimated bytes held by the training data, the caches and the nodes, and the memory budget.
+ *
+ * The estimates are kept up to date as the data is loaded, the caches fill and the nodes are created, so this is
+ * cheap to call at any time. The marginals of the branches of the contingency cube count as probability cache.
+ */
+MemoryUsage DecisionTree::getMemoryUsage() const
+{
+    MemoryUsage usage       = _memoryUsage;
+    usage.budgetBytes       = _memoryBudgetBytes;
+    usage.peakResidentBytes = peakResidentSetBytes();
+    usage.probabilityCacheBytes += _contingencyCube.branchMarginalsBytes();
+    return usage;
+}
 
-            if (entropy < existingNodeEntropy) {
-                entropyValuesForDifferentFeatures[featureName] = entropy;
-            }
-        }
+/**
+ * @brief Stores a probability in the probability cache, accounting for the memory of a new entry.
+ */
+void DecisionTree::storeProbability(const string &key, double value)
+{
+    auto [it, inserted] = _probabilityCache.insert_or_assign(key, value);
+    if (inserted) {
+        _memoryUsage.probabilityCacheBytes += MAP_NODE_BYTES + stringBytes(it->first) + sizeof(double);
     }
+}
 
-    double minEntropyForBestFeature = std::numeric_limits<double>::max();
-    string bestFeatureName;
-
-    for (const auto &featureNom : entropyValuesForDifferentFeatures) {
-        if (bestFeatureName == "" || featureNom.second < minEntropyForBestFeature) {
-            minEntropyForBestFeature = featureNom.second;
-            bestFeatureName          = featureNom.first;
-        }
+/**
+ * @brief Stores an entropy in the entropy cache, accounting for the memory of a new entry.
+ */
+void DecisionTree::storeEntropy(const string &key, double value)
+{
+    auto [it, inserted] = _entropyCache.insert_or_assign(key, value);
+    if (inserted) {
+        _memoryUsage.entropyCacheBytes += MAP_NODE_BYTES + stringBytes(it->first) + sizeof(double);
     }
+}
 
-    optional<double> thresholdForBestFeature;
-    // If best feature name is in partioning point threshold, return the threshold
-    if (partitioningPointThreshold.find(bestFeatureName) != partitioningPointThreshold.end()) {
-        if (partitioningPointThreshold[bestFeatureName].has_value()) {
-            thresholdForBestFeature = partitioningPointThreshold[bestFeatureName].value();
-        }
-        else {
-            thresholdForBestFeature = nullopt;
-        }
-    }
-    else {
-        thresholdForBestFeature = nullopt;
-    }
+/**
+ * @brief Empties the probability and entropy caches, and the marginals of the branches of the contingency cube. Every
+ * cached value is recomputed when it is next needed.
+ */
+void DecisionTree::clearCaches()
+{
+    _probabilityCache.clear();
+    _entropyCache.clear();
+    _contingencyCube.clearBranchMarginals();
+    _memoryUsage.probabilityCacheBytes = 0;
+    _memoryUsage.entropyCacheBytes     = 0;
+}
 
-    double bestFeatureEntropy = minEntropyForBestFeature;
-    optional<pair<double, double>> valBasedEntropiesToBeReturned;
-    optional<double> decisionValToBeReturned;
+/**
+ * @brief Estimates the bytes held by a node, without its children.
+ */
+static size_t nodeBytes(const DecisionTreeNode &node)
+{
+    return sizeof(DecisionTreeNode) + sizeof(unique_ptr<DecisionTreeNode>) +
+           node.GetClassProbabilities().size() * sizeof(double) +
+           containerBytes(node.GetBranchFeaturesAndValuesOrThresholds()) - sizeof(vector<string>);
+}
 
-    if (_numericFeaturesValueRangeDict.find(bestFeatureName) != _numericFeaturesValueRangeDict.end() &&
-        _featureValuesHowManyUniquesDict[bestFeatureName] > _symbolicToNumericCardinalityThreshold) {
-        if (thresholdForBestFeature.has_value()) {
-            valBasedEntropiesToBeReturned =
-                partitioningPointChildEntropiesDict[bestFeatureName][thresholdForBestFeature.value()];
-            decisionValToBeReturned = thresholdForBestFeature;
-        }
-        else {
-            valBasedEntropiesToBeReturned = nullopt;
-        }
+/**
+ * @brief Accounts for the memory of a newly created node.
+ */
+void DecisionTree::recordNode(const DecisionTreeNode &node)
+{
+    DTPP_STATS_COUNT(_stats.nodesCreated, 1);
+    _memoryUsage.nodeBytes += nodeBytes(node);
+    _treeRevision++;
+}
 
-        decisionValToBeReturned = thresholdForBestFeature;
-    }
-    else {
-        valBasedEntropiesToBeReturned = nullopt;
+/**
+ * @brief Stops accounting for the memory of a node and of its descendants, before they are deleted by pruning.
+ */
+void DecisionTree::forgetSubtree(const DecisionTreeNode &node)
+{
+    _memoryUsage.nodeBytes -= std::min(_memoryUsage.nodeBytes, nodeBytes(node));
+    _treeRevision++;
+    for (size_t i = 0; i < node.GetNumChildren(); ++i) {
+        forgetSubtree(*node.GetChild(i));
     }
+}
 
-    if (partitioningPointThreshold.find(bestFeatureName) != partitioningPointThreshold.end()) {
-        if (partitioningPointThreshold[bestFeatureName].has_value()) {
-            decisionValToBeReturned = partitioningPointThreshold[bestFeatureName].value();
-        }
-        else {
-            decisionValToBeReturned = nullopt;
-        }
-    }
-    else {
-        decisionValToBeReturned = nullopt;
+/**
+ * @brief Keeps the memory held by the decision tree within its budget, if it has one.
+ *
+ * This is called between units of work (after loading the data, after each feature's first-order probabilities, at
+ * each node, for each feature of the split search and once the tree is complete), when no cached value is in use, so
+ * the budget may be overshot by the caches of one unit of work in between. Over the budget, the caches
+ * are emptied; construction then goes on with the caches refilled only by the current node, trading time for memory.
+ * If the training data and the nodes alone exceed the budget, construction stops with an exception rather than
+ * running the host out of memory.
+ *
+ * @throws std::runtime_error If the memory held without the caches exceeds the budget.
+ */
+void DecisionTree::enforceMemoryBudget()
+{
+    const size_t marginalsBytes = _contingencyCube.branchMarginalsBytes();
+    if (_memoryBudgetBytes == 0 || _memoryUsage.totalBytes() + marginalsBytes <= _memoryBudgetBytes) {
+        return;
     }
 
-    if (_debug3) {
-        cout << "\nBFC8 Val based entropies to be returned for feature " << bestFeatureName << "are ";
-        if (valBasedEntropiesToBeReturned.has_value()) {
-            cout << valBasedEntropiesToBeReturned.value().first << " and "
-                 << valBasedEntropiesToBeReturned.value().second;
-        }
-        else {
-            cout << "None";
-        }
+    if (_memoryUsage.probabilityCacheBytes + _memoryUsage.entropyCacheBytes + marginalsBytes > 0) {
+        clearCaches();
+        _memoryUsage.cacheEvictions++;
     }
 
-    return {bestFeatureName, bestFeatureEntropy, valBasedEntropiesToBeReturned, decisionValToBeReturned};
+    if (_memoryUsage.totalBytes() > _memoryBudgetBytes) {
+        throw std::runtime_error("Memory budget of " + std::to_string(_memoryBudgetBytes) + " bytes exceeded: " +
+                                 std::to_string(_memoryUsage.trainingDataBytes) + " bytes of training data and " +
+                                 std::to_string(_memoryUsage.nodeBytes) + " bytes of nodes");
+    }
 }
 
 
 //--------------- Entropy Calculators ----------------//
 
+/**
+ * @brief Computes the entropy of the distribution of the classes, given a function of a class name that returns the
+ * probability of the class.
+ *
+ * The probabilities are gathered, in class order, into an array on the stack (or on the heap for more than
+ * MAX_STACK_CLASSES classes) and summed by the entropyOfProbabilities() kernel, so no memory is allocated for the
+ * usual numbers of classes.
+ */
+template <typename ProbabilityOfClass>
+double DecisionTree::entropyOfClassDistribution(const ProbabilityOfClass &probabilityOfClass) const
+{
+    constexpr size_t MAX_STACK_CLASSES = 64;
+    const size_t numClasses            = _classNames.size();
+    double stackProbabilities[MAX_STACK_CLASSES];
+    vector<double> heapProbabilities;
+    double* probabilities = stackProbabilities;
+    if (numClasses > MAX_STACK_CLASSES) {
+        heapProbabilities.resize(numClasses);
+        probabilities = heapProbabilities.data();
+    }
+
+    for (size_t i = 0; i < numClasses; ++i) {
+        probabilities[i] = probabilityOfClass(_classNames[i]);
+    }
+    return entropyOfProbabilities(probabilities, numClasses);
+}
+
 /**
  * @brief Calculates the entropy of the class priors.
  *
@@ -1524,35 +2471,16 @@ BestFeatureResult DecisionTree::bestFeatureCalculator(const vector<string> &feat
 double DecisionTree::classEntropyOnPriors()
 {
     // Check if the entropy for 'priors' is already cached
-    if (_entropyCache.find("priors") != _entropyCache.end()) {
-        return _entropyCache["priors"];
-    }
-
-    double entropy = 0.0; // Initialize entropy
-
-    // Calculate entropy based on class priors
-    for (const auto &className : _classNames) {
-        double prob = priorProbabilityForClass(className);
-
-        double logProb = 0.0;
-        if (prob >= 0.0001 && prob <= 0.999) {
-            logProb = std::log2(prob);
-        }
-
-        if (prob < 0.0001 || prob > 0.999) {
-            logProb = 0.0;
-        }
-
-        // Calculate entropy incrementally
-        entropy += -1.0 * prob * logProb;
+    if (auto cached = cachedEntropy("priors")) {
+        return *cached;
     }
 
-    if (std::abs(entropy) < 0.0000001) {
-        entropy = 0.0;
-    }
+    // Calculate entropy based on class priors; probabilities very close to 0 or 1 contribute nothing
+    const double entropy =
+        entropyOfClassDistribution([this](const string &className) { return priorProbabilityForClass(className); });
 
     // Cache the calculated entropy
-    _entropyCache["priors"] = entropy;
+    storeEntropy("priors", entropy);
 
     return entropy;
 }
@@ -1625,44 +2553,23 @@ double DecisionTree::EntropyForThresholdForFeature(const vector<string> &arrayOf
     sequence += ":" + featureThresholdCombo;
 
     // Check if the entropy for the sequence is already cached
-    if (_entropyCache.find(sequence) != _entropyCache.end()) {
-        return _entropyCache[sequence];
+    if (auto cached = cachedEntropy(sequence)) {
+        return *cached;
     }
 
     // make a copy of the array of features and values or thresholds
     vector<string> arrayOfFeaturesAndValuesOrThresholdsCopy = deepCopy(arrayOfFeaturesAndValuesOrThresholds);
     arrayOfFeaturesAndValuesOrThresholdsCopy.push_back(featureThresholdCombo);
 
-    // Calculate the entropy for the sequence
-    optional<double> entropy;
-
-    // Calculate the entropy for each class
-    for (const auto &className : _classNames) {
-        double logProb = 0.0;
-        double prob    = probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresholds(
-            className, arrayOfFeaturesAndValuesOrThresholdsCopy);
-        if (prob >= 0.0001 && prob <= 0.999) {
-            logProb = std::log2(prob);
-        }
-        else if (prob < 0.0001 || prob > 0.999) {
-            logProb = 0.0;
-        }
-
-        if (!entropy.has_value()) {
-            entropy = -1.0 * prob * logProb;
-            continue;
-        }
-
-        entropy.value() += -1.0 * prob * logProb;
-    }
+    // Calculate the entropy for the sequence from the probability of each class
+    const double entropy = entropyOfClassDistribution([&](const string &className) {
+        return probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresholds(className,
+                                                                              arrayOfFeaturesAndValuesOrThresholdsCopy);
+    });
 
-    // check floating point precision
-    if (std::abs(entropy.value()) < 0.0000001) {
-        entropy = 0.0;
-    }
     // cache the result
-    _entropyCache[sequence] = entropy.value();
-    return entropy.value();
+    storeEntropy(sequence, entropy);
+    return entropy;
 }
 
 /**
@@ -1727,36 +2634,18 @@ double DecisionTree::classEntropyForAGivenSequenceOfFeaturesAndValuesOrThreshold
     }
 
     // Check if the entropy for the sequence is already cached
-    if (_entropyCache.find(sequence) != _entropyCache.end()) {
-        return _entropyCache[sequence];
-    }
-
-    double entropy = 0.0;
-    double logProb = 0.0;
-
-    // Calculate the entropy for each class
-    for (const auto &className : _classNames) {
-        double prob = probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresholds(
-            className, arrayOfFeaturesAndValuesOrThresholds);
-
-        if (prob >= 0.0001 && prob <= 0.999) {
-            logProb = std::log2(prob);
-        }
-        // If probability is too small or too large, set logProb to zero
-        else {
-            logProb = 0.0;
-        }
-
-        // Calculate entropy incrementally
-        entropy += -1.0 * prob * logProb;
+    if (auto cached = cachedEntropy(sequence)) {
+        return *cached;
     }
 
-    if (std::abs(entropy) < 0.0000001) {
-        entropy = 0.0;
-    }
+    // Calculate the entropy from the probability of each class
+    const double entropy = entropyOfClassDistribution([&](const string &className) {
+        return probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresholds(className,
+                                                                              arrayOfFeaturesAndValuesOrThresholds);
+    });
 
     // Cache the result
-    _entropyCache[sequence] = entropy;
+    storeEntropy(sequence, entropy);
 
     return entropy;
 }
@@ -1780,31 +2669,26 @@ double DecisionTree::priorProbabilityForClass(const string &className)
     string classNameCacheKey = "prior::" + className;
 
     // Check if the probability is already in the cache (memoization)
-    if (_probabilityCache.find(classNameCacheKey) != _probabilityCache.end()) {
-        return _probabilityCache[classNameCacheKey];
+    if (auto cached = cachedProbability(classNameCacheKey)) {
+        return *cached;
     }
 
 
     // Calculate prior probability for all classes and store in cache
-    size_t totalNumSamples   = _samplesClassLabelDict.size();
-    vector<string> allValues = {};
-    for (const auto &kv : _samplesClassLabelDict) {
-        allValues.push_back(kv.second);
-    }
+    const auto [numSamplesForClasses, totalNumSamples] = countClassSamples();
 
     // Iterate over all class names to calculate their prior probabilities
-    for (const auto &className : _classNames) {
-        // Get the number of samples for the class
-        size_t numSamplesForClass = std::count(allValues.begin(), allValues.end(), className);
+    for (size_t i = 0; i < _classNames.size(); ++i) {
+        const string &className = _classNames[i];
         // Calculate the prior probability for the class
-        double priorProbability = static_cast<double>(numSamplesForClass) / static_cast<double>(totalNumSamples);
+        double priorProbability = static_cast<double>(numSamplesForClasses[i]) / static_cast<double>(totalNumSamples);
 
         // store the prior probability in the _classPriorsDict
         _classPriorsDict[className] = priorProbability;
 
         // Store the prior probability in the cache
         string classNamePrior             = "prior::" + className;
-        _probabilityCache[classNamePrior] = priorProbability;
+        storeProbability(classNamePrior, priorProbability);
     }
     return _probabilityCache[classNameCacheKey];
 }
@@ -1831,18 +2715,15 @@ void DecisionTree::calculateClassPriors()
         return;
     }
 
-    for (const auto &className : _classNames) {
-        int totalNumSamples      = _samplesClassLabelDict.size();
-        vector<string> allValues = {};
-        for (const auto &kv : _samplesClassLabelDict) {
-            allValues.push_back(kv.second);
-        }
-        int numSamplesForClass  = std::count(allValues.begin(), allValues.end(), className);
-        double priorProbability = static_cast<double>(numSamplesForClass) / static_cast<double>(totalNumSamples);
+    const auto [numSamplesForClasses, totalNumSamples] = countClassSamples();
+
+    for (size_t i = 0; i < _classNames.size(); ++i) {
+        const string &className = _classNames[i];
+        double priorProbability = static_cast<double>(numSamplesForClasses[i]) / static_cast<double>(totalNumSamples);
 
         _classPriorsDict[className]       = priorProbability;
         string classNamePrior             = "prior::" + className;
-        _probabilityCache[classNamePrior] = priorProbability;
+        storeProbability(classNamePrior, priorProbability);
     }
 
     if (_debug2) {
@@ -1892,8 +2773,8 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
     }
 
     // Check if the probability is already cached, if so, return it
-    if (_probabilityCache.find(featureAndValue) != _probabilityCache.end()) {
-        return _probabilityCache[featureAndValue];
+    if (auto cached = cachedProbability(featureAndValue)) {
+        return *cached;
     }
 
     // Initialize variables for histogram calculations
@@ -1904,19 +2785,14 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
 
     // Check if feature is numeric with sufficient unique values for histogram calculations
     if (_numericFeaturesValueRangeDict.find(feature) != _numericFeaturesValueRangeDict.end()) {
-        if (_featureValuesHowManyUniquesDict[feature] > _symbolicToNumericCardinalityThreshold) {
+        if (isNumericFeature(feature)) {
             // Calculate histogram delta based on median difference between unique sorted values
             if (_samplingPointsForNumericFeatureDict.find(feature) == _samplingPointsForNumericFeatureDict.end()) {
                 valueRange = _numericFeaturesValueRangeDict[feature];
                 diffRange  = valueRange[1] - valueRange[0];
 
-                vector<string> values = _featuresAndValuesDict[feature];
-                set<double> uniqueValues;
-                for (const auto &v : values) { // Remove NA values
-                    if (v != "NA") {
-                        uniqueValues.insert(convert(v));
-                    }
-                }
+                const vector<double> values = gatherNumericValues(feature);
+                set<double> uniqueValues(values.begin(), values.end());
 
                 // Get unique values
                 vector<double> sortedUniqueValues(uniqueValues.begin(), uniqueValues.end());
@@ -1956,29 +2832,20 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
     }
 
     if (_numericFeaturesValueRangeDict.find(feature) != _numericFeaturesValueRangeDict.end()) {
-        if (_featureValuesHowManyUniquesDict[feature] > _symbolicToNumericCardinalityThreshold) {
+        if (isNumericFeature(feature)) {
             auto samplingPointsForFeature = _samplingPointsForNumericFeatureDict[feature];
             vector<size_t> countsAtSamplingPoints(samplingPointsForFeature.size(), 0);
-            vector<string> actualValuesForFeature = _featuresAndValuesDict[feature];
-            vector<double> actualValuesForFeatureAsDoubles;
-
-            for (const auto &v : actualValuesForFeature) {
-                if (v != "NA") {
-                    double valueAsDouble = convert(v);
-                    if (!std::isnan(valueAsDouble)) {
-                        actualValuesForFeatureAsDoubles.push_back(valueAsDouble);
-                    }
-                }
-            }
+            const vector<double> actualValuesForFeatureAsDoubles = gatherNumericValues(feature);
 
             // Count the number of values at each sampling point
-            for (size_t i = 0; i < samplingPointsForFeature.size(); ++i) {
-                for (size_t j = 0; j < actualValuesForFeatureAsDoubles.size(); ++j) {
-                    if (abs(samplingPointsForFeature[i] - actualValuesForFeatureAsDoubles[j]) < histogramDelta) {
-                        countsAtSamplingPoints[i] += 1;
-                    }
-                }
-            }
+            countValuesNearGridPointsByClass(samplingPointsForFeature.data(),
+                                             samplingPointsForFeature.size(),
+                                             actualValuesForFeatureAsDoubles.data(),
+                                             nullptr,
+                                             actualValuesForFeatureAsDoubles.size(),
+                                             1,
+                                             histogramDelta,
+                                             countsAtSamplingPoints.data());
 
             // Calculate the total counts
             int totalCounts = 0;
@@ -2008,7 +2875,7 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
 
             // Cache rest
             for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-                _probabilityCache[valuesForFeature[i]] = probabilities[i];
+                storeProbability(valuesForFeature[i], probabilities[i]);
             }
 
             if (!std::isnan(valueAsDouble) && (_probabilityCache.find(featureAndValue) != _probabilityCache.end())) {
@@ -2020,29 +2887,22 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
         }
         else {
             // This section if for those numeric features treated symbolically
-            set<string> uniqueValuesForFeature =
-                set(_featuresAndValuesDict[feature].begin(), _featuresAndValuesDict[feature].end());
+            const set<string> &uniqueValuesForFeature = _featuresAndUniqueValuesDict[feature];
             vector<string> valuesForFeature(uniqueValuesForFeature.begin(), uniqueValuesForFeature.end());
             valuesForFeature.erase(std::remove(valuesForFeature.begin(), valuesForFeature.end(), "NA"),
                                    valuesForFeature.end());
 
-            // Create a feature and value string
+            // Calculate the counts for each value over the weighted rows
+            const auto countsOfValues = countFeatureValues(feature, std::nullopt).first;
+            vector<int> valueCounts(valuesForFeature.size(), 0);
             for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-                valuesForFeature[i] = feature + "=" + valuesForFeature[i];
+                auto count     = countsOfValues.find(valuesForFeature[i]);
+                valueCounts[i] = count != countsOfValues.end() ? count->second : 0;
             }
 
-            // Calculate the counts for each value
-            vector<int> valueCounts(valuesForFeature.size(), 0);
-            for (const auto &sample : _trainingDataDict) {
-                vector<string> featuresAndValues = sample.second;
-                for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-                    for (size_t j = 0; j < featuresAndValues.size(); ++j) {
-                        string name = _featureNames[j] + "=" + featuresAndValues[j];
-                        if (valuesForFeature[i] == name) {
-                            valueCounts[i]++;
-                        }
-                    }
-                }
+            // Create a feature and value string
+            for (size_t i = 0; i < valuesForFeature.size(); ++i) {
+                valuesForFeature[i] = feature + "=" + valuesForFeature[i];
             }
 
             // Assigning counts
@@ -2059,7 +2919,7 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
 
             // Assigning probability cache
             for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-                _probabilityCache[valuesForFeature[i]] = probabilities[i];
+                storeProbability(valuesForFeature[i], probabilities[i]);
             }
 
             // If the feature and value exists in the probability cache, return it
@@ -2073,25 +2933,17 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
     }
     // Symbolic feature case
     else {
-        vector<string> valuesForFeatures = _featuresAndValuesDict[feature];
+        const set<string> &uniqueValuesForFeature = _featuresAndUniqueValuesDict[feature];
+        vector<string> valuesForFeatures(uniqueValuesForFeature.begin(), uniqueValuesForFeature.end());
+
+        // Count the samples with each value over the weighted rows
+        const auto [countsOfValues, totalNumSamples] = countFeatureValues(feature, std::nullopt);
+        vector<int> countsForValues(valuesForFeatures.size(), 0);
         for (size_t i = 0; i < valuesForFeatures.size(); ++i) {
+            auto count           = countsOfValues.find(valuesForFeatures[i]);
+            countsForValues[i]   = count != countsOfValues.end() ? count->second : 0;
             valuesForFeatures[i] = feature + "=" + valuesForFeatures[i];
         }
-        vector<int> countsForValues(valuesForFeatures.size(), 0);
-
-        for (const auto &sample : _trainingDataDict) {
-            vector<string> featuresAndValues = sample.second;
-            for (int i = 0; i < valuesForFeatures.size(); i++) {
-                for (int j = 0; j < featuresAndValues.size(); j++) {
-                    string name = _featureNames[j] + "=" + featuresAndValues[j];
-                    if (valuesForFeatures[i] == name) {
-                        countsForValues[i]++;
-                    }
-                }
-            }
-        }
-
-        int totalNumSamples = _trainingDataDict.size();
 
         vector<double> probabilities;
         for (int count : countsForValues) {
@@ -2100,7 +2952,7 @@ double DecisionTree::probabilityOfFeatureValue(const string &feature, const stri
 
         for (size_t i = 0; i < valuesForFeatures.size(); ++i) {
             string name             = valuesForFeatures[i];
-            _probabilityCache[name] = probabilities[i];
+            storeProbability(name, probabilities[i]);
         }
 
         if (_probabilityCache.find(featureAndValue) != _probabilityCache.end()) {
@@ -2153,8 +3005,8 @@ DecisionTree::probabilityOfFeatureValueGivenClass(const string &feature, const s
     }
 
     // Check if the probability is already cached
-    if (_probabilityCache.find(featureAndValueClass) != _probabilityCache.end()) {
-        return _probabilityCache[featureAndValueClass];
+    if (auto cached = cachedProbability(featureAndValueClass)) {
+        return *cached;
     }
 
     // Initialize variables for histogram calculations
@@ -2165,7 +3017,7 @@ DecisionTree::probabilityOfFeatureValueGivenClass(const string &feature, const s
 
     // If feature in numericFeaturesValueRangeDict
     if (_numericFeaturesValueRangeDict.find(feature) != _numericFeaturesValueRangeDict.end()) {
-        if (_featureValuesHowManyUniquesDict[feature] > _symbolicToNumericCardinalityThreshold) {
+        if (isNumericFeature(feature)) {
             histogramDelta     = _histogramDeltaDict[feature];
             numOfHistogramBins = _numOfHistogramBinsDict[feature];
             valuerange         = _numericFeaturesValueRangeDict[feature];
@@ -2173,68 +3025,59 @@ DecisionTree::probabilityOfFeatureValueGivenClass(const string &feature, const s
         }
     }
 
-    vector<int> samplesForClass = {}; // Vector to store all sample indices for the given class
-
-    // Accumulate all samples names for the given class
-    for (const auto &sampleName : _samplesClassLabelDict) {
-        if (_samplesClassLabelDict[sampleName.first] == className) {
-            samplesForClass.push_back(sampleName.first);
-        }
-    }
-
     // Numeric feature case
     if (_numericFeaturesValueRangeDict.find(feature) != _numericFeaturesValueRangeDict.end()) {
-        if (_featureValuesHowManyUniquesDict[feature] > _symbolicToNumericCardinalityThreshold) {
-            vector<double> samplingPointsForFeature = _samplingPointsForNumericFeatureDict[feature];
-            vector<int> countsAtSamplingPoints(samplingPointsForFeature.size(), 0);
-            vector<string> actualFeatureValuesForSamplesInClass;
-
-            for (const auto &sample : samplesForClass) {
-                int featureIndex = 0;
-                for (const auto &value : _trainingDataDict[sample]) {
-                    string featureName = _featureNames[featureIndex++];
-                    if (featureName == feature && value != "NA") {
-                        actualFeatureValuesForSamplesInClass.push_back(value);
-                    }
+        if (isNumericFeature(feature)) {
+            const vector<double> &samplingPointsForFeature = _samplingPointsForNumericFeatureDict[feature];
+            const size_t numPoints                         = samplingPointsForFeature.size();
+            const size_t featureIndex =
+                std::find(_featureNames.begin(), _featureNames.end(), feature) - _featureNames.begin();
+
+            // Gather the values of the feature with the class of their sample, to histogram every class in one pass
+            vector<double> actualFeatureValues;
+            vector<int32_t> classesOfValues;
+            for (const auto &row : getWeightedRows()) {
+                const string &value        = (*row.values)[featureIndex];
+                const double valueAsDouble = std::trunc(row.numericValues[featureIndex]); // Truncated as by std::stoi
+                if (row.classIndex >= 0 && value != "NA" && !std::isnan(valueAsDouble)) {
+                    actualFeatureValues.insert(actualFeatureValues.end(), row.weight, valueAsDouble);
+                    classesOfValues.insert(classesOfValues.end(), row.weight, row.classIndex);
                 }
             }
 
-            for (size_t i = 0; i < samplingPointsForFeature.size(); ++i) {
-                for (size_t j = 0; j < actualFeatureValuesForSamplesInClass.size(); ++j) {
-                    if (std::abs(samplingPointsForFeature[i] - stoi(actualFeatureValuesForSamplesInClass[j])) <
-                        histogramDelta) {
-                        countsAtSamplingPoints[i]++;
-                    }
+            vector<size_t> countsAtSamplingPoints(_classNames.size() * numPoints, 0);
+            countValuesNearGridPointsByClass(samplingPointsForFeature.data(),
+                                             numPoints,
+                                             actualFeatureValues.data(),
+                                             classesOfValues.data(),
+                                             actualFeatureValues.size(),
+                                             _classNames.size(),
+                                             histogramDelta,
+                                             countsAtSamplingPoints.data());
+
+            // Cache the probabilities of every class that has training samples for the feature
+            bool classHasSamples = false;
+            for (size_t c = 0; c < _classNames.size(); ++c) {
+                const size_t* counts = countsAtSamplingPoints.data() + c * numPoints;
+                size_t totalCounts   = std::accumulate(counts, counts + numPoints, size_t{0});
+                if (totalCounts == 0) {
+                    continue;
                 }
-            }
+                classHasSamples |= _classNames[c] == className;
 
-            // Calculate the total counts (sum the counts at each sampling point)
-            size_t totalCounts = std::accumulate(countsAtSamplingPoints.begin(), countsAtSamplingPoints.end(), 0);
+                for (size_t i = 0; i < numPoints; ++i) {
+                    storeProbability(feature + "=" + formatDouble(samplingPointsForFeature[i]) + "::" + _classNames[c],
+                                     static_cast<double>(counts[i]) / static_cast<double>(totalCounts));
+                }
+            }
 
             // Check for total counts being zero
-            if (totalCounts == 0) {
+            if (!classHasSamples) {
                 throw std::runtime_error("PFVC1 Something is wrong with your training file. It contains no training "
                                          "samples for Class " +
                                          className + " and Feature " + feature);
             }
 
-            // Probabilities
-            vector<double> probabilities(countsAtSamplingPoints.size(), 0.0);
-            for (size_t i = 0; i < countsAtSamplingPoints.size(); ++i) {
-                probabilities[i] = static_cast<double>(countsAtSamplingPoints[i]) / static_cast<double>(totalCounts);
-            }
-
-            // Create values for feature and class (should be the same as list of a map)
-            vector<string> valuesForFeatureAndClass;
-            for (const auto &point : samplingPointsForFeature) {
-                valuesForFeatureAndClass.push_back(feature + "=" + formatDouble(point) + "::" + className);
-            }
-
-            // Cache probabilities
-            for (size_t i = 0; i < valuesForFeatureAndClass.size(); ++i) {
-                _probabilityCache[valuesForFeatureAndClass[i]] = probabilities[i];
-            }
-
             // Return the probability for the given feature-value-class pair if cached, else return 0
             if (_probabilityCache.find(featureAndValueClass) != _probabilityCache.end()) {
                 return _probabilityCache[featureAndValueClass];
@@ -2244,37 +3087,18 @@ DecisionTree::probabilityOfFeatureValueGivenClass(const string &feature, const s
             }
         }
         else {
-            // Extract unique values for the feature from _featuresAndValuesDict
-            set<string> uniqueValues(_featuresAndValuesDict[feature].begin(), _featuresAndValuesDict[feature].end());
-
-            // Remove "NA" values
+            // Extract unique values for the feature, without "NA"
+            set<string> uniqueValues = _featuresAndUniqueValuesDict[feature];
             uniqueValues.erase("NA");
 
-            // Format values as "feature=value"
+            // Count occurrences of feature values within samples for the class, over the weighted rows
+            const auto countsOfValues = countFeatureValues(feature, className).first;
             vector<string> valuesForFeature;
+            vector<int> valueCounts;
             for (const auto &value : uniqueValues) {
-                string formattedValue = feature + "=" + value;
-                valuesForFeature.push_back(formattedValue);
-            }
-
-            // Initialize counts for each value
-            vector<int> valueCounts(valuesForFeature.size(), 0);
-
-            // Count occurrences of feature values within samples for the class
-            for (const auto &sample : samplesForClass) {
-                vector<string> featuresAndValues;
-                for (size_t j = 0; j < _featureNames.size(); ++j) {
-                    featuresAndValues.push_back(_featureNames[j] + "=" + _trainingDataDict[sample][j]);
-                }
-
-                for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-                    for (const auto &currentValue : featuresAndValues) {
-                        // Compare full "feature=value" strings
-                        if (valuesForFeature[i] == currentValue) {
-                            valueCounts[i]++;
-                        }
-                    }
-                }
+                auto count = countsOfValues.find(value);
+                valueCounts.push_back(count != countsOfValues.end() ? count->second : 0);
+                valuesForFeature.push_back(feature + "=" + value); // Format values as "feature=value"
             }
 
             // Calculate the total count
@@ -2288,56 +3112,39 @@ DecisionTree::probabilityOfFeatureValueGivenClass(const string &feature, const s
             // Normalize and cache probabilities
             for (size_t i = 0; i < valuesForFeature.size(); ++i) {
                 string featureAndValueAndClass = valuesForFeature[i] + "::" + className;
-                _probabilityCache[featureAndValueAndClass] =
-                    static_cast<double>(valueCounts[i]) / static_cast<double>(totalCount);
+                storeProbability(featureAndValueAndClass,
+                                 static_cast<double>(valueCounts[i]) / static_cast<double>(totalCount));
             }
 
             // Check for cached value
             string featureValueClass = feature + "=" + adjustedValue + "::" + className;
-
-            for (const auto &entry : _probabilityCache) {
-                if (entry.first == featureValueClass) {
-                    return entry.second;
-                }
-            }
-            return 0.0;
+            auto cachedEntry         = _probabilityCache.find(featureValueClass);
+            return cachedEntry != _probabilityCache.end() ? cachedEntry->second : 0.0;
         }
     }
     // Purely symbolic case
     else {
-        vector<string> valuesForFeature = _featuresAndValuesDict[feature];
-        for (size_t i = 0; i < valuesForFeature.size(); ++i) {
-            valuesForFeature[i] = feature + "=" + valuesForFeature[i];
-        }
-
-        // Removing the duplicate values
-        std::sort(valuesForFeature.begin(), valuesForFeature.end());
-        auto it = std::unique(valuesForFeature.begin(), valuesForFeature.end());
-        valuesForFeature.erase(it, valuesForFeature.end());
+        const set<string> &uniqueValuesForFeature = _featuresAndUniqueValuesDict[feature];
+        vector<string> valuesForFeature(uniqueValuesForFeature.begin(), uniqueValuesForFeature.end());
 
+        // Count the samples of the class with each value over the weighted rows
+        const auto [countsOfValues, numSamplesForClass] = countFeatureValues(feature, className);
         vector<int> countsForValues(valuesForFeature.size(), 0);
-
-        for (const auto &sample : samplesForClass) {
-            vector<string> featuresAndValues = _trainingDataDict[sample];
-            for (int i = 0; i < valuesForFeature.size(); i++) {
-                for (int j = 0; j < featuresAndValues.size(); j++) {
-                    string name = _featureNames[j] + "=" + featuresAndValues[j];
-                    if (valuesForFeature[i] == name) {
-                        countsForValues[i]++;
-                    }
-                }
-            }
+        for (size_t i = 0; i < valuesForFeature.size(); ++i) {
+            auto count          = countsOfValues.find(valuesForFeature[i]);
+            countsForValues[i]  = count != countsOfValues.end() ? count->second : 0;
+            valuesForFeature[i] = feature + "=" + valuesForFeature[i];
         }
 
-        int totalNumSamples = samplesForClass.size();
+        int totalNumSamples = numSamplesForClass;
         if (totalNumSamples == 0) {
             return 0.0;
         }
 
         for (int i = 0; i < valuesForFeature.size(); i++) {
             string featureAndValueForClass = valuesForFeature[i] + "::" + className;
-            _probabilityCache[featureAndValueForClass] =
-                static_cast<double>(countsForValues[i]) / static_cast<double>(totalNumSamples);
+            storeProbability(featureAndValueForClass,
+                             static_cast<double>(countsForValues[i]) / static_cast<double>(totalNumSamples));
         }
 
         string featureAndValueAndClass = feature + "=" + adjustedValue + "::" + className;
@@ -2373,35 +3180,29 @@ double DecisionTree::probabilityOfFeatureLessThanThreshold(const string &feature
     string featureThresholdCombo = featureName + "<" + formatDouble(thresholdAsDouble);
 
     // Check if the probability is already cached
-    if (_probabilityCache.find(featureThresholdCombo) != _probabilityCache.end()) {
-        return _probabilityCache[featureThresholdCombo];
-    }
-
-    // Get all values for the feature
-    vector<string> valuesForFeature = _featuresAndValuesDict[featureName];
-    vector<double> valuesForFeatureAsDoubles;
-    for (const auto &v : valuesForFeature) {
-        if (v != "NA") // Remove NA
-        {
-            double valueAsDouble = convert(v);
+    if (auto cached = cachedProbability(featureThresholdCombo)) {
+        return *cached;
+    }
+
+    // Count the numeric values of the feature, and those less than or equal to the threshold, over the weighted rows
+    const size_t featureIndex =
+        std::find(_featureNames.begin(), _featureNames.end(), featureName) - _featureNames.begin();
+    size_t numValues                  = 0;
+    size_t numValuesLessThanThreshold = 0;
+    for (const auto &row : getWeightedRows()) {
+        const string &value = (*row.values)[featureIndex];
+        if (value != "NA") {
+            double valueAsDouble = row.numericValues[featureIndex];
             if (!std::isnan(valueAsDouble)) {
-                valuesForFeatureAsDoubles.push_back(valueAsDouble);
+                numValues += row.weight;
+                numValuesLessThanThreshold += valueAsDouble <= thresholdAsDouble ? row.weight : 0;
             }
         }
     }
 
-    // Get all values less than the threshold
-    vector<double> allValuesLessThanThreshold;
-    for (const auto &v : valuesForFeatureAsDoubles) {
-        if (v <= thresholdAsDouble) {
-            allValuesLessThanThreshold.push_back(v);
-        }
-    }
-
     // Calculate the probability
-    double probability =
-        static_cast<double>(allValuesLessThanThreshold.size()) / static_cast<double>(valuesForFeatureAsDoubles.size());
-    _probabilityCache[featureThresholdCombo] = probability;
+    double probability = static_cast<double>(numValuesLessThanThreshold) / static_cast<double>(numValues);
+    storeProbability(featureThresholdCombo, probability);
     return probability;
 }
 
@@ -2425,43 +3226,32 @@ double DecisionTree::probabilityOfFeatureLessThanThresholdGivenClass(const strin
     string featureThresholdCombo = featureName + "<" + std::to_string(thresholdAsDouble) + "::" + className;
 
     // Check if the probability is already cached
-    if (_probabilityCache.find(featureThresholdCombo) != _probabilityCache.end()) {
-        return _probabilityCache[featureThresholdCombo];
-    }
-
-    // Accumulate all smaples for given class
-    vector<int> dataSamplesForClass;
-    for (const auto &kv : _samplesClassLabelDict) {
-        if (kv.second == className) {
-            dataSamplesForClass.push_back(kv.first);
-        }
-    }
-
-    // Get all values for the feature
-    vector<string> actualFeatureValuesForSamplesInClass;
-    for (const auto &sampleIdx : dataSamplesForClass) {
-        int featureIdx = 0;
-        for (const auto &value : _trainingDataDict[sampleIdx]) {
-            // if feature matches, add it to the samples list
-            if (_featureNames[featureIdx++] == featureName && value != "NA") {
-                actualFeatureValuesForSamplesInClass.push_back(value);
+    if (auto cached = cachedProbability(featureThresholdCombo)) {
+        return *cached;
+    }
+
+    // Count the values of the feature for the samples of the class, and those less than or equal to the threshold,
+    // over the weighted rows
+    const size_t featureIndex =
+        std::find(_featureNames.begin(), _featureNames.end(), featureName) - _featureNames.begin();
+    const int classIndex =
+        static_cast<int>(std::find(_classNames.begin(), _classNames.end(), className) - _classNames.begin());
+    size_t numValues                  = 0;
+    size_t numValuesLessThanThreshold = 0;
+    for (const auto &row : getWeightedRows()) {
+        const string &value = (*row.values)[featureIndex];
+        if (row.classIndex == classIndex && value != "NA") {
+            numValues += row.weight;
+            double valueAsDouble = row.numericValues[featureIndex];
+            if (!std::isnan(valueAsDouble) && valueAsDouble <= thresholdAsDouble) {
+                numValuesLessThanThreshold += row.weight;
             }
         }
     }
 
-    // Get all values less than or Equal to the threshold
-    vector<double> actualPointsForFeatureLessThanThreshold;
-    for (const auto &v : actualFeatureValuesForSamplesInClass) {
-        double valueAsDouble = convert(v);
-        if (!std::isnan(valueAsDouble) && valueAsDouble <= thresholdAsDouble) {
-            actualPointsForFeatureLessThanThreshold.push_back(valueAsDouble);
-        }
-    }
-
     // Calculate and cache the probability
-    double probability = static_cast<double>(actualPointsForFeatureLessThanThreshold.size()) /
-                         static_cast<double>(actualFeatureValuesForSamplesInClass.size());
-    _probabilityCache[featureThresholdCombo] = probability;
+    double probability = static_cast<double>(numValuesLessThanThreshold) / static_cast<double>(numValues);
+    storeProbability(featureThresholdCombo, probability);
     return probability;
 }
 
@@ -2499,8 +3289,8 @@ double DecisionTree::probabilityOfASequenceOfFeaturesAndValuesOrThresholds(
     }
 
     // Check if the sequence is in the cache
-    if (_probabilityCache.find(sequence) != _probabilityCache.end()) {
-        return _probabilityCache[sequence];
+    if (auto cached = cachedProbability(sequence)) {
+        return *cached;
     }
 
     // Setup the ritual table
@@ -2628,7 +3418,7 @@ double DecisionTree::probabilityOfASequenceOfFeaturesAndValuesOrThresholds(
         }
     }
 
-    _probabilityCache[sequence] = probability;
+    storeProbability(sequence, probability);
     return probability;
 }
 
@@ -2802,7 +3592,7 @@ double DecisionTree::probabilityOfASequenceOfFeaturesAndValuesOrThresholdsGivenC
     }
 
 
-    _probabilityCache[sequenceWithClass] = probability;
+    storeProbability(sequenceWithClass, probability);
     return probability;
 }
 
@@ -2836,8 +3626,8 @@ double DecisionTree::probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresh
     string classAndSequence = className + "::" + sequence;
 
     // Check if the probability is already cached
-    if (_probabilityCache.find(classAndSequence) != _probabilityCache.end()) {
-        return _probabilityCache[classAndSequence];
+    if (auto cached = cachedProbability(classAndSequence)) {
+        return *cached;
     }
 
     // Calculate the probability
@@ -2878,7 +3668,7 @@ double DecisionTree::probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresh
     // Cache the probabilities
     for (size_t i = 0; i < _classNames.size(); ++i) {
         string key             = _classNames[i] + "::" + sequence;
-        _probabilityCache[key] = arrayOfClassProbabilities[i];
+        storeProbability(key, arrayOfClassProbabilities[i]);
     }
 
     // Return the probability
@@ -2894,7 +3684,8 @@ double DecisionTree::probabilityOfAClassGivenSequenceOfFeaturesAndValuesOrThresh
  * This method calculates the worst-case scenario for the number of nodes in the decision tree
  * by considering the number of unique values for symbolic features. It prints the number of features,
  * the largest number of values for symbolic features, and the estimated number of nodes in the worst-case scenario.
- * If the estimated number of nodes exceeds 10,000, it warns the user and prompts for confirmation to continue.
+ * If the estimated number of nodes exceeds 10,000, it warns the user. It never asks for input, so it is safe in
+ * non-interactive runs; the memory budget (memory_budget_mb) is what bounds a tree that grows too large.
  *
  * @note The exact number of nodes created depends on the entropy_threshold used for node expansion
  * (default value is 0.01) and the value set for max_depth_desired for the depth of the tree.
@@ -2949,19 +3740,9 @@ void DecisionTree::determineDataCondition()
     if (estimatedNumberOfNodes > 10000.0) {
         cout << "THIS IS WAY TOO MANY NODES. Consider using a relatively "
                 "large value for entropy_threshold and/or a small value for "
-                "max_depth_desired to reduce the number of nodes created";
-        cout << "\nDo you wish to continue? Enter 'y' if yes:  ";
-
-        string ans;
-        std::getline(std::cin, ans);
-
-        // Remove leading and trailing whitespace
-        ans.erase(ans.find_last_not_of(" \n\r\t") + 1);
-        ans.erase(0, ans.find_first_not_of(" \n\r\t"));
-
-        if (ans != "y") {
-            exit(0);
-        }
+                "max_depth_desired to reduce the number of nodes created, or set memory_budget_mb "
+                "to stop construction cleanly if it outgrows the memory available"
+             << endl;
     }
 }
 
@@ -2974,7 +3755,7 @@ void DecisionTree::determineDataCondition()
  * @param featuresAndValues A vector of strings containing the names of features and values to check.
  * @return true if all names in the vector are used, false otherwise.
  */
-bool DecisionTree::checkNamesUsed(const vector<string> &featuresAndValues)
+bool DecisionTree::checkNamesUsed(const vector<string> &featuresAndValues) const
 {
     for (const auto &featureAndValue : featuresAndValues) {
         // Find the '=' character
@@ -2985,8 +3766,7 @@ bool DecisionTree::checkNamesUsed(const vector<string> &featuresAndValues)
         }
 
         // Split into feature and value
-        string feature = trim(featureAndValue.substr(0, pos));
-        string value   = trim(featureAndValue.substr(pos + 1));
+        auto [feature, value] = splitFeatureAndValue(featureAndValue);
 
         // Check for empty feature or value
         if (feature.empty() || value.empty()) {
@@ -3203,6 +3983,26 @@ int DecisionTree::getDebug3() const
     return _debug3;
 }
 
+size_t DecisionTree::getMemoryBudgetBytes() const
+{
+    return _memoryBudgetBytes;
+}
+
+int DecisionTree::getFeaturesPerNode() const
+{
+    return _featuresPerNode;
+}
+
+size_t DecisionTree::getContingencyCubeMaxCells() const
+{
+    return _contingencyCubeMaxCells;
+}
+
+optional<uint64_t> DecisionTree::getSeed() const
+{
+    return _seed;
+}
+
 int DecisionTree::getHowManyTotalTrainingSamples() const
 {
     return _howManyTotalTrainingSamples;
@@ -3305,6 +4105,26 @@ void DecisionTree::setDebug3(int debug3)
     _debug3 = debug3;
 }
 
+void DecisionTree::setMemoryBudgetBytes(size_t memoryBudgetBytes)
+{
+    _memoryBudgetBytes = memoryBudgetBytes;
+}
+
+void DecisionTree::setContingencyCubeMaxCells(size_t contingencyCubeMaxCells)
+{
+    _contingencyCubeMaxCells = contingencyCubeMaxCells;
+}
+
+void DecisionTree::setFeaturesPerNode(int featuresPerNode)
+{
+    _featuresPerNode = featuresPerNode;
+}
+
+void DecisionTree::setSeed(uint64_t seed)
+{
+    _seed = seed;
+}
+
 void DecisionTree::setHowManyTotalTrainingSamples(int howManyTotalTrainingSamples)
 {
     _howManyTotalTrainingSamples = howManyTotalTrainingSamples;
@@ -3313,6 +4133,7 @@ void DecisionTree::setHowManyTotalTrainingSamples(int howManyTotalTrainingSample
 void DecisionTree::setRootNode(unique_ptr<DecisionTreeNode> rootNode)
 {
     _rootNode = std::move(rootNode);
+    _treeRevision++;
 }
 
 void DecisionTree::setClassNames(const vector<string> &classNames)
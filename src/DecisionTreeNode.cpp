@@ -67,6 +67,7 @@ DecisionTreeNode::DecisionTreeNode(shared_ptr<DecisionTree> dt) : _dt((dt))
 DecisionTreeNode::DecisionTreeNode(const DecisionTreeNode &other)
     : _feature(other._feature),
       _nodeCreationEntropy(other._nodeCreationEntropy),
+      _splitEntropy(other._splitEntropy),
       _classProbabilities(other._classProbabilities),
       _branchFeaturesAndValuesOrThresholds(other._branchFeaturesAndValuesOrThresholds),
       _dt(other._dt),
@@ -107,6 +108,7 @@ DecisionTreeNode &DecisionTreeNode::operator=(const DecisionTreeNode &other)
     _dt                                  = other._dt; // Copy the weak_ptr (safe to copy)
     _feature                             = other._feature;
     _nodeCreationEntropy                 = other._nodeCreationEntropy;
+    _splitEntropy                        = other._splitEntropy;
     _classProbabilities                  = other._classProbabilities;
     _branchFeaturesAndValuesOrThresholds = other._branchFeaturesAndValuesOrThresholds;
     _serialNumber                        = other._serialNumber;
@@ -145,7 +147,7 @@ int DecisionTreeNode::GetNextSerialNum() const
     return tree->_nodesCreated;
 }
 
-string DecisionTreeNode::GetFeature() const
+const string &DecisionTreeNode::GetFeature() const
 {
     return _feature;
 }
@@ -155,12 +157,12 @@ double DecisionTreeNode::GetNodeEntropy() const
     return _nodeCreationEntropy;
 }
 
-vector<double> DecisionTreeNode::GetClassProbabilities() const
+const vector<double> &DecisionTreeNode::GetClassProbabilities() const
 {
     return _classProbabilities;
 }
 
-vector<string> DecisionTreeNode::GetBranchFeaturesAndValuesOrThresholds() const
+const vector<string> &DecisionTreeNode::GetBranchFeaturesAndValuesOrThresholds() const
 {
     return _branchFeaturesAndValuesOrThresholds;
 }
@@ -199,22 +201,27 @@ void DecisionTreeNode::DeleteAllLinks()
     _linkedTo.clear();
 }
 
-void DecisionTreeNode::DisplayNode(const string &offset) const
+void DecisionTreeNode::DeleteChildLink(size_t index)
+{
+    _linkedTo.erase(_linkedTo.begin() + static_cast<long>(index));
+}
+
+void DecisionTreeNode::DisplayNode(const string &offset, std::ostream &out) const
 {
     // Format feature at the node
     string featureAtNode = _feature.empty() ? " " : _feature;
 
     // Format branch features and values with single quotes
-    cout << "NODE " << _serialNumber << ":  " << offset << "BRANCH TESTS TO "
-         << (_linkedTo.empty() ? "LEAF NODE: " : "NODE: ") << "[";
+    out << "NODE " << _serialNumber << ":  " << offset << "BRANCH TESTS TO "
+        << (_linkedTo.empty() ? "LEAF NODE: " : "NODE: ") << "[";
 
     for (size_t i = 0; i < _branchFeaturesAndValuesOrThresholds.size(); ++i) {
-        cout << "'" << _branchFeaturesAndValuesOrThresholds[i] << "'";
+        out << "'" << _branchFeaturesAndValuesOrThresholds[i] << "'";
         if (i < _branchFeaturesAndValuesOrThresholds.size() - 1) {
-            cout << ", ";
+            out << ", ";
         }
     }
-    cout << "]" << endl;
+    out << "]" << endl;
 
     // Offset for the second line
     string secondLineOffset = offset + string(8 + to_string(_serialNumber).length(), ' ');
@@ -228,19 +235,19 @@ void DecisionTreeNode::DisplayNode(const string &offset) const
     }
 
     // Print entropy and class probabilities
-    cout << secondLineOffset;
+    out << secondLineOffset;
     if (_linkedTo.empty()) {
         // Leaf node: Only print entropy and probabilities
-        cout << "Node Creation Entropy: " << roundDouble(_nodeCreationEntropy, 3) << "   Class Probs: "
-             << "[" << join(classProbabilitiesWithClass, ", ") << "]" << endl
-             << endl;
+        out << "Node Creation Entropy: " << roundDouble(_nodeCreationEntropy, 3) << "   Class Probs: "
+            << "[" << join(classProbabilitiesWithClass, ", ") << "]" << endl
+            << endl;
     }
     else {
         // Non-leaf node: Print feature, entropy, and probabilities
-        cout << "Decision Feature: " << featureAtNode
-             << "   Node Creation Entropy: " << roundDouble(_nodeCreationEntropy, 3) << "   Class Probs: "
-             << "[" << join(classProbabilitiesWithClass, ", ") << "]" << endl
-             << endl;
+        out << "Decision Feature: " << featureAtNode
+            << "   Node Creation Entropy: " << roundDouble(_nodeCreationEntropy, 3) << "   Class Probs: "
+            << "[" << join(classProbabilitiesWithClass, ", ") << "]" << endl
+            << endl;
     }
 }
 
@@ -1,5 +1,12 @@
 #include "EvalTrainingData.hpp"
 
+#include "Random.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
 // Constructor inheriting from the DecisionTree
 EvalTrainingData::EvalTrainingData(std::map<std::string, std::string> kwargs) : DecisionTree(kwargs) {}
 EvalTrainingData::~EvalTrainingData()
@@ -14,7 +21,8 @@ EvalTrainingData::~EvalTrainingData()
  * This function performs a 10-fold cross-validation on the training data to evaluate
  * the performance of a decision tree classifier. It checks if the training data file
  * is in CSV format, splits the data into training and testing sets, trains the decision
- * tree, and evaluates its performance on the testing set. The results are stored in a
+ * tree, and evaluates its performance on the testing set. The folds are consecutive runs of sample IDs, or, when the
+ * "seed" keyword is given, a random partition determined by the seed. The results are stored in a
  * confusion matrix, which is used to calculate and display the data quality index.
  *
  * @return double The data quality index calculated from the confusion matrix.
@@ -32,42 +40,11 @@ double EvalTrainingData::evaluateTrainingData()
 
     std::cout << "\nWill run a 10-fold cross-validation test on your training "
                  "data...\n";
-    std::map<int, std::vector<std::string>> allTrainingData;
-
-    // Get all the training data
-    for (const auto &entry : _trainingDataDict) {
-        allTrainingData[entry.first] = std::vector<std::string>();
-        for (const auto &feature : entry.second) {
-            allTrainingData[entry.first].push_back(feature);
-        }
-    }
-
-    std::vector<std::string> allSampleNames;
-
-    // Sort samples based on some index
-    for (const auto &entry : allTrainingData) {
-        auto ent = std::to_string(entry.first);
-        allSampleNames.push_back(ent);
-    }
-
-    // Sort the samples
-    std::sort(allSampleNames.begin(), allSampleNames.end(), [](const std::string &a, const std::string &b) {
-        return std::stoi(a) < std::stoi(b);
-    });
+    std::vector<std::string> allSampleNames = crossValidationOrder();
 
     // fold size is 10% of the training data
-    int foldSize = static_cast<int>(0.1 * allTrainingData.size());
-    std::map<int, std::map<std::string, int>> confusion_matrix;
-
-    // Initialize confusion matrix
-    for (const auto &class_name : _classNames) {
-        int class_index               = std::stoi(class_name);
-        confusion_matrix[class_index] = std::map<std::string, int>();
-        for (const auto &class_name2 : _classNames) {
-            confusion_matrix[class_index][class_name2] = 0;
-        }
-    }
-
+    int foldSize                                               = static_cast<int>(0.1 * allSampleNames.size());
+    std::map<int, std::map<std::string, int>> confusion_matrix = emptyConfusionMatrix();
 
     // Perform 10-fold cross-validation
     for (int foldIndex = 0; foldIndex < 10; ++foldIndex) {
@@ -82,108 +59,17 @@ double EvalTrainingData::evaluateTrainingData()
         std::vector<std::string> trainingSamples(allSampleNames.begin(), testingSamplesStart);
         trainingSamples.insert(trainingSamples.end(), testingSamplesEnd, allSampleNames.end());
 
-        // Create testing and training data
-        std::map<int, std::vector<std::string>> testingData, trainingData;
-        for (const auto &sample : testingSamples) {
-            auto samp         = std::stoi(sample);
-            testingData[samp] = allTrainingData[samp];
-        }
-        for (const auto &sample : trainingSamples) {
-            auto samp          = std::stoi(sample);
-            trainingData[samp] = allTrainingData[samp];
-        }
-
-        // Initialize DecisionTree and class variables
-        map<string, string> kwargs = {
-            {"training_datafile", _trainingDatafile}
-        };
-        shared_ptr<DecisionTree> trainingDT                = make_unique<DecisionTree>(kwargs);
-        trainingDT->_trainingDataDict                      = _trainingDataDict;
-        trainingDT->_classNames                            = _classNames;
-        trainingDT->_featureNames                          = _featureNames;
-        trainingDT->_entropyThreshold                      = _entropyThreshold;
-        trainingDT->_maxDepthDesired                       = _maxDepthDesired;
-        trainingDT->_symbolicToNumericCardinalityThreshold = _symbolicToNumericCardinalityThreshold;
-
-        // Assign samples class labels
-        for (const auto &sample : trainingSamples) {
-            trainingDT->_samplesClassLabelDict[std::stod(sample)] = _samplesClassLabelDict.at(std::stod(sample));
-        }
-
-        // Populate feature and values dictionary
-        trainingDT->_featuresAndValuesDict.clear();
-        int idx = 0;
-        for (const auto &item : trainingDT->_trainingDataDict) {
-            for (const auto &feature_and_value : item.second) {
-                std::string feature = trainingDT->_featureNames[idx % trainingDT->_featureNames.size()];
-                std::string value   = feature_and_value;
-
-                if (value != "NA") {
-                    trainingDT->_featuresAndValuesDict[feature].push_back(value);
-                }
-                idx++;
-            }
-        }
-
-        // Calculate unique values for each feature
-        trainingDT->_featuresAndUniqueValuesDict.clear();
-        for (const auto &pair : trainingDT->_featuresAndValuesDict) {
-            std::set<std::string> unique_values(pair.second.begin(), pair.second.end());
-            trainingDT->_featuresAndUniqueValuesDict[pair.first] =
-                std::set<std::string>(unique_values.begin(), unique_values.end());
-        }
-
-        // Calculate numeric feature value ranges
-        trainingDT->_numericFeaturesValueRangeDict.clear();
-        for (const auto &feature : _numericFeaturesValueRangeDict) {
-            std::set<double> numeric_values;
-            for (const auto &value : feature.second) {
-                try {
-                    numeric_values.insert(value);
-                }
-                catch (const std::invalid_argument &e) { // ignore invalid values
-                    continue;
-                }
-            }
-            if (!numeric_values.empty()) {
-                std::vector<double> numeric_values_vec(numeric_values.begin(), numeric_values.end());
-                std::sort(numeric_values_vec.begin(), numeric_values_vec.end());
-                trainingDT->_numericFeaturesValueRangeDict[feature.first] = {numeric_values_vec.front(),
-                                                                             numeric_values_vec.back()};
-            }
-        }
-
-        if (evalDebug) {
-            printDebugInformation(*trainingDT, testingSamples);
-        }
-
-        if (evalDebug) {
-            trainingDT->_debug2 = true;
-        }
-
-        // We have the training data, calculate probabilities and priors
-        trainingDT->calculateFirstOrderProbabilities();
-        trainingDT->calculateClassPriors();
-
         // Construct the decision tree classifier
-        auto rootNode = trainingDT->constructDecisionTreeClassifier();
+        auto trainingDT = trainFoldTree(trainingSamples, _entropyThreshold, _maxDepthDesired, evalDebug);
+        auto rootNode   = trainingDT->getRootNode();
         if (evalDebug) {
+            printDebugInformation(*trainingDT, testingSamples);
             trainingDT->getRootNode()->DisplayDecisionTree("    ");
         }
 
         // Show the classification results
         for (const auto &testSampleName : testingSamples) {
-            auto testSampleDataUnfiltered = allTrainingData[std::stoi(testSampleName)];
-
-            // Filter out empty and NA values from the test sample data
-            std::vector<std::string> testSampleData;
-            for (size_t idx = 0; idx < testSampleDataUnfiltered.size(); ++idx) {
-                const auto &data = testSampleDataUnfiltered[idx];
-                if (!data.empty() && data != "NA") {
-                    testSampleData.push_back(trainingDT->_featureNames[idx % trainingDT->_featureNames.size()] + "=" +
-                                             data);
-                }
-            }
+            std::vector<std::string> testSampleData = testSampleFeaturesAndValues(testSampleName);
 
             if (evalDebug) {
                 std::cout << "Data in test sample: ";
@@ -199,21 +85,9 @@ double EvalTrainingData::evaluateTrainingData()
             if (evalDebug) {
                 printClassificationInfo(trainingDT->_classNames, classification, solutionPath, rootNode);
             }
-            classification.erase("solution_path");
 
             // Get the most likely class label
-            std::vector<std::string> whichClasses;
-            for (const auto &entry : classification) {
-                whichClasses.push_back(entry.first);
-            }
-
-            std::sort(whichClasses.begin(),
-                      whichClasses.end(),
-                      [&classification](const std::string &a, const std::string &b) {
-                          return classification.at(a) > classification.at(b);
-                      });
-
-            auto mostLikelyClassLabel = whichClasses.front();
+            auto mostLikelyClassLabel = EvalTrainingData::mostLikelyClassLabel(classification);
             auto trueClassLabel       = _samplesClassLabelDict.at(std::stoi(testSampleName));
 
             if (evalDebug) {
@@ -234,6 +108,298 @@ double EvalTrainingData::evaluateTrainingData()
     return idx;
 }
 
+/**
+ * @brief Cross-validates every combination of the given entropy thresholds and maximum depths, growing one tree per
+ * fold instead of one per fold and combination.
+ *
+ * The tree of each fold is grown once with the lowest threshold and the greatest depth, and every combination is
+ * scored on the tree that DecisionTree::truncate() would cut from it, which is the tree the combination would have
+ * grown. A test sample descends the grown tree once; under a combination it stops at the first node of its path whose
+ * next node is truncated. The folds and the classification rule are those of evaluateTrainingData(), so each data
+ * quality index is the one evaluateTrainingData() returns with that combination.
+ *
+ * @param entropyThresholds The entropy thresholds to try.
+ * @param maxDepthsDesired The maximum depths to try; -1 for none.
+ * @return One result per combination, by entropy threshold and then by maximum depth, in the order given.
+ *
+ * @throws std::runtime_error If the training data file is not a CSV file.
+ * @throws std::invalid_argument If either list is empty.
+ */
+vector<SweepResult> EvalTrainingData::sweepHyperparameters(const vector<double> &entropyThresholds,
+                                                           const vector<int> &maxDepthsDesired)
+{
+    if (_trainingDatafile.substr(_trainingDatafile.find_last_of(".") + 1) != "csv") {
+        throw std::runtime_error("The data evaluation function can only be used for CSV files.");
+    }
+    if (entropyThresholds.empty() || maxDepthsDesired.empty()) {
+        throw std::invalid_argument("Expected at least one entropy threshold and one maximum depth to sweep.");
+    }
+
+    vector<SweepResult> results;
+    for (double entropyThreshold : entropyThresholds) {
+        for (int maxDepthDesired : maxDepthsDesired) {
+            results.push_back({entropyThreshold, maxDepthDesired, 0.0, 0.0});
+        }
+    }
+
+    // The most permissive combination grows the tree that every other one truncates
+    const double growthEntropyThreshold = *std::min_element(entropyThresholds.begin(), entropyThresholds.end());
+    const int growthMaxDepthDesired =
+        std::find(maxDepthsDesired.begin(), maxDepthsDesired.end(), -1) != maxDepthsDesired.end()
+            ? -1
+            : *std::max_element(maxDepthsDesired.begin(), maxDepthsDesired.end());
+
+    std::cout << "\nWill run a 10-fold cross-validation sweep over " << results.size()
+              << " combinations of entropy threshold and maximum depth...\n";
+    vector<string> allSampleNames = crossValidationOrder();
+    const int foldSize            = static_cast<int>(0.1 * allSampleNames.size());
+    vector<map<int, map<string, int>>> confusionMatrices(results.size(), emptyConfusionMatrix());
+
+    for (int foldIndex = 0; foldIndex < 10; ++foldIndex) {
+        auto testingSamplesStart = allSampleNames.begin() + static_cast<long>(foldSize) * foldIndex;
+        auto testingSamplesEnd   = allSampleNames.begin() + static_cast<long>(foldSize) * (foldIndex + 1);
+        vector<string> testingSamples(testingSamplesStart, testingSamplesEnd);
+        vector<string> trainingSamples(allSampleNames.begin(), testingSamplesStart);
+        trainingSamples.insert(trainingSamples.end(), testingSamplesEnd, allSampleNames.end());
+
+        auto trainingDT = trainFoldTree(trainingSamples, growthEntropyThreshold, growthMaxDepthDesired, false);
+        for (auto &result : results) {
+            result.meanNumNodes +=
+                trainingDT->countNodesAfterTruncation(result.entropyThreshold, result.maxDepthDesired) / 10.0;
+        }
+
+        map<int, const DecisionTreeNode*> nodesBySerialNum;
+        std::function<void(const DecisionTreeNode*)> indexNodes = [&](const DecisionTreeNode* node) {
+            nodesBySerialNum[node->GetSerialNum()] = node;
+            for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+                indexNodes(node->GetChild(i));
+            }
+        };
+        indexNodes(trainingDT->getRootNode());
+
+        for (const auto &testSampleName : testingSamples) {
+            const vector<string> testSampleData = testSampleFeaturesAndValues(testSampleName);
+            if (!trainingDT->checkNamesUsed(testSampleData)) {
+                throw std::runtime_error("\n\nError in the names you have used for features and/or values. "
+                                         "Try using the csv_cleanup_needed option in the constructor call.");
+            }
+
+            ClassificationAnswer answer;
+            for (const auto &className : trainingDT->_classNames) {
+                answer.classProbabilities[className] = 0.0;
+            }
+            trainingDT->recursiveDescentForClassification(trainingDT->getRootNode(), testSampleData, answer);
+
+            // The solution path goes from the node where the descent stopped up to the root
+            vector<const DecisionTreeNode*> path;
+            for (auto serialNum = answer.solutionPath.rbegin(); serialNum != answer.solutionPath.rend(); ++serialNum) {
+                path.push_back(nodesBySerialNum.at(*serialNum));
+            }
+
+            const int trueClass = std::stoi(_samplesClassLabelDict.at(std::stoi(testSampleName)));
+            for (size_t r = 0; r < results.size(); ++r) {
+                size_t stop = 0;
+                while (stop + 1 < path.size() && trainingDT->survivesTruncation(path[stop],
+                                                                                path[stop + 1],
+                                                                                results[r].entropyThreshold,
+                                                                                results[r].maxDepthDesired)) {
+                    stop++;
+                }
+
+                // The same rule as classify() and evaluateTrainingData() for the most likely class
+                map<string, string> classification;
+                const vector<double> &classProbabilities = path[stop]->GetClassProbabilities();
+                for (size_t c = 0; c < trainingDT->_classNames.size(); ++c) {
+                    std::ostringstream oss;
+                    oss << std::fixed << std::setprecision(3) << classProbabilities[c];
+                    classification[trainingDT->_classNames[c]] = oss.str();
+                }
+                confusionMatrices[r][trueClass][mostLikelyClassLabel(classification)] += 1;
+            }
+        }
+    }
+
+    for (size_t r = 0; r < results.size(); ++r) {
+        results[r].dataQualityIndex = calculateDataQualityIndex(confusionMatrices[r]);
+    }
+    return results;
+}
+
+
+//--------------- Cross-Validation Helpers ----------------//
+
+/**
+ * @brief Returns the sample IDs in the order in which they are dealt to the folds: by ID, or shuffled by the seed.
+ */
+vector<string> EvalTrainingData::crossValidationOrder() const
+{
+    std::vector<std::string> allSampleNames;
+
+    // Sort samples based on some index
+    for (const auto &entry : _trainingDataDict) {
+        allSampleNames.push_back(std::to_string(entry.first));
+    }
+
+    // Sort the samples
+    std::sort(allSampleNames.begin(), allSampleNames.end(), [](const std::string &a, const std::string &b) {
+        return std::stoi(a) < std::stoi(b);
+    });
+
+    // With a seed, the samples are dealt to the folds in a random order from a stream of their own
+    if (_seed) {
+        Philox4x32 rng = Philox4x32(*_seed).split(0);
+        for (size_t i = allSampleNames.size(); i > 1; --i) {
+            std::swap(allSampleNames[i - 1], allSampleNames[rng() % i]);
+        }
+    }
+
+    return allSampleNames;
+}
+
+/**
+ * @brief Constructs the decision tree of a fold, on the class labels of its training samples only.
+ *
+ * @param trainingSamples The IDs of the training samples of the fold.
+ * @param entropyThreshold The entropy threshold of the tree.
+ * @param maxDepthDesired The maximum depth of the tree.
+ * @param debug Whether to print the debugging output of the probability calculations.
+ * @return The constructed tree.
+ */
+shared_ptr<DecisionTree> EvalTrainingData::trainFoldTree(const vector<string> &trainingSamples,
+                                                         double entropyThreshold,
+                                                         int maxDepthDesired,
+                                                         bool debug)
+{
+    // Initialize DecisionTree and class variables
+    map<string, string> kwargs = {
+        {"training_datafile", _trainingDatafile}
+    };
+    shared_ptr<DecisionTree> trainingDT                = make_unique<DecisionTree>(kwargs);
+    trainingDT->_trainingDataDict                      = _trainingDataDict;
+    trainingDT->_classNames                            = _classNames;
+    trainingDT->_featureNames                          = _featureNames;
+    trainingDT->_entropyThreshold                      = entropyThreshold;
+    trainingDT->_maxDepthDesired                       = maxDepthDesired;
+    trainingDT->_symbolicToNumericCardinalityThreshold = _symbolicToNumericCardinalityThreshold;
+
+    // Assign samples class labels
+    for (const auto &sample : trainingSamples) {
+        trainingDT->_samplesClassLabelDict[std::stod(sample)] = _samplesClassLabelDict.at(std::stod(sample));
+    }
+
+    // Populate feature and values dictionary
+    trainingDT->_featuresAndValuesDict.clear();
+    int idx = 0;
+    for (const auto &item : trainingDT->_trainingDataDict) {
+        for (const auto &feature_and_value : item.second) {
+            std::string feature = trainingDT->_featureNames[idx % trainingDT->_featureNames.size()];
+            std::string value   = feature_and_value;
+
+            if (value != "NA") {
+                trainingDT->_featuresAndValuesDict[feature].push_back(value);
+            }
+            idx++;
+        }
+    }
+
+    // Calculate unique values for each feature
+    trainingDT->_featuresAndUniqueValuesDict.clear();
+    for (const auto &pair : trainingDT->_featuresAndValuesDict) {
+        std::set<std::string> unique_values(pair.second.begin(), pair.second.end());
+        trainingDT->_featuresAndUniqueValuesDict[pair.first] =
+            std::set<std::string>(unique_values.begin(), unique_values.end());
+    }
+
+    // Calculate numeric feature value ranges
+    trainingDT->_numericFeaturesValueRangeDict.clear();
+    for (const auto &feature : _numericFeaturesValueRangeDict) {
+        std::set<double> numeric_values;
+        for (const auto &value : feature.second) {
+            try {
+                numeric_values.insert(value);
+            }
+            catch (const std::invalid_argument &e) { // ignore invalid values
+                continue;
+            }
+        }
+        if (!numeric_values.empty()) {
+            std::vector<double> numeric_values_vec(numeric_values.begin(), numeric_values.end());
+            std::sort(numeric_values_vec.begin(), numeric_values_vec.end());
+            trainingDT->_numericFeaturesValueRangeDict[feature.first] = {numeric_values_vec.front(),
+                                                                         numeric_values_vec.back()};
+        }
+    }
+
+    if (debug) {
+        trainingDT->_debug2 = true;
+    }
+
+    // We have the training data, calculate probabilities and priors
+    trainingDT->calculateFirstOrderProbabilities();
+    trainingDT->calculateClassPriors();
+    trainingDT->constructDecisionTreeClassifier();
+    return trainingDT;
+}
+
+/**
+ * @brief Returns the values of a test sample as "feature=value" strings, leaving out the missing ones.
+ */
+vector<string> EvalTrainingData::testSampleFeaturesAndValues(const string &testSampleName) const
+{
+    const auto &testSampleDataUnfiltered = _trainingDataDict.at(std::stoi(testSampleName));
+
+    // Filter out empty and NA values from the test sample data
+    std::vector<std::string> testSampleData;
+    for (size_t idx = 0; idx < testSampleDataUnfiltered.size(); ++idx) {
+        const auto &data = testSampleDataUnfiltered[idx];
+        if (!data.empty() && data != "NA") {
+            testSampleData.push_back(_featureNames[idx % _featureNames.size()] + "=" + data);
+        }
+    }
+    return testSampleData;
+}
+
+/**
+ * @brief Returns a confusion matrix with a zero count for every pair of classes.
+ */
+map<int, map<string, int>> EvalTrainingData::emptyConfusionMatrix() const
+{
+    std::map<int, std::map<std::string, int>> confusion_matrix;
+    for (const auto &class_name : _classNames) {
+        int class_index               = std::stoi(class_name);
+        confusion_matrix[class_index] = std::map<std::string, int>();
+        for (const auto &class_name2 : _classNames) {
+            confusion_matrix[class_index][class_name2] = 0;
+        }
+    }
+    return confusion_matrix;
+}
+
+/**
+ * @brief Picks the most likely class of a classification returned by DecisionTree::classify().
+ *
+ * @param classification The probabilities of the classes as strings, and possibly the solution path.
+ * @return The class with the highest probability.
+ */
+string EvalTrainingData::mostLikelyClassLabel(map<string, string> classification)
+{
+    classification.erase("solution_path");
+
+    std::vector<std::string> whichClasses;
+    for (const auto &entry : classification) {
+        whichClasses.push_back(entry.first);
+    }
+
+    std::sort(whichClasses.begin(), whichClasses.end(), [&classification](const std::string &a, const std::string &b) {
+        return classification.at(a) > classification.at(b);
+    });
+
+    return whichClasses.front();
+}
+
+
+//--------------- Display ----------------//
+
 /**
  * @brief Prints debug information for the training and testing data.
  *
@@ -253,19 +419,19 @@ void EvalTrainingData::printDebugInformation(DecisionTree &trainingDT, const std
         std::cout << sample << "\n";
     }
     std::cout << "\n\nPrinting features and their values in the training set:\n";
-    for (const auto &item : _featuresAndValuesDict) {
+    for (const auto &item : trainingDT._featuresAndValuesDict) {
         for (const auto &value : item.second) {
             std::cout << item.first << "  =>  " << value << "\n";
         }
     }
     std::cout << "\n\nPrinting unique values for features:\n";
-    for (const auto &item : _featuresAndUniqueValuesDict) {
+    for (const auto &item : trainingDT._featuresAndUniqueValuesDict) {
         for (const auto &value : item.second) {
             std::cout << item.first << "  =>  " << value << "\n";
         }
     }
     std::cout << "\n\nPrinting unique value ranges for features:\n";
-    for (const auto &item : _numericFeaturesValueRangeDict) {
+    for (const auto &item : trainingDT._numericFeaturesValueRangeDict) {
         std::cout << item.first << "  =>  " << item.second[0] << " - " << item.second[1] << "\n";
     }
 }
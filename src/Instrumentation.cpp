@@ -0,0 +1,126 @@
+#include "Instrumentation.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+// Appends a string as a JSON string literal
+void appendJsonString(string &out, const string &value)
+{
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[7];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// Appends a number as a JSON number, with the given digits after the decimal point or, if digits is negative, in the
+// shortest form that reads back to the same value. JSON has no NaN or infinity, so those become null.
+void appendJsonNumber(string &out, double value, int digits = -1)
+{
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char buffer[64];
+    auto result = digits < 0 ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+                             : std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, digits);
+    out.append(buffer, result.ptr);
+}
+} // namespace
+
+/**
+ * @brief Turns recording on or off. Turning it on discards the spans recorded so far and restarts the clock.
+ */
+void TraceRecorder::setEnabled(bool enabled)
+{
+    if (enabled && !_enabled) {
+        _events.clear();
+        _origin = std::chrono::steady_clock::now();
+    }
+    _enabled = enabled;
+}
+
+/**
+ * @brief Returns the recorded spans as a Chrome trace-event JSON document.
+ *
+ * Every span is a complete ("X") event of one process and thread, with its timestamps in microseconds, so spans that
+ * were nested when recorded are drawn nested.
+ */
+string TraceRecorder::toChromeTraceJson() const
+{
+    string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"DecisionTree\"}}";
+
+    for (const auto &event : _events) {
+        json += ",\n{\"name\":";
+        appendJsonString(json, event.name);
+        json += ",\"cat\":";
+        appendJsonString(json, event.category);
+        json += ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":";
+        appendJsonNumber(json, event.startMicros, 3);
+        json += ",\"dur\":";
+        appendJsonNumber(json, event.durationMicros, 3);
+        json += ",\"args\":{";
+        for (size_t i = 0; i < event.args.size(); ++i) {
+            if (i > 0) {
+                json += ',';
+            }
+            appendJsonString(json, event.args[i].first);
+            json += ':';
+            appendJsonNumber(json, event.args[i].second);
+        }
+        json += "}}";
+    }
+
+    json += "\n]}\n";
+    return json;
+}
+
+/**
+ * @brief Writes the recorded spans to a file as Chrome trace-event JSON.
+ *
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+void TraceRecorder::writeChromeTrace(const string &filename) const
+{
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open trace file: " + filename);
+    }
+    file << toChromeTraceJson();
+}
+
+/**
+ * @brief Returns the peak resident set size of the process in bytes, or 0 where it is not available.
+ */
+size_t peakResidentSetBytes()
+{
+#if defined(__APPLE__)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) : 0;
+#elif defined(__unix__)
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0; // In KiB
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,157 @@
+// Include
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+//--------------- Split Finding ----------------//
+
+/**
+ * @brief Finds the sampling point closest to a value.
+ *
+ * @param samplingPoints The sampling points, of which there must be at least one.
+ * @param numSamplingPoints The number of sampling points.
+ * @param value The value.
+ * @return The index of the first of the closest sampling points.
+ */
+DTPP_MULTIVERSION
+size_t closestSamplingPointIndex(const double* samplingPoints, size_t numSamplingPoints, double value)
+{
+    double minDiff = std::abs(value - samplingPoints[0]);
+    size_t index   = 0;
+
+    for (size_t i = 1; i < numSamplingPoints; ++i) {
+        const double diff = std::abs(value - samplingPoints[i]);
+        if (diff < minDiff) {
+            minDiff = diff;
+            index   = i;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * @brief Computes the entropy, in bits, of a distribution over classes.
+ *
+ * Each class contributes -p * log2(p), except that probabilities below 0.0001 or above 0.999 contribute nothing, and
+ * the terms are added in class order, so the result is the same to the bit as the loops over the classes this
+ * replaces. An entropy smaller than 1e-7 in magnitude is returned as 0. Nothing is allocated; the caller owns the
+ * probabilities, typically in an array on its stack.
+ *
+ * @param probabilities The probability of each class.
+ * @param numClasses The number of classes.
+ * @return The entropy of the distribution.
+ */
+DTPP_MULTIVERSION
+double entropyOfProbabilities(const double* probabilities, size_t numClasses)
+{
+    double entropy = 0.0;
+
+    for (size_t i = 0; i < numClasses; ++i) {
+        const double prob = probabilities[i];
+        if (prob >= 0.0001 && prob <= 0.999) {
+            entropy += -1.0 * prob * std::log2(prob);
+        }
+    }
+    if (std::abs(entropy) < 0.0000001) {
+        entropy = 0.0;
+    }
+
+    return entropy;
+}
+
+
+//--------------- Histograms ----------------//
+
+/**
+ * @brief Computes the bin of every value in a grid of equal bins.
+ *
+ * The bin of a value is floor((value - origin) / binWidth), except that values before the first bin get -1 and bins
+ * past INT32_MAX - 1 are clamped to it, so the bins can be used as indices after a bounds check. The loop has no
+ * branches, so it is vectorized in each of the clones built by DTPP_MULTIVERSION.
+ *
+ * @param values The values, none of which may be NaN.
+ * @param numValues The number of values.
+ * @param origin The start of the first bin.
+ * @param binWidth The width of the bins, which must be positive.
+ * @param bins An array of numValues bins, which are overwritten.
+ */
+DTPP_MULTIVERSION
+void binIndices(const double* values, size_t numValues, double origin, double binWidth, int32_t* bins)
+{
+    const double inverseWidth = 1.0 / binWidth;
+
+    for (size_t i = 0; i < numValues; ++i) {
+        // Shifted by one bin so that truncation toward zero is the floor, for the values before the grid too
+        double shifted = (values[i] - origin) * inverseWidth + 1.0;
+        shifted        = shifted < 0.0 ? 0.0 : shifted;
+        shifted        = 2147483647.0 < shifted ? 2147483647.0 : shifted;
+        bins[i]        = static_cast<int32_t>(shifted) - 1;
+    }
+}
+
+/**
+ * @brief Counts, for every class and every point of an evenly spaced grid, the values of the class that lie within
+ * histogramDelta of the point.
+ *
+ * This is the inner loop of the histogram estimates of the probability distributions of a numeric feature, whose grid
+ * points are histogramDelta apart. Only the grid points around the bin of a value can be within histogramDelta of it,
+ * so each value is compared with four points instead of all of them, and the classes share one pass over the
+ * values. The bins are computed with binIndices, a block of values at a time.
+ *
+ * @param gridPoints The grid points, gridPoints[i] being gridPoints[0] + i * histogramDelta up to rounding.
+ * @param numGridPoints The number of grid points.
+ * @param values The values, without missing values or NaNs.
+ * @param classes The class of every value, from 0 to numClasses - 1; values of a negative class are skipped. May be
+ * null, in which case all the values are of class 0.
+ * @param numValues The number of values.
+ * @param numClasses The number of classes.
+ * @param histogramDelta The spacing of the grid, and half width of the window around each grid point.
+ * @param counts An array of numClasses * numGridPoints counts, the counts of class c starting at c * numGridPoints,
+ * which are overwritten.
+ */
+DTPP_MULTIVERSION
+void countValuesNearGridPointsByClass(const double* gridPoints,
+                                      size_t numGridPoints,
+                                      const double* values,
+                                      const int32_t* classes,
+                                      size_t numValues,
+                                      size_t numClasses,
+                                      double histogramDelta,
+                                      size_t* counts)
+{
+    std::memset(counts, 0, numClasses * numGridPoints * sizeof(size_t));
+    if (numGridPoints == 0 || !(histogramDelta > 0.0)) {
+        return; // No value is within a window of zero width
+    }
+
+    constexpr size_t BLOCK = 256;
+    int32_t bins[BLOCK];
+    const auto lastPoint = static_cast<int64_t>(numGridPoints) - 1;
+
+    for (size_t blockStart = 0; blockStart < numValues; blockStart += BLOCK) {
+        const size_t blockSize = std::min(BLOCK, numValues - blockStart);
+        binIndices(values + blockStart, blockSize, gridPoints[0], histogramDelta, bins);
+
+        for (size_t j = 0; j < blockSize; ++j) {
+            const int32_t classIndex = classes ? classes[blockStart + j] : 0;
+            if (classIndex < 0) {
+                continue;
+            }
+            const double value  = values[blockStart + j];
+            size_t* classCounts = counts + static_cast<size_t>(classIndex) * numGridPoints;
+            const int64_t first = std::max<int64_t>(int64_t{bins[j]} - 1, 0);
+            const int64_t last  = std::min<int64_t>(int64_t{bins[j]} + 2, lastPoint);
+
+            // The points in bins[j] - 1 to bins[j] + 2 cover the window with room to spare for rounding, so the
+            // counts are those of comparing the value with every grid point
+            for (int64_t i = first; i <= last; ++i) {
+                classCounts[i] += std::abs(gridPoints[i] - value) < histogramDelta;
+            }
+        }
+    }
+}
+
@@ -0,0 +1,219 @@
+#include "Logger.hpp"
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Constructs a Logger that appends to a file, and starts its writer thread.
+ *
+ * @param filename The log file, opened in append mode, or empty to write to the console only.
+ * @param echoToConsole Whether the messages are also written to the console.
+ * @param capacity The number of messages the ring buffer holds, rounded up to a power of two.
+ */
+Logger::Logger(const string &filename, bool echoToConsole, size_t capacity) : _echoToConsole(echoToConsole)
+{
+    _capacity = 2;
+    while (_capacity < capacity) {
+        _capacity *= 2;
+    }
+    _mask  = _capacity - 1;
+    _slots = make_unique<Slot[]>(_capacity);
+    for (size_t i = 0; i < _capacity; ++i) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    if (!filename.empty()) {
+        _logFile.open(filename, std::ios::app);
+        if (!_logFile.is_open()) {
+            std::cerr << "Error opening log file." << endl;
+        }
+    }
+
+    _writer = std::thread(&Logger::writerLoop, this);
+}
+
+/**
+ * @brief Writes the messages still in the ring buffer, stops the writer thread and closes the log file.
+ */
+Logger::~Logger()
+{
+    _stop.store(true, std::memory_order_release);
+    _writer.join();
+    _logFile.close();
+}
+
+/**
+ * @brief Queues a message for the writer thread. Safe to call from any number of threads.
+ *
+ * @param level The level of the message.
+ * @param message The message.
+ * @return true if the message was queued, false if it was dropped because the ring buffer was full.
+ */
+bool Logger::log(LogLevel level, string message)
+{
+    auto time  = std::chrono::system_clock::now();
+    size_t pos = _enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    // Claim the slot at pos once the writer is done with it; a slot lagging a lap behind means the buffer is full
+    while (true) {
+        slot                = &_slots[pos & _mask];
+        size_t sequence     = slot->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (_enqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            pos = _enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level   = level;
+    slot->time    = time;
+    slot->message = std::move(message);
+    slot->sequence.store(pos + 1, std::memory_order_release); // Hand the slot to the writer
+    return true;
+}
+
+/**
+ * @brief Waits until every message queued before the call has been written and the log file flushed.
+ */
+void Logger::flush()
+{
+    const size_t target = _enqueuePosition.load(std::memory_order_acquire);
+
+    // Tell the writer to flush once it reaches target, as it may never run out of messages while others keep logging
+    size_t requested = _flushRequested.load(std::memory_order_relaxed);
+    while (requested < target &&
+           !_flushRequested.compare_exchange_weak(requested, target, std::memory_order_release)) {
+    }
+    while (_flushedPosition.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+/**
+ * @brief Converts a log level to the string written in front of its messages.
+ */
+string Logger::levelToString(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::DEBUG:
+        return "DEBUG";
+    case LogLevel::INFO:
+        return "INFO";
+    case LogLevel::WARNING:
+        return "WARNING";
+    case LogLevel::ERROR:
+        return "ERROR";
+    case LogLevel::CRITICAL:
+        return "CRITICAL";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Takes the next message out of the ring buffer, if the producer that claimed it has finished writing it.
+ *
+ * The slot must be released with the sequence number of the next lap once the message has been written.
+ */
+bool Logger::tryPop(Slot* &slot)
+{
+    slot = &_slots[_dequeuePosition & _mask];
+    return slot->sequence.load(std::memory_order_acquire) == _dequeuePosition + 1;
+}
+
+/**
+ * @brief The body of the writer thread: writes messages as they arrive and flushes whenever it runs out of them, every
+ * FLUSH_INTERVAL messages, and as soon as it has written the messages a call to flush() waits for.
+ */
+void Logger::writerLoop()
+{
+    int idleRounds = 0;
+    while (true) {
+        Slot* slot;
+        if (tryPop(slot)) {
+            write(*slot);
+            slot->sequence.store(_dequeuePosition + _capacity, std::memory_order_release);
+            ++_dequeuePosition;
+            idleRounds = 0;
+
+            const size_t flushed   = _flushedPosition.load(std::memory_order_relaxed);
+            const size_t requested = _flushRequested.load(std::memory_order_acquire);
+            if (_dequeuePosition - flushed >= FLUSH_INTERVAL ||
+                (flushed < requested && _dequeuePosition >= requested)) {
+                flushStreams();
+            }
+            continue;
+        }
+
+        if (_flushedPosition.load(std::memory_order_relaxed) != _dequeuePosition) {
+            flushStreams();
+        }
+
+        // The producers are gone once the destructor runs, so an empty buffer then means everything is written
+        if (_stop.load(std::memory_order_acquire) &&
+            _enqueuePosition.load(std::memory_order_acquire) == _dequeuePosition) {
+            break;
+        }
+
+        // Back off from spinning to sleeping while there is nothing to write
+        if (++idleRounds < 64) {
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(idleRounds < 1024 ? 50 : 1000));
+        }
+    }
+}
+
+/**
+ * @brief Formats a message with its timestamp and level and writes it out. Only called by the writer thread.
+ */
+void Logger::write(const Slot &slot)
+{
+    time_t seconds = std::chrono::system_clock::to_time_t(slot.time);
+    auto millis    = std::chrono::duration_cast<std::chrono::milliseconds>(slot.time.time_since_epoch()).count() % 1000;
+    tm timeinfo;
+#ifdef _WIN32
+    localtime_s(&timeinfo, &seconds);
+#else
+    localtime_r(&seconds, &timeinfo);
+#endif
+    char timestamp[20];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &timeinfo);
+
+    // Create log entry
+    std::ostringstream logEntry;
+    logEntry << "[" << timestamp << "." << std::setw(3) << std::setfill('0') << millis << "] "
+             << levelToString(slot.level) << ": " << slot.message << '\n';
+    const string entry = logEntry.str();
+
+    if (_echoToConsole) {
+        cout << entry;
+    }
+    if (_logFile.is_open()) {
+        _logFile << entry;
+    }
+}
+
+/**
+ * @brief Flushes the log file and the console, and publishes that the messages written so far are flushed. Only
+ * called by the writer thread.
+ */
+void Logger::flushStreams()
+{
+    _logFile.flush();
+    if (_echoToConsole) {
+        cout.flush();
+    }
+    _flushedPosition.store(_dequeuePosition, std::memory_order_release);
+}
@@ -0,0 +1,442 @@
+#include "QuickScorer.hpp"
+
+#include "DecisionForest.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Clears the bits [begin, end) of an array of 64-bit words; end > begin
+inline void clearBits(uint64_t* words, uint32_t begin, uint32_t end)
+{
+    const uint32_t firstWord = begin / 64;
+    const uint32_t lastWord  = (end - 1) / 64;
+    const uint64_t firstMask = ~uint64_t{0} << (begin % 64);
+    const uint64_t lastMask  = ~uint64_t{0} >> (63 - (end - 1) % 64);
+
+    if (firstWord == lastWord) {
+        words[firstWord] &= ~(firstMask & lastMask);
+        return;
+    }
+    words[firstWord] &= ~firstMask;
+    for (uint32_t word = firstWord + 1; word < lastWord; word++) {
+        words[word] = 0;
+    }
+    words[lastWord] &= ~lastMask;
+}
+
+// The index of the lowest set bit of a non-zero word
+inline uint32_t lowestSetBit(uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+    uint32_t bit = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+} // namespace
+
+
+//--------------- Constructors and Destructors ----------------//
+
+/**
+ * @brief Builds the bitvectors and the per-feature test lists of an ensemble of compiled trees.
+ *
+ * @param trees The trees, which must have the same features, symbolic values and classes.
+ * @throws std::invalid_argument If there are no trees, or if they differ in their features, symbolic values or classes.
+ */
+QuickScorer::QuickScorer(const vector<CompiledDecisionTree> &trees)
+{
+    if (trees.empty()) {
+        throw std::invalid_argument("QuickScorer: there are no trees to score");
+    }
+
+    const CompiledDecisionTree &first = trees.front();
+    _featureNames                     = first.getFeatureNames();
+    _classNames                       = first.getClassNames();
+    _symbolicValues                   = first.getSymbolicValues();
+    for (size_t i = 0; i < _featureNames.size(); i++) {
+        _featureIsNumeric.push_back(first.isNumericFeature(i));
+    }
+
+    // Every node is an exit, so a tree needs a bit per node
+    size_t numExits = 0;
+    _treeWordOffsets.push_back(0);
+    for (const auto &tree : trees) {
+        if (tree.getFeatureNames() != _featureNames || tree.getClassNames() != _classNames ||
+            tree.getSymbolicValues() != _symbolicValues) {
+            throw std::invalid_argument(
+                "QuickScorer: the trees must have the same features, symbolic values and classes");
+        }
+        _treeExitOffsets.push_back(numExits);
+        numExits += tree.getNumNodes();
+        _treeWordOffsets.push_back(_treeWordOffsets.back() + (tree.getNumNodes() + 63) / 64);
+    }
+    if (_treeWordOffsets.back() * 64 > UINT32_MAX) {
+        throw std::invalid_argument("QuickScorer: the trees have too many nodes");
+    }
+
+    _initialBitvectors.assign(_treeWordOffsets.back(), 0);
+    _exitProbabilities.resize(numExits * _classNames.size());
+
+    vector<vector<QuickScorerTest>> lessTests(_featureNames.size());
+    vector<vector<QuickScorerTest>> greaterTests(_featureNames.size());
+    vector<vector<QuickScorerTest>> equalTests(_featureNames.size());
+    for (size_t t = 0; t < trees.size(); t++) {
+        const uint32_t firstBit = static_cast<uint32_t>(_treeWordOffsets[t] * 64);
+        uint32_t nextExit       = 0;
+        addExits(trees[t], 0, firstBit, nextExit, _treeExitOffsets[t], lessTests, greaterTests, equalTests);
+        for (uint32_t bit = firstBit; bit < firstBit + nextExit; bit++) {
+            _initialBitvectors[bit / 64] |= uint64_t{1} << (bit % 64);
+        }
+    }
+
+    // A '<' test is false for the values above its threshold, and a '>' test for the values up to it
+    for (size_t f = 0; f < _featureNames.size(); f++) {
+        auto byValue = [](const QuickScorerTest &a, const QuickScorerTest &b) { return a.value < b.value; };
+        std::stable_sort(lessTests[f].begin(), lessTests[f].end(), byValue);
+        std::stable_sort(greaterTests[f].rbegin(), greaterTests[f].rend(), byValue);
+
+        FeatureTests featureTests;
+        featureTests.lessBegin = _tests.size();
+        _tests.insert(_tests.end(), lessTests[f].begin(), lessTests[f].end());
+        featureTests.greaterBegin = _tests.size();
+        _tests.insert(_tests.end(), greaterTests[f].begin(), greaterTests[f].end());
+        featureTests.equalBegin = _tests.size();
+        _tests.insert(_tests.end(), equalTests[f].begin(), equalTests[f].end());
+        featureTests.end = _tests.size();
+        _featureTests.push_back(featureTests);
+    }
+
+    // The checkpoints of a list take at most one WordMask per word each
+    size_t numThresholdTests = 0;
+    for (const auto &featureTests : _featureTests) {
+        numThresholdTests += featureTests.equalBegin - featureTests.lessBegin;
+    }
+    const size_t checkpointBytes = numThresholdTests * _initialBitvectors.size() * sizeof(WordMask);
+    _checkpointInterval          = std::max<size_t>(2, (checkpointBytes + MASK_BUDGET_BYTES - 1) / MASK_BUDGET_BYTES);
+
+    // A missing value clears every test on the feature, a symbolic code every test on another value, and a checkpoint
+    // the tests of its prefix of the '<' or '>' list
+    _maskOffsets.push_back(0);
+    for (size_t f = 0; f < _featureNames.size(); f++) {
+        FeatureTests &tests = _featureTests[f];
+        vector<uint64_t> words(_initialBitvectors.size(), ~uint64_t{0});
+        clearTests(words, tests.lessBegin, tests.end, -1);
+        tests.missingMask = _maskOffsets.size() - 1;
+        addMask(words);
+
+        const auto values = _symbolicValues.find(_featureNames[f]);
+        tests.numCodes    = _featureIsNumeric[f] || values == _symbolicValues.end()
+                                ? 0
+                                : static_cast<int>(values->second.size());
+        for (int code = 0; code < tests.numCodes; code++) {
+            words.assign(words.size(), ~uint64_t{0});
+            clearTests(words, tests.lessBegin, tests.end, code);
+            addMask(words);
+        }
+
+        tests.lessMasks = _maskOffsets.size() - 1;
+        words.assign(words.size(), ~uint64_t{0});
+        for (size_t end = tests.lessBegin + _checkpointInterval; end <= tests.greaterBegin;
+             end += _checkpointInterval) {
+            clearTests(words, end - _checkpointInterval, end, -1);
+            addMask(words);
+        }
+
+        tests.greaterMasks = _maskOffsets.size() - 1;
+        words.assign(words.size(), ~uint64_t{0});
+        for (size_t end = tests.greaterBegin + _checkpointInterval; end <= tests.equalBegin;
+             end += _checkpointInterval) {
+            clearTests(words, end - _checkpointInterval, end, -1);
+            addMask(words);
+        }
+    }
+}
+
+/**
+ * @brief Builds a QuickScorer for the compiled trees of a fitted forest.
+ *
+ * @throws std::invalid_argument If the forest has not been fitted.
+ */
+QuickScorer::QuickScorer(const DecisionForest &forest) : QuickScorer(forest.getCompiledTrees()) {}
+
+QuickScorer::~QuickScorer() {}
+
+
+//--------------- Classify ----------------//
+
+/**
+ * @brief Computes the class probabilities of a batch of samples, averaged over the trees.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues A row-major numRows x getNumFeatures() array of numeric values, or nullptr, as for
+ * CompiledDecisionTree::predictProba().
+ * @param symbolicCodes A row-major numRows x getNumFeatures() array of symbolic value codes, or nullptr.
+ * @param numRows The number of samples.
+ * @param probabilities A row-major numRows x getNumClasses() array into which the class probabilities are written.
+ */
+template <typename T>
+void QuickScorer::predictProba(const T* numericValues,
+                               const int* symbolicCodes,
+                               size_t numRows,
+                               double* probabilities) const
+{
+    // Rows are scored in blocks, which are spread over the threads when the library is built with OpenMP
+    const long long numBlocks = static_cast<long long>((numRows + PREDICT_BLOCK_SIZE - 1) / PREDICT_BLOCK_SIZE);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if (numBlocks > 1)
+#endif
+    for (long long block = 0; block < numBlocks; block++) {
+        const size_t begin = static_cast<size_t>(block) * PREDICT_BLOCK_SIZE;
+        const size_t end   = std::min(numRows, begin + PREDICT_BLOCK_SIZE);
+        predictProbaRows(numericValues, symbolicCodes, begin, end, probabilities);
+    }
+}
+
+/**
+ * @brief Computes the class probabilities of a single sample, averaged over the trees.
+ *
+ * @param numericValues One numeric value per feature, or an empty vector.
+ * @param symbolicCodes One symbolic value code per feature, or an empty vector.
+ * @return The probability of each class, in the order of getClassNames().
+ *
+ * @throws std::invalid_argument If a non-empty vector does not have one entry per feature.
+ */
+vector<double> QuickScorer::predictProba(const vector<double> &numericValues, const vector<int> &symbolicCodes) const
+{
+    if ((!numericValues.empty() && numericValues.size() != getNumFeatures()) ||
+        (!symbolicCodes.empty() && symbolicCodes.size() != getNumFeatures())) {
+        throw std::invalid_argument("Expected one value per feature: " + std::to_string(getNumFeatures()));
+    }
+
+    vector<double> probabilities(getNumClasses());
+    predictProba(numericValues.empty() ? nullptr : numericValues.data(),
+                 symbolicCodes.empty() ? nullptr : symbolicCodes.data(),
+                 1,
+                 probabilities.data());
+
+    return probabilities;
+}
+
+/**
+ * @brief Returns the code of a symbolic value, or -1 if it was not seen in the training data.
+ */
+int QuickScorer::encodeSymbolicValue(const string &feature, const string &value) const
+{
+    auto it = _symbolicValues.find(feature);
+    if (it == _symbolicValues.end()) {
+        return -1;
+    }
+
+    auto valueIt = std::lower_bound(it->second.begin(), it->second.end(), value);
+    if (valueIt == it->second.end() || *valueIt != value) {
+        return -1;
+    }
+
+    return static_cast<int>(valueIt - it->second.begin());
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Numbers the exits of a subtree in postorder and records the test on the branch to each child.
+ *
+ * @param tree The compiled tree.
+ * @param nodeIndex The index of the root of the subtree in the node array of the tree.
+ * @param firstBit The bit of the tree's first exit in the concatenated bitvectors.
+ * @param nextExit The number of exits of the tree numbered so far; advanced past the subtree.
+ * @param exitOffset The index of the tree's first exit in _exitProbabilities.
+ * @param lessTests The '<' tests on each feature, to which the tests of the subtree are added.
+ * @param greaterTests The '>' tests on each feature.
+ * @param equalTests The '=' tests on each feature.
+ * @return The number of the first exit of the subtree in the tree.
+ */
+uint32_t QuickScorer::addExits(const CompiledDecisionTree &tree,
+                               int nodeIndex,
+                               uint32_t firstBit,
+                               uint32_t &nextExit,
+                               size_t exitOffset,
+                               vector<vector<QuickScorerTest>> &lessTests,
+                               vector<vector<QuickScorerTest>> &greaterTests,
+                               vector<vector<QuickScorerTest>> &equalTests)
+{
+    const vector<CompiledNode> &nodes = tree.getNodes();
+    const CompiledNode &node          = nodes[nodeIndex];
+    const uint32_t subtreeBegin       = nextExit;
+
+    for (int child = node.firstChild; child < node.firstChild + node.numChildren; child++) {
+        const uint32_t childBegin =
+            addExits(tree, child, firstBit, nextExit, exitOffset, lessTests, greaterTests, equalTests);
+
+        // When the test on the branch to the child is false, no exit under the child can be reached
+        const CompiledNode &childNode = nodes[child];
+        QuickScorerTest test          = {childNode.value, childNode.code, firstBit + childBegin, firstBit + nextExit};
+        auto &tests = childNode.op == '<' ? lessTests : childNode.op == '>' ? greaterTests : equalTests;
+        tests[node.featureIndex].push_back(test);
+    }
+
+    // The node itself is the exit of the samples that take none of its branches
+    const size_t numClasses = _classNames.size();
+    const uint32_t exit     = nextExit++;
+    std::copy(tree.getClassProbabilities().begin() + nodeIndex * numClasses,
+              tree.getClassProbabilities().begin() + (nodeIndex + 1) * numClasses,
+              _exitProbabilities.begin() + (exitOffset + exit) * numClasses);
+
+    return subtreeBegin;
+}
+
+/**
+ * @brief Clears the exits behind the tests [testsBegin, testsEnd) of _tests, except the tests on a symbolic code.
+ *
+ * @param words The bitvectors of all the trees.
+ * @param testsBegin The first test.
+ * @param testsEnd One past the last test.
+ * @param keptCode The symbolic value code whose tests are true and so clear nothing, or -1 to clear every test.
+ */
+void QuickScorer::clearTests(vector<uint64_t> &words, size_t testsBegin, size_t testsEnd, int keptCode) const
+{
+    for (size_t i = testsBegin; i < testsEnd; i++) {
+        if (keptCode < 0 || _tests[i].code != keptCode) {
+            clearBits(words.data(), _tests[i].exitBegin, _tests[i].exitEnd);
+        }
+    }
+}
+
+/**
+ * @brief Adds a mask that leaves set the bits set in words, keeping only the words with cleared bits.
+ */
+void QuickScorer::addMask(const vector<uint64_t> &words)
+{
+    for (size_t word = 0; word < words.size(); word++) {
+        if (words[word] != ~uint64_t{0}) {
+            _wordMasks.push_back({static_cast<uint32_t>(word), words[word]});
+        }
+    }
+    _maskOffsets.push_back(_wordMasks.size());
+}
+
+/**
+ * @brief Clears the exits behind the first numFalse tests of a '<' or '>' list, by the checkpoint mask of the longest
+ * prefix that has one and then test by test.
+ *
+ * @param words The bitvectors of all the trees.
+ * @param testsBegin The first test of the list in _tests.
+ * @param numFalse The number of tests to clear.
+ * @param firstMask The index in _maskOffsets of the list's first checkpoint mask.
+ */
+void QuickScorer::clearPrefix(uint64_t* words, size_t testsBegin, size_t numFalse, size_t firstMask) const
+{
+    const size_t checkpoints = numFalse / _checkpointInterval;
+    if (checkpoints > 0) {
+        const size_t mask = firstMask + checkpoints - 1;
+        for (size_t i = _maskOffsets[mask]; i < _maskOffsets[mask + 1]; i++) {
+            words[_wordMasks[i].word] &= _wordMasks[i].mask;
+        }
+    }
+    for (size_t i = testsBegin + checkpoints * _checkpointInterval; i < testsBegin + numFalse; i++) {
+        clearBits(words, _tests[i].exitBegin, _tests[i].exitEnd);
+    }
+}
+
+/**
+ * @brief Computes the class probabilities for the rows [begin, end) of a batch.
+ *
+ * For every feature of a row, the false tests on the feature clear the exits behind them: with a symbolic code or a
+ * missing value, by the precomputed mask of the code or of the missing value; and otherwise the '<' tests with a
+ * threshold below the value and the '>' tests with a threshold at or above it, found by binary search and cleared
+ * mostly by a checkpoint mask, and the '=' tests on other values. The exit of each tree is then the lowest bit left
+ * set in its bitvector.
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues The numeric values of the whole batch, or nullptr.
+ * @param symbolicCodes The symbolic value codes of the whole batch, or nullptr.
+ * @param begin The first row to score.
+ * @param end One past the last row to score.
+ * @param probabilities The class probabilities of the whole batch.
+ */
+template <typename T>
+DTPP_MULTIVERSION void QuickScorer::predictProbaRows(
+    const T* numericValues, const int* symbolicCodes, size_t begin, size_t end, double* probabilities) const
+{
+    const size_t numFeatures = _featureNames.size();
+    const size_t numClasses  = _classNames.size();
+    const size_t numTrees    = getNumTrees();
+    const double scale       = 1.0 / static_cast<double>(numTrees);
+    vector<uint64_t> bitvectors(_initialBitvectors.size());
+    uint64_t* words = bitvectors.data();
+
+    for (size_t row = begin; row < end; row++) {
+        const T* numericRow    = numericValues ? numericValues + row * numFeatures : nullptr;
+        const int* symbolicRow = symbolicCodes ? symbolicCodes + row * numFeatures : nullptr;
+        std::copy(_initialBitvectors.begin(), _initialBitvectors.end(), bitvectors.begin());
+
+        for (size_t f = 0; f < numFeatures; f++) {
+            const FeatureTests &tests = _featureTests[f];
+            const int code            = symbolicRow ? symbolicRow[f] : -1;
+            const double value =
+                numericRow ? static_cast<double>(numericRow[f]) : std::numeric_limits<double>::quiet_NaN();
+
+            // A code the trees do not test matches none of the tests, as a missing value does
+            const bool symbolic = !_featureIsNumeric[f] && code >= 0;
+            if (symbolic || std::isnan(value)) {
+                const size_t mask = tests.missingMask + (symbolic && code < tests.numCodes ? 1 + code : 0);
+                for (size_t i = _maskOffsets[mask]; i < _maskOffsets[mask + 1]; i++) {
+                    words[_wordMasks[i].word] &= _wordMasks[i].mask;
+                }
+            }
+            else {
+                const QuickScorerTest* less    = _tests.data() + tests.lessBegin;
+                const QuickScorerTest* greater = _tests.data() + tests.greaterBegin;
+                const QuickScorerTest* equal   = _tests.data() + tests.equalBegin;
+                const size_t numFalseLess =
+                    std::partition_point(less, greater, [value](const auto &test) { return test.value < value; }) -
+                    less;
+                const size_t numFalseGreater =
+                    std::partition_point(greater, equal, [value](const auto &test) { return test.value >= value; }) -
+                    greater;
+                clearPrefix(words, tests.lessBegin, numFalseLess, tests.lessMasks);
+                clearPrefix(words, tests.greaterBegin, numFalseGreater, tests.greaterMasks);
+                for (size_t i = tests.equalBegin; i < tests.end; i++) {
+                    if (_tests[i].value != value) {
+                        clearBits(words, _tests[i].exitBegin, _tests[i].exitEnd);
+                    }
+                }
+            }
+        }
+
+        // The root is the last exit of its tree and is never cleared, so every tree has a set bit
+        double* rowProbabilities = probabilities + row * numClasses;
+        std::fill(rowProbabilities, rowProbabilities + numClasses, 0.0);
+        for (size_t t = 0; t < numTrees; t++) {
+            size_t word = _treeWordOffsets[t];
+            while (words[word] == 0) {
+                word++;
+            }
+            const size_t exit               = (word - _treeWordOffsets[t]) * 64 + lowestSetBit(words[word]);
+            const double* exitProbabilities = _exitProbabilities.data() + (_treeExitOffsets[t] + exit) * numClasses;
+            for (size_t c = 0; c < numClasses; c++) {
+                rowProbabilities[c] += exitProbabilities[c];
+            }
+        }
+        for (size_t c = 0; c < numClasses; c++) {
+            rowProbabilities[c] *= scale;
+        }
+    }
+}
+
+
+//--------------- Explicit Instantiations ----------------//
+template void QuickScorer::predictProba<double>(const double*, const int*, size_t, double*) const;
+template void QuickScorer::predictProba<float>(const float*, const int*, size_t, double*) const;
@@ -0,0 +1,34 @@
+#include "Random.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Returns the seed used by the components that are not given one.
+ *
+ * Setting the DTPP_SEED environment variable to an unsigned integer makes every such component use that seed, which
+ * makes a whole run reproducible without changing the code. Otherwise a fresh seed is drawn from std::random_device on
+ * every call; the components report the seed they used (getSeed()) so that a run can be repeated.
+ *
+ * @throws std::invalid_argument If DTPP_SEED is set but is not an unsigned integer.
+ */
+uint64_t defaultSeed()
+{
+    if (const char* seed = std::getenv("DTPP_SEED")) {
+        try {
+            size_t end;
+            uint64_t value = std::stoull(seed, &end);
+            if (seed[end] == '\0') {
+                return value;
+            }
+        }
+        catch (const std::exception &) {
+        }
+        throw std::invalid_argument(std::string("DTPP_SEED is not an unsigned integer: ") + seed);
+    }
+
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
@@ -1,5 +1,52 @@
 #include "TrainingDataGeneratorNumeric.hpp"
 
+#include "Random.hpp"
+#include "Utility.hpp"
+
+#include <thread>
+
+namespace {
+// Mixes the bits of a 64-bit integer (the SplitMix64 finalizer)
+uint64_t mixBits(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Maps an index in [0, n) to its position in a pseudorandom permutation of [0, n) chosen by a key.
+ *
+ * The permutation is a four-round Feistel network over the smallest power of four that covers n, restricted to
+ * [0, n) by cycle walking. It is computed without storing the permutation, so any row of a shuffled output can be
+ * produced on its own.
+ */
+uint64_t permuteIndex(uint64_t index, uint64_t n, uint64_t key)
+{
+    int halfBits = 1;
+    while ((uint64_t(1) << (2 * halfBits)) < n) {
+        ++halfBits;
+    }
+    const uint64_t mask = (uint64_t(1) << halfBits) - 1;
+
+    do {
+        uint64_t left  = index >> halfBits;
+        uint64_t right = index & mask;
+        for (uint64_t round = 0; round < 4; ++round) {
+            const uint64_t newRight = left ^ (mixBits(right ^ (key + round * 0x9e3779b97f4a7c15ULL)) & mask);
+            left                    = right;
+            right                   = newRight;
+        }
+        index = (left << halfBits) | right;
+    } while (index >= n);
+
+    return index;
+}
+} // namespace
+
 /**
  * @brief Constructor for TrainingDataGeneratorNumeric class.
  *
@@ -13,12 +60,16 @@
  *               - "number_of_samples_per_class": Number of samples per class (as a string, will be converted to an
  * integer).
  *               - "debug": Debug flag (as a string, will be converted to an integer).
+ *               - "seed": Seed of the random number generator; defaultSeed() is used if it is not given.
+ *               - "number_of_threads": Number of threads generating the data (default: the number of hardware
+ * threads).
  *
  * @throws std::invalid_argument if the kwargs map is empty or contains invalid keys.
  */
 TrainingDataGeneratorNumeric::TrainingDataGeneratorNumeric(map<string, string> kwargs)
 {
-    vector<string> allowedKeys = {"output_csv_file", "parameter_file", "number_of_samples_per_class", "debug"};
+    vector<string> allowedKeys = {
+        "output_csv_file", "parameter_file", "number_of_samples_per_class", "debug", "seed", "number_of_threads"};
 
     if (kwargs.empty()) {
         throw std::invalid_argument("Missing parameters.");
@@ -33,7 +84,9 @@ TrainingDataGeneratorNumeric::TrainingDataGeneratorNumeric(map<string, string> k
     }
 
     // Set default values
-    _debug = 0;
+    _debug           = 0;
+    _seed            = defaultSeed();
+    _numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
 
     // go through the passed keyword arguments
     for (const auto &kv : kwargs) {
@@ -52,6 +105,12 @@ TrainingDataGeneratorNumeric::TrainingDataGeneratorNumeric(map<string, string> k
         else if (key == "debug") {
             _debug = std::stoi(value);
         }
+        else if (key == "seed") {
+            _seed = std::stoull(value);
+        }
+        else if (key == "number_of_threads") {
+            _numberOfThreads = std::stoi(value);
+        }
     }
 }
 
@@ -268,7 +327,8 @@ void TrainingDataGeneratorNumeric::ReadParameterFileNumeric()
  * @brief Generates multivariate normal samples.
  *
  * This function generates a specified number of samples from a multivariate normal distribution
- * with a given mean vector and covariance matrix.
+ * with a given mean vector and covariance matrix. The samples are drawn together as the columns of L * Z, where L is
+ * the Cholesky factor of the covariance and Z a matrix of standard normal draws.
  *
  * @param mean A vector of doubles representing the mean of the multivariate normal distribution.
  * @param cov A MatrixXd representing the covariance matrix of the multivariate normal distribution.
@@ -279,24 +339,23 @@ vector<VectorXd> TrainingDataGeneratorNumeric::GenerateMultivariateSamples(const
                                                                            const MatrixXd &cov,
                                                                            int numSamples)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // Every call draws from its own substream, away from the streams of the blocks
+    Philox4x32 gen = Philox4x32(_seed).split(_multivariateDraws++);
     std::normal_distribution<> dist(0, 1);
 
-    // Generate multivariate normal samples
-    vector<VectorXd> samples;
-    Eigen::LLT<MatrixXd> llt(cov);
-    MatrixXd L = llt.matrixL(); // Cholesky decomposition
+    const Eigen::Index dim = mean.size();
+    MatrixXd L             = Eigen::LLT<MatrixXd>(cov).matrixL(); // Cholesky decomposition
+
+    MatrixXd Z(dim, numSamples);
+    for (Eigen::Index i = 0; i < Z.size(); ++i) {
+        Z.data()[i] = dist(gen);
+    }
+    MatrixXd X = (L * Z).colwise() + VectorXd::Map(mean.data(), dim);
 
-    // Add a sample from the multivariate normal distribution to the samples vector
-    // The sample is generated by multiplying the Cholesky decomposition (L) with a vector of random samples
+    vector<VectorXd> samples;
+    samples.reserve(numSamples);
     for (int i = 0; i < numSamples; ++i) {
-        VectorXd z(mean.size());
-        for (size_t j = 0; j < mean.size(); ++j) {
-            z(j) = dist(gen);
-        }
-        VectorXd sample = L * z + VectorXd::Map(mean.data(), mean.size());
-        samples.push_back(sample);
+        samples.push_back(X.col(i));
     }
 
     return samples;
@@ -305,18 +364,12 @@ vector<VectorXd> TrainingDataGeneratorNumeric::GenerateMultivariateSamples(const
 /**
  * @brief Generates training data for numeric features and writes it to a CSV file.
  *
- * This function generates multivariate normal samples for each class based on the provided
- * mean and covariance values. It then creates data records for each sample, shuffles them,
- * and writes them to a CSV file.
- *
- * The CSV file will contain a header row with feature names and subsequent rows with
- * the generated data records.
+ * _numberOfSamplesPerClass samples are drawn from the multivariate normal distribution of each class, and the
+ * CSV file lists them in a random order, numbered from 1, after a header row with the feature names.
  *
- * The function performs the following steps:
- * 1. Generates samples for each class using multivariate normal distribution.
- * 2. Creates data records for each sample.
- * 3. Shuffles the data records randomly.
- * 4. Writes the data records to a CSV file with a header row.
+ * Row p of the output is sample permuteIndex(p) of the concatenated classes, so every block of rows knows which
+ * classes its rows belong to without a shuffle of the whole data set. Each block draws the samples of each class it
+ * contains at once, as a matrix product, and the blocks are formatted on _numberOfThreads threads.
  *
  * @note The function assumes that the class parameters (_classesAndTheirParamValues) contain
  *       mean and covariance values for each class.
@@ -326,71 +379,106 @@ vector<VectorXd> TrainingDataGeneratorNumeric::GenerateMultivariateSamples(const
  */
 void TrainingDataGeneratorNumeric::GenerateTrainingDataNumeric()
 {
-    map<string, vector<VectorXd>> samplesForClass;
+    const vector<ClassDistribution> distributions = classDistributions();
+
+    // Prepare the CSV output
+    std::ofstream file(_outputCsvFile, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open output file: " + _outputCsvFile);
+    }
+    file << "\"\",class_name";
+    for (const auto &feature : _featuresOrdered) {
+        file << ',' << feature;
+    }
+    file << "\n";
+
+    // Write the data records to the CSV file
+    const size_t numSamples = distributions.size() * size_t(_numberOfSamplesPerClass);
+    const size_t numBlocks  = (numSamples + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    writeBlocksInParallel(file, numBlocks, _numberOfThreads, [&](size_t block, string &text) {
+        formatBlock(distributions, block, text);
+    });
+    file.close();
+}
+
+/**
+ * @brief Returns the mean and the Cholesky factor of the covariance of each class.
+ */
+vector<TrainingDataGeneratorNumeric::ClassDistribution> TrainingDataGeneratorNumeric::classDistributions() const
+{
+    vector<ClassDistribution> distributions;
 
-    // Generate samples for each class
     for (const auto &classEntry : _classesAndTheirParamValues) {
         // Get class name, mean and covariance
-        string className       = classEntry.first;
-        vector<double> mean    = classEntry.second.at("mean");
-        vector<double> covFlat = classEntry.second.at("covariance");
+        const vector<double> &mean    = classEntry.second.at("mean");
+        const vector<double> &covFlat = classEntry.second.at("covariance");
 
         // Convert flat covariance back to matrix
-        int dim = mean.size();
+        const Eigen::Index dim = mean.size();
         MatrixXd covMatrix(dim, dim);
-        for (int i = 0; i < dim; ++i) {
-            for (int j = 0; j < dim; ++j) {
+        for (Eigen::Index i = 0; i < dim; ++i) {
+            for (Eigen::Index j = 0; j < dim; ++j) {
                 covMatrix(i, j) = covFlat[i * dim + j];
             }
         }
 
-        // Generate multivariate normal samples
-        samplesForClass[className] = GenerateMultivariateSamples(mean, covMatrix, _numberOfSamplesPerClass);
+        distributions.push_back(
+            {classEntry.first, VectorXd::Map(mean.data(), dim), Eigen::LLT<MatrixXd>(covMatrix).matrixL()});
     }
 
-    // Store data records to be written to the CSV file
-    // For each class, for each sample, create a data record
-    vector<string> dataRecords;
-    for (const auto &classEntry : samplesForClass) {
-        // For each sample in the class, create a data record
-        const string &className = classEntry.first;
-        for (int sampleIndex = 0; sampleIndex < _numberOfSamplesPerClass; ++sampleIndex) {
-            string dataRecord = className + ",";
-            // For each feature in the sample, add to the data record
-            for (int featureIndex = 0; featureIndex < classEntry.second[sampleIndex].size(); ++featureIndex) {
-                dataRecord += std::to_string(classEntry.second[sampleIndex](featureIndex));
-
-                // Add comma if not the last feature
-                if (featureIndex < classEntry.second[sampleIndex].size() - 1) {
-                    dataRecord += ",";
-                }
-            }
-            if (_debug) {
-                cout << "Data record: " << dataRecord << endl;
-            }
-            dataRecords.push_back(dataRecord);
-        }
-    }
+    return distributions;
+}
 
-    // Shuffle the data records randomly
-    std::srand(unsigned(std::time(0)));
-    std::shuffle(dataRecords.begin(), dataRecords.end(), std::mt19937{std::random_device{}()});
+/**
+ * @brief Generates and formats one block of rows of the output.
+ *
+ * @param distributions The distributions of the classes.
+ * @param block The block number.
+ * @param text The string to append the CSV rows to.
+ */
+void TrainingDataGeneratorNumeric::formatBlock(const vector<ClassDistribution> &distributions,
+                                               size_t block,
+                                               string &text) const
+{
+    const size_t numSamples = distributions.size() * size_t(_numberOfSamplesPerClass);
+    const size_t first      = block * BLOCK_SIZE;
+    const size_t last       = std::min(first + BLOCK_SIZE, numSamples);
+
+    // The class of each row, from the position of its sample in the concatenated classes
+    vector<int> classOfRow(last - first);
+    vector<Eigen::Index> numRowsOfClass(distributions.size(), 0);
+    for (size_t row = first; row < last; ++row) {
+        classOfRow[row - first] = permuteIndex(row, numSamples, _seed) / _numberOfSamplesPerClass;
+        ++numRowsOfClass[classOfRow[row - first]];
+    }
 
-    // Prepare the CSV output
-    std::ofstream file(_outputCsvFile);
-    file << "\"\",class_name,"
-         << std::accumulate(
-                _featuresOrdered.begin(),
-                _featuresOrdered.end(),
-                string(),
-                [](const string &acc, const string &feature) { return acc + (acc.empty() ? "" : ",") + feature; })
-         << "\n";
+    // Draw the samples of each class in the block as the columns of L * Z + mean
+    Philox4x32 gen(_seed, block);
+    std::normal_distribution<> dist(0, 1);
+    vector<MatrixXd> samples(distributions.size());
+    for (size_t c = 0; c < distributions.size(); ++c) {
+        MatrixXd Z(distributions[c].mean.size(), numRowsOfClass[c]);
+        for (Eigen::Index i = 0; i < Z.size(); ++i) {
+            Z.data()[i] = dist(gen);
+        }
+        samples[c] = (distributions[c].choleskyFactor * Z).colwise() + distributions[c].mean;
+    }
 
-    // Write the data records to the CSV file
-    for (size_t i = 0; i < dataRecords.size(); ++i) {
-        file << (i + 1) << "," << dataRecords[i] << "\n";
+    // Format the rows, taking the samples of each class in turn
+    vector<Eigen::Index> nextSample(distributions.size(), 0);
+    for (size_t row = first; row < last; ++row) {
+        const int c       = classOfRow[row - first];
+        const auto sample = samples[c].col(nextSample[c]++);
+
+        text += std::to_string(row + 1);
+        text += ',';
+        text += distributions[c].className;
+        for (Eigen::Index j = 0; j < sample.size(); ++j) {
+            text += ',';
+            appendNumber(text, sample(j));
+        }
+        text += '\n';
     }
-    file.close();
 }
 
 /*
@@ -416,6 +504,16 @@ int TrainingDataGeneratorNumeric::getDebug() const
     return _debug;
 }
 
+uint64_t TrainingDataGeneratorNumeric::getSeed() const
+{
+    return _seed;
+}
+
+int TrainingDataGeneratorNumeric::getNumberOfThreads() const
+{
+    return _numberOfThreads;
+}
+
 vector<string> TrainingDataGeneratorNumeric::getClassNames() const
 {
     return _classNames;
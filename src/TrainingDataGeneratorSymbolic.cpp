@@ -1,5 +1,64 @@
 #include "TrainingDataGeneratorSymbolic.hpp"
 
+#include "Random.hpp"
+#include "Utility.hpp"
+
+#include <limits>
+#include <thread>
+
+/**
+ * @brief Builds the alias table of a discrete distribution with Vose's algorithm.
+ *
+ * @param weights The nonnegative weights of the outcomes, which need not sum to 1.
+ *
+ * @throws std::invalid_argument if there are no weights or they do not have a positive sum.
+ */
+AliasTable::AliasTable(const vector<double> &weights)
+{
+    const size_t n   = weights.size();
+    const double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+    if (n == 0 || !(sum > 0.0)) {
+        throw std::invalid_argument("An alias table needs weights with a positive sum.");
+    }
+
+    _probabilities.resize(n);
+    _aliases.resize(n);
+
+    // Scale the weights so that their mean is 1 and split them into the columns that are too small and too large
+    vector<double> scaled(n);
+    vector<int> small, large;
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = weights[i] * n / sum;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    // Fill each small column from a large one
+    while (!small.empty() && !large.empty()) {
+        const int s = small.back();
+        const int l = large.back();
+        small.pop_back();
+
+        _probabilities[s] = scaled[s];
+        _aliases[s]       = l;
+        scaled[l] -= 1.0 - scaled[s];
+
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // Whatever is left is full, up to rounding
+    for (int i : large) {
+        _probabilities[i] = 1.0;
+        _aliases[i]       = i;
+    }
+    for (int i : small) {
+        _probabilities[i] = 1.0;
+        _aliases[i]       = i;
+    }
+}
+
 /**
  * @brief Constructs a new TrainingDataGeneratorSymbolic object with the given keyword arguments.
  *
@@ -10,13 +69,21 @@
  * - "write_to_file": A flag indicating whether to write to a file (1 for true, 0 for false).
  * - "debug1": Debug level 1 (integer value).
  * - "debug2": Debug level 2 (integer value).
+ * - "seed": The seed of the random number generator; defaultSeed() is used if it is not given.
+ * - "number_of_threads": The number of threads (default: the number of hardware threads).
  *
  * @throws std::invalid_argument if the kwargs map is empty or contains invalid keys.
  */
 TrainingDataGeneratorSymbolic::TrainingDataGeneratorSymbolic(map<string, string> kwargs)
 {
-    vector<string> allowedKeys = {
-        "output_datafile", "parameter_file", "number_of_training_samples", "write_to_file", "debug1", "debug2"};
+    vector<string> allowedKeys = {"output_datafile",
+                                  "parameter_file",
+                                  "number_of_training_samples",
+                                  "write_to_file",
+                                  "debug1",
+                                  "debug2",
+                                  "seed",
+                                  "number_of_threads"};
 
     if (kwargs.empty()) {
         throw std::invalid_argument("Missing parameters.");
@@ -31,8 +98,10 @@ TrainingDataGeneratorSymbolic::TrainingDataGeneratorSymbolic(map<string, string>
     }
 
     // Assign default values
-    _debug1 = 0;
-    _debug2 = 0;
+    _debug1          = 0;
+    _debug2          = 0;
+    _seed            = defaultSeed();
+    _numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
 
     // go through the passed keyword arguments
     for (const auto &kv : kwargs) {
@@ -54,6 +123,12 @@ TrainingDataGeneratorSymbolic::TrainingDataGeneratorSymbolic(map<string, string>
         else if (kv.first == "debug2") {
             _debug2 = std::stoi(kv.second);
         }
+        else if (kv.first == "seed") {
+            _seed = std::stoull(kv.second);
+        }
+        else if (kv.first == "number_of_threads") {
+            _numberOfThreads = std::stoi(kv.second);
+        }
     }
 }
 
@@ -112,8 +187,9 @@ vector<string> TrainingDataGeneratorSymbolic::splitByRegex(const string &input,
  * in the corresponding member variables `_classNames`, `_classPriors`, `_featuresAndValuesDict`,
  * and `_biasDict`.
  *
- * @throws std::invalid_argument if the parameter file is empty or if required patterns
- *         (class names, class priors, features, and biases) are not found in the file.
+ * @throws std::invalid_argument if the parameter file is empty, if required patterns
+ *         (class names, class priors, features, and biases) are not found in the file, or if there are more than
+ *         65535 classes or values of a feature.
  *
  * The function performs the following steps:
  * 1. Reads the entire content of the parameter file into a string.
@@ -179,6 +255,12 @@ void TrainingDataGeneratorSymbolic::ReadParameterFileSymbolic()
             classPriorsDouble.push_back(std::stod(item));
         }
         _classPriors = classPriorsDouble;
+
+        // The generated samples keep their class indices as uint16_t
+        if (_classNames.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::invalid_argument("Too many class names: at most " +
+                                        std::to_string(std::numeric_limits<uint16_t>::max()) + " are supported.");
+        }
     }
     else {
         throw std::invalid_argument("Class names and class priors not found.");
@@ -236,6 +318,14 @@ void TrainingDataGeneratorSymbolic::ReadParameterFileSymbolic()
     else {
         throw std::invalid_argument("Feature and bias not found.");
     }
+
+    // The generated samples keep the value indices of each feature as uint16_t too
+    for (const auto &[feature, values] : featuresAndValuesDict) {
+        if (values.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::invalid_argument("Too many values for feature " + feature + ": at most " +
+                                        std::to_string(std::numeric_limits<uint16_t>::max()) + " are supported.");
+        }
+    }
     _featuresAndValuesDict = featuresAndValuesDict;
 
     // Now onto the bias
@@ -301,15 +391,14 @@ void TrainingDataGeneratorSymbolic::ReadParameterFileSymbolic()
  *
  * This function generates a specified number of training samples, each consisting of a class label
  * and feature values. The class labels and feature values are generated based on predefined class
- * priors and feature biases. The generated training samples are stored in the `_trainingSampleRecords` member.
+ * priors and feature biases. The generated training samples are stored, dictionary coded, in `_sampleCodes`.
  *
  * The function performs the following steps:
- * 1. Initializes random seed.
- * 2. Maps class priors to unit intervals.
- * 3. Initializes maps for each class and feature.
- * 4. Processes bias for each class and feature, mapping feature value priors to unit intervals.
- * 5. Generates training samples by randomly selecting class labels and feature values based on the mapped intervals.
- * 6. Stores the generated training samples in `_trainingSampleRecords`.
+ * 1. Builds an alias table for the class priors.
+ * 2. Processes bias for each class and feature: the biased value gets the given probability and the other values
+ *    share the rest equally. A feature without a bias is uniform. An alias table is built for each class and feature.
+ * 3. Generates the training samples in blocks on `_numberOfThreads` threads, drawing the class label and then each
+ *    feature value given the class.
  *
  * Debugging output is provided if `_debug1` or `_debug2` flags are set.
  *
@@ -317,133 +406,82 @@ void TrainingDataGeneratorSymbolic::ReadParameterFileSymbolic()
  */
 void TrainingDataGeneratorSymbolic::GenerateTrainingDataSymbolic()
 {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
-
-    vector<string> classNames                         = this->_classNames;
-    vector<double> classPriors                        = this->_classPriors;
-    map<string, vector<string>> featuresAndValuesDict = this->_featuresAndValuesDict;
-    map<string, map<string, vector<string>>> biasDict = this->_biasDict;
-    int howManyTrainingSamples                        = this->_numberOfTrainingSamples;
-
-    map<string, pair<double, double>> classPriorsToUnitIntervalMap;
-    double accumulatedInterval = 0.0;
-
-    // Map class priors to unit interval
-    for (size_t i = 0; i < classNames.size(); ++i) {
-        classPriorsToUnitIntervalMap[classNames[i]] =
-            std::make_pair(accumulatedInterval, accumulatedInterval + classPriors[i]);
-        accumulatedInterval += classPriors[i];
-    }
+    const AliasTable classTable(_classPriors);
 
     // Debugging output
     if (this->_debug1) {
-        cout << "Mapping of class priors to unit interval:" << endl;
-        for (const auto &item : classPriorsToUnitIntervalMap) {
-            cout << item.first << " ===> (" << item.second.first << ", " << item.second.second << ")" << endl;
+        cout << "Class priors:" << endl;
+        for (size_t i = 0; i < _classNames.size(); ++i) {
+            cout << _classNames[i] << " ===> " << _classPriors[i] << endl;
         }
     }
 
-    map<string, map<string, map<string, pair<double, double>>>> classAndFeatureBasedValuePriorsToUnitIntervalMap;
-
-    // Initialize maps for each class and feature
-    for (const auto &className : classNames) {
-        classAndFeatureBasedValuePriorsToUnitIntervalMap[className] = {};
-        for (const auto &feature : featuresAndValuesDict) {
-            classAndFeatureBasedValuePriorsToUnitIntervalMap[className][feature.first] = {};
-        }
-    }
+    // Value distributions for each class and feature
+    vector<vector<AliasTable>> valueTables(_classNames.size());
+    for (size_t c = 0; c < _classNames.size(); ++c) {
+        const string &className = _classNames[c];
 
-    // Process bias for each class and feature
-    for (const auto &className : classNames) {
-        for (const auto &feature : featuresAndValuesDict) {
-            const vector<string> &values = featuresAndValuesDict[feature.first];
+        for (const auto &feature : _featuresAndValuesDict) {
+            const vector<string> &values = feature.second;
             string biasString;
 
-            if (!biasDict[className][feature.first].empty()) {
-                biasString = biasDict[className][feature.first][0];
+            auto classBias = _biasDict.find(className);
+            if (classBias != _biasDict.end() && classBias->second.count(feature.first) &&
+                !classBias->second.at(feature.first).empty()) {
+                biasString = classBias->second.at(feature.first)[0];
             }
             else {
                 double noBias = 1.0 / values.size();
                 biasString    = values[0] + "=" + std::to_string(noBias);
             }
 
-            map<string, pair<double, double>> valuePriorsToUnitIntervalMap;
             vector<string> splits       = splitByRegex(biasString, "=");
             string chosenForBiasValue   = splits[0];
             double chosenBias           = std::stod(splits[1]);
-            double remainingBias        = 1.0 - chosenBias;
-            double remainingPortionBias = remainingBias / (values.size() - 1);
-            double accumulated          = 0.0;
-
-            // Assign intervals for each value
-            for (size_t i = 0; i < values.size(); ++i) {
-                if (values[i] == chosenForBiasValue) {
-                    valuePriorsToUnitIntervalMap[values[i]] = {accumulated, accumulated + chosenBias};
-                    accumulated += chosenBias;
-                }
-                else {
-                    valuePriorsToUnitIntervalMap[values[i]] = {accumulated, accumulated + remainingPortionBias};
-                    accumulated += remainingPortionBias;
-                }
-            }
+            double remainingPortionBias = values.size() > 1 ? (1.0 - chosenBias) / (values.size() - 1) : 0.0;
 
-            classAndFeatureBasedValuePriorsToUnitIntervalMap[className][feature.first] = valuePriorsToUnitIntervalMap;
+            vector<double> valuePriors;
+            for (const auto &value : values) {
+                valuePriors.push_back(value == chosenForBiasValue ? chosenBias : remainingPortionBias);
+            }
+            valueTables[c].emplace_back(valuePriors);
 
             // Debugging output
             if (this->_debug2) {
-                cout << "For class " << className << ": Mapping feature value priors for feature '" << feature.first
-                     << "' to unit interval: " << endl;
-                for (const auto &item : valuePriorsToUnitIntervalMap) {
-                    cout << "    " << item.first << " ===> (" << item.second.first << ", " << item.second.second << ")"
-                         << endl;
+                cout << "For class " << className << ": feature value priors for feature '" << feature.first
+                     << "': " << endl;
+                for (size_t i = 0; i < values.size(); ++i) {
+                    cout << "    " << values[i] << " ===> " << valuePriors[i] << endl;
                 }
             }
         }
     }
 
-    map<int, vector<string>> trainingSampleRecords;
-    int eleIndex = 0;
-
     // Generate training samples
-    while (eleIndex < howManyTrainingSamples) {
-        int sampleName                    = eleIndex;
-        trainingSampleRecords[sampleName] = {};
-
-        // Generate class label for the sample
-        double roll_the_dice = randomDouble(0.0, 1.0);
-        string classLabel;
-        for (const auto &classEntry : classPriorsToUnitIntervalMap) {
-            const pair<double, double> &interval = classEntry.second;
-            if (roll_the_dice >= interval.first && roll_the_dice <= interval.second) {
-                trainingSampleRecords[sampleName].push_back(classEntry.first);
-                classLabel = classEntry.first;
-                break;
+    const size_t numSamples = std::max(_numberOfTrainingSamples, 0);
+    const size_t width      = rowWidth();
+    _sampleCodes.assign(numSamples * width, 0);
+
+    const size_t numBlocks = (numSamples + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    parallelFor(numBlocks, _numberOfThreads, [&](size_t block) {
+        Philox4x32 gen(_seed, block);
+        const size_t last = std::min((block + 1) * BLOCK_SIZE, numSamples);
+
+        for (size_t sample = block * BLOCK_SIZE; sample < last; ++sample) {
+            uint16_t* codes = &_sampleCodes[sample * width];
+            const int c     = classTable(gen);
+
+            codes[0] = c;
+            for (size_t f = 0; f < valueTables[c].size(); ++f) {
+                codes[1 + f] = valueTables[c][f](gen);
             }
         }
-
-        // Generate feature values for the sample
-        for (const auto &feature : featuresAndValuesDict) {
-            roll_the_dice = randomDouble(0.0, 1.0);
-            const auto &valuePriorsToUnitIntervalMap =
-                classAndFeatureBasedValuePriorsToUnitIntervalMap[classLabel][feature.first];
-            for (const auto &valueEntry : valuePriorsToUnitIntervalMap) {
-                const pair<double, double> &interval = valueEntry.second;
-                if (roll_the_dice >= interval.first && roll_the_dice <= interval.second) {
-                    trainingSampleRecords[sampleName].push_back(valueEntry.first);
-                    break;
-                }
-            }
-        }
-
-        eleIndex++;
-    }
-
-    this->_trainingSampleRecords = trainingSampleRecords;
+    });
 
     // Debugging output for the generated records
     if (this->_debug2) {
         cout << "\n\nTERMINAL DISPLAY OF TRAINING RECORDS:\n\n";
-        for (const auto &sampleEntry : trainingSampleRecords) {
+        for (const auto &sampleEntry : getTrainingSampleRecords()) {
             cout << sampleEntry.first << " = ";
             for (const auto &record : sampleEntry.second) {
                 cout << record << ", ";
@@ -453,9 +491,59 @@ void TrainingDataGeneratorSymbolic::GenerateTrainingDataSymbolic()
     }
 }
 
-double TrainingDataGeneratorSymbolic::randomDouble(double lower, double upper)
+/**
+ * @brief Decodes the generated samples.
+ *
+ * @return A map from the sample number to the class label followed by the feature values, in the order of the
+ * features.
+ */
+map<int, vector<string>> TrainingDataGeneratorSymbolic::getTrainingSampleRecords()
 {
-    return lower + static_cast<double>(rand()) / (static_cast<double>(RAND_MAX / (upper - lower)));
+    map<int, vector<string>> trainingSampleRecords;
+    const size_t width = rowWidth();
+
+    for (size_t sample = 0; sample < numberOfGeneratedSamples(); ++sample) {
+        const uint16_t* codes  = &_sampleCodes[sample * width];
+        vector<string> &record = trainingSampleRecords[sample];
+
+        record.push_back(_classNames[codes[0]]);
+        size_t f = 1;
+        for (const auto &feature : _featuresAndValuesDict) {
+            record.push_back(feature.second[codes[f++]]);
+        }
+    }
+
+    return trainingSampleRecords;
+}
+
+/**
+ * @brief Formats the samples first to last - 1 as CSV rows.
+ *
+ * @param first The first sample.
+ * @param last One past the last sample.
+ * @param text The string to append the rows to.
+ */
+void TrainingDataGeneratorSymbolic::formatRecords(size_t first, size_t last, string &text) const
+{
+    const size_t width = rowWidth();
+
+    vector<const vector<string>*> featureValues;
+    for (const auto &feature : _featuresAndValuesDict) {
+        featureValues.push_back(&feature.second);
+    }
+
+    for (size_t sample = first; sample < last; ++sample) {
+        const uint16_t* codes = &_sampleCodes[sample * width];
+
+        text += std::to_string(sample);
+        text += ',';
+        text += _classNames[codes[0]];
+        for (size_t f = 0; f < featureValues.size(); ++f) {
+            text += ',';
+            text += (*featureValues[f])[codes[1 + f]];
+        }
+        text += '\n';
+    }
 }
 
 void TrainingDataGeneratorSymbolic::WriteTrainingDataToFile()
@@ -465,7 +553,7 @@ void TrainingDataGeneratorSymbolic::WriteTrainingDataToFile()
         return;
     }
 
-    std::ofstream outFile(_outputDatafile);
+    std::ofstream outFile(_outputDatafile, std::ios::binary);
     if (!outFile.is_open()) {
         throw std::runtime_error("Unable to open output file: " + _outputDatafile);
     }
@@ -475,16 +563,14 @@ void TrainingDataGeneratorSymbolic::WriteTrainingDataToFile()
     for (const auto &feature : _featuresAndValuesDict) {
         outFile << ',' << feature.first;
     }
-    outFile << endl;
+    outFile << '\n';
 
     // print the sample records
-    for (const auto &record : _trainingSampleRecords) {
-        outFile << record.first;
-        for (const auto &feature : record.second) {
-            outFile << ',' << feature;
-        }
-        outFile << endl;
-    }
+    const size_t numSamples = numberOfGeneratedSamples();
+    const size_t numBlocks  = (numSamples + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    writeBlocksInParallel(outFile, numBlocks, _numberOfThreads, [&](size_t block, string &text) {
+        formatRecords(block * BLOCK_SIZE, std::min((block + 1) * BLOCK_SIZE, numSamples), text);
+    });
 
     outFile.close();
     cout << "Training data written to " << _outputDatafile << endl;
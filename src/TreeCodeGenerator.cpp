@@ -0,0 +1,527 @@
+// Include
+#include "TreeCodeGenerator.hpp"
+
+#include <dlfcn.h>
+#include <stdlib.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+namespace {
+
+// A private directory for the files of one compilation, removed with everything in it when it goes out of scope
+class TemporaryDirectory {
+  public:
+    TemporaryDirectory()
+    {
+        string pattern = (std::filesystem::temp_directory_path() / "dtpp-XXXXXX").string();
+        if (mkdtemp(pattern.data()) == nullptr) {
+            throw std::runtime_error("Unable to create a temporary directory: " + pattern);
+        }
+        _path = pattern;
+    }
+    ~TemporaryDirectory()
+    {
+        std::error_code ignored;
+        std::filesystem::remove_all(_path, ignored);
+    }
+    TemporaryDirectory(const TemporaryDirectory &)            = delete;
+    TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+    const std::filesystem::path &path() const { return _path; }
+
+  private:
+    std::filesystem::path _path;
+};
+
+// A path as a single word for the shell
+string shellQuoted(const std::filesystem::path &path)
+{
+    string quoted = "'";
+    for (char c : path.string()) {
+        quoted += c == '\'' ? string("'\\''") : string(1, c);
+    }
+    return quoted + "'";
+}
+
+} // namespace
+
+
+//--------------- Constructors and Destructors ----------------//
+
+/**
+ * @brief Constructs a generator for a constructed decision tree, which is compiled first.
+ *
+ * @param dt A shared pointer to a DecisionTree whose classifier has been constructed.
+ * @param name The namespace of the generated header and the prefix of the plugin's entry points.
+ * @throws std::runtime_error If the decision tree has not been constructed.
+ * @throws std::invalid_argument If the name is not a C identifier.
+ */
+TreeCodeGenerator::TreeCodeGenerator(shared_ptr<DecisionTree> dt, const string &name)
+    : TreeCodeGenerator(CompiledDecisionTree(dt), name)
+{
+}
+
+/**
+ * @brief Constructs a generator for a compiled decision tree.
+ *
+ * @param tree The compiled tree, whose nodes become the generated branches.
+ * @param name The namespace of the generated header and the prefix of the plugin's entry points.
+ * @throws std::invalid_argument If the name is not a C identifier.
+ */
+TreeCodeGenerator::TreeCodeGenerator(const CompiledDecisionTree &tree, const string &name) : _tree(tree), _name(name)
+{
+    bool valid = !_name.empty() && !std::isdigit(static_cast<unsigned char>(_name[0]));
+    for (char c : _name) {
+        valid = valid && (std::isalnum(static_cast<unsigned char>(c)) || c == '_');
+    }
+    if (!valid) {
+        throw std::invalid_argument("The name of the generated code must be a C identifier: " + _name);
+    }
+}
+
+TreeCodeGenerator::~TreeCodeGenerator() {}
+
+
+//--------------- Code Generation ----------------//
+
+/**
+ * @brief Generates a self-contained header with the tree in a namespace named after the generator.
+ *
+ * The header defines NUM_FEATURES, NUM_CLASSES, NUM_NODES, the CLASS_PROBABILITIES table, predictNode(), which returns
+ * the row of the table for one sample, and predictProba(), which takes the arrays of
+ * CompiledDecisionTree::predictProba().
+ *
+ * @return The source code of the header.
+ */
+string TreeCodeGenerator::generateHeader() const
+{
+    const vector<string> &features = _tree.getFeatureNames();
+    const vector<string> &classes  = _tree.getClassNames();
+    const size_t numClasses        = classes.size();
+
+    string guard = "DTPP_GENERATED_" + _name + "_HPP";
+    std::transform(
+        guard.begin(), guard.end(), guard.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+
+    std::ostringstream out;
+    out << "// Generated by Decision Tree++ from a constructed decision tree. Do not edit.\n"
+        << "//\n"
+        << "// Feature columns, with the symbolic values in code order:\n";
+    for (size_t j = 0; j < features.size(); j++) {
+        out << "//   " << j << " " << features[j];
+        if (!_tree.isNumericFeature(j)) {
+            out << " (symbolic:";
+            for (const auto &value : _tree.getSymbolicValues().at(features[j])) {
+                out << " " << value;
+            }
+            out << ")";
+        }
+        out << "\n";
+    }
+    out << "// Class columns:\n";
+    for (size_t c = 0; c < numClasses; c++) {
+        out << "//   " << c << " " << classes[c] << "\n";
+    }
+    out << "//\n"
+        << "// Missing values are NaN and must compare false, so do not compile this with -ffast-math.\n\n"
+        << "#ifndef " << guard << "\n"
+        << "#define " << guard << "\n\n"
+        << "#include <cstddef>\n"
+        << "#include <limits>\n\n"
+        << "namespace " << _name << " {\n\n"
+        << "constexpr std::size_t NUM_FEATURES = " << features.size() << ";\n"
+        << "constexpr std::size_t NUM_CLASSES  = " << numClasses << ";\n"
+        << "constexpr std::size_t NUM_NODES    = " << _tree.getNumNodes() << ";\n\n";
+
+    // One row per node, in the order of the compiled tree's node array
+    const vector<double> &probabilities = _tree.getClassProbabilities();
+    out << "constexpr double CLASS_PROBABILITIES[NUM_NODES][NUM_CLASSES] = {\n";
+    for (size_t i = 0; i < _tree.getNumNodes(); i++) {
+        out << "    {";
+        for (size_t c = 0; c < numClasses; c++) {
+            out << (c > 0 ? ", " : "") << doubleLiteral(probabilities[i * numClasses + c]);
+        }
+        out << "}, // node " << _tree.getNodes()[i].serialNum << "\n";
+    }
+    out << "};\n\n";
+
+    out << "// The row of CLASS_PROBABILITIES of the node at which the descent of one sample ends\n"
+        << "template <typename T> inline int predictNode(const T* numericValues, const int* symbolicCodes) noexcept\n"
+        << "{\n"
+        << "    // A tree need not test any feature through one of the arrays\n"
+        << "    static_cast<void>(numericValues);\n"
+        << "    static_cast<void>(symbolicCodes);\n\n";
+    emitNode(out, 0, 1);
+    out << "}\n\n";
+
+    out << "// The class probabilities of numRows samples, given as row-major arrays of numRows x NUM_FEATURES values\n"
+        << "// and codes, either of which may be nullptr\n"
+        << "template <typename T>\n"
+        << "inline void predictProba(const T* numericValues,\n"
+        << "                         const int* symbolicCodes,\n"
+        << "                         std::size_t numRows,\n"
+        << "                         double* probabilities) noexcept\n"
+        << "{\n"
+        << "    for (std::size_t row = 0; row < numRows; row++) {\n"
+        << "        const int node = predictNode(numericValues ? numericValues + row * NUM_FEATURES : nullptr,\n"
+        << "                                     symbolicCodes ? symbolicCodes + row * NUM_FEATURES : nullptr);\n"
+        << "        for (std::size_t c = 0; c < NUM_CLASSES; c++) {\n"
+        << "            probabilities[row * NUM_CLASSES + c] = CLASS_PROBABILITIES[node][c];\n"
+        << "        }\n"
+        << "    }\n"
+        << "}\n\n"
+        << "} // namespace " << _name << "\n\n"
+        << "#endif // " << guard << "\n";
+
+    return out.str();
+}
+
+/**
+ * @brief Generates the source of a shared library: the header followed by extern "C" entry points.
+ *
+ * The entry points are <name>_predict_proba_double() and <name>_predict_proba_float(), which call predictProba() for
+ * double and float values.
+ *
+ * @return The source code of the plugin.
+ */
+string TreeCodeGenerator::generatePluginSource() const
+{
+    std::ostringstream out;
+    out << generateHeader() << "\n"
+        << "extern \"C\" {\n";
+    for (const char* type : {"double", "float"}) {
+        out << "\n"
+            << "void " << _name << "_predict_proba_" << type << "(const " << type
+            << "* numericValues, const int* symbolicCodes, std::size_t numRows, double* probabilities)\n"
+            << "{\n"
+            << "    " << _name << "::predictProba(numericValues, symbolicCodes, numRows, probabilities);\n"
+            << "}\n";
+    }
+    out << "\n"
+        << "} // extern \"C\"\n";
+
+    return out.str();
+}
+
+/**
+ * @brief Writes the generated header to a file, for compiling the tree into a program.
+ *
+ * @param filename The path of the header.
+ * @throws std::runtime_error If the file cannot be opened.
+ */
+void TreeCodeGenerator::writeHeader(const string &filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open output file: " + filename);
+    }
+    file << generateHeader();
+}
+
+/**
+ * @brief Compiles the generated code into a shared library with the system compiler and loads it.
+ *
+ * The source and the library are written to a temporary directory, which is removed once the library is loaded.
+ *
+ * @param compiler The compiler command; the CXX environment variable, or c++, if empty.
+ * @param flags Extra compiler flags, such as the optimization level.
+ * @return The loaded tree.
+ * @throws std::runtime_error If the code does not compile, with the compiler's output, or cannot be loaded.
+ */
+shared_ptr<NativeDecisionTree> TreeCodeGenerator::compileAndLoad(const string &compiler, const string &flags) const
+{
+    string command = compiler;
+    if (command.empty()) {
+        const char* cxx = std::getenv("CXX");
+        command         = cxx != nullptr && *cxx != '\0' ? cxx : "c++";
+    }
+
+    TemporaryDirectory directory;
+    const std::filesystem::path source  = directory.path() / (_name + ".cpp");
+    const std::filesystem::path library = directory.path() / ("lib" + _name + ".so");
+    const std::filesystem::path log     = directory.path() / "compiler.log";
+
+    {
+        std::ofstream file(source, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open output file: " + source.string());
+        }
+        file << generatePluginSource();
+    }
+
+    command += " -std=c++17 -shared -fPIC " + flags + " -o " + shellQuoted(library) + " " + shellQuoted(source) +
+               " > " + shellQuoted(log) + " 2>&1";
+    if (std::system(command.c_str()) != 0) {
+        std::ifstream logFile(log);
+        std::ostringstream output;
+        output << logFile.rdbuf();
+        throw std::runtime_error("Unable to compile the generated decision tree: " + command + "\n" + output.str());
+    }
+
+    // The library stays loaded after its file is removed
+    void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        throw std::runtime_error("Unable to load the compiled decision tree: " + string(dlerror()));
+    }
+
+    return shared_ptr<NativeDecisionTree>(new NativeDecisionTree(handle, _name, _tree));
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Emits the branches of a node and of the nodes below it.
+ *
+ * The branches follow CompiledDecisionTree::descend(). At a numeric feature, the children's tests are tried in order on
+ * the value, and a NaN fails them all. At a symbolic feature, the child is chosen by a switch on the code, or by the
+ * tests on the value if the code is negative, and its subtree is then emitted once. A sample that takes no branch
+ * returns the node itself.
+ *
+ * @param out The stream to write to.
+ * @param index The index of the node in the compiled tree's node array.
+ * @param depth The indentation level of the node's code.
+ */
+void TreeCodeGenerator::emitNode(std::ostream &out, int index, int depth) const
+{
+    const CompiledNode &node = _tree.getNodes()[index];
+    const string indent(4 * depth, ' ');
+    const string id = std::to_string(index);
+
+    if (node.numChildren == 0) {
+        out << indent << "return " << index << ";\n";
+        return;
+    }
+
+    const string column       = std::to_string(node.featureIndex);
+    const string value        = "value" + id;
+    const string numericValue = "numericValues ? static_cast<double>(numericValues[" + column +
+                                "]) : std::numeric_limits<double>::quiet_NaN()";
+    out << indent << "// node " << node.serialNum << ": " << _tree.getFeatureNames()[node.featureIndex] << "\n";
+
+    // A test against NaN is never true, and only the first child with a given code can be chosen
+    vector<int> byValue;
+    vector<int> byCode;
+    set<int> codes;
+    for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+        const CompiledNode &child = _tree.getNodes()[i];
+        if (!std::isnan(child.value)) {
+            byValue.push_back(i);
+        }
+        if (child.code >= 0 && codes.insert(child.code).second) {
+            byCode.push_back(i);
+        }
+    }
+
+    if (_tree.isNumericFeature(node.featureIndex)) {
+        if (!byValue.empty()) {
+            out << indent << "const double " << value << " = " << numericValue << ";\n";
+        }
+        for (int i : byValue) {
+            const CompiledNode &child = _tree.getNodes()[i];
+            out << indent << "if (" << condition(child.op, value, child.value) << ") {\n";
+            emitNode(out, i, depth + 1);
+            out << indent << "}\n";
+        }
+        out << indent << "return " << index << ";\n";
+        return;
+    }
+
+    if (byValue.empty() && byCode.empty()) {
+        out << indent << "return " << index << ";\n";
+        return;
+    }
+
+    const string code  = "code" + id;
+    const string child = "child" + id;
+    out << indent << "const int " << code << " = symbolicCodes ? symbolicCodes[" << column << "] : -1;\n"
+        << indent << "int " << child << " = -1;\n";
+
+    // A negative code matches no case, so the switch needs no test of its own without a numeric fallback
+    string switchIndent = indent;
+    if (!byValue.empty()) {
+        out << indent << "if (" << code << " < 0) {\n"
+            << indent << "    const double " << value << " = " << numericValue << ";\n";
+        for (size_t k = 0; k < byValue.size(); k++) {
+            const CompiledNode &test = _tree.getNodes()[byValue[k]];
+            out << indent << "    " << (k == 0 ? "if (" : "else if (") << condition(test.op, value, test.value)
+                << ") {\n"
+                << indent << "        " << child << " = " << byValue[k] << ";\n"
+                << indent << "    }\n";
+        }
+        out << indent << "}\n";
+        if (!byCode.empty()) {
+            out << indent << "else {\n";
+            switchIndent += "    ";
+        }
+    }
+    if (!byCode.empty()) {
+        out << switchIndent << "switch (" << code << ") {\n";
+        for (int i : byCode) {
+            out << switchIndent << "case " << _tree.getNodes()[i].code << ":\n"
+                << switchIndent << "    " << child << " = " << i << ";\n"
+                << switchIndent << "    break;\n";
+        }
+        out << switchIndent << "}\n";
+        if (!byValue.empty()) {
+            out << indent << "}\n";
+        }
+    }
+
+    // The children that can be chosen, each ending in a return
+    set<int> reachable(byValue.begin(), byValue.end());
+    reachable.insert(byCode.begin(), byCode.end());
+    out << indent << "switch (" << child << ") {\n";
+    for (int i : reachable) {
+        out << indent << "case " << i << ": {\n";
+        emitNode(out, i, depth + 1);
+        out << indent << "}\n";
+    }
+    out << indent << "}\n"
+        << indent << "return " << index << ";\n";
+}
+
+/**
+ * @brief Formats a double as a C++ literal that reads back as the same value.
+ */
+string TreeCodeGenerator::doubleLiteral(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? "std::numeric_limits<double>::infinity()" : "-std::numeric_limits<double>::infinity()";
+    }
+
+    std::ostringstream out;
+    out << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    string literal = out.str();
+    if (literal.find_first_of(".e") == string::npos) {
+        literal += ".0";
+    }
+    return literal;
+}
+
+/**
+ * @brief Formats the feature test on a branch as a C++ condition on a variable.
+ */
+string TreeCodeGenerator::condition(char op, const string &variable, double value)
+{
+    switch (op) {
+    case '<':
+        return variable + " <= " + doubleLiteral(value);
+    case '>':
+        return variable + " > " + doubleLiteral(value);
+    default:
+        return variable + " == " + doubleLiteral(value);
+    }
+}
+
+
+//--------------- NativeDecisionTree ----------------//
+
+/**
+ * @brief Takes ownership of a loaded plugin and looks up its entry points.
+ *
+ * @param handle The handle of the shared library, from dlopen().
+ * @param name The prefix of the entry points.
+ * @param tree The compiled tree the plugin was generated from, for its features, classes and symbolic values.
+ * @throws std::runtime_error If an entry point is missing; the library is then unloaded.
+ */
+NativeDecisionTree::NativeDecisionTree(void* handle, const string &name, const CompiledDecisionTree &tree)
+{
+    _handle             = handle;
+    _predictProbaDouble = reinterpret_cast<PredictProbaDouble>(dlsym(handle, (name + "_predict_proba_double").c_str()));
+    _predictProbaFloat  = reinterpret_cast<PredictProbaFloat>(dlsym(handle, (name + "_predict_proba_float").c_str()));
+    if (_predictProbaDouble == nullptr || _predictProbaFloat == nullptr) {
+        dlclose(handle);
+        throw std::runtime_error("The compiled decision tree has no entry points named " + name + "_predict_proba_*");
+    }
+
+    _featureNames   = tree.getFeatureNames();
+    _classNames     = tree.getClassNames();
+    _symbolicValues = tree.getSymbolicValues();
+}
+
+NativeDecisionTree::~NativeDecisionTree()
+{
+    dlclose(_handle);
+}
+
+/**
+ * @brief Computes the class probabilities for a batch of samples, as CompiledDecisionTree::predictProba().
+ *
+ * @tparam T The type of the numeric values, float or double.
+ * @param numericValues A row-major numRows x getNumFeatures() array of numeric values, or nullptr.
+ * @param symbolicCodes A row-major numRows x getNumFeatures() array of symbolic value codes, or nullptr.
+ * @param numRows The number of samples.
+ * @param probabilities A row-major numRows x getNumClasses() array into which the class probabilities are written.
+ */
+template <typename T>
+void NativeDecisionTree::predictProba(const T* numericValues,
+                                      const int* symbolicCodes,
+                                      size_t numRows,
+                                      double* probabilities) const
+{
+    if constexpr (std::is_same_v<T, float>) {
+        _predictProbaFloat(numericValues, symbolicCodes, numRows, probabilities);
+    }
+    else {
+        _predictProbaDouble(numericValues, symbolicCodes, numRows, probabilities);
+    }
+}
+
+/**
+ * @brief Computes the class probabilities for a single sample.
+ *
+ * @param numericValues The numeric values of the sample, one per feature, or an empty vector.
+ * @param symbolicCodes The symbolic value codes of the sample, one per feature, or an empty vector.
+ * @return The class probabilities, in the order of getClassNames().
+ * @throws std::invalid_argument If a non-empty vector does not have one entry per feature.
+ */
+vector<double> NativeDecisionTree::predictProba(const vector<double> &numericValues,
+                                                const vector<int> &symbolicCodes) const
+{
+    if ((!numericValues.empty() && numericValues.size() != _featureNames.size()) ||
+        (!symbolicCodes.empty() && symbolicCodes.size() != _featureNames.size())) {
+        throw std::invalid_argument("Expected one value per feature: " + std::to_string(_featureNames.size()));
+    }
+
+    vector<double> probabilities(_classNames.size());
+    predictProba(numericValues.empty() ? nullptr : numericValues.data(),
+                 symbolicCodes.empty() ? nullptr : symbolicCodes.data(),
+                 1,
+                 probabilities.data());
+
+    return probabilities;
+}
+
+/**
+ * @brief Returns the code of a symbolic value of a feature, as CompiledDecisionTree::encodeSymbolicValue().
+ */
+int NativeDecisionTree::encodeSymbolicValue(const string &feature, const string &value) const
+{
+    auto it = _symbolicValues.find(feature);
+    if (it == _symbolicValues.end()) {
+        return -1;
+    }
+
+    auto valueIt = std::lower_bound(it->second.begin(), it->second.end(), value);
+    if (valueIt == it->second.end() || *valueIt != value) {
+        return -1;
+    }
+
+    return static_cast<int>(valueIt - it->second.begin());
+}
+
+
+//--------------- Explicit Instantiations ----------------//
+template void NativeDecisionTree::predictProba<double>(const double*, const int*, size_t, double*) const;
+template void NativeDecisionTree::predictProba<float>(const float*, const int*, size_t, double*) const;
@@ -0,0 +1,327 @@
+// Include
+#include "TreePruner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+//--------------- Constructors and Destructors ----------------//
+
+/**
+ * @brief Constructs a TreePruner for a decision tree. The tree must be constructed before the pruning path is computed.
+ *
+ * @param dt A shared pointer to the DecisionTree to prune.
+ */
+TreePruner::TreePruner(shared_ptr<DecisionTree> dt)
+{
+    _dt             = dt;
+    _trainingWeight = 0.0;
+    _heldOutWeight  = 0.0;
+}
+
+TreePruner::~TreePruner() {}
+
+
+//--------------- Pruning ----------------//
+
+/**
+ * @brief Sets the samples on which every subtree of the pruning path is scored, and from which selectStep() picks one.
+ *
+ * @param featuresAndValues The samples, each as "feature=value" strings as for DecisionTree::classify().
+ * @param classNames The class of each sample.
+ *
+ * @throws std::invalid_argument If the two vectors differ in size, or if a sample uses unknown names or classes.
+ */
+void TreePruner::setHeldOutSamples(const vector<vector<string>> &featuresAndValues, const vector<string> &classNames)
+{
+    if (featuresAndValues.size() != classNames.size()) {
+        throw std::invalid_argument("Expected one class name per held-out sample.");
+    }
+
+    vector<int> classes;
+    for (size_t i = 0; i < featuresAndValues.size(); ++i) {
+        auto classIt = std::find(_dt->_classNames.begin(), _dt->_classNames.end(), classNames[i]);
+        if (classIt == _dt->_classNames.end()) {
+            throw std::invalid_argument("Unknown class name of a held-out sample: " + classNames[i]);
+        }
+        if (!_dt->checkNamesUsed(featuresAndValues[i])) {
+            throw std::invalid_argument("Error in the names used for the features and/or values of a held-out sample.");
+        }
+        classes.push_back(static_cast<int>(classIt - _dt->_classNames.begin()));
+    }
+
+    _heldOutFeaturesAndValues = featuresAndValues;
+    _heldOutClasses           = classes;
+    _pruningPath.clear();
+}
+
+/**
+ * @brief Computes the cost-complexity pruning path of the tree as it is now.
+ *
+ * The training samples and the held-out samples are each classified once by the full tree; the errors every node would
+ * make as a leaf are then enough to score every subtree of the path.
+ *
+ * @return The subtrees of the path, from the full tree at alpha 0 down to the root alone.
+ *
+ * @throws std::runtime_error If the tree has not been constructed or has no labeled training samples.
+ */
+const vector<PruningStep> &TreePruner::computePruningPath()
+{
+    DecisionTreeNode* rootNode = _dt->getRootNode();
+    if (rootNode == nullptr) {
+        throw std::runtime_error("You must first construct the decision tree before pruning it.");
+    }
+
+    _nodes.clear();
+    _nodeIndices.clear();
+    _pruningPath.clear();
+    indexNodes(rootNode);
+
+    // Missing values are left out of the samples, so their descent stops at the node that tests them
+    _trainingWeight = 0.0;
+    for (const auto &row : _dt->getWeightedRows()) {
+        if (row.classIndex < 0) {
+            continue;
+        }
+        vector<string> featuresAndValues;
+        for (size_t i = 0; i < _dt->_featureNames.size(); ++i) {
+            if ((*row.values)[i] != "NA") {
+                featuresAndValues.push_back(_dt->_featureNames[i] + "=" + (*row.values)[i]);
+            }
+        }
+        countErrors(featuresAndValues, row.classIndex, row.weight, false);
+        _trainingWeight += row.weight;
+    }
+    if (_trainingWeight == 0.0) {
+        throw std::runtime_error("The decision tree has no labeled training samples to prune it with.");
+    }
+
+    _heldOutWeight = 0.0;
+    for (size_t i = 0; i < _heldOutFeaturesAndValues.size(); ++i) {
+        countErrors(_heldOutFeaturesAndValues[i], _heldOutClasses[i], 1.0, true);
+        _heldOutWeight += 1.0;
+    }
+
+    vector<SubtreeCost> costs(_nodes.size());
+    vector<size_t> internalNodes;
+    SubtreeCost cost = subtreeCost(0, costs, internalNodes);
+    double alpha     = 0.0;
+    _pruningPath.push_back(makeStep(alpha, cost));
+
+    while (!internalNodes.empty()) {
+        // The weakest links: the nodes whose subtrees remove the fewest training errors per node they add
+        auto linkStrength = [&](size_t index) {
+            return (_nodes[index].trainingIfLeaf - costs[index].trainingErrors) / _trainingWeight /
+                   (costs[index].numNodes - 1);
+        };
+        double weakest = std::numeric_limits<double>::infinity();
+        for (size_t index : internalNodes) {
+            weakest = std::min(weakest, linkStrength(index));
+        }
+
+        // Ties are pruned together; a node below one already pruned at this step is gone with it
+        vector<int> prunedNodes;
+        size_t prunedEnd = 0;
+        for (size_t index : internalNodes) {
+            if (index < prunedEnd || linkStrength(index) > weakest + 1e-12) {
+                continue;
+            }
+            _nodes[index].collapsed = true;
+            prunedEnd               = _nodes[index].subtreeEnd;
+            prunedNodes.push_back(_nodes[index].node->GetSerialNum());
+        }
+
+        // Subtrees that do worse than their root as a leaf are pruned at alpha 0
+        alpha = std::max(alpha, weakest);
+        internalNodes.clear();
+        cost = subtreeCost(0, costs, internalNodes);
+        _pruningPath.push_back(makeStep(alpha, cost));
+        _pruningPath.back().prunedNodes = prunedNodes;
+    }
+
+    return _pruningPath;
+}
+
+/**
+ * @brief Picks the subtree of the pruning path with the highest accuracy on the held-out samples, and the smallest
+ * such subtree if several tie.
+ *
+ * @return The index of the subtree in the pruning path.
+ *
+ * @throws std::runtime_error If the pruning path has not been computed, or was computed without held-out samples.
+ */
+size_t TreePruner::selectStep() const
+{
+    if (_pruningPath.empty()) {
+        throw std::runtime_error("You must first compute the pruning path.");
+    }
+    if (_heldOutWeight == 0.0) {
+        throw std::runtime_error("Selecting a pruned tree needs held-out samples; see setHeldOutSamples().");
+    }
+
+    size_t best = 0;
+    for (size_t step = 1; step < _pruningPath.size(); ++step) {
+        if (_pruningPath[step].heldOutAccuracy >= _pruningPath[best].heldOutAccuracy) {
+            best = step;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Prunes the tree in place to a subtree of the pruning path.
+ *
+ * The pruned nodes keep their class probabilities and become leaves, and the nodes below them are deleted. The
+ * routing index of the tree, if it has one, is rebuilt; trees compiled before pruning are not updated. The pruning path
+ * is cleared, since it no longer describes the tree.
+ *
+ * @param step The index of the subtree in the pruning path.
+ * @return The root node of the pruned tree.
+ *
+ * @throws std::invalid_argument If the pruning path has no such step.
+ */
+DecisionTreeNode* TreePruner::pruneToStep(size_t step)
+{
+    if (step >= _pruningPath.size()) {
+        throw std::invalid_argument("The pruning path has no step " + std::to_string(step) + ".");
+    }
+
+    // The nodes pruned at a step are never below those pruned at an earlier step
+    for (size_t s = 1; s <= step; ++s) {
+        for (int serialNum : _pruningPath[s].prunedNodes) {
+            DecisionTreeNode* node = _nodes[_nodeIndices.at(serialNum)].node;
+            for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+                _dt->forgetSubtree(*node->GetChild(i));
+            }
+            node->DeleteAllLinks();
+        }
+    }
+
+    if (_dt->hasRoutingIndex()) {
+        _dt->buildRoutingIndex();
+    }
+
+    _nodes.clear();
+    _nodeIndices.clear();
+    _pruningPath.clear();
+    return _dt->getRootNode();
+}
+
+/**
+ * @brief Prunes the tree in place to the subtree of the pruning path that does best on the held-out samples.
+ *
+ * @return The root node of the pruned tree.
+ *
+ * @throws std::runtime_error If there are no held-out samples, or as computePruningPath().
+ */
+DecisionTreeNode* TreePruner::prune()
+{
+    if (_pruningPath.empty()) {
+        computePruningPath();
+    }
+    return pruneToStep(selectStep());
+}
+
+
+//--------------- Private Helpers ----------------//
+
+/**
+ * @brief Adds a node and its descendants to _nodes in preorder.
+ *
+ * @return The index of the node in _nodes.
+ */
+size_t TreePruner::indexNodes(DecisionTreeNode* node)
+{
+    const vector<double> &classProbabilities = node->GetClassProbabilities();
+    const size_t index                       = _nodes.size();
+
+    NodeErrors entry{};
+    entry.node = node;
+    entry.predictedClass =
+        classProbabilities.empty()
+            ? -1
+            : static_cast<int>(std::max_element(classProbabilities.begin(), classProbabilities.end()) -
+                               classProbabilities.begin());
+    _nodes.push_back(entry);
+    _nodeIndices[node->GetSerialNum()] = index;
+
+    for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+        size_t child = indexNodes(node->GetChild(i));
+        _nodes[index].children.push_back(child);
+    }
+    _nodes[index].subtreeEnd = _nodes.size();
+
+    return index;
+}
+
+/**
+ * @brief Classifies a sample with the full tree, and counts it as an error of every node on its path whose class is
+ * not the sample's.
+ *
+ * @throws std::invalid_argument If the value of a numeric feature tested on the way is not a number.
+ */
+void TreePruner::countErrors(const vector<string> &featuresAndValues, int classIndex, double weight, bool heldOut)
+{
+    ClassificationAnswer answer;
+    for (const auto &className : _dt->_classNames) {
+        answer.classProbabilities[className] = 0.0;
+    }
+    _dt->recursiveDescentForClassification(_nodes.front().node, featuresAndValues, answer);
+
+    // The solution path goes from the node where the descent stopped up to the root
+    for (size_t i = 0; i < answer.solutionPath.size(); ++i) {
+        NodeErrors &entry = _nodes[_nodeIndices.at(answer.solutionPath[i])];
+        if (entry.predictedClass == classIndex) {
+            continue;
+        }
+        (heldOut ? entry.heldOutIfLeaf : entry.trainingIfLeaf) += weight;
+        if (i == 0) {
+            (heldOut ? entry.heldOutStopped : entry.trainingStopped) += weight;
+        }
+    }
+}
+
+/**
+ * @brief Computes the errors and size of the subtree of a node in the tree pruned so far.
+ *
+ * @param index The index of the node in _nodes.
+ * @param costs The cost of every node of the subtree, filled in.
+ * @param internalNodes The internal nodes of the subtree, appended in preorder.
+ * @return The cost of the subtree.
+ */
+TreePruner::SubtreeCost
+TreePruner::subtreeCost(size_t index, vector<SubtreeCost> &costs, vector<size_t> &internalNodes) const
+{
+    const NodeErrors &entry = _nodes[index];
+    if (entry.collapsed || entry.children.empty()) {
+        costs[index] = {entry.trainingIfLeaf, entry.heldOutIfLeaf, 1, 1};
+        return costs[index];
+    }
+
+    internalNodes.push_back(index);
+    SubtreeCost cost = {entry.trainingStopped, entry.heldOutStopped, 1, 0};
+    for (size_t child : entry.children) {
+        const SubtreeCost childCost = subtreeCost(child, costs, internalNodes);
+        cost.trainingErrors += childCost.trainingErrors;
+        cost.heldOutErrors += childCost.heldOutErrors;
+        cost.numNodes += childCost.numNodes;
+        cost.numLeaves += childCost.numLeaves;
+    }
+    costs[index] = cost;
+    return cost;
+}
+
+/**
+ * @brief Describes a subtree of the pruning path from its cost.
+ */
+PruningStep TreePruner::makeStep(double alpha, const SubtreeCost &cost) const
+{
+    PruningStep step;
+    step.alpha            = alpha;
+    step.numNodes         = cost.numNodes;
+    step.numLeaves        = cost.numLeaves;
+    step.trainingAccuracy = 1.0 - cost.trainingErrors / _trainingWeight;
+    step.heldOutAccuracy  = _heldOutWeight > 0.0 ? 1.0 - cost.heldOutErrors / _heldOutWeight : std::nan("");
+    return step;
+}
@@ -1,9 +1,16 @@
 #include "Utility.hpp"
 
+#include <atomic>
+#include <cctype>
+#include <charconv>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
 #include <iomanip>
+#include <mutex>
 #include <regex>
 #include <sstream>
+#include <thread>
 
 int sampleIndex(string sample_name)
 {
@@ -14,15 +21,50 @@ int sampleIndex(string sample_name)
     return std::stoi(match[1]);
 };
 
-double convert(const string &str)
+/**
+ * @brief Parses the number at the start of a string as std::stod does, without allocating or throwing.
+ *
+ * Leading whitespace, a sign, decimal and hexadecimal numbers, infinities and NaNs are accepted, and the characters
+ * after the number are ignored.
+ *
+ * @param str The string.
+ * @param value Set to the number when there is one.
+ * @return false if the string does not start with a number, or the number is out of the range of a double.
+ */
+bool parseDouble(std::string_view str, double &value)
 {
-    // The purpose of this function is to convert a string to a double.
-    try {
-        return std::stod(str);
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+        str.remove_prefix(1);
+    }
+
+    // std::from_chars takes neither a plus sign nor the prefix of a hexadecimal number
+    bool negative = false;
+    if (!str.empty() && (str.front() == '+' || str.front() == '-')) {
+        negative = str.front() == '-';
+        str.remove_prefix(1);
+    }
+    auto format = std::chars_format::general;
+    if (str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X') &&
+        std::isxdigit(static_cast<unsigned char>(str[2]))) {
+        format = std::chars_format::hex;
+        str.remove_prefix(2);
     }
-    catch (const std::exception &e) {
-        return std::nan("");
+    if (str.empty() || str.front() == '+' || str.front() == '-') {
+        return false;
     }
+
+    if (std::from_chars(str.data(), str.data() + str.size(), value, format).ec != std::errc()) {
+        return false;
+    }
+    value = negative ? -value : value;
+    return true;
+}
+
+double convert(const string &str)
+{
+    // The purpose of this function is to convert a string to a double, or NaN if it is not a number.
+    double value;
+    return parseDouble(str, value) ? value : std::nan("");
 }
 
 /**
@@ -127,6 +169,185 @@ string formatDouble(double value)
     return removeTrailingZeros(ss.str()); // Remove any unnecessary trailing zeros
 }
 
+/**
+ * @brief Runs the tasks 0 to numTasks - 1 on numThreads threads.
+ *
+ * Thread t runs the tasks t, t + numThreads, and so on. With one thread, or a single task, the tasks run on the
+ * calling thread. A thread whose task throws runs none of its remaining tasks; the other threads finish theirs.
+ *
+ * @param numTasks The number of tasks.
+ * @param numThreads The number of threads.
+ * @param task Runs a task, given its number.
+ * @throws Rethrows the error of the lowest numbered thread that failed, after all threads have been joined.
+ */
+void parallelFor(size_t numTasks, int numThreads, const std::function<void(size_t task)> &task)
+{
+    const size_t threads = std::min<size_t>(std::max(numThreads, 1), numTasks);
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < numTasks; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    vector<std::exception_ptr> errors(threads);
+    vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            try {
+                for (size_t i = t; i < numTasks; i += threads) {
+                    task(i);
+                }
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/**
+ * @brief Appends a double to a string with six significant digits.
+ *
+ * The value is formatted with std::to_chars, which neither allocates nor consults the locale, so the generators can
+ * format millions of values quickly.
+ *
+ * @param out The string to append to.
+ * @param value The value to append.
+ */
+void appendNumber(string &out, double value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 6);
+    out.append(buffer, result.ptr);
+}
+
+/**
+ * @brief Formats blocks of output on several threads and writes them in order.
+ *
+ * The workers are started once and take the next block from a shared counter, so a slow block holds up only its own
+ * thread. The calling thread writes the blocks in order as they are finished. A worker waits before taking a block
+ * more than 2 * numThreads blocks ahead of the last one written, so the size of the output is not limited by memory.
+ * As long as formatBlock depends only on the block number, the output does not depend on the number of threads.
+ *
+ * @param out The stream to write to.
+ * @param numBlocks The number of blocks.
+ * @param numThreads The number of threads, at least 1.
+ * @param formatBlock Formats a block, given its number, into a string, which is empty on entry.
+ * @throws Rethrows the first error raised by formatBlock or by the stream, after all workers have stopped.
+ */
+void writeBlocksInParallel(std::ostream &out,
+                           size_t numBlocks,
+                           int numThreads,
+                           const std::function<void(size_t block, string &text)> &formatBlock)
+{
+    const size_t threads = std::min<size_t>(std::max(numThreads, 1), numBlocks);
+
+    if (threads <= 1) {
+        string text;
+        for (size_t block = 0; block < numBlocks; ++block) {
+            text.clear();
+            formatBlock(block, text);
+            out.write(text.data(), text.size());
+        }
+        return;
+    }
+
+    // Block b is formatted into slot b % window, which is free once block b - window has been written
+    const size_t window = 2 * threads;
+    vector<string> texts(window);
+    vector<bool> ready(window, false);
+    size_t written = 0;
+    bool failed    = false;
+    std::atomic<size_t> nextBlock{0};
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    vector<std::exception_ptr> errors(threads);
+    vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            try {
+                for (size_t block = nextBlock++; block < numBlocks; block = nextBlock++) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&] { return failed || block < written + window; });
+                        if (failed) {
+                            return;
+                        }
+                    }
+                    string &text = texts[block % window];
+                    text.clear();
+                    formatBlock(block, text);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ready[block % window] = true;
+                    }
+                    changed.notify_all();
+                }
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failed = true;
+                }
+                changed.notify_all();
+            }
+        });
+    }
+
+    std::exception_ptr writeError;
+    try {
+        while (written < numBlocks) {
+            const size_t slot = written % window;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return failed || ready[slot]; });
+                if (failed) {
+                    break;
+                }
+            }
+            out.write(texts[slot].data(), texts[slot].size());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[slot] = false;
+                ++written;
+            }
+            changed.notify_all();
+        }
+    }
+    catch (...) {
+        writeError = std::current_exception();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+        }
+        changed.notify_all();
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (writeError) {
+        std::rethrow_exception(writeError);
+    }
+    for (const auto &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 /**
  * @brief Rounds a double value to a specified precision and returns it as a string.
  *
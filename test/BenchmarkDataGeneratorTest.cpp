@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "BenchmarkDataGenerator.hpp"
+#include "DecisionTree.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+class BenchmarkDataGeneratorTest : public ::testing::Test
+{
+protected:
+    void TearDown() override { std::remove("../test/resources/benchmark_data_out.csv"); }
+
+    map<string, string> kwargs = {
+        {"output_datafile", "../test/resources/benchmark_data_out.csv"},
+        {"number_of_samples", "1000"},
+        {"number_of_numeric_features", "3"},
+        {"number_of_symbolic_features", "2"},
+        {"number_of_classes", "3"},
+        {"seed", "42"},
+        {"block_size", "64"}};
+
+    string readFile(const string &filename)
+    {
+        std::ifstream file(filename);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    string generate(map<string, string> args)
+    {
+        BenchmarkDataGenerator generator(args);
+        generator.GenerateBenchmarkData();
+        return readFile(args["output_datafile"]);
+    }
+};
+
+TEST_F(BenchmarkDataGeneratorTest, CheckParams)
+{
+    BenchmarkDataGenerator generator(kwargs);
+    ASSERT_EQ(generator.getNumberOfSamples(), 1000);
+    ASSERT_EQ(generator.getNumberOfNumericFeatures(), 3);
+    ASSERT_EQ(generator.getNumberOfSymbolicFeatures(), 2);
+    ASSERT_EQ(generator.getNumberOfClasses(), 3);
+    ASSERT_EQ(generator.getNumberOfSymbolicValues(), 5);
+    ASSERT_EQ(generator.getSeed(), 42);
+    ASSERT_EQ(generator.getBlockSize(), 64);
+    ASSERT_EQ(generator.getFeatureNames(),
+              vector<string>({"numeric_1", "numeric_2", "numeric_3", "symbolic_1", "symbolic_2"}));
+}
+
+TEST_F(BenchmarkDataGeneratorTest, InvalidParamsThrow)
+{
+    using Kwargs = map<string, string>;
+    ASSERT_THROW(BenchmarkDataGenerator(Kwargs{{"number_of_sample", "10"}}), std::invalid_argument);
+    ASSERT_THROW(BenchmarkDataGenerator(Kwargs{{"number_of_samples", "0"}}), std::invalid_argument);
+    ASSERT_THROW(BenchmarkDataGenerator(Kwargs{{"number_of_samples", "10"}, {"number_of_numeric_features", "300"}}),
+                 std::invalid_argument);
+}
+
+TEST_F(BenchmarkDataGeneratorTest, WritesAllSamples)
+{
+    std::istringstream contents(generate(kwargs));
+    string line;
+
+    std::getline(contents, line);
+    ASSERT_EQ(line, "\"\",class,numeric_1,numeric_2,numeric_3,symbolic_1,symbolic_2");
+
+    int numRows = 0;
+    while (std::getline(contents, line)) {
+        ++numRows;
+        ASSERT_EQ(line.substr(0, line.find(',')), std::to_string(numRows));
+        ASSERT_EQ(std::count(line.begin(), line.end(), ','), 6);
+    }
+    ASSERT_EQ(numRows, 1000);
+}
+
+TEST_F(BenchmarkDataGeneratorTest, OutputDependsOnlyOnSeed)
+{
+    kwargs["number_of_threads"] = "1";
+    string serial               = generate(kwargs);
+
+    kwargs["number_of_threads"] = "4";
+    ASSERT_EQ(generate(kwargs), serial);
+
+    kwargs["seed"] = "43";
+    ASSERT_NE(generate(kwargs), serial);
+}
+
+TEST_F(BenchmarkDataGeneratorTest, DecisionTreeTrainsOnOutput)
+{
+    kwargs["number_of_samples"] = "200";
+    BenchmarkDataGenerator generator(kwargs);
+    generator.GenerateBenchmarkData();
+
+    auto dt = make_shared<DecisionTree>(map<string, string>{
+        {       "training_datafile",            kwargs["output_datafile"]},
+        {  "csv_class_column_index",                                  "1"},
+        {"csv_columns_for_features", generator.getCsvColumnsForFeatures()},
+        {       "max_depth_desired",                                  "3"}
+    });
+    dt->fit();
+
+    ASSERT_EQ(dt->_featureNames, generator.getFeatureNames());
+    ASSERT_EQ(dt->_trainingDataDict.size(), 200);
+    ASSERT_EQ(dt->_classNames.size(), 3);
+}
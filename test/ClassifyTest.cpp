@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "DecisionTree.hpp"
 
+#include <thread>
+
 class ClassifyTest : public ::testing::Test
 {
 protected:
@@ -155,4 +157,41 @@ TEST_F(ClassifyTest, ClassifyNumeric)
         expected["solution_path"] = "NODE0";
         ASSERT_EQ(classification, expected);
     }
-}
\ No newline at end of file
+}
+
+TEST_F(ClassifyTest, ConcurrentClassifyLeavesTheTreeUnchanged)
+{
+    DecisionTreeNode* rootN = dtN->constructDecisionTreeClassifier();
+    const shared_ptr<const DecisionTree> tree = dtN;
+
+    vector<vector<string>> testSamples = {
+        {"age=60", "eet=2", "g2=10.22", "grade=2", "gleason=4", "ploidy=diploid"},
+        {"age=71", "eet=1", "g2=16.92", "grade=4", "gleason=7", "ploidy=aneuploid"},
+        {"age=65", "eet=2", "g2=6.20", "grade=2", "gleason=5", "ploidy=tetraploid"},
+        {"age=52", "grade=2", "ploidy=tetraploid"}
+    };
+    vector<map<string, string>> expected;
+    for (const auto &testSample : testSamples) {
+        expected.push_back(tree->classify(rootN, testSample));
+    }
+    const auto featuresAndValuesBefore = dtN->getFeaturesAndValuesDict();
+
+    // Every thread classifies every sample many times on the same tree
+    vector<std::thread> threads;
+    vector<int> mismatches(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < 50; ++round) {
+                for (size_t i = 0; i < testSamples.size(); ++i) {
+                    mismatches[t] += tree->classify(rootN, testSamples[i]) != expected[i];
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(mismatches, vector<int>(4, 0));
+    ASSERT_EQ(dtN->getFeaturesAndValuesDict(), featuresAndValuesBefore);
+}
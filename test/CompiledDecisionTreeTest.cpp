@@ -0,0 +1,226 @@
+#include "CompiledDecisionTree.hpp"
+
+#include <gtest/gtest.h>
+
+class CompiledDecisionTreeTest : public ::testing::Test {
+  protected:
+    shared_ptr<DecisionTree> dtS; // Symbolic DecisionTree
+    shared_ptr<DecisionTree> dtN; // Numeric DecisionTree
+    map<string, string> kwargsS;
+    map<string, string> kwargsN;
+
+    void SetUp() override
+    {
+        kwargsS = {
+            // Symbolic kwargs
+            {       "training_datafile", "../test/resources/training_symbolic.csv"},
+            {  "csv_class_column_index",                                       "1"},
+            {"csv_columns_for_features",                              {2, 3, 4, 5}},
+            {       "max_depth_desired",                                       "5"},
+            {       "entropy_threshold",                                     "0.1"},
+            {                  "debug3",                                       "0"}
+        };
+
+        kwargsN = {
+            // Numeric kwargs
+            {       "training_datafile", "../test/resources/stage3cancer.csv"},
+            {  "csv_class_column_index",                                  "2"},
+            {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+            {       "max_depth_desired",                                  "8"},
+            {       "entropy_threshold",                               "0.01"},
+            {                  "debug3",                                  "0"}
+        };
+
+        dtS = make_shared<DecisionTree>(kwargsS);
+        dtS->getTrainingData();
+        dtS->calculateFirstOrderProbabilities();
+        dtS->calculateClassPriors();
+
+        dtN = make_shared<DecisionTree>(kwargsN);
+        dtN->getTrainingData();
+        dtN->calculateFirstOrderProbabilities();
+        dtN->calculateClassPriors();
+    }
+
+    void TearDown() override
+    {
+        dtS.reset();
+        dtN.reset();
+    }
+};
+
+// Encodes the training data of a decision tree as the numeric and symbolic arrays of a compiled tree
+void encodeTrainingData(const shared_ptr<DecisionTree> &dt,
+                        const CompiledDecisionTree &compiled,
+                        vector<double> &numericValues,
+                        vector<int> &symbolicCodes)
+{
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        compiled.encodeRow(values, numericValues, symbolicCodes);
+    }
+}
+
+TEST_F(CompiledDecisionTreeTest, ThrowsWithoutTree)
+{
+    ASSERT_THROW(CompiledDecisionTree compiled(dtS), std::runtime_error);
+}
+
+TEST_F(CompiledDecisionTreeTest, LayoutMatchesTree)
+{
+    dtS->constructDecisionTreeClassifier();
+    CompiledDecisionTree compiled(dtS);
+
+    ASSERT_EQ(compiled.getNumNodes(), static_cast<size_t>(dtS->getRootNode()->HowManyNodes()));
+    ASSERT_EQ(compiled.getNumClasses(), dtS->_classNames.size());
+    ASSERT_EQ(compiled.getNumFeatures(), dtS->_featureNames.size());
+    ASSERT_EQ(compiled.getNodes()[0].serialNum, 0);
+    ASSERT_EQ(compiled.encodeSymbolicValue("fatIntake", "heavy"), 0);
+    ASSERT_EQ(compiled.encodeSymbolicValue("fatIntake", "nonexistent"), -1);
+    ASSERT_EQ(compiled.encodeSymbolicValue("nonexistent", "heavy"), -1);
+}
+
+TEST_F(CompiledDecisionTreeTest, PredictProbaMatchesClassify)
+{
+    for (auto dt : {dtS, dtN}) {
+        dt->constructDecisionTreeClassifier();
+        CompiledDecisionTree compiled(dt);
+
+        vector<double> numericValues;
+        vector<int> symbolicCodes;
+        encodeTrainingData(dt, compiled, numericValues, symbolicCodes);
+
+        const size_t numRows    = dt->_trainingDataDict.size();
+        const size_t numClasses = compiled.getNumClasses();
+        vector<double> probabilities(numRows * numClasses);
+        compiled.predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+
+        vector<float> numericValuesF(numericValues.begin(), numericValues.end());
+        vector<double> probabilitiesF(numRows * numClasses);
+        compiled.predictProba(numericValuesF.data(), symbolicCodes.data(), numRows, probabilitiesF.data());
+
+        size_t row = 0;
+        for (const auto &[sample, values] : dt->_trainingDataDict) {
+            // classify() cannot handle missing values
+            if (std::find(values.begin(), values.end(), "NA") != values.end()) {
+                row++;
+                continue;
+            }
+
+            vector<string> featuresAndValues;
+            for (size_t i = 0; i < values.size(); i++) {
+                featuresAndValues.push_back(dt->_featureNames[i] + "=" + values[i]);
+            }
+            map<string, string> classification = dt->classify(dt->getRootNode(), featuresAndValues);
+
+            for (size_t c = 0; c < numClasses; c++) {
+                ASSERT_NEAR(probabilities[row * numClasses + c], stod(classification[compiled.getClassNames()[c]]),
+                            0.0005);
+                ASSERT_NEAR(probabilitiesF[row * numClasses + c], stod(classification[compiled.getClassNames()[c]]),
+                            0.0005);
+            }
+            row++;
+        }
+    }
+}
+
+TEST_F(CompiledDecisionTreeTest, MissingValuesStopAtRoot)
+{
+    dtN->constructDecisionTreeClassifier();
+    CompiledDecisionTree compiled(dtN);
+
+    vector<double> missing(compiled.getNumFeatures(), std::nan(""));
+    ASSERT_EQ(compiled.predictLeaf(missing.data(), nullptr), 0);
+    ASSERT_EQ(compiled.predictProba(missing, {}), dtN->getRootNode()->GetClassProbabilities());
+    ASSERT_THROW(compiled.predictProba(vector<double>{1.0}, {}), std::invalid_argument);
+}
+
+TEST_F(CompiledDecisionTreeTest, LayoutsKeepPredictions)
+{
+    for (auto dt : {dtS, dtN}) {
+        dt->constructDecisionTreeClassifier();
+        CompiledDecisionTree depthFirst(dt);
+        ASSERT_EQ(depthFirst.getLayout(), NodeLayout::DEPTH_FIRST);
+
+        vector<double> numericValues;
+        vector<int> symbolicCodes;
+        encodeTrainingData(dt, depthFirst, numericValues, symbolicCodes);
+
+        // Rows with their symbolic values given as numbers, and rows with missing numeric values
+        const size_t numFeatures = depthFirst.getNumFeatures();
+        const size_t numRows     = numericValues.size() / numFeatures;
+        for (size_t row = 0; row < numRows; row++) {
+            if (row % 3 == 1) {
+                std::fill_n(symbolicCodes.begin() + row * numFeatures, numFeatures, -1);
+            }
+            else if (row % 3 == 2) {
+                std::fill_n(numericValues.begin() + row * numFeatures, numFeatures, std::nan(""));
+            }
+        }
+        vector<double> expected(numRows * depthFirst.getNumClasses());
+        depthFirst.predictProba(numericValues.data(), symbolicCodes.data(), numRows, expected.data());
+
+        for (auto layout : {NodeLayout::BREADTH_FIRST, NodeLayout::VAN_EMDE_BOAS, NodeLayout::HOT_PATH}) {
+            CompiledDecisionTree compiled(dt, layout);
+            ASSERT_EQ(compiled.getLayout(), layout);
+            ASSERT_EQ(compiled.getNumNodes(), depthFirst.getNumNodes());
+            ASSERT_EQ(compiled.getNodes()[0].serialNum, 0);
+
+            vector<double> probabilities(expected.size());
+            compiled.predictProba(numericValues.data(), symbolicCodes.data(), numRows, probabilities.data());
+            ASSERT_EQ(probabilities, expected);
+            for (size_t row = 0; row < numRows; row++) {
+                ASSERT_EQ(compiled.predictLeaf(&numericValues[row * numFeatures], &symbolicCodes[row * numFeatures]),
+                          depthFirst.predictLeaf(&numericValues[row * numFeatures], &symbolicCodes[row * numFeatures]));
+            }
+
+            // Back to the layout of the compiler
+            compiled.relayout(NodeLayout::DEPTH_FIRST);
+            for (size_t i = 0; i < compiled.getNumNodes(); i++) {
+                ASSERT_EQ(compiled.getNodes()[i].serialNum, depthFirst.getNodes()[i].serialNum);
+            }
+        }
+    }
+}
+
+TEST_F(CompiledDecisionTreeTest, HotPathFollowsTheTraffic)
+{
+    dtN->constructDecisionTreeClassifier();
+    CompiledDecisionTree compiled(dtN);
+    ASSERT_THROW(compiled.relayout(NodeLayout::HOT_PATH), std::invalid_argument);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    encodeTrainingData(dtN, compiled, numericValues, symbolicCodes);
+    const size_t numRows           = dtN->_trainingDataDict.size();
+    const map<int, size_t> traffic = compiled.countTraffic(numericValues.data(), symbolicCodes.data(), numRows);
+
+    // Every sample passes through the root, and no more samples go down to the children than reach their parent
+    ASSERT_EQ(traffic.size(), compiled.getNumNodes());
+    ASSERT_EQ(traffic.at(0), numRows);
+    for (const auto &node : compiled.getNodes()) {
+        size_t childTraffic = 0;
+        for (int i = node.firstChild; i < node.firstChild + node.numChildren; i++) {
+            childTraffic += traffic.at(compiled.getNodes()[i].serialNum);
+        }
+        ASSERT_LE(childTraffic, traffic.at(node.serialNum));
+    }
+
+    // The blocks of children along the most travelled path follow each other
+    compiled.relayout(NodeLayout::HOT_PATH, traffic);
+    const vector<CompiledNode> &nodes = compiled.getNodes();
+    int index                         = 0;
+    int blockEnd                      = 1;
+    while (nodes[index].numChildren > 0) {
+        ASSERT_EQ(nodes[index].firstChild, blockEnd);
+        blockEnd = nodes[index].firstChild + nodes[index].numChildren;
+
+        int hottest = nodes[index].firstChild;
+        for (int i = hottest + 1; i < blockEnd; i++) {
+            if (traffic.at(nodes[i].serialNum) > traffic.at(nodes[hottest].serialNum)) {
+                hottest = i;
+            }
+        }
+        index = hottest;
+    }
+    ASSERT_EQ(compiled.countTraffic(numericValues.data(), symbolicCodes.data(), numRows), traffic);
+}
@@ -1,6 +1,8 @@
+#include "DTIntrospection.hpp"
 #include "DecisionTree.hpp"
 
 #include <gtest/gtest.h>
+#include <thread>
 
 class ConstructTreeTest : public ::testing::Test {
   protected:
@@ -353,4 +355,292 @@ NODE 27:       BRANCH TESTS TO LEAF NODE: ['grade=4']
     while (std::getline(actualStream, actualLine)) {
         ADD_FAILURE() << "Extra line in actual output: " << actualLine;
     }
-}
\ No newline at end of file
+}
+
+TEST_F(ConstructTreeTest, buildRoutingIndexThrowsWithoutTree)
+{
+    ASSERT_FALSE(dtS->hasRoutingIndex());
+    ASSERT_THROW(dtS->buildRoutingIndex(), std::runtime_error);
+}
+
+TEST_F(ConstructTreeTest, routingIndexFromKwargs)
+{
+    kwargsS["build_routing_index"] = "1";
+    auto dt                        = make_shared<DecisionTree>(kwargsS);
+    dt->getTrainingData();
+    dt->calculateFirstOrderProbabilities();
+    dt->calculateClassPriors();
+    dt->constructDecisionTreeClassifier();
+
+    ASSERT_TRUE(dt->hasRoutingIndex());
+    const RoutingIndex &routingIndex = dt->getRoutingIndex();
+    ASSERT_EQ(routingIndex.permutedSamples.size(), dt->_trainingDataDict.size());
+    ASSERT_EQ(routingIndex.nodeRowRanges.at(0), (pair<int, int>{0, static_cast<int>(dt->_trainingDataDict.size())}));
+    ASSERT_EQ(routingIndex.firstSample, dt->_trainingDataDict.begin()->first);
+    ASSERT_EQ(routingIndex.sampleToLeaf.size(), dt->_trainingDataDict.rbegin()->first - routingIndex.firstSample + 1);
+}
+
+TEST_F(ConstructTreeTest, routingIndexConsistentWithTree)
+{
+    for (auto dt : {dtS, dtN}) {
+        dt->constructDecisionTreeClassifier();
+        ASSERT_FALSE(dt->hasRoutingIndex());
+        dt->buildRoutingIndex();
+        const RoutingIndex &routingIndex = dt->getRoutingIndex();
+
+        // Every child's range is nested inside its parent's range
+        for (size_t child = 0; child < routingIndex.parentNodes.size(); child++) {
+            const int parent = routingIndex.parentNodes[child];
+            if (parent < 0) {
+                continue;
+            }
+            const auto &childRange  = routingIndex.nodeRowRanges.at(child);
+            const auto &parentRange = routingIndex.nodeRowRanges.at(parent);
+            ASSERT_GE(childRange.first, parentRange.first);
+            ASSERT_LE(childRange.second, parentRange.second);
+        }
+
+        // Every sample lies in the range of its leaf, and that leaf is the one classify() reaches
+        map<int, int> positionOfSample;
+        for (int i = 0; i < static_cast<int>(routingIndex.permutedSamples.size()); i++) {
+            positionOfSample[routingIndex.permutedSamples[i]] = i;
+        }
+
+        for (const auto &[sample, values] : dt->_trainingDataDict) {
+            const int leaf    = routingIndex.sampleToLeaf.at(sample - routingIndex.firstSample);
+            const auto &range = routingIndex.nodeRowRanges.at(leaf);
+            ASSERT_GE(positionOfSample[sample], range.first);
+            ASSERT_LT(positionOfSample[sample], range.second);
+
+            // classify() cannot handle missing values
+            if (std::find(values.begin(), values.end(), "NA") != values.end()) {
+                continue;
+            }
+
+            vector<string> featuresAndValues;
+            for (size_t i = 0; i < dt->_featureNames.size(); i++) {
+                featuresAndValues.push_back(dt->_featureNames[i] + "=" + values[i]);
+            }
+            string solutionPath = dt->classify(dt->getRootNode(), featuresAndValues)["solution_path"];
+            ASSERT_EQ(solutionPath.substr(solutionPath.rfind("NODE") + 4), std::to_string(leaf));
+        }
+    }
+}
+
+TEST_F(ConstructTreeTest, fitMatchesStepByStepConstruction)
+{
+    dtN->constructDecisionTreeClassifier();
+    auto expected = make_shared<DTIntrospection>(dtN);
+    expected->initialize();
+
+    // Several trees trained concurrently from threads end up identical to the one trained step by step
+    vector<shared_ptr<DecisionTree>> trees;
+    vector<std::thread> threads;
+    for (int i = 0; i < 3; i++) {
+        trees.push_back(make_shared<DecisionTree>(kwargsN));
+    }
+    for (auto &tree : trees) {
+        threads.emplace_back([tree]() { tree->fit(); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (auto &tree : trees) {
+        ASSERT_NE(tree->getRootNode(), nullptr);
+        auto actual = make_shared<DTIntrospection>(tree);
+        actual->initialize();
+        ASSERT_EQ(actual->getBranchFeaturesToNodesDict(), expected->getBranchFeaturesToNodesDict());
+        ASSERT_EQ(actual->getSamplesAtNodesDict(), expected->getSamplesAtNodesDict());
+    }
+}
+
+TEST_F(ConstructTreeTest, statsAreCollectedDuringConstruction)
+{
+    DecisionTreeNode* rootN = dtN->constructDecisionTreeClassifier();
+    ASSERT_NE(rootN, nullptr);
+
+    TrainingStats stats = dtN->getStats();
+    ASSERT_EQ(stats.probabilityCacheEntries, dtN->_probabilityCache.size());
+    ASSERT_EQ(stats.entropyCacheEntries, dtN->_entropyCache.size());
+    ASSERT_GT(stats.bytesAllocated, 0u);
+
+#ifdef DTPP_ENABLE_STATS
+    ASSERT_EQ(stats.nodesCreated, rootN->HowManyNodes());
+    ASSERT_EQ(stats.splitSearches, static_cast<long long>(stats.splitSearchSecondsPerNode.size()));
+    ASSERT_GT(stats.splitSearches, 0);
+    ASSERT_GE(stats.featuresEvaluated, stats.splitSearches);
+    ASSERT_GT(stats.thresholdsEvaluated, 0);
+    ASSERT_GT(stats.probabilityCacheHits, 0);
+    ASSERT_GT(stats.entropyCacheMisses, 0);
+    ASSERT_GT(stats.loadSeconds, 0.0);
+    ASSERT_GE(stats.constructSeconds, stats.splitSearchSeconds);
+    ASSERT_GT(stats.probabilityCacheHitRate(), 0.0);
+    ASSERT_LE(stats.probabilityCacheHitRate(), 1.0);
+
+    dtN->resetStats();
+    ASSERT_EQ(dtN->getStats().nodesCreated, 0);
+#else
+    ASSERT_EQ(stats.nodesCreated, 0);
+#endif
+}
+
+TEST_F(ConstructTreeTest, tracingRecordsNodeAndFeatureSpans)
+{
+    dtN->setTracing(true);
+    DecisionTreeNode* rootN = dtN->constructDecisionTreeClassifier();
+    ASSERT_NE(rootN, nullptr);
+
+    // Every node gets a span, and the root span encloses all the others
+    const auto &events = dtN->getTrace().getEvents();
+    int nodeSpans = 0, featureSpans = 0;
+    const TraceEvent* rootSpan = nullptr;
+    for (const auto &event : events) {
+        if (event.category == "recursiveDescent") {
+            nodeSpans++;
+            if (event.name == "node 0") {
+                rootSpan = &event;
+            }
+        }
+        else {
+            ASSERT_EQ(event.category, "bestFeatureCalculator");
+            featureSpans++;
+        }
+    }
+    ASSERT_EQ(nodeSpans, rootN->HowManyNodes());
+    ASSERT_GT(featureSpans, 0);
+    ASSERT_NE(rootSpan, nullptr);
+    for (const auto &event : events) {
+        ASSERT_GE(event.startMicros, rootSpan->startMicros);
+        ASSERT_LE(event.startMicros + event.durationMicros, rootSpan->startMicros + rootSpan->durationMicros + 1e-3);
+    }
+
+    map<string, double> rootArgs(rootSpan->args.begin(), rootSpan->args.end());
+    ASSERT_EQ(rootArgs["node"], 0);
+    ASSERT_EQ(rootArgs["depth"], 0);
+    ASSERT_EQ(rootArgs["samples"], dtN->getTrainingDataDict().size());
+
+    string json = dtN->getTrace().toChromeTraceJson();
+    ASSERT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0);
+    ASSERT_NE(json.find("\"name\":\"node 0\",\"cat\":\"recursiveDescent\",\"ph\":\"X\""), string::npos);
+
+    // Turning tracing off keeps the spans but records no more
+    dtN->setTracing(false);
+    dtN->countSamplesOnBranch({});
+    ASSERT_EQ(dtN->getTrace().getEvents().size(), events.size());
+}
+
+TEST_F(ConstructTreeTest, memoryBudgetEvictsCachesWithoutChangingTheTree)
+{
+    dtS->constructDecisionTreeClassifier();
+    MemoryUsage unbounded = dtS->getMemoryUsage();
+    ASSERT_GT(unbounded.trainingDataBytes, 0u);
+    ASSERT_GT(unbounded.probabilityCacheBytes, 0u);
+    ASSERT_GT(unbounded.entropyCacheBytes, 0u);
+    ASSERT_GT(unbounded.nodeBytes, 0u);
+    ASSERT_EQ(unbounded.cacheEvictions, 0);
+    ASSERT_EQ(dtS->getStats().bytesAllocated, unbounded.totalBytes());
+
+    // A budget that holds the data and nodes but not the caches gives the same tree
+    auto kwargs                = kwargsS;
+    kwargs["memory_budget_mb"] = std::to_string(
+        (unbounded.trainingDataBytes + unbounded.nodeBytes + unbounded.probabilityCacheBytes / 4) / (1024.0 * 1024.0));
+    auto bounded = make_shared<DecisionTree>(kwargs);
+    bounded->getTrainingData();
+    bounded->calculateFirstOrderProbabilities();
+    bounded->calculateClassPriors();
+    bounded->constructDecisionTreeClassifier();
+
+    MemoryUsage usage = bounded->getMemoryUsage();
+    ASSERT_GT(usage.cacheEvictions, 0);
+    ASSERT_LE(usage.totalBytes(), usage.budgetBytes);
+    ASSERT_EQ(bounded->getRootNode()->HowManyNodes(), dtS->getRootNode()->HowManyNodes());
+
+    auto expected = make_shared<DTIntrospection>(dtS);
+    auto actual   = make_shared<DTIntrospection>(bounded);
+    expected->initialize();
+    actual->initialize();
+    ASSERT_EQ(actual->getBranchFeaturesToNodesDict(), expected->getBranchFeaturesToNodesDict());
+
+    // A budget smaller than the training data fails cleanly
+    kwargs["memory_budget_mb"] = "0.0001";
+    auto tooSmall              = make_shared<DecisionTree>(kwargs);
+    ASSERT_THROW(tooSmall->getTrainingData(), std::runtime_error);
+}
+
+TEST_F(ConstructTreeTest, truncatingGivesTheTreeOfStricterParameters)
+{
+    // The same branches and class probabilities, whatever the serial numbers
+    std::function<void(const DecisionTreeNode*, const DecisionTreeNode*)> expectSameTree =
+        [&](const DecisionTreeNode* expected, const DecisionTreeNode* actual) {
+            ASSERT_EQ(actual->GetBranchFeaturesAndValuesOrThresholds(),
+                      expected->GetBranchFeaturesAndValuesOrThresholds());
+            ASSERT_EQ(actual->GetClassProbabilities(), expected->GetClassProbabilities());
+            ASSERT_EQ(actual->GetNumChildren(), expected->GetNumChildren());
+            for (size_t i = 0; i < expected->GetNumChildren(); ++i) {
+                expectSameTree(expected->GetChild(i), actual->GetChild(i));
+            }
+        };
+
+    auto grow = [](map<string, string> kwargs, double entropyThreshold, int maxDepthDesired) {
+        kwargs["entropy_threshold"] = std::to_string(entropyThreshold);
+        kwargs["max_depth_desired"] = std::to_string(maxDepthDesired);
+        auto dt                     = make_shared<DecisionTree>(kwargs);
+        dt->fit();
+        return dt;
+    };
+
+    const vector<tuple<map<string, string>, double, int>> configurations = {
+        {kwargsN, 0.05, 4},
+        {kwargsN, 0.01, 3},
+        {kwargsN,  0.2, 8},
+        {kwargsS,  0.2, 3},
+        {kwargsS,  0.1, 2},
+    };
+    for (const auto &[kwargs, entropyThreshold, maxDepthDesired] : configurations) {
+        auto expected = grow(kwargs, entropyThreshold, maxDepthDesired);
+        auto actual =
+            grow(kwargs, std::stod(kwargs.at("entropy_threshold")), std::stoi(kwargs.at("max_depth_desired")));
+
+        const int expectedNodes = actual->countNodesAfterTruncation(entropyThreshold, maxDepthDesired);
+        actual->truncate(entropyThreshold, maxDepthDesired);
+        expectSameTree(expected->getRootNode(), actual->getRootNode());
+        ASSERT_EQ(actual->countNodesAfterTruncation(entropyThreshold, maxDepthDesired), expectedNodes);
+        ASSERT_EQ(actual->getEntropyThreshold(), entropyThreshold);
+        ASSERT_EQ(actual->getMaxDepthDesired(), maxDepthDesired);
+    }
+
+    // A tree cannot be truncated to one it does not contain
+    auto tree = grow(kwargsS, 0.1, 3);
+    ASSERT_THROW(tree->truncate(0.05, 3), std::invalid_argument);
+    ASSERT_THROW(tree->truncate(0.1, 4), std::invalid_argument);
+    ASSERT_THROW(tree->truncate(0.1, -1), std::invalid_argument);
+}
+
+TEST_F(ConstructTreeTest, debugOutputGoesToTheLogger)
+{
+    if (LogLevel::DEBUG < Logger::MIN_LEVEL) {
+        GTEST_SKIP() << "DEBUG messages are compiled out";
+    }
+
+    const string logFile = "ConstructTreeTest.log";
+    std::remove(logFile.c_str());
+    auto logger = make_shared<Logger>(logFile, false);
+    dtS->setDebug3(1);
+    dtS->setLogger(logger);
+
+    // The construction messages go to the logger and not to the console
+    std::ostringstream outputBuffer;
+    std::streambuf* oldCoutBuffer = cout.rdbuf(outputBuffer.rdbuf());
+    dtS->constructDecisionTreeClassifier();
+    cout.rdbuf(oldCoutBuffer);
+    logger->flush();
+    ASSERT_EQ(outputBuffer.str().find("RD1 NODE SERIAL NUMBER"), string::npos);
+
+    std::ifstream file(logFile);
+    const string logged((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_NE(logged.find("DEBUG: RD1 NODE SERIAL NUMBER: 0"), string::npos);
+    ASSERT_NE(logged.find("DEBUG: BFC1    FEATURE BEING CONSIDERED: fatIntake"), string::npos);
+    ASSERT_NE(logged.find("NODE 0:  BRANCH TESTS TO"), string::npos);
+    std::remove(logFile.c_str());
+}
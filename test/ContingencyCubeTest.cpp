@@ -0,0 +1,152 @@
+#include "ContingencyCube.hpp"
+#include "DecisionTree.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(ContingencyCubeTest, CountsMatchTheSamples)
+{
+    // Three features with 2, 3 and 1 values, and 2 classes
+    ContingencyCube cube({{"a", "b"}, {"x", "y", "z"}, {"only"}}, 2);
+    ASSERT_EQ(ContingencyCube::numCells({{"a", "b"}, {"x", "y", "z"}, {"only"}}, 2), 2 * 3 * 1 * 3);
+    ASSERT_EQ(cube.valueCode(1, "y"), 1);
+    ASSERT_EQ(cube.valueCode(1, "w"), ContingencyCube::ANY);
+
+    struct Sample {
+        vector<int> codes;
+        int classIndex;
+        uint32_t weight;
+    };
+    const vector<Sample> samples = {
+        {{0, 0, 0},  0, 3},
+        {{0, 2, 0},  1, 1},
+        {{1, 1, 0},  0, 2},
+        {{1, 2, 0},  1, 5},
+        {{1, 2, 0}, -1, 4}, // Without a class label
+        {{0, 0, 0},  1, 1},
+    };
+    for (const auto &sample : samples) {
+        cube.add(sample.codes, sample.classIndex, sample.weight);
+    }
+    ASSERT_THROW(cube.add({0, 3, 0}, 0, 1), std::invalid_argument);
+
+    // Every combination of fixed and free features and class agrees with counting the samples
+    for (int a = -1; a < 2; ++a) {
+        for (int x = -1; x < 3; ++x) {
+            for (int c = -1; c < 2; ++c) {
+                uint64_t expected = 0;
+                for (const auto &sample : samples) {
+                    if ((a == -1 || sample.codes[0] == a) && (x == -1 || sample.codes[1] == x) &&
+                        (c == -1 || sample.classIndex == c)) {
+                        expected += sample.weight;
+                    }
+                }
+                ASSERT_EQ(cube.count({a, x, ContingencyCube::ANY}, c), expected) << a << " " << x << " " << c;
+                if (a != -1 && x == -1) {
+                    ASSERT_EQ(cube.featureValueCount(0, a, c), expected);
+                }
+                if (a == -1 && x != -1) {
+                    ASSERT_EQ(cube.featureValueCount(1, x, c), expected);
+                }
+                if (a == -1 && x == -1) {
+                    ASSERT_EQ(cube.classCount(c), expected);
+                }
+            }
+        }
+    }
+}
+
+TEST(ContingencyCubeTest, BranchesAreCountedFromTheMarginalsOfTheirParent)
+{
+    ContingencyCube cube({{"a", "b"}, {"x", "y", "z"}}, 2);
+    cube.add({0, 0}, 0, 3);
+    cube.add({0, 2}, 1, 1);
+    cube.add({1, 2}, 1, 5);
+    cube.add({1, 2}, -1, 4);
+
+    // The marginals of a branch hold the counts of the branch with one more feature fixed
+    const auto &branch = cube.marginals({1, ContingencyCube::ANY});
+    ASSERT_EQ(branch.classTotals, (vector<uint64_t>{0, 5, 4}));
+    ASSERT_EQ(branch.valueCounts[0], (vector<uint64_t>{0, 0, 0, 0, 5, 4}));
+    ASSERT_EQ(branch.valueCounts[1], (vector<uint64_t>{0, 0, 0, 0, 0, 0, 0, 5, 4}));
+
+    // Counting the children of the branch is a lookup, which sums no marginals of its own
+    const size_t bytes = cube.branchMarginalsBytes();
+    ASSERT_EQ(cube.count({1, 2}, ContingencyCube::ANY), 9);
+    ASSERT_EQ(cube.count({1, 0}, 0), 0);
+    ASSERT_EQ(cube.branchMarginalsBytes(), bytes);
+
+    // Adding samples drops the marginals
+    cube.add({1, 0}, 0, 2);
+    ASSERT_EQ(cube.branchMarginalsBytes(), 0);
+    ASSERT_EQ(cube.count({1, 0}, 0), 2);
+}
+
+TEST(ContingencyCubeTest, SymbolicTreeIsCountedFromTheCube)
+{
+    map<string, string> kargs = {
+        {       "training_datafile", "../test/resources/training_symbolic_large1.csv"},
+        {  "csv_class_column_index",                                             "1"},
+        {"csv_columns_for_features",                                    {2, 3, 4, 5}},
+        {       "max_depth_desired",                                             "5"},
+        {       "entropy_threshold",                                           "0.1"}
+    };
+    auto withCube = make_shared<DecisionTree>(kargs);
+    withCube->getTrainingData();
+    ASSERT_TRUE(withCube->hasContingencyCube());
+
+    kargs["contingency_cube_max_cells"] = "0";
+    auto withoutCube                    = make_shared<DecisionTree>(kargs);
+    withoutCube->getTrainingData();
+    ASSERT_FALSE(withoutCube->hasContingencyCube());
+
+    // The same probabilities, and so the same tree
+    for (auto dt : {withCube, withoutCube}) {
+        dt->calculateFirstOrderProbabilities();
+        dt->calculateClassPriors();
+        dt->constructDecisionTreeClassifier();
+    }
+    ASSERT_EQ(withCube->_probabilityCache, withoutCube->_probabilityCache);
+    ASSERT_EQ(withCube->_nodesCreated, withoutCube->_nodesCreated);
+
+    // Branch counts from the cube match testing every sample
+    const vector<vector<string>> branches = {
+        {},
+        {"smoking=heavy"},
+        {"smoking=heavy", "exercising=never"},
+        {"smoking=heavy", "fatIntake=low", "videoAddiction=none"},
+        {"smoking=heavy", "smoking=never"},
+        {"smoking=sometimes-maybe"},
+    };
+    for (const auto &branch : branches) {
+        ASSERT_EQ(withCube->countSamplesOnBranch(branch), withoutCube->countSamplesOnBranch(branch));
+    }
+    ASSERT_EQ(withCube->countSamplesOnBranch({}), withCube->_trainingDataDict.size());
+
+    // The marginals summed for the branches count as probability cache, and are dropped with it
+    ASSERT_GT(withCube->getContingencyCube().branchMarginalsBytes(), 0);
+    ASSERT_GE(withCube->getMemoryUsage().probabilityCacheBytes, withCube->getContingencyCube().branchMarginalsBytes());
+    withCube->clearCaches();
+    ASSERT_EQ(withCube->getContingencyCube().branchMarginalsBytes(), 0);
+}
+
+TEST(ContingencyCubeTest, NoCubeForNumericOrLargeFeatureSpaces)
+{
+    map<string, string> kargs = {
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}}
+    };
+    DecisionTree numeric(kargs);
+    numeric.getTrainingData();
+    ASSERT_FALSE(numeric.hasContingencyCube());
+
+    map<string, string> symbolicKargs = {
+        {          "training_datafile", "../test/resources/training_symbolic.csv"},
+        {     "csv_class_column_index",                                       "1"},
+        {   "csv_columns_for_features",                              {2, 3, 4, 5}},
+        {"contingency_cube_max_cells",                                       "10"}
+    };
+    DecisionTree tooLarge(symbolicKargs);
+    tooLarge.getTrainingData();
+    ASSERT_FALSE(tooLarge.hasContingencyCube());
+}
@@ -0,0 +1,176 @@
+#include "DecisionForest.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numeric>
+
+class DecisionForestTest : public ::testing::Test {
+  protected:
+    map<string, string> symbolicKargs = {
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {       "max_depth_desired",                                       "5"},
+        {       "entropy_threshold",                                     "0.1"},
+        {         "number_of_trees",                                       "6"},
+        {                    "seed",                                       "3"}
+    };
+    map<string, string> numericKargs = {
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {       "max_depth_desired",                                  "4"},
+        {       "entropy_threshold",                                "0.1"},
+        {         "number_of_trees",                                  "4"},
+        {                    "seed",                                  "5"}
+    };
+};
+
+TEST_F(DecisionForestTest, TreesShareTheDataThroughBootstrapWeights)
+{
+    DecisionForest forest(symbolicKargs);
+    forest.fit();
+    ASSERT_EQ(forest.getNumTrees(), 6u);
+    ASSERT_EQ(forest.getCompiledTrees().size(), 6u);
+
+    const size_t numSamples = forest.getData()->_trainingDataDict.size();
+    for (const auto &tree : forest.getTrees()) {
+        // No copy of the samples, and a bootstrap sample as large as the data
+        ASSERT_TRUE(tree->_trainingDataDict.empty());
+        ASSERT_NE(tree->getRootNode(), nullptr);
+        ASSERT_EQ(tree->getFeaturesPerNode(), 2); // The ceiling of the square root of 4 features
+        size_t totalWeight = 0;
+        for (const auto &row : tree->_weightedRows) {
+            ASSERT_GT(row.weight, 0);
+            totalWeight += row.weight;
+        }
+        ASSERT_EQ(totalWeight, numSamples);
+        ASSERT_EQ(tree->countSamplesOnBranch({}), static_cast<int>(numSamples));
+    }
+
+    // Each tree draws a bootstrap sample of its own
+    auto rowWeights = [](const shared_ptr<DecisionTree> &tree) {
+        vector<pair<int, int>> weights;
+        for (const auto &row : tree->_weightedRows) {
+            weights.emplace_back(row.sample, row.weight);
+        }
+        return weights;
+    };
+    ASSERT_NE(rowWeights(forest.getTrees()[0]), rowWeights(forest.getTrees()[1]));
+}
+
+TEST_F(DecisionForestTest, TreesHoldOnlyTheirWeightedRows)
+{
+    DecisionForest forest(symbolicKargs);
+    forest.fit();
+
+    const size_t dataBytes = forest.getData()->getMemoryUsage().trainingDataBytes;
+    for (const auto &tree : forest.getTrees()) {
+        const MemoryUsage usage = tree->getMemoryUsage();
+        ASSERT_EQ(usage.trainingDataBytes,
+                  sizeof(tree->_weightedRows) + tree->_weightedRows.capacity() * sizeof(WeightedRow));
+        ASSERT_LT(usage.trainingDataBytes, dataBytes);
+        ASSERT_GT(usage.nodeBytes, 0u);
+
+        // The values parsed as numbers are those of the data
+        const vector<double> &dataNumericValues = forest.getData()->_rowNumericValues;
+        for (const auto &row : tree->_weightedRows) {
+            ASSERT_GE(row.numericValues, dataNumericValues.data());
+            ASSERT_LT(row.numericValues, dataNumericValues.data() + dataNumericValues.size());
+        }
+    }
+}
+
+TEST_F(DecisionForestTest, SameForestForAnyNumberOfThreads)
+{
+    symbolicKargs["number_of_threads"] = "1";
+    DecisionForest serial(symbolicKargs);
+    serial.fit();
+    symbolicKargs["number_of_threads"] = "3";
+    DecisionForest parallel(symbolicKargs);
+    parallel.fit();
+
+    ASSERT_EQ(serial.getNumTrees(), parallel.getNumTrees());
+    for (size_t t = 0; t < serial.getNumTrees(); ++t) {
+        ASSERT_EQ(serial.getTrees()[t]->_probabilityCache, parallel.getTrees()[t]->_probabilityCache);
+        ASSERT_EQ(serial.getTrees()[t]->_nodesCreated, parallel.getTrees()[t]->_nodesCreated);
+    }
+
+    const vector<string> sample = {"exercising=never", "smoking=heavy", "fatIntake=heavy", "videoAddiction=heavy"};
+    ASSERT_EQ(serial.classify(sample), parallel.classify(sample));
+}
+
+TEST_F(DecisionForestTest, BatchPredictionAveragesTheTrees)
+{
+    DecisionForest forest(symbolicKargs);
+    forest.fit();
+
+    const vector<string> features        = forest.getFeatureNames();
+    const vector<vector<string>> samples = {
+        {      "exercising=never",  "smoking=heavy",  "fatIntake=heavy", "videoAddiction=heavy"},
+        {   "exercising=regularly",  "smoking=never",    "fatIntake=low",  "videoAddiction=none"},
+        {"exercising=occasionally",  "smoking=light", "fatIntake=medium",   "videoAddiction=low"},
+    };
+
+    vector<int> codes(samples.size() * features.size(), -1);
+    for (size_t row = 0; row < samples.size(); ++row) {
+        for (const auto &featureAndValue : samples[row]) {
+            const string feature = featureAndValue.substr(0, featureAndValue.find('='));
+            const string value   = featureAndValue.substr(featureAndValue.find('=') + 1);
+            const size_t column  = std::find(features.begin(), features.end(), feature) - features.begin();
+            codes[row * features.size() + column] = forest.encodeSymbolicValue(feature, value);
+        }
+    }
+
+    const size_t numClasses = forest.getNumClasses();
+    vector<double> probabilities(samples.size() * numClasses);
+    forest.predictProba<double>(nullptr, codes.data(), samples.size(), probabilities.data());
+
+    for (size_t row = 0; row < samples.size(); ++row) {
+        const double* rowProbabilities = probabilities.data() + row * numClasses;
+        ASSERT_NEAR(std::accumulate(rowProbabilities, rowProbabilities + numClasses, 0.0), 1.0, 1e-9);
+
+        // The compiled trees agree with descending the trees themselves
+        const map<string, double> classified = forest.classify(samples[row]);
+        for (size_t c = 0; c < numClasses; ++c) {
+            ASSERT_NEAR(rowProbabilities[c], classified.at(forest.getClassNames()[c]), 1e-9);
+        }
+    }
+
+    ASSERT_THROW(DecisionForest(symbolicKargs).predictProba(vector<double>{}, vector<int>(4, 0)), std::runtime_error);
+}
+
+TEST_F(DecisionForestTest, NumericFeatures)
+{
+    DecisionForest forest(numericKargs);
+    forest.fit();
+    ASSERT_EQ(forest.getNumTrees(), 4u);
+
+    // A sample given by name, laid out in the order of the features
+    const map<string, double> numericValues = {
+        {     "g2", 4.2},
+        {  "grade", 2.3},
+        {"gleason", 4.0},
+        {    "eet", 1.7},
+        {    "age", 55.0}
+    };
+    const int diploid = forest.encodeSymbolicValue("ploidy", "diploid");
+    ASSERT_GE(diploid, 0);
+    vector<double> sample;
+    vector<int> codes;
+    for (const auto &feature : forest.getFeatureNames()) {
+        auto value = numericValues.find(feature);
+        sample.push_back(value != numericValues.end() ? value->second : std::nan(""));
+        codes.push_back(feature == "ploidy" ? diploid : -1);
+    }
+
+    vector<double> probabilities = forest.predictProba(sample, codes);
+    ASSERT_EQ(probabilities.size(), forest.getNumClasses());
+    ASSERT_NEAR(std::accumulate(probabilities.begin(), probabilities.end(), 0.0), 1.0, 1e-9);
+
+    vector<float> sampleAsFloats(sample.begin(), sample.end());
+    vector<double> fromFloats(forest.getNumClasses());
+    forest.predictProba(sampleAsFloats.data(), codes.data(), 1, fromFloats.data());
+    ASSERT_EQ(fromFloats, probabilities);
+}
@@ -164,6 +164,103 @@ TEST_F(DecisionTreeTest, CheckGetTrainingData)
 }
 
 
+TEST_F(DecisionTreeTest, FeatureTypesAreInferredOrDeclared)
+{
+    map<string, string> kargs = {
+        {                        "training_datafile", "../test/resources/stage3cancer.csv"},
+        {                   "csv_class_column_index",                                  "2"},
+        {                 "csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {"symbolic_to_numeric_cardinality_threshold",                                 "20"}
+    };
+
+    // Inferred from the number of unique values
+    DecisionTree inferred(kargs);
+    inferred.getTrainingData();
+    map<string, FeatureType> expectedTypes = {
+        {    "age",  FeatureType::NUMERIC},
+        {    "eet", FeatureType::SYMBOLIC},
+        {     "g2",  FeatureType::NUMERIC},
+        {  "grade", FeatureType::SYMBOLIC},
+        {"gleason", FeatureType::SYMBOLIC},
+        { "ploidy", FeatureType::SYMBOLIC}
+    };
+    ASSERT_EQ(inferred.getFeatureTypes(), expectedTypes);
+    ASSERT_TRUE(inferred.isNumericFeature("g2"));
+    ASSERT_FALSE(inferred.isNumericFeature("ploidy"));
+
+    // Declared types replace the inferred ones
+    kargs["feature_types"] = "gleason=numeric, age=symbolic";
+    DecisionTree declared(kargs);
+    declared.getTrainingData();
+    expectedTypes["gleason"] = FeatureType::NUMERIC;
+    expectedTypes["age"]     = FeatureType::SYMBOLIC;
+    ASSERT_EQ(declared.getFeatureTypes(), expectedTypes);
+
+    // Declarations that do not fit the data
+    for (const char* featureTypes : {"ploidy=numeric", "height=numeric"}) {
+        kargs["feature_types"] = featureTypes;
+        DecisionTree wrong(kargs);
+        ASSERT_THROW(wrong.getTrainingData(), std::invalid_argument) << featureTypes;
+    }
+    kargs["feature_types"] = "age=ordinal";
+    ASSERT_THROW(DecisionTree{kargs}, std::invalid_argument);
+}
+
+TEST_F(DecisionTreeTest, WeightedRowsGiveTheSameTree)
+{
+    // Without a contingency cube, so that the counts come from the weighted rows
+    map<string, string> kargs = {
+        {         "training_datafile", "../test/resources/training_symbolic_large1.csv"},
+        {    "csv_class_column_index",                                             "1"},
+        {  "csv_columns_for_features",                                    {2, 3, 4, 5}},
+        {         "max_depth_desired",                                             "5"},
+        {         "entropy_threshold",                                           "0.1"},
+        {"contingency_cube_max_cells",                                             "0"}
+    };
+
+    // The duplicate samples are collapsed into far fewer weighted rows
+    auto compacted = make_shared<DecisionTree>(kargs);
+    compacted->getTrainingData();
+    const auto &rows = compacted->getWeightedRows();
+    int totalWeight  = 0;
+    for (const auto &row : rows) {
+        totalWeight += row.weight;
+        ASSERT_EQ(compacted->_classNames[row.classIndex], compacted->_samplesClassLabelDict.at(row.sample));
+    }
+    ASSERT_EQ(totalWeight, compacted->_trainingDataDict.size());
+    ASSERT_LT(rows.size(), 1000);
+
+    // One row per sample counts every sample on its own, as without compaction
+    auto uncompacted = make_shared<DecisionTree>(kargs);
+    uncompacted->getTrainingData();
+    uncompacted->_weightedRows.clear();
+    for (const auto &[sample, className] : uncompacted->_samplesClassLabelDict) {
+        const int classIndex = std::find(uncompacted->_classNames.begin(), uncompacted->_classNames.end(), className) -
+                               uncompacted->_classNames.begin();
+        uncompacted->_weightedRows.push_back({sample, classIndex, 1, &uncompacted->_trainingDataDict.at(sample)});
+    }
+
+    for (auto dt : {compacted, uncompacted}) {
+        dt->calculateFirstOrderProbabilities();
+        dt->calculateClassPriors();
+        dt->constructDecisionTreeClassifier();
+    }
+    ASSERT_EQ(compacted->_classPriorsDict, uncompacted->_classPriorsDict);
+    ASSERT_EQ(compacted->_nodesCreated, uncompacted->_nodesCreated);
+
+    std::function<void(const DecisionTreeNode*, const DecisionTreeNode*)> assertSameSubtree =
+        [&](const DecisionTreeNode* a, const DecisionTreeNode* b) {
+            ASSERT_EQ(a->GetFeature(), b->GetFeature());
+            ASSERT_EQ(a->GetBranchFeaturesAndValuesOrThresholds(), b->GetBranchFeaturesAndValuesOrThresholds());
+            ASSERT_EQ(a->GetClassProbabilities(), b->GetClassProbabilities());
+            ASSERT_EQ(a->GetNumChildren(), b->GetNumChildren());
+            for (size_t i = 0; i < a->GetNumChildren(); ++i) {
+                assertSameSubtree(a->GetChild(i), b->GetChild(i));
+            }
+        };
+    assertSameSubtree(compacted->getRootNode(), uncompacted->getRootNode());
+}
+
 TEST_F(DecisionTreeTest, findBoundedIntervalsForNumericFeatures)
 {
     // Test case 1: Single feature with ">" condition only
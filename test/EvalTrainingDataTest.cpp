@@ -40,4 +40,49 @@ TEST_F(EvalTrainingDataTest, testEvaluateTrainingDataDiscrimination)
 
     // assert within ~5 points
     ASSERT_NEAR(idx, 60.71, 0.1);
-}
\ No newline at end of file
+}
+
+TEST_F(EvalTrainingDataTest, testSeededFoldsAreReproducible)
+{
+    auto evaluate = [this](const string &seed) {
+        auto seededKwargs    = kwargs;
+        seededKwargs["seed"] = seed;
+        auto seeded          = make_shared<EvalTrainingData>(seededKwargs);
+        seeded->getTrainingData();
+        return seeded->evaluateTrainingData();
+    };
+
+    double first = evaluate("7");
+    ASSERT_EQ(evaluate("7"), first);
+    ASSERT_GT(first, 0.0);
+}
+
+TEST_F(EvalTrainingDataTest, testSweepMatchesEvaluatingEachCombination)
+{
+    evalData->getTrainingData();
+    const vector<SweepResult> results = evalData->sweepHyperparameters({0.01, 0.1}, {3, 5});
+    ASSERT_EQ(results.size(), 4u);
+    ASSERT_EQ(results[3].entropyThreshold, 0.1);
+    ASSERT_EQ(results[3].maxDepthDesired, 5);
+
+    // The most permissive combination is the tree evaluateTrainingData() grows with the fixture's parameters
+    ASSERT_EQ(results[1].entropyThreshold, 0.01);
+    ASSERT_EQ(results[1].maxDepthDesired, 5);
+    ASSERT_NEAR(results[1].dataQualityIndex, 60.71, 0.1);
+    ASSERT_GE(results[1].meanNumNodes, results[0].meanNumNodes);
+    ASSERT_GE(results[1].meanNumNodes, results[3].meanNumNodes);
+    ASSERT_GT(results[1].meanNumNodes, results[2].meanNumNodes);
+
+    // A truncated combination scores as if it had been grown
+    auto evaluate = [this](const string &entropyThreshold, const string &maxDepthDesired) {
+        auto combinationKwargs                 = kwargs;
+        combinationKwargs["entropy_threshold"] = entropyThreshold;
+        combinationKwargs["max_depth_desired"] = maxDepthDesired;
+        auto combination                       = make_shared<EvalTrainingData>(combinationKwargs);
+        combination->getTrainingData();
+        return combination->evaluateTrainingData();
+    };
+    ASSERT_EQ(results[2].dataQualityIndex, evaluate("0.1", "3"));
+
+    ASSERT_THROW(evalData->sweepHyperparameters({}, {3}), std::invalid_argument);
+}
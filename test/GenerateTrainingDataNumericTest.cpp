@@ -192,3 +192,43 @@ TEST_F(TrainingDataGeneratorNumericTest, TestGenerateTrainingDataNumeric)
     std::remove("../test/resources/param_numeric_out.txt");
 }
 
+
+TEST_F(TrainingDataGeneratorNumericTest, TestGenerateTrainingDataNumericSeeded)
+{
+    auto generate = [this](const string &seed, const string &numThreads) {
+        map<string, string> args = kwargs;
+        args["seed"]              = seed;
+        args["number_of_threads"] = numThreads;
+
+        TrainingDataGeneratorNumeric generator(args);
+        generator.ReadParameterFileNumeric();
+        generator.GenerateTrainingDataNumeric();
+
+        std::ifstream file("../test/resources/param_numeric_out.txt");
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    };
+
+    // The output depends on the seed but not on the number of threads
+    string serial = generate("7", "1");
+    ASSERT_EQ(generate("7", "3"), serial);
+    ASSERT_NE(generate("8", "1"), serial);
+
+    // Every class has exactly number_of_samples_per_class rows
+    std::istringstream lines(serial);
+    string line;
+    std::getline(lines, line);
+    map<string, int> rowsPerClass;
+    while (std::getline(lines, line)) {
+        std::istringstream ss(line);
+        string id, className;
+        std::getline(ss, id, ',');
+        std::getline(ss, className, ',');
+        ++rowsPerClass[className];
+    }
+    ASSERT_EQ(rowsPerClass["recession"], 3000);
+    ASSERT_EQ(rowsPerClass["goodtimes"], 3000);
+
+    std::remove("../test/resources/param_numeric_out.txt");
+}
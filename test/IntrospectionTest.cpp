@@ -374,3 +374,116 @@ TEST_F(IntrospectionTest, CheckdtIRecursiveDescentNumeric)
     ASSERT_EQ(branchFeaturesToNodesDict, expectedBranchFeaturesToNodesDict);
     ASSERT_EQ(sampleToNodeMappingDirectDict, expectedSampleToNodeMappingDirectDict);
 }
+
+TEST_F(IntrospectionTest, CheckdtILazyThrows)
+{
+    ASSERT_THROW(dtSI->initializeLazy(), std::runtime_error);
+    ASSERT_THROW(dtSI->getSamplesAtNode(1), std::runtime_error);
+    ASSERT_THROW(dtSI->getNodePathForSample(1), std::runtime_error);
+}
+
+TEST_F(IntrospectionTest, CheckdtILazyMatchesEager)
+{
+    dtS->constructDecisionTreeClassifier();
+    dtN->constructDecisionTreeClassifier();
+
+    for (auto dt : {dtS, dtN}) {
+        auto eager = make_shared<DTIntrospection>(dt);
+        auto lazy  = make_shared<DTIntrospection>(dt);
+        eager->initialize();
+        ASSERT_NO_THROW(lazy->initializeLazy());
+
+        // Nothing is materialized until it is asked for
+        ASSERT_TRUE(lazy->getSamplesAtNodesDict().empty());
+        ASSERT_TRUE(lazy->getSampleToNodeMappingDirectDict().empty());
+
+        for (const auto &[nodeSerialNum, node] : eager->getNodeSerialNumToNodeDict()) {
+            vector<int> expected;
+            auto it = eager->getSamplesAtNodesDict().find(nodeSerialNum);
+            if (it != eager->getSamplesAtNodesDict().end()) {
+                for (const auto &sample : it->second) {
+                    expected.push_back(std::stoi(sample));
+                }
+            }
+            ASSERT_EQ(lazy->getSamplesAtNode(nodeSerialNum), expected);
+            ASSERT_EQ(lazy->getBranchFeaturesAtNode(nodeSerialNum),
+                      eager->getBranchFeaturesToNodesDict().at(nodeSerialNum));
+        }
+
+        for (const auto &samplePair : dt->getTrainingDataDict()) {
+            vector<int> expected;
+            auto it = eager->getSampleToNodeMappingDirectDict().find(std::to_string(samplePair.first));
+            if (it != eager->getSampleToNodeMappingDirectDict().end()) {
+                expected = it->second;
+            }
+            ASSERT_EQ(lazy->getNodePathForSample(samplePair.first), expected);
+        }
+
+        ASSERT_THROW(lazy->getSamplesAtNode(100000), std::runtime_error);
+        ASSERT_THROW(lazy->getNodePathForSample(-5), std::runtime_error);
+    }
+}
+
+TEST_F(IntrospectionTest, CheckdtILazyMemoizes)
+{
+    dtS->constructDecisionTreeClassifier();
+    dtSI->initializeLazy();
+
+    const vector<int> &first  = dtSI->getSamplesAtNode(1);
+    const vector<int> &second = dtSI->getSamplesAtNode(1);
+    ASSERT_EQ(&first, &second);
+
+    const vector<int> &path1 = dtSI->getNodePathForSample(0);
+    const vector<int> &path2 = dtSI->getNodePathForSample(0);
+    ASSERT_EQ(&path1, &path2);
+}
+
+TEST_F(IntrospectionTest, CheckdtILazyForgetsRebuiltTree)
+{
+    dtN->constructDecisionTreeClassifier();
+    dtNI->initializeLazy();
+    for (const auto &[nodeSerialNum, node] : dtNI->getNodeSerialNumToNodeDict()) {
+        dtNI->getBranchFeaturesAtNode(nodeSerialNum);
+    }
+
+    dtN->setMaxDepthDesired(3);
+    dtN->setEntropyThreshold(0.1);
+    dtN->constructDecisionTreeClassifier();
+    dtNI->initializeLazy();
+    for (const auto &[nodeSerialNum, node] : dtNI->getNodeSerialNumToNodeDict()) {
+        ASSERT_EQ(dtNI->getBranchFeaturesAtNode(nodeSerialNum), node->GetBranchFeaturesAndValuesOrThresholds());
+    }
+}
+
+TEST_F(IntrospectionTest, CheckdtIRoutingIndexMatchesScan)
+{
+    for (auto dt : {dtS, dtN}) {
+        dt->constructDecisionTreeClassifier();
+        auto scanned = make_shared<DTIntrospection>(dt);
+        scanned->initialize();
+        testing::internal::CaptureStdout();
+        scanned->displayTrainingSamplesToNodesInfluencePropagation();
+        const string scannedInfluence = testing::internal::GetCapturedStdout();
+
+        dt->buildRoutingIndex();
+        auto indexed = make_shared<DTIntrospection>(dt);
+        indexed->initialize();
+        auto lazy = make_shared<DTIntrospection>(dt);
+        lazy->initializeLazy();
+
+        ASSERT_EQ(indexed->getSamplesAtNodesDict(), scanned->getSamplesAtNodesDict());
+        ASSERT_EQ(indexed->getSampleToNodeMappingDirectDict(), scanned->getSampleToNodeMappingDirectDict());
+
+        for (const auto &[sample, nodes] : scanned->getSampleToNodeMappingDirectDict()) {
+            ASSERT_EQ(lazy->getNodePathForSample(std::stoi(sample)), nodes);
+        }
+
+        // The influence of the samples is read off the routing index, without the direct mapping of initialize()
+        auto lazyDisplay = make_shared<DTIntrospection>(dt);
+        lazyDisplay->initializeLazy();
+        testing::internal::CaptureStdout();
+        lazyDisplay->displayTrainingSamplesToNodesInfluencePropagation();
+        ASSERT_EQ(testing::internal::GetCapturedStdout(), scannedInfluence);
+        ASSERT_TRUE(lazyDisplay->getSampleToNodeMappingDirectDict().empty());
+    }
+}
@@ -0,0 +1,136 @@
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <thread>
+
+class LoggerTest : public ::testing::Test {
+  protected:
+    const string logFile = "LoggerTest.log";
+
+    void SetUp() override { std::remove(logFile.c_str()); }
+    void TearDown() override { std::remove(logFile.c_str()); }
+
+    vector<string> readLines()
+    {
+        std::ifstream file(logFile);
+        vector<string> lines;
+        string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+};
+
+TEST_F(LoggerTest, WritesFormattedMessages)
+{
+    {
+        Logger logger(logFile, false);
+        logger.log(LogLevel::INFO, "first message");
+        logger.log(LogLevel::CRITICAL, "second message");
+        logger.flush();
+
+        vector<string> lines = readLines();
+        ASSERT_EQ(lines.size(), 2);
+        ASSERT_EQ(lines[0].front(), '[');
+        ASSERT_NE(lines[0].find("] INFO: first message"), string::npos);
+        ASSERT_NE(lines[1].find("] CRITICAL: second message"), string::npos);
+    }
+
+    // The file is appended to, and the destructor writes what is still queued
+    {
+        Logger logger(logFile, false);
+        logger.log(LogLevel::WARNING, "third message");
+    }
+    vector<string> lines = readLines();
+    ASSERT_EQ(lines.size(), 3);
+    ASSERT_NE(lines[2].find("] WARNING: third message"), string::npos);
+}
+
+TEST_F(LoggerTest, ConcurrentProducersKeepTheirOrder)
+{
+    const int numThreads = 4;
+    const int perThread  = 5000;
+    {
+        Logger logger(logFile, false, 1024);
+        ASSERT_EQ(logger.getCapacity(), 1024);
+
+        vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    // A full ring buffer drops the message, so retry until it is queued
+                    while (!logger.log(LogLevel::DEBUG, std::to_string(t) + " " + std::to_string(i))) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Every message is written once, and the messages of each thread are written in the order they were logged
+    vector<string> lines = readLines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(numThreads * perThread));
+    vector<int> next(numThreads, 0);
+    for (const auto &line : lines) {
+        std::istringstream message(line.substr(line.find("DEBUG: ") + 7));
+        int t, i;
+        message >> t >> i;
+        ASSERT_EQ(i, next[t]++);
+    }
+}
+
+TEST_F(LoggerTest, FlushReturnsWhileOtherThreadsKeepLogging)
+{
+    Logger logger(logFile, false, 64);
+    std::atomic<bool> stop{false};
+    std::thread producer([&]() {
+        while (!stop.load()) {
+            logger.log(LogLevel::DEBUG, "background message");
+        }
+    });
+
+    // The ring buffer need never run empty, so the writer must flush without waiting for it to
+    for (int i = 0; i < 10; ++i) {
+        const string message = "flushed message " + std::to_string(i);
+        while (!logger.log(LogLevel::INFO, message)) {
+            std::this_thread::yield();
+        }
+        logger.flush();
+
+        const vector<string> lines = readLines();
+        ASSERT_TRUE(std::any_of(lines.begin(), lines.end(), [&](const string &line) {
+            return line.find("] INFO: " + message) != string::npos;
+        }));
+    }
+    stop.store(true);
+    producer.join();
+}
+
+TEST_F(LoggerTest, LevelsBelowTheMinimumAreCompiledOut)
+{
+    int evaluated = 0;
+    auto message  = [&evaluated]() {
+        ++evaluated;
+        return string("message");
+    };
+
+    {
+        Logger logger(logFile, false);
+        DTPP_LOG(logger, DEBUG, message());
+        DTPP_LOG(logger, ERROR, message());
+    }
+
+    const int expected = static_cast<int>(LogLevel::DEBUG) >= DTPP_MIN_LOG_LEVEL ? 2 : 1;
+    ASSERT_EQ(evaluated, expected);
+    ASSERT_EQ(readLines().size(), static_cast<size_t>(expected));
+    ASSERT_EQ(Logger::levelToString(LogLevel::ERROR), "ERROR");
+}
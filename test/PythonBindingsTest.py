@@ -0,0 +1,148 @@
+"""Smoke test of the DecisionTreePP Python module, run by CTest with the built module on PYTHONPATH."""
+import gc
+import math
+import os
+import sys
+import threading
+import time
+import unittest
+
+try:
+    import numpy as np
+except ImportError:
+    print("NumPy is not installed, skipping the Python bindings test")
+    sys.exit(77)  # CTest's SKIP_RETURN_CODE
+
+import DecisionTreePP as dtp
+
+RESOURCES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "resources")
+
+
+def stage3cancer_kwargs():
+    # The keywords are strings, with one character per column for csv_columns_for_features
+    return {
+        "training_datafile": os.path.join(RESOURCES, "stage3cancer.csv"),
+        "csv_class_column_index": "2",
+        "csv_columns_for_features": "".join(chr(column) for column in [3, 4, 5, 6, 7, 8]),
+        "max_depth_desired": "8",
+        "entropy_threshold": "0.01",
+    }
+
+
+def to_number(value):
+    try:
+        return float(value)
+    except ValueError:
+        return math.nan
+
+
+def encode_training_data(dt, compiled):
+    """The training samples as the arrays taken by predict_proba: float64 values, with NA as NaN, and int64 codes."""
+    features = compiled.getFeatureNames()
+    samples = list(dt.getTrainingDataDict().values())
+    numeric = np.array([[to_number(value) for value in values] for values in samples], dtype=np.float64)
+    symbolic = np.array([[compiled.encodeSymbolicValue(feature, value) for feature, value in zip(features, values)]
+                         for values in samples], dtype=np.int64)
+    return numeric, symbolic
+
+
+class PredictProbaTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.dt = dtp.DecisionTree(stage3cancer_kwargs())
+        cls.dt.fit()
+        cls.compiled = dtp.CompiledDecisionTree(cls.dt)
+        cls.numeric, cls.symbolic = encode_training_data(cls.dt, cls.compiled)
+
+    def test_numpy_rows_match_the_compiled_tree(self):
+        probabilities = self.dt.predict_proba(self.numeric, self.symbolic)
+        self.assertIsInstance(probabilities, np.ndarray)
+        self.assertEqual(probabilities.dtype, np.float64)
+        self.assertEqual(probabilities.shape, (len(self.numeric), len(self.dt.getClassNames())))
+        np.testing.assert_allclose(probabilities.sum(axis=1), 1.0, atol=1e-3)
+        np.testing.assert_array_equal(probabilities, self.compiled.predict_proba(self.numeric, self.symbolic))
+
+    def test_other_layouts_and_dtypes(self):
+        expected = self.dt.predict_proba(self.numeric, self.symbolic)
+
+        # Arrays that cannot be read in place are converted first
+        np.testing.assert_array_equal(self.dt.predict_proba(np.asfortranarray(self.numeric), self.symbolic), expected)
+        np.testing.assert_array_equal(self.dt.predict_proba(self.numeric, self.symbolic.astype(np.int32)), expected)
+
+        as_float = self.dt.predict_proba(self.numeric.astype(np.float32), self.symbolic)
+        self.assertEqual(as_float.shape, expected.shape)
+        self.assertEqual(self.dt.predict_proba(self.numeric).shape, expected.shape)
+
+    def test_rejects_arrays_of_the_wrong_shape(self):
+        with self.assertRaises(ValueError):
+            self.dt.predict_proba(self.numeric[:, :3])
+        with self.assertRaises(ValueError):
+            self.dt.predict_proba(self.numeric, self.symbolic[:10])
+
+
+class NodeOwnershipTest(unittest.TestCase):
+    def test_nodes_stay_owned_by_their_tree(self):
+        # The nodes are returned by reference, so dropping them must not free them and they keep their tree alive
+        dt = dtp.DecisionTree(stage3cancer_kwargs())
+        root = dt.fit()
+        num_nodes = root.HowManyNodes()
+        self.assertGreater(num_nodes, 1)
+        for _ in range(3):
+            self.assertEqual(dt.getRootNode().GetSerialNum(), root.GetSerialNum())
+            self.assertTrue(dt.getRootNode().GetChildren())
+            gc.collect()
+
+        children = root.GetChildren()
+        del dt, root
+        gc.collect()
+        for child in children:
+            self.assertEqual(child.HowManyNodes(), num_nodes)
+            self.assertTrue(child.GetBranchFeaturesAndValuesOrThresholds())
+
+
+class ConcurrencyTest(unittest.TestCase):
+    def test_fit_releases_the_gil(self):
+        # This thread keeps running Python code while another fits a tree; had fit() held the GIL, it would have
+        # stalled for the whole fit
+        dt = dtp.DecisionTree(stage3cancer_kwargs())
+        finished = threading.Event()
+
+        def fit():
+            dt.fit()
+            finished.set()
+
+        worker = threading.Thread(target=fit)
+        begin = last = time.perf_counter()
+        longest_gap = 0.0
+        worker.start()
+        while not finished.is_set():
+            now = time.perf_counter()
+            longest_gap = max(longest_gap, now - last)
+            last = now
+        duration = time.perf_counter() - begin
+        worker.join()
+
+        if duration < 0.05:
+            self.skipTest("fit() took too little time to tell whether it released the GIL")
+        self.assertLess(longest_gap, duration / 2)
+
+    def test_fit_async_resolves_to_the_fitted_tree(self):
+        expected = dtp.DecisionTree(stage3cancer_kwargs())
+        expected.fit()
+        numeric, symbolic = encode_training_data(expected, dtp.CompiledDecisionTree(expected))
+
+        dt = dtp.DecisionTree(stage3cancer_kwargs())
+        future = dt.fit_async()
+        self.assertIs(future.result(timeout=300), dt)
+        np.testing.assert_array_equal(dt.predict_proba(numeric, symbolic), expected.predict_proba(numeric, symbolic))
+
+    def test_fit_async_raises_what_fit_raises(self):
+        kwargs = stage3cancer_kwargs()
+        kwargs["training_datafile"] = os.path.join(RESOURCES, "missing.csv")
+        future = dtp.DecisionTree(kwargs).fit_async()
+        with self.assertRaises(ValueError):
+            future.result(timeout=300)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,134 @@
+#include "DecisionForest.hpp"
+#include "QuickScorer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+void expectSameProbabilities(const DecisionForest &forest,
+                             const QuickScorer &scorer,
+                             const vector<double> &numericValues,
+                             const vector<int> &symbolicCodes)
+{
+    const size_t numRows = numericValues.size() / forest.getNumFeatures();
+    vector<double> fromForest(numRows * forest.getNumClasses());
+    vector<double> fromScorer(numRows * forest.getNumClasses());
+    forest.predictProba(numericValues.data(), symbolicCodes.data(), numRows, fromForest.data());
+    scorer.predictProba(numericValues.data(), symbolicCodes.data(), numRows, fromScorer.data());
+
+    for (size_t i = 0; i < fromForest.size(); i++) {
+        ASSERT_DOUBLE_EQ(fromForest[i], fromScorer[i]) << "row " << i / forest.getNumClasses();
+    }
+}
+
+TEST(QuickScorerTest, NumericForestMatchesDescendingTheTrees)
+{
+    DecisionForest forest({
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {       "max_depth_desired",                                  "8"},
+        {       "entropy_threshold",                               "0.01"},
+        {         "number_of_trees",                                  "8"},
+        {       "features_per_node",                                  "6"},
+        {                    "seed",                                  "11"}
+    });
+    forest.fit();
+    QuickScorer scorer(forest);
+    ASSERT_EQ(scorer.getNumTrees(), 8u);
+
+    // Some trees need more than one word of bits
+    ASSERT_GT(scorer.getNumWords(), scorer.getNumTrees());
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : forest.getData()->_trainingDataDict) {
+        forest.getCompiledTrees().front().encodeRow(values, numericValues, symbolicCodes);
+    }
+    expectSameProbabilities(forest, scorer, numericValues, symbolicCodes);
+
+    // Values between and beyond the thresholds, missing values, and symbolic values given as numbers or unknown
+    const size_t numFeatures = forest.getNumFeatures();
+    for (size_t i = 0; i < numericValues.size(); i++) {
+        numericValues[i] = i % 7 == 0 ? std::nan("") : numericValues[i] * 1.0001 + 0.05 * (i % 5);
+        symbolicCodes[i] = i % 3 == 0 ? -1 : symbolicCodes[i];
+    }
+    expectSameProbabilities(forest, scorer, numericValues, symbolicCodes);
+    ASSERT_EQ(scorer.predictProba(vector<double>(numFeatures, std::nan("")), {}),
+              forest.predictProba(vector<double>(numFeatures, std::nan("")), {}));
+}
+
+TEST(QuickScorerTest, SymbolicForestMatchesDescendingTheTrees)
+{
+    DecisionForest forest({
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {       "max_depth_desired",                                       "5"},
+        {       "entropy_threshold",                                     "0.1"},
+        {         "number_of_trees",                                      "20"},
+        {                    "seed",                                       "2"}
+    });
+    forest.fit();
+    QuickScorer scorer(forest);
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : forest.getData()->_trainingDataDict) {
+        forest.getCompiledTrees().front().encodeRow(values, numericValues, symbolicCodes);
+    }
+    expectSameProbabilities(forest, scorer, numericValues, symbolicCodes);
+
+    // Unknown values, and codes beyond the values of the feature, stop at the node that tests them
+    for (size_t i = 0; i < symbolicCodes.size(); i += 3) {
+        symbolicCodes[i] = -1;
+    }
+    for (size_t i = 1; i < symbolicCodes.size(); i += 5) {
+        symbolicCodes[i] = 99;
+    }
+    expectSameProbabilities(forest, scorer, numericValues, symbolicCodes);
+    ASSERT_EQ(scorer.encodeSymbolicValue("smoking", "heavy"), forest.encodeSymbolicValue("smoking", "heavy"));
+}
+
+TEST(QuickScorerTest, RejectsEnsemblesItCannotScore)
+{
+    ASSERT_THROW(QuickScorer(vector<CompiledDecisionTree>{}), std::invalid_argument);
+
+    DecisionForest symbolic({
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {         "number_of_trees",                                       "1"},
+        {                    "seed",                                       "2"}
+    });
+    ASSERT_THROW(QuickScorer{symbolic}, std::invalid_argument);
+
+    DecisionForest numeric({
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {         "number_of_trees",                                  "1"},
+        {       "max_depth_desired",                                  "2"},
+        {                    "seed",                                  "2"}
+    });
+    symbolic.fit();
+    numeric.fit();
+    vector<CompiledDecisionTree> mixed = {symbolic.getCompiledTrees()[0], numeric.getCompiledTrees()[0]};
+    ASSERT_THROW(QuickScorer{mixed}, std::invalid_argument);
+
+    // The same code would stand for different values in trees that saw different symbolic values
+    auto dt = make_shared<DecisionTree>(map<string, string>{
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {                  "debug3",                                       "0"}
+    });
+    dt->getTrainingData();
+    dt->calculateFirstOrderProbabilities();
+    dt->calculateClassPriors();
+    dt->constructDecisionTreeClassifier();
+    CompiledDecisionTree seen(dt);
+    dt->_featuresAndUniqueValuesDict["smoking"].insert("chain");
+    vector<CompiledDecisionTree> vocabularies = {seen, CompiledDecisionTree(dt)};
+    ASSERT_THROW(QuickScorer{vocabularies}, std::invalid_argument);
+}
@@ -0,0 +1,68 @@
+#include "Random.hpp"
+
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+
+TEST(RandomTest, PhiloxMatchesKnownAnswers)
+{
+    // Known-answer vectors of Philox4x32-10 from the Random123 distribution
+    using Block = Philox4x32::Block;
+    ASSERT_EQ(Philox4x32::philox({0, 0, 0, 0}, {0, 0}), (Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    ASSERT_EQ(Philox4x32::philox({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (Block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    ASSERT_EQ(Philox4x32::philox({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              (Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+
+    // The first output of stream 0 under seed 0 is the first two words of the block of counter 0
+    Philox4x32 rng;
+    ASSERT_EQ(rng(), 0xe169c58d6627e8d5ull);
+    ASSERT_EQ(rng(), 0x9b00dbd8bc57ac4cull);
+}
+
+TEST(RandomTest, DiscardSkipsOutputs)
+{
+    for (unsigned long long skip : {0ull, 1ull, 2ull, 5ull, 1000ull}) {
+        Philox4x32 stepped(42, 3), skipped(42, 3);
+        stepped();
+        skipped();
+        for (unsigned long long i = 0; i < skip; ++i) {
+            stepped();
+        }
+        skipped.discard(skip);
+        ASSERT_EQ(stepped(), skipped()) << "after discarding " << skip;
+        ASSERT_EQ(stepped(), skipped()) << "after discarding " << skip;
+    }
+}
+
+TEST(RandomTest, StreamsAndSplitsAreIndependent)
+{
+    // Different seeds, streams and substreams give different sequences, the same ones give the same sequence
+    std::set<unsigned long long> firstOutputs;
+    const Philox4x32 root(7);
+    for (uint64_t i = 0; i < 100; ++i) {
+        firstOutputs.insert(Philox4x32(7, i)());
+        firstOutputs.insert(root.split(i)());
+        firstOutputs.insert(root.split(i).split(0)());
+        firstOutputs.insert(Philox4x32(i + 8)());
+    }
+    ASSERT_EQ(firstOutputs.size(), 400u);
+
+    Philox4x32 a = root.split(5), b = root.split(5);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(a(), b());
+    }
+}
+
+TEST(RandomTest, DefaultSeedReadsTheEnvironment)
+{
+    setenv("DTPP_SEED", "12345", 1);
+    ASSERT_EQ(defaultSeed(), 12345u);
+
+    setenv("DTPP_SEED", "not a seed", 1);
+    ASSERT_THROW(defaultSeed(), std::invalid_argument);
+
+    unsetenv("DTPP_SEED");
+    ASSERT_NE(defaultSeed(), defaultSeed());
+}
@@ -143,4 +143,72 @@ TEST_F(TrainingDataGeneratorSymbolicTest, CheckTrainingSampleRecords)
             ASSERT_TRUE(std::find(values[i - 1].begin(), values[i - 1].end(), record.second[i]) != values[i - 1].end());
         }
     }
-}
\ No newline at end of file
+}
+TEST_F(TrainingDataGeneratorSymbolicTest, AliasTableMatchesWeights)
+{
+    AliasTable table({0.5, 0.0, 0.2, 0.3});
+    ASSERT_EQ(table.size(), 4);
+    ASSERT_THROW(AliasTable(vector<double>{}), std::invalid_argument);
+
+    std::mt19937_64 gen(1);
+    vector<int> counts(4, 0);
+    const int numDraws = 100000;
+    for (int i = 0; i < numDraws; ++i) {
+        ++counts[table(gen)];
+    }
+
+    ASSERT_NEAR(counts[0] / double(numDraws), 0.5, 0.01);
+    ASSERT_EQ(counts[1], 0);
+    ASSERT_NEAR(counts[2] / double(numDraws), 0.2, 0.01);
+    ASSERT_NEAR(counts[3] / double(numDraws), 0.3, 0.01);
+}
+
+TEST_F(TrainingDataGeneratorSymbolicTest, SeededGenerationIsReproducible)
+{
+    auto generate = [this](const string &seed, const string &numThreads) {
+        map<string, string> args = kwargs;
+        args["number_of_training_samples"] = "10000";
+        args["seed"]                       = seed;
+        args["number_of_threads"]          = numThreads;
+
+        TrainingDataGeneratorSymbolic generator(args);
+        generator.ReadParameterFileSymbolic();
+        generator.GenerateTrainingDataSymbolic();
+        return generator.getSampleCodes();
+    };
+
+    // The samples depend on the seed but not on the number of threads
+    vector<uint16_t> serial = generate("3", "1");
+    ASSERT_EQ(serial.size(), 10000 * 5);
+    ASSERT_EQ(generate("3", "4"), serial);
+    ASSERT_NE(generate("4", "1"), serial);
+
+    // malignant (index 0) has prior 0.4
+    int numMalignant = 0;
+    for (size_t i = 0; i < serial.size(); i += 5) {
+        numMalignant += serial[i] == 0;
+    }
+    ASSERT_NEAR(numMalignant / 10000.0, 0.4, 0.03);
+}
+
+TEST_F(TrainingDataGeneratorSymbolicTest, WrittenFileMatchesRecords)
+{
+    ASSERT_NO_THROW(tdgs.ReadParameterFileSymbolic());
+    ASSERT_NO_THROW(tdgs.GenerateTrainingDataSymbolic());
+    ASSERT_NO_THROW(tdgs.WriteTrainingDataToFile());
+
+    std::ifstream file("../test/resources/training_symbolic_1.csv");
+    string line;
+    std::getline(file, line);
+    ASSERT_EQ(line, ",class,exercising,fatIntake,smoking,videoAddiction");
+
+    for (const auto &record : tdgs.getTrainingSampleRecords()) {
+        std::getline(file, line);
+        string expected = std::to_string(record.first);
+        for (const auto &value : record.second) {
+            expected += "," + value;
+        }
+        ASSERT_EQ(line, expected);
+    }
+    ASSERT_FALSE(std::getline(file, line));
+}
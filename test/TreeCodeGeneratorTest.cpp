@@ -0,0 +1,141 @@
+#include "TreeCodeGenerator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+class TreeCodeGeneratorTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        const char* cxx = std::getenv("CXX");
+        compiler        = cxx != nullptr && *cxx != '\0' ? cxx : "c++";
+        if (std::system((compiler + " --version > /dev/null 2>&1").c_str()) != 0) {
+            GTEST_SKIP() << "No C++ compiler to compile the generated code with: " << compiler;
+        }
+    }
+
+    static void expectSameProbabilities(const CompiledDecisionTree &tree,
+                                        const NativeDecisionTree &native,
+                                        const vector<double> &numericValues,
+                                        const vector<int> &symbolicCodes)
+    {
+        const size_t numRows = numericValues.size() / tree.getNumFeatures();
+        vector<double> fromTree(numRows * tree.getNumClasses());
+        vector<double> fromNative(numRows * tree.getNumClasses());
+        tree.predictProba(numericValues.data(), symbolicCodes.data(), numRows, fromTree.data());
+        native.predictProba(numericValues.data(), symbolicCodes.data(), numRows, fromNative.data());
+        for (size_t i = 0; i < fromTree.size(); i++) {
+            ASSERT_EQ(fromTree[i], fromNative[i]) << "row " << i / tree.getNumClasses();
+        }
+
+        // The same rows as floats, and without the symbolic codes
+        const vector<float> floatValues(numericValues.begin(), numericValues.end());
+        tree.predictProba(floatValues.data(), nullptr, numRows, fromTree.data());
+        native.predictProba(floatValues.data(), nullptr, numRows, fromNative.data());
+        for (size_t i = 0; i < fromTree.size(); i++) {
+            ASSERT_EQ(fromTree[i], fromNative[i]) << "float row " << i / tree.getNumClasses();
+        }
+    }
+
+    string compiler;
+};
+
+TEST_F(TreeCodeGeneratorTest, NumericTreeMatchesCompiledTree)
+{
+    auto dt = make_shared<DecisionTree>(map<string, string>{
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {       "max_depth_desired",                                  "8"},
+        {       "entropy_threshold",                               "0.01"}
+    });
+    dt->fit();
+    TreeCodeGenerator generator(dt, "stage3cancer");
+    const CompiledDecisionTree &tree      = generator.getCompiledTree();
+    shared_ptr<NativeDecisionTree> native = generator.compileAndLoad(compiler);
+    ASSERT_EQ(native->getFeatureNames(), tree.getFeatureNames());
+    ASSERT_EQ(native->getClassNames(), tree.getClassNames());
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        tree.encodeRow(values, numericValues, symbolicCodes);
+    }
+    expectSameProbabilities(tree, *native, numericValues, symbolicCodes);
+
+    // Values between and beyond the thresholds, missing values, and symbolic values given as numbers or unknown
+    for (size_t i = 0; i < numericValues.size(); i++) {
+        numericValues[i] = i % 7 == 0 ? std::nan("") : numericValues[i] * 1.0001 + 0.05 * (i % 5);
+        symbolicCodes[i] = i % 3 == 0 ? -1 : symbolicCodes[i];
+    }
+    expectSameProbabilities(tree, *native, numericValues, symbolicCodes);
+    const vector<double> missing(tree.getNumFeatures(), std::nan(""));
+    ASSERT_EQ(native->predictProba(missing, {}), tree.predictProba(missing, {}));
+    ASSERT_THROW(native->predictProba({1.0}, {}), std::invalid_argument);
+}
+
+TEST_F(TreeCodeGeneratorTest, SymbolicTreeMatchesCompiledTree)
+{
+    auto dt = make_shared<DecisionTree>(map<string, string>{
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {       "max_depth_desired",                                       "5"},
+        {       "entropy_threshold",                                     "0.1"}
+    });
+    dt->fit();
+    TreeCodeGenerator generator(dt);
+    const CompiledDecisionTree &tree      = generator.getCompiledTree();
+    shared_ptr<NativeDecisionTree> native = generator.compileAndLoad(compiler, "-O1");
+
+    vector<double> numericValues;
+    vector<int> symbolicCodes;
+    for (const auto &[sample, values] : dt->_trainingDataDict) {
+        tree.encodeRow(values, numericValues, symbolicCodes);
+    }
+    expectSameProbabilities(tree, *native, numericValues, symbolicCodes);
+
+    // Unknown values stop at the node that tests them
+    for (size_t i = 0; i < symbolicCodes.size(); i += 3) {
+        symbolicCodes[i] = -1;
+    }
+    expectSameProbabilities(tree, *native, numericValues, symbolicCodes);
+    ASSERT_EQ(native->encodeSymbolicValue("smoking", "heavy"), tree.encodeSymbolicValue("smoking", "heavy"));
+}
+
+TEST_F(TreeCodeGeneratorTest, WritesTheHeaderAndReportsCompilerErrors)
+{
+    auto dt = make_shared<DecisionTree>(map<string, string>{
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {       "max_depth_desired",                                       "2"}
+    });
+    dt->fit();
+    ASSERT_THROW(TreeCodeGenerator(dt, ""), std::invalid_argument);
+    ASSERT_THROW(TreeCodeGenerator(dt, "2trees"), std::invalid_argument);
+    ASSERT_THROW(TreeCodeGenerator(dt, "my-tree"), std::invalid_argument);
+
+    TreeCodeGenerator generator(dt, "smoking_tree");
+    const string header = generator.generateHeader();
+    ASSERT_NE(header.find("namespace smoking_tree {"), string::npos);
+    ASSERT_NE(header.find("constexpr double CLASS_PROBABILITIES[NUM_NODES][NUM_CLASSES]"), string::npos);
+    ASSERT_EQ(generator.generatePluginSource().rfind(header, 0), 0u);
+    ASSERT_NE(generator.generatePluginSource().find("void smoking_tree_predict_proba_float("), string::npos);
+
+    const string filename = "smoking_tree.hpp";
+    generator.writeHeader(filename);
+    std::ifstream file(filename);
+    std::stringstream written;
+    written << file.rdbuf();
+    ASSERT_EQ(written.str(), header);
+    std::remove(filename.c_str());
+
+    ASSERT_THROW(generator.compileAndLoad(compiler, "-DNUM_CLASSES=0"), std::runtime_error);
+    ASSERT_THROW(generator.compileAndLoad("no-such-compiler"), std::runtime_error);
+}
@@ -0,0 +1,176 @@
+#include "TreePruner.hpp"
+
+#include <gtest/gtest.h>
+
+class TreePrunerTest : public ::testing::Test {
+  protected:
+    map<string, string> symbolicKargs = {
+        {       "training_datafile", "../test/resources/training_symbolic.csv"},
+        {  "csv_class_column_index",                                       "1"},
+        {"csv_columns_for_features",                              {2, 3, 4, 5}},
+        {       "max_depth_desired",                                       "5"},
+        {       "entropy_threshold",                                     "0.1"}
+    };
+    map<string, string> numericKargs = {
+        {       "training_datafile", "../test/resources/stage3cancer.csv"},
+        {  "csv_class_column_index",                                  "2"},
+        {"csv_columns_for_features",                   {3, 4, 5, 6, 7, 8}},
+        {       "max_depth_desired",                                  "8"},
+        {       "entropy_threshold",                               "0.01"}
+    };
+
+    static int countNodes(const DecisionTreeNode* node)
+    {
+        int count = 1;
+        for (size_t i = 0; i < node->GetNumChildren(); ++i) {
+            count += countNodes(node->GetChild(i));
+        }
+        return count;
+    }
+
+    // The samples of a tree's training data as "feature=value" strings without missing values, with their classes
+    static void labeledSamples(const DecisionTree &dt,
+                               vector<vector<string>> &featuresAndValues,
+                               vector<string> &classNames,
+                               size_t maxSamples = SIZE_MAX)
+    {
+        for (const auto &[sample, values] : dt._trainingDataDict) {
+            if (featuresAndValues.size() == maxSamples) {
+                break;
+            }
+            vector<string> sampleFeaturesAndValues;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (values[i] != "NA") {
+                    sampleFeaturesAndValues.push_back(dt._featureNames[i] + "=" + values[i]);
+                }
+            }
+            featuresAndValues.push_back(sampleFeaturesAndValues);
+            classNames.push_back(dt._samplesClassLabelDict.at(sample));
+        }
+    }
+
+    // The fraction of the samples whose most probable class in the tree is their own
+    static double accuracy(const DecisionTree &dt,
+                           const vector<vector<string>> &featuresAndValues,
+                           const vector<string> &classNames)
+    {
+        int correct = 0;
+        for (size_t i = 0; i < featuresAndValues.size(); ++i) {
+            ClassificationAnswer answer;
+            for (const auto &className : dt._classNames) {
+                answer.classProbabilities[className] = 0.0;
+            }
+            dt.recursiveDescentForClassification(dt.getRootNode(), featuresAndValues[i], answer);
+
+            // The first class of highest probability, in class order
+            string predicted;
+            double highest = -1.0;
+            for (const auto &className : dt._classNames) {
+                if (answer.classProbabilities[className] > highest) {
+                    highest   = answer.classProbabilities[className];
+                    predicted = className;
+                }
+            }
+            correct += predicted == classNames[i];
+        }
+        return static_cast<double>(correct) / featuresAndValues.size();
+    }
+};
+
+TEST_F(TreePrunerTest, PathShrinksTheTreeToItsRoot)
+{
+    auto dt = make_shared<DecisionTree>(numericKargs);
+    dt->fit();
+    TreePruner pruner(dt);
+    ASSERT_THROW(pruner.selectStep(), std::runtime_error);
+
+    const vector<PruningStep> &path = pruner.computePruningPath();
+    ASSERT_GT(path.size(), 2u);
+    ASSERT_EQ(path.front().numNodes, countNodes(dt->getRootNode()));
+    ASSERT_EQ(path.front().alpha, 0.0);
+    ASSERT_TRUE(path.front().prunedNodes.empty());
+    ASSERT_TRUE(std::isnan(path.front().heldOutAccuracy));
+    ASSERT_EQ(path.back().numNodes, 1);
+    ASSERT_EQ(path.back().numLeaves, 1);
+
+    for (size_t step = 1; step < path.size(); ++step) {
+        ASSERT_LT(path[step].numNodes, path[step - 1].numNodes);
+        ASSERT_LE(path[step].numLeaves, path[step - 1].numLeaves);
+        ASSERT_GE(path[step].alpha, path[step - 1].alpha);
+        ASSERT_FALSE(path[step].prunedNodes.empty());
+    }
+
+    // The accuracy of the full tree is that of classifying the training samples
+    vector<vector<string>> featuresAndValues;
+    vector<string> classNames;
+    labeledSamples(*dt, featuresAndValues, classNames);
+    ASSERT_NEAR(path.front().trainingAccuracy, accuracy(*dt, featuresAndValues, classNames), 1e-12);
+
+    // Without held-out samples there is nothing to select a tree with
+    ASSERT_THROW(pruner.selectStep(), std::runtime_error);
+    ASSERT_THROW(pruner.prune(), std::runtime_error);
+}
+
+TEST_F(TreePrunerTest, PruningToAStepGivesItsTree)
+{
+    auto dt = make_shared<DecisionTree>(numericKargs);
+    dt->fit();
+    dt->buildRoutingIndex();
+    TreePruner pruner(dt);
+    const vector<PruningStep> path = pruner.computePruningPath();
+    const size_t step              = path.size() / 2;
+    const size_t nodeBytes         = dt->getMemoryUsage().nodeBytes;
+
+    DecisionTreeNode* root = pruner.pruneToStep(step);
+    ASSERT_EQ(root, dt->getRootNode());
+    ASSERT_EQ(countNodes(root), path[step].numNodes);
+    ASSERT_LT(dt->getMemoryUsage().nodeBytes, nodeBytes);
+    ASSERT_TRUE(pruner.getPruningPath().empty());
+    ASSERT_THROW(pruner.pruneToStep(0), std::invalid_argument);
+
+    // The pruned tree classifies the training samples as the path said, and routes them to the nodes it still has
+    vector<vector<string>> featuresAndValues;
+    vector<string> classNames;
+    labeledSamples(*dt, featuresAndValues, classNames);
+    ASSERT_NEAR(accuracy(*dt, featuresAndValues, classNames), path[step].trainingAccuracy, 1e-12);
+    const vector<pair<int, int>> &nodeRowRanges = dt->getRoutingIndex().nodeRowRanges;
+    const auto numRoutedNodes =
+        std::count_if(nodeRowRanges.begin(), nodeRowRanges.end(), [](const auto &range) { return range.first >= 0; });
+    ASSERT_EQ(numRoutedNodes, path[step].numNodes);
+
+    // The pruned tree starts a path of its own
+    const vector<PruningStep> &rest = pruner.computePruningPath();
+    ASSERT_EQ(rest.front().numNodes, path[step].numNodes);
+    ASSERT_EQ(rest.back().numNodes, 1);
+}
+
+TEST_F(TreePrunerTest, HeldOutSamplesSelectTheTree)
+{
+    auto dt = make_shared<DecisionTree>(symbolicKargs);
+    dt->fit();
+
+    // Samples from the same distribution that the tree was not trained on
+    auto heldOutData = make_shared<DecisionTree>(symbolicKargs);
+    heldOutData->_trainingDatafile = "../test/resources/training_symbolic_large1.csv";
+    heldOutData->getTrainingData();
+    vector<vector<string>> featuresAndValues;
+    vector<string> classNames;
+    labeledSamples(*heldOutData, featuresAndValues, classNames, 500);
+
+    TreePruner pruner(dt);
+    ASSERT_THROW(pruner.setHeldOutSamples(featuresAndValues, {}), std::invalid_argument);
+    ASSERT_THROW(pruner.setHeldOutSamples({{"smoking=heavy"}}, {"no such class"}), std::invalid_argument);
+    pruner.setHeldOutSamples(featuresAndValues, classNames);
+
+    const vector<PruningStep> path = pruner.computePruningPath();
+    ASSERT_NEAR(path.front().heldOutAccuracy, accuracy(*dt, featuresAndValues, classNames), 1e-12);
+
+    const size_t best = pruner.selectStep();
+    for (const auto &step : path) {
+        ASSERT_LE(step.heldOutAccuracy, path[best].heldOutAccuracy);
+    }
+
+    pruner.prune();
+    ASSERT_EQ(countNodes(dt->getRootNode()), path[best].numNodes);
+    ASSERT_NEAR(accuracy(*dt, featuresAndValues, classNames), path[best].heldOutAccuracy, 1e-12);
+}
@@ -2,6 +2,11 @@
 
 #include "Utility.hpp"
 
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
 class UtilityTest : public ::testing::Test
 {
 protected:
@@ -55,6 +60,17 @@ TEST_F(UtilityTest, convert)
     string str3 = "42";
     double result3 = convert(str3);
     ASSERT_EQ(result3, 42.0);
+
+    // Parsed like std::stod: whitespace, signs, exponents, hexadecimal and trailing characters
+    ASSERT_EQ(convert("  -2.5e2"), -250.0);
+    ASSERT_EQ(convert("+7"), 7.0);
+    ASSERT_EQ(convert("0x1A"), 26.0);
+    ASSERT_EQ(convert("12abc"), 12.0);
+
+    // Anything else is NaN, without an exception
+    for (const char* notANumber : {"NA", "diploid", "", "+-1", "-", "1e999"}) {
+        ASSERT_TRUE(std::isnan(convert(notANumber))) << notANumber;
+    }
 }
 
 TEST_F(UtilityTest, ClosestSamplingPoint)
@@ -86,4 +102,120 @@ TEST_F(UtilityTest, cleanupCSV)
         string result = CleanupCsvString(std::get<0>(test));
         ASSERT_EQ(result, std::get<1>(test));
     }
-}
\ No newline at end of file
+}
+
+TEST_F(UtilityTest, countValuesNearGridPointsByClass)
+{
+    // The per-class counts must match comparing every value of each class with every grid point
+    const double delta = 0.37;
+    vector<double> gridPoints;
+    for (int i = 0; i < 40; ++i) {
+        gridPoints.push_back(-2.0 + delta * i);
+    }
+    vector<double> values;
+    vector<int32_t> classes;
+    for (int i = 0; i < 1000; ++i) {
+        values.push_back(-4.0 + 0.0191 * i);
+        classes.push_back(i % 3);
+    }
+    values.push_back(gridPoints[7]); // Exactly on a grid point
+    classes.push_back(1);
+
+    vector<size_t> counts(3 * gridPoints.size());
+    countValuesNearGridPointsByClass(
+        gridPoints.data(), gridPoints.size(), values.data(), classes.data(), values.size(), 3, delta, counts.data());
+
+    for (int32_t c = 0; c < 3; ++c) {
+        vector<size_t> expected(gridPoints.size(), 0);
+        for (size_t i = 0; i < values.size(); ++i) {
+            for (size_t point = 0; point < gridPoints.size(); ++point) {
+                expected[point] += classes[i] == c && std::abs(gridPoints[point] - values[i]) < delta;
+            }
+        }
+        vector<size_t> actual(counts.begin() + c * gridPoints.size(), counts.begin() + (c + 1) * gridPoints.size());
+        ASSERT_EQ(actual, expected);
+    }
+
+    // Bins are floors, with the values before the grid in bin -1
+    vector<double> binned = {-3.0, -0.1, 0.0, 0.99, 1.0, 2.5};
+    vector<int32_t> bins(binned.size());
+    binIndices(binned.data(), binned.size(), 0.0, 1.0, bins.data());
+    ASSERT_EQ(bins, (vector<int32_t>{-1, -1, 0, 0, 1, 2}));
+
+    // A window of zero width contains nothing
+    countValuesNearGridPointsByClass(
+        gridPoints.data(), gridPoints.size(), values.data(), nullptr, values.size(), 1, 0.0, counts.data());
+    ASSERT_EQ(std::accumulate(counts.begin(), counts.begin() + gridPoints.size(), size_t{0}), 0u);
+}
+
+TEST_F(UtilityTest, entropyOfProbabilities)
+{
+    // The same to the bit as summing the terms in class order, skipping the probabilities near 0 and 1
+    const vector<double> probabilities = {0.3, 0.00005, 0.1, 0.25, 0.2, 0.14995, 0.9995};
+    double expected                    = 0.0;
+    for (double prob : probabilities) {
+        if (prob >= 0.0001 && prob <= 0.999) {
+            expected += -1.0 * prob * std::log2(prob);
+        }
+    }
+    ASSERT_EQ(entropyOfProbabilities(probabilities.data(), probabilities.size()), expected);
+    ASSERT_EQ(entropyOfProbabilities(probabilities.data(), 1), -0.3 * std::log2(0.3));
+
+    // A certain class, and no classes at all, have no entropy, while the bounds of the range still count
+    const double certain[] = {1.0, 0.0};
+    ASSERT_EQ(entropyOfProbabilities(certain, 2), 0.0);
+    ASSERT_EQ(entropyOfProbabilities(nullptr, 0), 0.0);
+    const double bounds[] = {0.999, 0.0001};
+    ASSERT_EQ(entropyOfProbabilities(bounds, 2), -0.999 * std::log2(0.999) + -0.0001 * std::log2(0.0001));
+}
+
+TEST_F(UtilityTest, writeBlocksInParallel)
+{
+    auto formatBlock = [](size_t block, string &text) {
+        // Blocks of uneven length, so that they finish out of order
+        text.assign(block % 5 * 1000, 'a' + static_cast<char>(block % 26));
+        text += std::to_string(block) + "\n";
+    };
+    std::ostringstream expected;
+    writeBlocksInParallel(expected, 100, 1, formatBlock);
+    for (int threads : {2, 3, 8, 200}) {
+        std::ostringstream out;
+        writeBlocksInParallel(out, 100, threads, formatBlock);
+        ASSERT_EQ(out.str(), expected.str()) << threads << " threads";
+    }
+
+    // An error in any block is rethrown once the workers have stopped, and nothing after the block is written
+    for (int threads : {1, 4}) {
+        std::ostringstream out;
+        ASSERT_THROW(writeBlocksInParallel(out,
+                                           100,
+                                           threads,
+                                           [&](size_t block, string &text) {
+                                               if (block == 37) {
+                                                   throw std::runtime_error("block 37");
+                                               }
+                                               formatBlock(block, text);
+                                           }),
+                     std::runtime_error);
+        ASSERT_EQ(out.str().find("37\n"), string::npos);
+    }
+}
+
+TEST_F(UtilityTest, parallelFor)
+{
+    for (int threads : {1, 3, 64}) {
+        vector<int> runs(50, 0);
+        parallelFor(runs.size(), threads, [&](size_t task) { runs[task]++; });
+        ASSERT_EQ(runs, vector<int>(50, 1)) << threads << " threads";
+
+        // An error is rethrown once every thread has been joined
+        ASSERT_THROW(parallelFor(runs.size(),
+                                 threads,
+                                 [&](size_t task) {
+                                     if (task == 7) {
+                                         throw std::invalid_argument("task 7");
+                                     }
+                                 }),
+                     std::invalid_argument);
+    }
+}